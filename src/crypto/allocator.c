@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocator.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+/* Prefix of every block; 16 bytes keep the payload 16-byte aligned */
+typedef struct {
+    size_t size;                        // Bytes requested by the caller
+    const tls_allocator_t *allocator;   // Vtable the block must be returned to
+} allocator_header_t;
+
+constexpr size_t ALLOCATOR_HEADER_SIZE = 16;
+static_assert(sizeof(allocator_header_t) <= ALLOCATOR_HEADER_SIZE,
+              "allocator header must fit in 16 bytes");
+
+static void *system_alloc(void *userdata, size_t size) {
+    (void)userdata;
+    return malloc(size);
+}
+
+static void system_free(void *userdata, void *ptr, size_t size) {
+    (void)userdata;
+    (void)size;
+    free(ptr);
+}
+
+static const tls_allocator_t system_allocator = {
+    .alloc_func = system_alloc,
+    .free_func = system_free,
+    .userdata = nullptr,
+};
+
+static const tls_allocator_t *g_allocator = &system_allocator;
+
+// Session the calling thread is working for (see ALLOCATOR_ATTRIBUTE)
+static _Thread_local tls_memory_stats_t *t_current_stats = nullptr;
+
+void allocator_set(const tls_allocator_t *allocator) {
+    g_allocator = allocator != nullptr ? allocator : &system_allocator;
+}
+
+[[nodiscard]] const tls_allocator_t *allocator_get(void) {
+    return g_allocator;
+}
+
+[[nodiscard]] void *allocator_malloc(size_t size) {
+    if (size > SIZE_MAX - ALLOCATOR_HEADER_SIZE) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    const tls_allocator_t *allocator = g_allocator;
+    uint8_t *block = allocator->alloc_func(allocator->userdata, size + ALLOCATOR_HEADER_SIZE);
+    if (block == nullptr) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    allocator_header_t *header = (allocator_header_t *)block;
+    header->size = size;
+    header->allocator = allocator;
+
+    tls_memory_stats_t *stats = t_current_stats;
+    if (stats != nullptr) {
+        stats->allocations++;
+        stats->bytes_allocated += size;
+    }
+    return block + ALLOCATOR_HEADER_SIZE;
+}
+
+[[nodiscard]] void *allocator_calloc(size_t nmemb, size_t size) {
+    if (size != 0 && nmemb > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    void *ptr = allocator_malloc(nmemb * size);
+    if (ptr != nullptr) {
+        memset(ptr, 0, nmemb * size);
+    }
+    return ptr;
+}
+
+[[nodiscard]] void *allocator_realloc(void *ptr, size_t size) {
+    if (ptr == nullptr) {
+        return allocator_malloc(size);
+    }
+    if (size == 0) {
+        allocator_free(ptr);
+        return nullptr;
+    }
+
+    const allocator_header_t *header =
+        (const allocator_header_t *)((uint8_t *)ptr - ALLOCATOR_HEADER_SIZE);
+    if (size <= header->size) {
+        return ptr;     // Shrinking keeps the block; the sized free stays exact
+    }
+
+    void *grown = allocator_malloc(size);
+    if (grown == nullptr) {
+        return nullptr;
+    }
+    memcpy(grown, ptr, header->size);
+    allocator_free(ptr);
+    return grown;
+}
+
+void allocator_free(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    uint8_t *block = (uint8_t *)ptr - ALLOCATOR_HEADER_SIZE;
+    const allocator_header_t *header = (const allocator_header_t *)block;
+    size_t size = header->size;
+    const tls_allocator_t *allocator = header->allocator;
+
+    // Count before releasing: the block may hold the statistics themselves
+    tls_memory_stats_t *stats = t_current_stats;
+    if (stats != nullptr) {
+        stats->frees++;
+        stats->bytes_freed += size;
+    }
+    allocator->free_func(allocator->userdata, block, size + ALLOCATOR_HEADER_SIZE);
+}
+
+[[nodiscard]] tls_memory_stats_t *allocator_attribute_begin(tls_memory_stats_t *stats) {
+    tls_memory_stats_t *previous = t_current_stats;
+    t_current_stats = stats;
+    return previous;
+}
+
+void allocator_attribute_end(tls_memory_stats_t **previous) {
+    t_current_stats = *previous;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_ALLOCATOR_H
+#define WOLFGUARD_ALLOCATOR_H
+
+/**
+ * TLS Memory Allocation (internal)
+ *
+ * Every allocation made for a session - by the abstraction layer and, where
+ * the library lets us hook it, by the TLS library itself - goes through
+ * allocator_malloc() and allocator_free(). They forward to the allocator
+ * installed with tls_global_init_with_allocator() (the system heap by
+ * default) and prefix each block with a 16-byte header recording its size
+ * and the allocator that produced it. The size lets the vtable use sized
+ * frees, which is what makes a headerless size-class arena possible, and the
+ * allocator pointer keeps blocks freeable after the allocator is replaced.
+ *
+ * Accounting: a thread may name the statistics of the session it is working
+ * for with ALLOCATOR_ATTRIBUTE(); until the end of that scope, allocations
+ * and frees on the thread are counted against those statistics. Frees are
+ * charged to whichever session is current when they happen, not to the one
+ * that allocated the block, so no stale session pointer is ever followed.
+ */
+
+#include <stddef.h>
+
+#include "tls_abstract.h"
+
+/**
+ * Install the allocator used by later allocations
+ *
+ * @param allocator Vtable (must outlive every block allocated through it),
+ *                  or nullptr for the system heap
+ *
+ * Not thread-safe; called from tls_global_init_with_allocator().
+ */
+void allocator_set(const tls_allocator_t *allocator);
+
+/**
+ * Currently installed allocator (never nullptr)
+ */
+[[nodiscard]] const tls_allocator_t *allocator_get(void);
+
+/**
+ * Allocate @p size bytes (16-byte aligned)
+ *
+ * @return Pointer on success, nullptr on failure (errno = ENOMEM)
+ */
+[[nodiscard]] void *allocator_malloc(size_t size);
+
+/**
+ * Allocate zeroed memory for @p nmemb elements of @p size bytes
+ */
+[[nodiscard]] void *allocator_calloc(size_t nmemb, size_t size);
+
+/**
+ * Resize a block; nullptr @p ptr allocates, zero @p size frees
+ *
+ * @return New block, or nullptr on failure (the old block is left intact)
+ */
+[[nodiscard]] void *allocator_realloc(void *ptr, size_t size);
+
+/**
+ * Release a block from allocator_malloc() and friends (nullptr is a no-op)
+ */
+void allocator_free(void *ptr);
+
+/**
+ * Make @p stats the accounting target of the calling thread
+ *
+ * @return Previous target, to be restored with allocator_attribute_end()
+ */
+[[nodiscard]] tls_memory_stats_t *allocator_attribute_begin(tls_memory_stats_t *stats);
+
+/**
+ * Restore the accounting target saved by allocator_attribute_begin()
+ */
+void allocator_attribute_end(tls_memory_stats_t **previous);
+
+/**
+ * Count allocations on this thread against @p stats until the end of the
+ * enclosing scope
+ */
+#define ALLOCATOR_ATTRIBUTE(stats) \
+    __attribute__((cleanup(allocator_attribute_end))) \
+    tls_memory_stats_t *allocator_previous_ = allocator_attribute_begin(stats)
+
+#endif // WOLFGUARD_ALLOCATOR_H
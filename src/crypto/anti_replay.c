@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE  // For CLOCK_MONOTONIC_COARSE, getrandom()
+
+#include "anti_replay.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+struct anti_replay {
+    pthread_mutex_t lock;
+
+    uint64_t *filters[2];       // filters[current] takes new keys
+    unsigned int current;
+    size_t words;               // Per filter
+    uint64_t bit_mask;          // Filter bits - 1 (power of 2)
+
+    unsigned int window_ms;
+    int64_t window_start_ms;    // Start of the current window
+
+    uint64_t hash_key[2];
+    anti_replay_stats_t stats;
+};
+
+/* ============================================================================
+ * Hashing and Time
+ * ============================================================================ */
+
+// MurmurHash3 finalizer
+static inline uint64_t fmix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Keyed 64-bit hash
+ *
+ * Keys are PSK binders (GnuTLS) or ClientHello randoms (wolfSSL), i.e.
+ * already unpredictable MAC or random output, and a collision only costs a
+ * 1-RTT handshake; the secret key keeps outsiders from choosing which
+ * ClientHellos collide.
+ */
+static uint64_t filter_hash(uint64_t seed, const uint8_t *key, size_t size) {
+    uint64_t h = fmix64(seed ^ (uint64_t)size);
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, key, sizeof(word));
+        h = fmix64(h ^ word) + 0x9e3779b97f4a7c15ULL;
+        key += 8;
+        size -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, key, size);
+    return fmix64(h ^ tail ^ seed);
+}
+
+static inline int64_t filter_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (int64_t)ts.tv_sec * 1'000 + ts.tv_nsec / 1'000'000;
+}
+
+// Start a new window when the current one is over (lock held)
+static void filter_advance(anti_replay_t *filter, int64_t now_ms) {
+    int64_t elapsed = now_ms - filter->window_start_ms;
+    if (elapsed < (int64_t)filter->window_ms) {
+        return;
+    }
+
+    size_t bytes = filter->words * sizeof(uint64_t);
+    if (elapsed >= 2 * (int64_t)filter->window_ms) {
+        // Idle for two windows: nothing in either filter is still fresh
+        memset(filter->filters[0], 0, bytes);
+        memset(filter->filters[1], 0, bytes);
+        filter->window_start_ms = now_ms;
+    } else {
+        filter->current ^= 1;
+        memset(filter->filters[filter->current], 0, bytes);
+        filter->window_start_ms += filter->window_ms;
+    }
+}
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+anti_replay_t* anti_replay_new(size_t capacity, unsigned int window_ms) {
+    if (capacity == 0 || capacity > SIZE_MAX / ANTI_REPLAY_BITS_PER_KEY / 2 || window_ms == 0) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    size_t bits = ANTI_REPLAY_MIN_BITS;
+    while (bits < capacity * ANTI_REPLAY_BITS_PER_KEY) {
+        bits *= 2;
+    }
+
+    anti_replay_t *filter = calloc(1, sizeof(anti_replay_t));
+    if (filter == nullptr) {
+        return nullptr;
+    }
+    filter->words = bits / 64;
+    filter->bit_mask = bits - 1;
+    filter->window_ms = window_ms;
+    filter->window_start_ms = filter_clock_ms();
+    filter->stats.capacity = capacity;
+    filter->stats.memory_bytes = 2 * filter->words * sizeof(uint64_t);
+
+    // Both filters in one allocation
+    filter->filters[0] = calloc(2 * filter->words, sizeof(uint64_t));
+    if (filter->filters[0] == nullptr) {
+        free(filter);
+        return nullptr;
+    }
+    filter->filters[1] = filter->filters[0] + filter->words;
+
+    if (getrandom(filter->hash_key, sizeof(filter->hash_key), 0) !=
+        (ssize_t)sizeof(filter->hash_key)) {
+        int saved_errno = errno;
+        free(filter->filters[0]);
+        free(filter);
+        errno = saved_errno;
+        return nullptr;
+    }
+
+    pthread_mutex_init(&filter->lock, nullptr);
+    return filter;
+}
+
+void anti_replay_free(anti_replay_t *filter) {
+    if (filter == nullptr) {
+        return;
+    }
+
+    pthread_mutex_destroy(&filter->lock);
+    free(filter->filters[0]);
+    free(filter);
+}
+
+int anti_replay_check(void *userdata, const uint8_t *key, size_t key_size) {
+    anti_replay_t *filter = userdata;
+    if (filter == nullptr || key == nullptr || key_size == 0) {
+        return -1;
+    }
+
+    // Double hashing: probe i is h1 + i * h2 (h2 odd, so probes differ)
+    uint64_t h1 = filter_hash(filter->hash_key[0], key, key_size);
+    uint64_t h2 = filter_hash(filter->hash_key[1], key, key_size) | 1;
+
+    pthread_mutex_lock(&filter->lock);
+    filter_advance(filter, filter_clock_ms());
+
+    uint64_t *current = filter->filters[filter->current];
+    const uint64_t *previous = filter->filters[filter->current ^ 1];
+    bool in_current = true;
+    bool in_previous = true;
+
+    for (unsigned int i = 0; i < ANTI_REPLAY_HASHES; i++) {
+        uint64_t bit = (h1 + i * h2) & filter->bit_mask;
+        uint64_t mask = 1ULL << (bit & 63);
+        size_t word = (size_t)(bit >> 6);
+
+        if ((current[word] & mask) == 0) {
+            in_current = false;
+            current[word] |= mask;
+        }
+        if ((previous[word] & mask) == 0) {
+            in_previous = false;
+        }
+    }
+
+    bool seen = in_current || in_previous;
+    filter->stats.checked++;
+    filter->stats.replays += seen ? 1 : 0;
+    pthread_mutex_unlock(&filter->lock);
+
+    return seen ? 1 : 0;
+}
+
+void anti_replay_get_stats(anti_replay_t *filter, anti_replay_stats_t *stats) {
+    if (stats == nullptr) {
+        return;
+    }
+    if (filter == nullptr) {
+        *stats = (anti_replay_stats_t){0};
+        return;
+    }
+
+    pthread_mutex_lock(&filter->lock);
+    *stats = filter->stats;
+    pthread_mutex_unlock(&filter->lock);
+}
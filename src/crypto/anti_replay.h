@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_ANTI_REPLAY_H
+#define WOLFGUARD_ANTI_REPLAY_H
+
+/**
+ * 0-RTT Anti-Replay Filter
+ *
+ * Remembers every ClientHello that offered early data for at least one
+ * freshness window, so that a recorded ClientHello replayed inside the window
+ * is recognised and gets a 1-RTT handshake instead (RFC 8446, section 8.2).
+ * ClientHellos older than the window are already turned away by the
+ * backend's ticket age check, so nothing needs to be remembered for longer.
+ *
+ * Design:
+ * - Two Bloom filters, one per window: keys are added to the current one and
+ *   looked up in both. When a window ends the older filter is cleared and
+ *   becomes current, so each key is remembered for one to two windows.
+ * - Fixed memory, sized at creation for the expected early-data handshakes
+ *   per window (ANTI_REPLAY_BITS_PER_KEY bits each); nothing is allocated
+ *   per check.
+ * - A false positive only costs one 1-RTT handshake, never lets a replay
+ *   through. Up to the configured capacity they stay around 0.1%; past it
+ *   they grow, and early data degrades to 1-RTT rather than to replays.
+ * - Filter positions come from a per-filter random key, so which
+ *   ClientHellos collide cannot be predicted from outside.
+ * - One mutex; a check is two hashes and ANTI_REPLAY_HASHES bit tests.
+ *
+ * Replays to another server are only caught if the servers share a filter,
+ * e.g. behind a load balancer that pins clients to a node.
+ *
+ * Usage:
+ *   anti_replay_t *filter = anti_replay_new(100'000, TLS_EARLY_DATA_WINDOW_MS);
+ *   tls_context_set_early_data(ctx, 16'384, anti_replay_check, filter);
+ *   // ... serve ...
+ *   anti_replay_free(filter);
+ */
+
+#include "tls_abstract.h"
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+/* ============================================================================
+ * Configuration Constants
+ * ============================================================================ */
+
+constexpr size_t ANTI_REPLAY_BITS_PER_KEY = 16;
+constexpr size_t ANTI_REPLAY_MIN_BITS = 4'096;      // Per filter, power of 2
+constexpr unsigned int ANTI_REPLAY_HASHES = 11;     // Optimal for 16 bits per key
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/**
+ * Anti-replay filter handle (opaque)
+ */
+typedef struct anti_replay anti_replay_t;
+
+/**
+ * Filter statistics
+ */
+typedef struct {
+    uint64_t checked;       // ClientHellos checked
+    uint64_t replays;       // ... reported as seen (replays and false positives)
+    size_t capacity;        // Keys per window the filter is sized for
+    size_t memory_bytes;    // Both filters
+} anti_replay_stats_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * Create a filter
+ *
+ * @param capacity Expected early-data handshakes per window
+ * @param window_ms Freshness window, at least the backend's
+ *                  (TLS_EARLY_DATA_WINDOW_MS)
+ * @return Filter on success, nullptr on failure (errno = EINVAL for invalid
+ *         parameters, ENOMEM, or the errno of getrandom())
+ */
+[[nodiscard]] anti_replay_t* anti_replay_new(size_t capacity, unsigned int window_ms);
+
+/**
+ * Free a filter (after the contexts using it)
+ *
+ * @param filter Filter
+ */
+void anti_replay_free(anti_replay_t *filter);
+
+/**
+ * Check and record a ClientHello (tls_replay_check_func_t)
+ *
+ * @param userdata Filter
+ * @param key Key identifying the ClientHello
+ * @param key_size Key length
+ * @return 0 if the key was not seen in the last one to two windows, 1 if it
+ *         was (or may have been), -1 on invalid parameters
+ *
+ * Note: Thread-safe.
+ */
+int anti_replay_check(void *userdata, const uint8_t *key, size_t key_size);
+
+/**
+ * Get filter statistics
+ *
+ * @param filter Filter
+ * @param stats Output statistics
+ */
+void anti_replay_get_stats(anti_replay_t *filter, anti_replay_stats_t *stats);
+
+#endif // WOLFGUARD_ANTI_REPLAY_H
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "arena.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+/* Blocks moved from the central list per refill */
+constexpr size_t ARENA_REFILL_BLOCKS = 32;
+
+/* Small classes: 16, 32, ... 128 bytes */
+constexpr unsigned int ARENA_SMALL_CLASSES = 8;
+constexpr size_t ARENA_SMALL_MAX = 128;
+
+/* Free block, linked through its first word */
+typedef struct arena_block {
+    struct arena_block *next;
+} arena_block_t;
+
+/* Uncarved end of a chunk left behind by an exited thread */
+typedef struct arena_tail {
+    struct arena_tail *next;
+    size_t size;                // Bytes from this header to the chunk end
+} arena_tail_t;
+
+typedef struct {
+    arena_block_t *free_list[ARENA_NUM_CLASSES];
+    size_t free_count[ARENA_NUM_CLASSES];
+    uint8_t *chunk;             // Next uncarved byte of the current chunk
+    size_t chunk_left;
+    bool registered;            // Exit destructor armed for this thread
+} arena_cache_t;
+
+static _Thread_local arena_cache_t t_cache;
+
+static struct {
+    pthread_mutex_t lock;
+    arena_block_t *free_list[ARENA_NUM_CLASSES];
+    arena_tail_t *tails;
+} g_central = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_key;
+
+/* ============================================================================
+ * Size Classes
+ * ============================================================================ */
+
+[[nodiscard]] unsigned int arena_size_class(size_t size) {
+    if (size <= ARENA_SMALL_MAX) {
+        return size == 0 ? 0 : (unsigned int)((size - 1) / 16);
+    }
+
+    // power < size <= 2 * power, split into four steps of power / 4
+    unsigned int shift = 63 - (unsigned int)__builtin_clzll((unsigned long long)(size - 1));
+    size_t power = (size_t)1 << shift;
+    return ARENA_SMALL_CLASSES + (shift - 7) * 4 + (unsigned int)((size - 1 - power) / (power / 4));
+}
+
+[[nodiscard]] size_t arena_class_size(unsigned int size_class) {
+    if (size_class < ARENA_SMALL_CLASSES) {
+        return (size_t)(size_class + 1) * 16;
+    }
+
+    unsigned int index = size_class - ARENA_SMALL_CLASSES;
+    size_t power = ARENA_SMALL_MAX << (index / 4);
+    return power + (index % 4 + 1) * (power / 4);
+}
+
+static_assert(ARENA_SMALL_MAX << ((ARENA_NUM_CLASSES - ARENA_SMALL_CLASSES) / 4) == ARENA_MAX_SIZE,
+              "size classes must end at ARENA_MAX_SIZE");
+
+/* ============================================================================
+ * Central Pool
+ * ============================================================================ */
+
+// Thread exit: hand every cached block and the rest of the chunk to the pool
+static void arena_thread_exit(void *arg) {
+    arena_cache_t *cache = arg;
+
+    pthread_mutex_lock(&g_central.lock);
+    for (unsigned int c = 0; c < ARENA_NUM_CLASSES; c++) {
+        arena_block_t *head = cache->free_list[c];
+        if (head == nullptr) {
+            continue;
+        }
+        arena_block_t *last = head;
+        while (last->next != nullptr) {
+            last = last->next;
+        }
+        last->next = g_central.free_list[c];
+        g_central.free_list[c] = head;
+    }
+    if (cache->chunk_left >= arena_class_size(0)) {
+        arena_tail_t *tail = (arena_tail_t *)cache->chunk;
+        tail->size = cache->chunk_left;
+        tail->next = g_central.tails;
+        g_central.tails = tail;
+    }
+    pthread_mutex_unlock(&g_central.lock);
+
+    *cache = (arena_cache_t){0};
+}
+
+static void arena_create_key(void) {
+    // Without the key blocks cached by exiting threads are lost, not corrupted
+    (void)pthread_key_create(&g_key, arena_thread_exit);
+}
+
+static void arena_register(arena_cache_t *cache) {
+    pthread_once(&g_key_once, arena_create_key);
+    if (pthread_setspecific(g_key, cache) == 0) {
+        cache->registered = true;
+    }
+}
+
+// Move the older half of an overgrown list to the pool
+static void arena_flush(arena_cache_t *cache, unsigned int size_class) {
+    size_t keep = cache->free_count[size_class] / 2;
+    arena_block_t *last_kept = cache->free_list[size_class];
+    for (size_t i = 1; i < keep; i++) {
+        last_kept = last_kept->next;
+    }
+
+    arena_block_t *head = last_kept->next;
+    arena_block_t *last = head;
+    while (last->next != nullptr) {
+        last = last->next;
+    }
+    last_kept->next = nullptr;
+    cache->free_count[size_class] = keep;
+
+    pthread_mutex_lock(&g_central.lock);
+    last->next = g_central.free_list[size_class];
+    g_central.free_list[size_class] = head;
+    pthread_mutex_unlock(&g_central.lock);
+}
+
+// Slow path of arena_alloc(): refill from the pool, else carve a new block
+static void *arena_refill(arena_cache_t *cache, unsigned int size_class) {
+    if (!cache->registered) {
+        arena_register(cache);
+    }
+
+    size_t block_size = arena_class_size(size_class);
+    arena_block_t *taken = nullptr;
+    size_t count = 0;
+
+    pthread_mutex_lock(&g_central.lock);
+    taken = g_central.free_list[size_class];
+    if (taken != nullptr) {
+        arena_block_t *last = taken;
+        for (count = 1; count < ARENA_REFILL_BLOCKS && last->next != nullptr; count++) {
+            last = last->next;
+        }
+        g_central.free_list[size_class] = last->next;
+        last->next = nullptr;
+    } else if (cache->chunk_left < block_size && g_central.tails != nullptr &&
+               g_central.tails->size >= block_size) {
+        // The rest of the current chunk is abandoned; it is smaller than one block
+        arena_tail_t *tail = g_central.tails;
+        g_central.tails = tail->next;
+        cache->chunk = (uint8_t *)tail;
+        cache->chunk_left = tail->size;
+    }
+    pthread_mutex_unlock(&g_central.lock);
+
+    if (taken != nullptr) {
+        cache->free_list[size_class] = taken->next;
+        cache->free_count[size_class] = count - 1;
+        return taken;
+    }
+
+    if (cache->chunk_left < block_size) {
+        uint8_t *chunk = malloc(ARENA_CHUNK_SIZE);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        cache->chunk = chunk;
+        cache->chunk_left = ARENA_CHUNK_SIZE;
+    }
+
+    void *block = cache->chunk;
+    cache->chunk += block_size;
+    cache->chunk_left -= block_size;
+    return block;
+}
+
+/* ============================================================================
+ * Allocator Vtable
+ * ============================================================================ */
+
+static void *arena_alloc(void *userdata, size_t size) {
+    (void)userdata;
+
+    if (size > ARENA_MAX_SIZE) {
+        return malloc(size);
+    }
+
+    unsigned int size_class = arena_size_class(size);
+    arena_cache_t *cache = &t_cache;
+    arena_block_t *block = cache->free_list[size_class];
+    if (block == nullptr) {
+        return arena_refill(cache, size_class);
+    }
+    cache->free_list[size_class] = block->next;
+    cache->free_count[size_class]--;
+    return block;
+}
+
+static void arena_free(void *userdata, void *ptr, size_t size) {
+    (void)userdata;
+
+    if (size > ARENA_MAX_SIZE) {
+        free(ptr);
+        return;
+    }
+
+    unsigned int size_class = arena_size_class(size);
+    arena_cache_t *cache = &t_cache;
+    if (!cache->registered) {
+        arena_register(cache);
+    }
+
+    arena_block_t *block = ptr;
+    block->next = cache->free_list[size_class];
+    cache->free_list[size_class] = block;
+    if (++cache->free_count[size_class] * arena_class_size(size_class) > ARENA_CACHE_BYTES) {
+        arena_flush(cache, size_class);
+    }
+}
+
+static const tls_allocator_t arena_allocator = {
+    .alloc_func = arena_alloc,
+    .free_func = arena_free,
+    .userdata = nullptr,
+};
+
+[[nodiscard]] const tls_allocator_t *tls_arena_allocator(void) {
+    return &arena_allocator;
+}
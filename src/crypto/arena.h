@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_ARENA_H
+#define WOLFGUARD_ARENA_H
+
+/**
+ * Per-Thread Size-Class Arena (internal)
+ *
+ * The allocator returned by tls_arena_allocator(). Requests are rounded up
+ * to one of ARENA_NUM_CLASSES size classes: steps of 16 bytes up to 128,
+ * then four classes per power of two up to ARENA_MAX_SIZE, which bounds
+ * the rounding waste to 25%. Larger requests go straight to malloc().
+ *
+ * Each thread keeps a free list per class and carves new blocks from a
+ * private ARENA_CHUNK_SIZE chunk, so the common allocate/free pairs of a
+ * worker touch no shared state and take no lock. A block freed on another
+ * thread simply joins that thread's list. A list that grows past
+ * ARENA_CACHE_BYTES hands half of its blocks to a mutex-protected central
+ * list, which threads refill from before carving new memory, and a thread
+ * that exits gives all of its blocks and the rest of its chunk back.
+ *
+ * Chunks are never returned to the system: the arena keeps the high-water
+ * mark of the process's TLS memory, which is the point of it.
+ */
+
+#include <stddef.h>
+
+#include "tls_abstract.h"
+
+constexpr size_t ARENA_MAX_SIZE = 32'768;       // Largest pooled block
+constexpr size_t ARENA_CHUNK_SIZE = 262'144;    // Unit carved into blocks
+constexpr size_t ARENA_CACHE_BYTES = 262'144;   // Per-class, per-thread cache limit
+constexpr unsigned int ARENA_NUM_CLASSES = 40;
+
+/**
+ * Size class serving a @p size byte request (size <= ARENA_MAX_SIZE)
+ */
+[[nodiscard]] unsigned int arena_size_class(size_t size);
+
+/**
+ * Block size of a size class
+ */
+[[nodiscard]] size_t arena_class_size(unsigned int size_class);
+
+#endif // WOLFGUARD_ARENA_H
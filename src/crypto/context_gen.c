@@ -0,0 +1,385 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE  // For struct stat st_mtim/st_ctim
+
+#include "context_gen.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+/* ============================================================================
+ * Internal Structures
+ * ============================================================================ */
+
+struct context_gen {
+    /*
+     * Read side: no lock. A reader registers in readers[epoch & 1] while it
+     * loads current and takes its reference; a reloader flips epoch so new
+     * readers register in the other slot, and waits for the slots to drain.
+     */
+    _Atomic(tls_context_t *) current;
+    atomic_uint epoch;
+    atomic_uint readers[2];
+
+    // Guards everything below; held across builds, never by readers
+    pthread_mutex_t lock;
+
+    context_gen_build_func_t build;
+    context_gen_retire_func_t retire;
+    void *userdata;
+
+    // Watched files and their identity at the last build
+    char *watch[CONTEXT_GEN_MAX_WATCH];
+    struct stat watch_stat[CONTEXT_GEN_MAX_WATCH];
+    size_t watch_count;
+    unsigned int poll_interval_ms;
+
+    context_gen_stats_t stats;
+
+    // Watcher thread
+    pthread_t watcher;
+    pthread_cond_t wake;
+    bool watcher_running;
+    bool stopping;
+};
+
+/* ============================================================================
+ * Grace Periods
+ * ============================================================================ */
+
+static inline uint64_t clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1'000'000'000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Flip the epoch and wait until no reader is left in the previous slot
+static void drain_slot(context_gen_t *gen) {
+    unsigned int slot = atomic_fetch_add(&gen->epoch, 1) & 1;
+    while (atomic_load(&gen->readers[slot]) != 0) {
+        sched_yield();
+    }
+}
+
+/**
+ * Wait until no reader can still take a reference to a replaced generation
+ *
+ * A reader that loaded the old pointer registered before the exchange, in
+ * either slot: one that read the epoch before an earlier flip registers late
+ * in the slot the previous reload drained. Draining both slots, each after
+ * flipping new readers away from it, covers both without waiting for readers
+ * that arrive meanwhile - those see the new generation.
+ */
+static void grace_period(context_gen_t *gen) {
+    drain_slot(gen);
+    drain_slot(gen);
+}
+
+/* ============================================================================
+ * Publishing (lock held)
+ * ============================================================================ */
+
+static void publish_locked(context_gen_t *gen, tls_context_t *ctx) {
+    tls_context_t *old = atomic_exchange(&gen->current, ctx);
+
+    uint64_t start = clock_ns();
+    grace_period(gen);
+    uint64_t grace_ns = clock_ns() - start;
+
+    gen->stats.generation++;
+    gen->stats.loaded_at = time(nullptr);
+    if (grace_ns > gen->stats.max_grace_ns) {
+        gen->stats.max_grace_ns = grace_ns;
+    }
+
+    // Sessions on the old generation keep it alive until they are freed
+    if (gen->retire != nullptr) {
+        gen->retire(gen->userdata, old);
+    }
+    tls_context_free(old);
+}
+
+// Build and publish a generation (lock held)
+static int reload_locked(context_gen_t *gen) {
+    tls_context_t *ctx = gen->build(gen->userdata);
+    if (ctx == nullptr) {
+        errno = ECANCELED;
+        return -1;
+    }
+
+    publish_locked(gen, ctx);
+    return 0;
+}
+
+/* ============================================================================
+ * Watching
+ * ============================================================================ */
+
+static bool same_file(const struct stat *a, const struct stat *b) {
+    return a->st_dev == b->st_dev && a->st_ino == b->st_ino && a->st_size == b->st_size &&
+           a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec &&
+           a->st_ctim.tv_sec == b->st_ctim.tv_sec && a->st_ctim.tv_nsec == b->st_ctim.tv_nsec;
+}
+
+/**
+ * Rebuild if a watched file changed (lock held)
+ *
+ * The new identities are recorded before building, so a failed build is not
+ * retried until the files change again, and a change during the build is
+ * picked up by the next poll.
+ *
+ * @return 1 if a generation was published, 0 if unchanged, -1 on failure
+ *         (errno set)
+ */
+static int poll_locked(context_gen_t *gen) {
+    bool changed = false;
+    for (size_t i = 0; i < gen->watch_count; i++) {
+        struct stat st;
+        if (stat(gen->watch[i], &st) != 0) {
+            return -1;
+        }
+        if (!same_file(&st, &gen->watch_stat[i])) {
+            gen->watch_stat[i] = st;
+            changed = true;
+        }
+    }
+
+    if (!changed) {
+        return 0;
+    }
+    return reload_locked(gen) == 0 ? 1 : -1;
+}
+
+// Failure accounting for poll_locked()/reload_locked() results (lock held)
+static int count_result(context_gen_t *gen, int rc) {
+    if (rc < 0) {
+        gen->stats.failures++;
+        gen->stats.last_error = errno;
+    }
+    return rc;
+}
+
+static void *watcher_main(void *arg) {
+    context_gen_t *gen = arg;
+
+    pthread_mutex_lock(&gen->lock);
+    while (!gen->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += gen->poll_interval_ms / 1'000;
+        deadline.tv_nsec += (long)(gen->poll_interval_ms % 1'000) * 1'000'000L;
+        if (deadline.tv_nsec >= 1'000'000'000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1'000'000'000L;
+        }
+
+        while (!gen->stopping &&
+               pthread_cond_timedwait(&gen->wake, &gen->lock, &deadline) != ETIMEDOUT) {
+        }
+        if (!gen->stopping) {
+            (void)count_result(gen, poll_locked(gen));
+        }
+    }
+    pthread_mutex_unlock(&gen->lock);
+    return nullptr;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+static void gen_destroy(context_gen_t *gen) {
+    pthread_cond_destroy(&gen->wake);
+    pthread_mutex_destroy(&gen->lock);
+    for (size_t i = 0; i < gen->watch_count; i++) {
+        free(gen->watch[i]);
+    }
+    free(gen);
+}
+
+context_gen_t* context_gen_new(const context_gen_config_t *config) {
+    if (config == nullptr || config->build == nullptr ||
+        (config->poll_interval_ms > 0 && config->watch[0] == nullptr)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    context_gen_t *gen = calloc(1, sizeof(context_gen_t));
+    if (gen == nullptr) {
+        return nullptr;
+    }
+    gen->build = config->build;
+    gen->retire = config->retire;
+    gen->userdata = config->userdata;
+    gen->poll_interval_ms = config->poll_interval_ms;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&gen->lock, nullptr);
+    pthread_cond_init(&gen->wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    for (size_t i = 0; i < CONTEXT_GEN_MAX_WATCH && config->watch[i] != nullptr; i++) {
+        gen->watch[i] = strdup(config->watch[i]);
+        if (gen->watch[i] == nullptr) {
+            gen_destroy(gen);
+            errno = ENOMEM;
+            return nullptr;
+        }
+        gen->watch_count++;
+
+        // Identity of what the first generation is built from
+        if (stat(gen->watch[i], &gen->watch_stat[i]) != 0) {
+            int saved_errno = errno;
+            gen_destroy(gen);
+            errno = saved_errno;
+            return nullptr;
+        }
+    }
+
+    tls_context_t *ctx = gen->build(gen->userdata);
+    if (ctx == nullptr) {
+        gen_destroy(gen);
+        errno = ECANCELED;
+        return nullptr;
+    }
+    atomic_init(&gen->current, ctx);
+    gen->stats.generation = 1;
+    gen->stats.loaded_at = time(nullptr);
+
+    if (gen->poll_interval_ms > 0) {
+        int ret = pthread_create(&gen->watcher, nullptr, watcher_main, gen);
+        if (ret != 0) {
+            if (gen->retire != nullptr) {
+                gen->retire(gen->userdata, ctx);
+            }
+            tls_context_free(ctx);
+            gen_destroy(gen);
+            errno = ret;
+            return nullptr;
+        }
+        gen->watcher_running = true;
+    }
+
+    return gen;
+}
+
+void context_gen_free(context_gen_t *gen) {
+    if (gen == nullptr) {
+        return;
+    }
+
+    if (gen->watcher_running) {
+        pthread_mutex_lock(&gen->lock);
+        gen->stopping = true;
+        pthread_cond_signal(&gen->wake);
+        pthread_mutex_unlock(&gen->lock);
+        pthread_join(gen->watcher, nullptr);
+    }
+
+    tls_context_t *ctx = atomic_load(&gen->current);
+    if (gen->retire != nullptr) {
+        gen->retire(gen->userdata, ctx);
+    }
+    tls_context_free(ctx);
+    gen_destroy(gen);
+}
+
+/* ============================================================================
+ * Connections
+ * ============================================================================ */
+
+tls_context_t* context_gen_acquire(context_gen_t *gen) {
+    if (gen == nullptr) {
+        return nullptr;
+    }
+
+    unsigned int slot = atomic_load(&gen->epoch) & 1;
+    atomic_fetch_add(&gen->readers[slot], 1);
+    tls_context_t *ctx = tls_context_ref(atomic_load(&gen->current));
+    atomic_fetch_sub(&gen->readers[slot], 1);
+    return ctx;
+}
+
+tls_session_t* context_gen_session_new(context_gen_t *gen) {
+    tls_context_t *ctx = context_gen_acquire(gen);
+    if (ctx == nullptr) {
+        return nullptr;
+    }
+
+    // The session takes its own reference
+    tls_session_t *session = tls_session_new(ctx);
+    tls_context_free(ctx);
+    return session;
+}
+
+/* ============================================================================
+ * Reloading
+ * ============================================================================ */
+
+int context_gen_publish(context_gen_t *gen, tls_context_t *ctx) {
+    if (gen == nullptr || ctx == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&gen->lock);
+    publish_locked(gen, ctx);
+    pthread_mutex_unlock(&gen->lock);
+    return 0;
+}
+
+int context_gen_reload(context_gen_t *gen) {
+    if (gen == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&gen->lock);
+    int rc = count_result(gen, reload_locked(gen));
+    int saved_errno = errno;
+    pthread_mutex_unlock(&gen->lock);
+
+    errno = saved_errno;
+    return rc;
+}
+
+void context_gen_get_stats(context_gen_t *gen, context_gen_stats_t *stats) {
+    if (stats == nullptr) {
+        return;
+    }
+    if (gen == nullptr) {
+        *stats = (context_gen_stats_t){0};
+        return;
+    }
+
+    pthread_mutex_lock(&gen->lock);
+    *stats = gen->stats;
+    pthread_mutex_unlock(&gen->lock);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_CONTEXT_GEN_H
+#define WOLFGUARD_CONTEXT_GEN_H
+
+/**
+ * Context Generations (hot certificate and key reload)
+ *
+ * A context must not be reconfigured while sessions are created from it, so
+ * a certificate rotation builds a whole new context - a generation - and
+ * swaps it in, read-copy-update style:
+ *
+ * - A build function supplied by the caller creates and configures the
+ *   context (certificate, key, priorities, tickets, ...). It runs on the
+ *   reloading thread - the watcher, or the caller of context_gen_reload() -
+ *   never on a connection's path.
+ * - The new generation is published with one atomic pointer exchange.
+ *   Sessions created afterwards use it; running sessions hold a reference to
+ *   the generation they were created from, which is freed with the last of
+ *   them (see tls_context_free()).
+ * - Getting the current generation never waits: it is a few atomic
+ *   operations and no lock. Only the reloading thread waits, for a grace
+ *   period in which connection threads that loaded the old pointer take
+ *   their reference - nanoseconds, as no reader sleeps in between.
+ *
+ * Watching:
+ *   With watch paths and a poll interval, a watcher thread stat()s the files
+ *   (certificate, key, CA bundle, ...) and builds a new generation when any
+ *   of them changed. A build that fails - say the certificate was replaced
+ *   and the key not yet - keeps the current generation and is retried when
+ *   the files change again, so replace the key first, or both with rename().
+ *
+ * Usage:
+ *   static tls_context_t *build(void *userdata) {
+ *       tls_context_t *ctx = tls_context_new(true, false);
+ *       if (ctx != nullptr && (tls_context_set_cert_file(ctx, CERT) != TLS_E_SUCCESS ||
+ *                              tls_context_set_key_file(ctx, KEY) != TLS_E_SUCCESS)) {
+ *           tls_context_free(ctx);
+ *           ctx = nullptr;
+ *       }
+ *       return ctx;
+ *   }
+ *
+ *   context_gen_config_t config = {
+ *       .build = build,
+ *       .watch = {CERT, KEY},
+ *       .poll_interval_ms = 1000,
+ *   };
+ *   context_gen_t *gen = context_gen_new(&config);
+ *   // ... per connection ...
+ *   tls_session_t *session = context_gen_session_new(gen);
+ *   // ... on shutdown ...
+ *   context_gen_free(gen);
+ */
+
+#include "tls_abstract.h"
+#include <time.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+/* ============================================================================
+ * Configuration Constants
+ * ============================================================================ */
+
+constexpr size_t CONTEXT_GEN_MAX_WATCH = 4;     // Watched files per holder
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/**
+ * Context generation holder (opaque)
+ */
+typedef struct context_gen context_gen_t;
+
+/**
+ * Build a new generation
+ *
+ * @param userdata User data from the configuration
+ * @return Configured context (its reference passes to the holder), nullptr
+ *         on failure
+ */
+typedef tls_context_t* (*context_gen_build_func_t)(void *userdata);
+
+/**
+ * A generation was replaced (or the holder freed)
+ *
+ * Called on the reloading thread before the holder drops its reference, to
+ * undo what the build function set up outside the context (for example
+ * ticket_keys_detach()). Sessions may still be using @p ctx.
+ */
+typedef void (*context_gen_retire_func_t)(void *userdata, tls_context_t *ctx);
+
+/**
+ * Holder configuration
+ */
+typedef struct {
+    context_gen_build_func_t build;
+    context_gen_retire_func_t retire;           // Optional
+    void *userdata;
+    const char *watch[CONTEXT_GEN_MAX_WATCH];   // Files to watch (copied), unused = nullptr
+    unsigned int poll_interval_ms;              // Watcher period, 0 = no watcher thread
+} context_gen_config_t;
+
+/**
+ * Holder statistics
+ */
+typedef struct {
+    uint64_t generation;    // Generations published, 1 for the initial one
+    uint64_t failures;      // Builds that failed (current generation kept)
+    int last_error;         // errno of the last failure, 0 if none yet
+    time_t loaded_at;       // When the current generation was published
+    uint64_t max_grace_ns;  // Longest wait for readers of a replaced generation
+} context_gen_stats_t;
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+/**
+ * Create a holder and build its first generation
+ *
+ * @param config Holder configuration
+ * @return Holder on success, nullptr on failure (errno = EINVAL for invalid
+ *         configuration, ECANCELED if the build function failed, or the
+ *         errno of a failed stat() of a watched file)
+ */
+[[nodiscard]] context_gen_t* context_gen_new(const context_gen_config_t *config);
+
+/**
+ * Stop the watcher and drop the current generation
+ *
+ * Sessions still running keep their generation until they are freed.
+ *
+ * @param gen Holder
+ */
+void context_gen_free(context_gen_t *gen);
+
+/* ============================================================================
+ * Connections
+ * ============================================================================ */
+
+/**
+ * Get the current generation
+ *
+ * @param gen Holder
+ * @return Context with a reference for the caller (release it with
+ *         tls_context_free()), nullptr if @p gen is nullptr
+ *
+ * Note: Thread-safe and wait-free for readers; may run concurrently with a
+ *       reload.
+ */
+[[nodiscard]] tls_context_t* context_gen_acquire(context_gen_t *gen);
+
+/**
+ * Create a session on the current generation
+ *
+ * @param gen Holder
+ * @return Session pinned to the generation current at the call, nullptr on
+ *         failure
+ *
+ * Note: Thread-safe.
+ */
+[[nodiscard]] tls_session_t* context_gen_session_new(context_gen_t *gen);
+
+/* ============================================================================
+ * Reloading
+ * ============================================================================ */
+
+/**
+ * Publish a context built by the caller
+ *
+ * The holder takes over the caller's reference to @p ctx; the generation it
+ * replaces is retired once readers are past it.
+ *
+ * @param gen Holder
+ * @param ctx Configured context
+ * @return 0 on success, -1 on invalid parameters (errno = EINVAL)
+ */
+int context_gen_publish(context_gen_t *gen, tls_context_t *ctx);
+
+/**
+ * Build and publish a new generation now
+ *
+ * What the watcher does when a watched file changed, for callers without a
+ * watcher (or with a SIGHUP handler that defers to a worker).
+ *
+ * @param gen Holder
+ * @return 0 on success, -1 on failure (errno = ECANCELED if the build
+ *         function failed; the current generation stays in place)
+ */
+int context_gen_reload(context_gen_t *gen);
+
+/**
+ * Get holder statistics
+ *
+ * @param gen Holder
+ * @param stats Output statistics
+ */
+void context_gen_get_stats(context_gen_t *gen, context_gen_stats_t *stats);
+
+#endif // WOLFGUARD_CONTEXT_GEN_H
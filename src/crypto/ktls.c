@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE  // For SOL_TLS, TCP_ULP, explicit_bzero()
+
+#include "ktls.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#if defined(__linux__) && __has_include(<linux/tls.h>)
+#define KTLS_SUPPORTED 1
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#endif
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+constexpr uint8_t ALERT_LEVEL_WARNING = 1;
+constexpr uint8_t ALERT_CLOSE_NOTIFY = 0;
+
+[[nodiscard]] int ktls_map_errno(int err, bool sending) {
+    switch (err) {
+        case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+        case EWOULDBLOCK:
+#endif
+            return TLS_E_AGAIN;
+        case EINTR:
+            return TLS_E_INTERRUPTED;
+        case EBADMSG:
+            return TLS_E_DECRYPTION_FAILED;
+        case ECONNABORTED:
+            return TLS_E_FATAL_ALERT_RECEIVED;
+        case ENOMSG:
+            return TLS_E_UNEXPECTED_MESSAGE;
+        default:
+            return sending ? TLS_E_PUSH_ERROR : TLS_E_PULL_ERROR;
+    }
+}
+
+#ifdef KTLS_SUPPORTED
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+/* ============================================================================
+ * Key Installation
+ * ============================================================================ */
+
+[[nodiscard]] int ktls_attach(int fd) {
+    static const char ulp[] = "tls";
+    return setsockopt(fd, IPPROTO_TCP, TCP_ULP, ulp, sizeof(ulp));
+}
+
+[[nodiscard]] int ktls_set_keys(int fd, bool tx, const ktls_keys_t *keys) {
+    if (keys == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    union {
+        struct tls12_crypto_info_aes_gcm_128 aes128;
+        struct tls12_crypto_info_aes_gcm_256 aes256;
+        struct tls12_crypto_info_chacha20_poly1305 chacha;
+    } info;
+    memset(&info, 0, sizeof(info));
+
+    uint16_t version = keys->tls13 ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+    socklen_t size;
+
+    // GCM nonce = 4-byte salt || 8 bytes. TLS 1.2 sends those 8 bytes with
+    // each record (the kernel counts them up from the sequence number);
+    // TLS 1.3 takes them from the IV and XORs in the sequence number.
+    switch (keys->cipher) {
+        case KTLS_CIPHER_AES_128_GCM:
+            info.aes128.info.version = version;
+            info.aes128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+            memcpy(info.aes128.key, keys->key, sizeof(info.aes128.key));
+            memcpy(info.aes128.salt, keys->iv, sizeof(info.aes128.salt));
+            memcpy(info.aes128.iv, keys->tls13 ? keys->iv + 4 : keys->seq, sizeof(info.aes128.iv));
+            memcpy(info.aes128.rec_seq, keys->seq, sizeof(info.aes128.rec_seq));
+            size = sizeof(info.aes128);
+            break;
+        case KTLS_CIPHER_AES_256_GCM:
+            info.aes256.info.version = version;
+            info.aes256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+            memcpy(info.aes256.key, keys->key, sizeof(info.aes256.key));
+            memcpy(info.aes256.salt, keys->iv, sizeof(info.aes256.salt));
+            memcpy(info.aes256.iv, keys->tls13 ? keys->iv + 4 : keys->seq, sizeof(info.aes256.iv));
+            memcpy(info.aes256.rec_seq, keys->seq, sizeof(info.aes256.rec_seq));
+            size = sizeof(info.aes256);
+            break;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case KTLS_CIPHER_CHACHA20_POLY1305:
+            // Same nonce construction in TLS 1.2 (RFC 7905) and TLS 1.3
+            info.chacha.info.version = version;
+            info.chacha.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+            memcpy(info.chacha.key, keys->key, sizeof(info.chacha.key));
+            memcpy(info.chacha.iv, keys->iv, sizeof(info.chacha.iv));
+            memcpy(info.chacha.rec_seq, keys->seq, sizeof(info.chacha.rec_seq));
+            size = sizeof(info.chacha);
+            break;
+#endif
+        default:
+            errno = ENOTSUP;
+            return -1;
+    }
+
+    int ret = setsockopt(fd, SOL_TLS, tx ? TLS_TX : TLS_RX, &info, size);
+    int saved_errno = errno;
+    explicit_bzero(&info, sizeof(info));
+    errno = saved_errno;
+    return ret;
+}
+
+/* ============================================================================
+ * Record I/O
+ * ============================================================================ */
+
+[[nodiscard]] ssize_t ktls_sendv(int fd, uint8_t record_type,
+                                 const struct iovec *iov, int iovcnt, int flags) {
+    struct msghdr msg = {
+        .msg_iov = (struct iovec *)iov,
+        .msg_iovlen = (size_t)(iovcnt < KTLS_MAX_IOV ? iovcnt : KTLS_MAX_IOV),
+    };
+    union {
+        struct cmsghdr align;
+        uint8_t buf[CMSG_SPACE(sizeof(uint8_t))];
+    } control;
+
+    // Application data needs no control message
+    if (record_type != KTLS_RECORD_APPLICATION_DATA) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_TLS;
+        cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+        *CMSG_DATA(cmsg) = record_type;
+    }
+
+    return sendmsg(fd, &msg, flags | MSG_NOSIGNAL);
+}
+
+[[nodiscard]] ssize_t ktls_recvv(int fd, const struct iovec *iov, int iovcnt, int flags) {
+    for (;;) {
+        union {
+            struct cmsghdr align;
+            uint8_t buf[CMSG_SPACE(sizeof(uint8_t))];
+        } control;
+        struct msghdr msg = {
+            .msg_iov = (struct iovec *)iov,
+            .msg_iovlen = (size_t)(iovcnt < KTLS_MAX_IOV ? iovcnt : KTLS_MAX_IOV),
+            .msg_control = control.buf,
+            .msg_controllen = sizeof(control.buf),
+        };
+
+        // Without room for the record type the kernel fails control
+        // records with EIO, so there is always a control buffer
+        ssize_t n = recvmsg(fd, &msg, flags);
+        if (n <= 0) {
+            return n;
+        }
+
+        uint8_t record_type = KTLS_RECORD_APPLICATION_DATA;
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg != nullptr && cmsg->cmsg_level == SOL_TLS &&
+            cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+            record_type = *CMSG_DATA(cmsg);
+        }
+        if (record_type == KTLS_RECORD_APPLICATION_DATA) {
+            return n;
+        }
+
+        // One control record per call; gather its first two bytes
+        uint8_t head[2] = {0};
+        size_t copied = 0;
+        for (int i = 0; i < iovcnt && copied < sizeof(head) && copied < (size_t)n; i++) {
+            size_t len = iov[i].iov_len;
+            if (len > sizeof(head) - copied) {
+                len = sizeof(head) - copied;
+            }
+            memcpy(head + copied, iov[i].iov_base, len);
+            copied += len;
+        }
+
+        if (record_type == KTLS_RECORD_ALERT && copied == sizeof(head)) {
+            if (head[1] == ALERT_CLOSE_NOTIFY) {
+                return 0;
+            }
+            if (head[0] == ALERT_LEVEL_WARNING) {
+                continue;
+            }
+            errno = ECONNABORTED;
+            return -1;
+        }
+
+        errno = record_type == KTLS_RECORD_ALERT ? ECONNABORTED : ENOMSG;
+        return -1;
+    }
+}
+
+[[nodiscard]] ssize_t ktls_sendfile(int fd, int in_fd, off_t *offset, size_t count) {
+    return sendfile(fd, in_fd, offset, count);
+}
+
+#else // !KTLS_SUPPORTED
+
+[[nodiscard]] int ktls_attach(int fd) {
+    (void)fd;
+    errno = ENOTSUP;
+    return -1;
+}
+
+[[nodiscard]] int ktls_set_keys(int fd, bool tx, const ktls_keys_t *keys) {
+    (void)fd;
+    (void)tx;
+    (void)keys;
+    errno = ENOTSUP;
+    return -1;
+}
+
+[[nodiscard]] ssize_t ktls_sendv(int fd, uint8_t record_type,
+                                 const struct iovec *iov, int iovcnt, int flags) {
+    (void)fd;
+    (void)record_type;
+    (void)iov;
+    (void)iovcnt;
+    (void)flags;
+    errno = ENOTSUP;
+    return -1;
+}
+
+[[nodiscard]] ssize_t ktls_recvv(int fd, const struct iovec *iov, int iovcnt, int flags) {
+    (void)fd;
+    (void)iov;
+    (void)iovcnt;
+    (void)flags;
+    errno = ENOTSUP;
+    return -1;
+}
+
+[[nodiscard]] ssize_t ktls_sendfile(int fd, int in_fd, off_t *offset, size_t count) {
+    (void)fd;
+    (void)in_fd;
+    (void)offset;
+    (void)count;
+    errno = ENOTSUP;
+    return -1;
+}
+
+#endif // KTLS_SUPPORTED
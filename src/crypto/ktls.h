@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_KTLS_H
+#define WOLFGUARD_KTLS_H
+
+/**
+ * Kernel TLS (kTLS) Offload (internal)
+ *
+ * Backend-independent socket plumbing behind tls_context_set_ktls(). After
+ * the TLS library has finished the handshake, the backend exports the
+ * negotiated traffic keys and sequence numbers into a ktls_keys_t and hands
+ * them to the kernel:
+ *
+ *   ktls_attach(fd)                   setsockopt(TCP_ULP, "tls")
+ *   ktls_set_keys(fd, true, &tx)      setsockopt(SOL_TLS, TLS_TX)
+ *   ktls_set_keys(fd, false, &rx)     setsockopt(SOL_TLS, TLS_RX)
+ *
+ * From then on application data in that direction is plain socket I/O: the
+ * kernel builds and encrypts records on send()/sendfile() and decrypts them
+ * on recv(). Control records (alerts, post-handshake messages) travel with
+ * a TLS_SET_RECORD_TYPE / TLS_GET_RECORD_TYPE control message.
+ *
+ * Supported: TLS 1.2 and TLS 1.3 over TCP with AES-128-GCM, AES-256-GCM or
+ * ChaCha20-Poly1305. A socket with the "tls" ULP attached but no keys set
+ * behaves like a plain TCP socket, so every failure here leaves the
+ * connection usable with user-space records.
+ *
+ * All functions return -1 and set errno on failure (ENOTSUP on systems
+ * without kTLS).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "tls_abstract.h"
+
+/* Record content types (RFC 8446 Section 5.1) */
+constexpr uint8_t KTLS_RECORD_ALERT = 21;
+constexpr uint8_t KTLS_RECORD_HANDSHAKE = 22;
+constexpr uint8_t KTLS_RECORD_APPLICATION_DATA = 23;
+
+/* Most buffers one ktls_sendv() / ktls_recvv() passes to the kernel */
+constexpr int KTLS_MAX_IOV = 1'024;        // UIO_MAXIOV
+
+typedef enum {
+    KTLS_CIPHER_AES_128_GCM,
+    KTLS_CIPHER_AES_256_GCM,
+    KTLS_CIPHER_CHACHA20_POLY1305,
+} ktls_cipher_t;
+
+/**
+ * Traffic keys of one direction, as negotiated by the TLS library
+ */
+typedef struct {
+    bool tls13;                 // TLS 1.3 (else TLS 1.2)
+    ktls_cipher_t cipher;
+    uint8_t key[32];            // 16 bytes used for AES-128-GCM
+    uint8_t iv[12];             // TLS 1.2 AES-GCM: 4-byte salt; else full IV
+    uint8_t seq[8];             // Sequence number of the next record, big endian
+} ktls_keys_t;
+
+/**
+ * Attach the kernel TLS upper-layer protocol to a connected TCP socket
+ *
+ * @param fd Connected TCP socket
+ * @return 0 on success, -1 on failure (ENOENT: kernel without the tls module)
+ */
+[[nodiscard]] int ktls_attach(int fd);
+
+/**
+ * Install the traffic keys of one direction
+ *
+ * @param fd Socket with the "tls" ULP attached
+ * @param tx true for the send direction, false for receive
+ * @param keys Keys, IV and next sequence number
+ * @return 0 on success, -1 on failure (the direction stays in user space)
+ */
+[[nodiscard]] int ktls_set_keys(int fd, bool tx, const ktls_keys_t *keys);
+
+/**
+ * Send application data, or one control record, through kernel TLS
+ *
+ * @param fd Socket with TLS_TX installed
+ * @param record_type KTLS_RECORD_APPLICATION_DATA, or the control record type
+ * @param iov Buffers to send, in order (at most KTLS_MAX_IOV are used)
+ * @param iovcnt Number of buffers
+ * @param flags send() flags (MSG_NOSIGNAL is always added)
+ * @return Bytes sent, -1 on failure
+ */
+[[nodiscard]] ssize_t ktls_sendv(int fd, uint8_t record_type,
+                                 const struct iovec *iov, int iovcnt, int flags);
+
+/**
+ * Receive application data through kernel TLS
+ *
+ * Control records are consumed here: close_notify reads as end of file,
+ * warning alerts are skipped, anything else fails with ECONNABORTED (a
+ * fatal alert) or ENOMSG (a post-handshake message the kernel cannot
+ * process, e.g. a TLS 1.3 KeyUpdate). A record that fails authentication
+ * fails with EBADMSG.
+ *
+ * @param fd Socket with TLS_RX installed
+ * @param iov Buffers to fill, in order (at most KTLS_MAX_IOV are used)
+ * @param iovcnt Number of buffers
+ * @param flags recv() flags
+ * @return Bytes received, 0 at end of stream, -1 on failure
+ */
+[[nodiscard]] ssize_t ktls_recvv(int fd, const struct iovec *iov, int iovcnt, int flags);
+
+/**
+ * Send a file through kernel TLS without copying it to user space
+ *
+ * @param fd Socket with TLS_TX installed
+ * @param in_fd File to read from
+ * @param offset File offset to read from, advanced; nullptr for the file position
+ * @param count Bytes to send
+ * @return Bytes sent, -1 on failure
+ */
+[[nodiscard]] ssize_t ktls_sendfile(int fd, int in_fd, off_t *offset, size_t count);
+
+/**
+ * Map a ktls_* errno to a TLS_E_* code
+ *
+ * @param err errno after a failed call
+ * @param sending true for send paths, false for receive paths
+ * @return Negative TLS_E_* error code
+ */
+[[nodiscard]] int ktls_map_errno(int err, bool sending);
+
+#endif // WOLFGUARD_KTLS_H
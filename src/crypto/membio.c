@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "membio.h"
+#include "allocator.h"
+#include <errno.h>
+#include <string.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+[[nodiscard]] int membio_write(membio_t *bio, const void *data, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+
+    if (len > bio->capacity - bio->tail) {
+        size_t pending = membio_pending(bio);
+        if (len > SIZE_MAX - pending) {
+            errno = ENOMEM;
+            return -1;
+        }
+
+        size_t needed = pending + len;
+        if (needed > bio->capacity) {
+            size_t capacity = bio->capacity > 0 ? bio->capacity : MEMBIO_MIN_CAPACITY;
+            while (capacity < needed) {
+                capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+            }
+
+            // Only the unread bytes move; realloc() would copy the consumed
+            // prefix as well
+            uint8_t *grown = allocator_malloc(capacity);
+            if (grown == nullptr) {
+                errno = ENOMEM;
+                return -1;
+            }
+            if (pending > 0) {
+                memcpy(grown, bio->data + bio->head, pending);
+            }
+            allocator_free(bio->data);
+            bio->data = grown;
+            bio->capacity = capacity;
+        } else {
+            memmove(bio->data, bio->data + bio->head, pending);
+        }
+        bio->head = 0;
+        bio->tail = pending;
+    }
+
+    memcpy(bio->data + bio->tail, data, len);
+    bio->tail += len;
+    return 0;
+}
+
+size_t membio_read(membio_t *bio, void *out, size_t len) {
+    size_t pending = membio_pending(bio);
+    if (len > pending) {
+        len = pending;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    memcpy(out, bio->data + bio->head, len);
+    bio->head += len;
+    if (bio->head == bio->tail) {
+        // Empty: the next write starts at the front again
+        bio->head = 0;
+        bio->tail = 0;
+    }
+    return len;
+}
+
+void membio_clear(membio_t *bio) {
+    bio->head = 0;
+    bio->tail = 0;
+}
+
+void membio_free(membio_t *bio) {
+    allocator_free(bio->data);
+    *bio = (membio_t){0};
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_MEMBIO_H
+#define WOLFGUARD_MEMBIO_H
+
+/**
+ * Memory BIO Buffers (internal)
+ *
+ * Byte queues behind tls_session_set_memory_bio(). Each session in memory-BIO
+ * mode owns two of them: ciphertext fed by the application, which the TLS
+ * library's pull callback consumes, and ciphertext the push callback
+ * produces, which the application drains.
+ *
+ * A buffer is one linear allocation with a read offset. Reading it empty
+ * rewinds both offsets, and a write that does not fit behind the data moves
+ * the data to the front before growing, so once a buffer has reached the
+ * largest backlog of its connection it is reused without allocating.
+ *
+ * Not thread-safe; a buffer belongs to one session.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tls_abstract.h"
+
+/* Capacity of the first allocation: one full TLS record plus overhead */
+constexpr size_t MEMBIO_MIN_CAPACITY = 18'432;
+
+typedef struct {
+    uint8_t *data;
+    size_t head;                // First unread byte
+    size_t tail;                // End of the queued bytes
+    size_t capacity;
+} membio_t;
+
+/**
+ * Append bytes, growing the buffer if needed
+ *
+ * @return 0 on success, -1 on failure (errno = ENOMEM; nothing appended)
+ */
+[[nodiscard]] int membio_write(membio_t *bio, const void *data, size_t len);
+
+/**
+ * Consume up to @p len bytes from the front
+ *
+ * @return Bytes copied to @p out (0 if the buffer is empty)
+ */
+size_t membio_read(membio_t *bio, void *out, size_t len);
+
+/**
+ * Bytes queued and not yet read
+ */
+[[nodiscard]] static inline size_t membio_pending(const membio_t *bio) {
+    return bio->tail - bio->head;
+}
+
+/**
+ * Drop all queued bytes, keeping the allocation
+ */
+void membio_clear(membio_t *bio);
+
+/**
+ * Release the allocation (the buffer can be reused afterwards)
+ */
+void membio_free(membio_t *bio);
+
+#endif // WOLFGUARD_MEMBIO_H
@@ -16,101 +16,401 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime(), strdup(), posix_madvise()
+#define _DEFAULT_SOURCE          // For explicit_bzero()
+
 #include "session_cache.h"
+#include "session_cache_shm.h"
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/stat.h>
 
 // C23 standard compliance
 #if __STDC_VERSION__ < 202000L
 #error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
 #endif
 
+// Linux tick-granularity clock (vDSO read, no syscall); plain monotonic elsewhere
+#ifndef CLOCK_MONOTONIC_COARSE
+#define CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC
+#endif
+
 /* ============================================================================
  * Internal Data Structures
  * ============================================================================ */
 
 /**
- * Cache entry (hash table node + LRU list node)
+ * Cache entry (eviction queue node, referenced from a hash table slot)
+ *
+ * Variable length: the fixed header is followed by exactly session_id_size
+ * ID bytes, session_data_size data bytes and remote_addr_len address bytes,
+ * so a typical resumable session costs a few hundred bytes instead of a full
+ * tls_session_cache_entry_t. Entries live in slab size classes (see below).
  */
 typedef struct cache_entry {
-    // Session data
-    tls_session_cache_entry_t session;
+    // Cached hash of session_id (selects shard and home slot)
+    uint64_t hash;
+
+    // Eviction queue linkage (doubly linked, see cache_queue_t)
+    struct cache_entry *queue_next;
+    struct cache_entry *queue_prev;
+
+    // Timing wheel linkage (wheel_pprev == nullptr when not scheduled)
+    struct cache_entry *wheel_next;
+    struct cache_entry **wheel_pprev;
+
+    // Coarse clock ticks: last access, first tick at which entry is expired
+    int64_t last_access;
+    int64_t expire_tick;
+
+    // Session metadata
+    time_t expiration;
+    uint16_t session_id_size;
+    uint16_t session_data_size;
+    uint8_t slab_class;
+    uint8_t queue;              // QUEUE_MAIN, QUEUE_SMALL or QUEUE_DETACHED
+    uint8_t freq;               // S3-FIFO access counter (0..S3FIFO_MAX_FREQ)
+    uint8_t leases;             // Outstanding session_cache_borrow() views
+    socklen_t remote_addr_len;
+
+    // session_id | session_data | remote_addr
+    alignas(8) uint8_t bytes[];
+} cache_entry_t;
 
-    // Hash table linkage (chaining for collisions)
-    struct cache_entry *hash_next;
-    struct cache_entry *hash_prev;
+static inline const uint8_t* entry_session_id(const cache_entry_t *entry) {
+    return entry->bytes;
+}
 
-    // LRU list linkage (doubly linked)
-    struct cache_entry *lru_next;
-    struct cache_entry *lru_prev;
+static inline const uint8_t* entry_session_data(const cache_entry_t *entry) {
+    return entry->bytes + entry->session_id_size;
+}
 
-    // Timestamp for LRU tracking
-    time_t last_access;
-} cache_entry_t;
+static inline const uint8_t* entry_remote_addr(const cache_entry_t *entry) {
+    return entry->bytes + entry->session_id_size + entry->session_data_size;
+}
 
 /**
- * Session cache (hash table + LRU list)
+ * Bytes needed to store a session as a cache entry
  */
-struct session_cache {
-    // Configuration
+static inline size_t entry_size_for(const tls_session_cache_entry_t *session) {
+    return sizeof(cache_entry_t) + session->session_id_size +
+           session->session_data_size + session->remote_addr_len;
+}
+
+/* ============================================================================
+ * Slab Size Classes
+ * ============================================================================ */
+
+/**
+ * Entry size classes (bytes, multiples of 16)
+ *
+ * Roughly 1.25x apart so internal fragmentation stays below ~25%. The largest
+ * class fits a session with maximum-size ID, data and address.
+ */
+static const uint16_t slab_class_sizes[] = {
+    96, 128, 160, 192, 256, 320, 384, 512, 640, 768,
+    1'024, 1'280, 1'536, 2'048, 2'560, 3'072, 4'096, 4'608,
+};
+
+constexpr size_t SLAB_CLASS_COUNT = sizeof(slab_class_sizes) / sizeof(slab_class_sizes[0]);
+
+// Target slab page size (smaller for shards that cannot fill a full page)
+constexpr size_t SLAB_PAGE_SIZE = 64 * 1'024;
+
+static_assert(sizeof(cache_entry_t) + TLS_MAX_SESSION_ID_SIZE + TLS_MAX_SESSION_DATA_SIZE +
+              sizeof(struct sockaddr_storage) <= 4'608,
+              "largest slab class must fit a maximum-size session");
+
+/**
+ * Free block in a slab class (overlays a released entry)
+ */
+typedef struct slab_block {
+    struct slab_block *next;
+} slab_block_t;
+
+/**
+ * Slab page (carved into equally sized blocks of one class)
+ */
+typedef struct slab_page {
+    struct slab_page *next;
+    size_t size;    // Total allocation size, header included
+    alignas(16) uint8_t mem[];
+} slab_page_t;
+
+/**
+ * Per-class allocator state
+ */
+typedef struct {
+    slab_block_t *free_list;    // Released blocks
+    uint8_t *bump;              // Next never-used block in the newest page
+    size_t bump_left;           // Never-used blocks left in the newest page
+} slab_class_t;
+
+/**
+ * Eviction queue (head = newest / most recently used, tail = next victim)
+ */
+typedef struct {
+    cache_entry_t *head;
+    cache_entry_t *tail;
+    size_t count;
+} cache_queue_t;
+
+// Queue an entry is linked on (cache_entry_t.queue)
+constexpr uint8_t QUEUE_MAIN = 0;
+constexpr uint8_t QUEUE_SMALL = 1;
+constexpr uint8_t QUEUE_DETACHED = 2;   // Dropped while leased, freed on last release
+
+// S3-FIFO tuning: small queue share of capacity (percent), counter ceiling
+constexpr size_t S3FIFO_SMALL_PERCENT = 10;
+constexpr uint8_t S3FIFO_MAX_FREQ = 3;
+
+/**
+ * Hash table slot (open addressing)
+ *
+ * The full hash is kept next to the entry pointer so that probing compares
+ * hashes inside the slot array and only dereferences the entry (a cold cache
+ * line) on a probable match. An empty slot has entry == nullptr.
+ */
+typedef struct {
+    uint64_t hash;
+    cache_entry_t *entry;
+} cache_slot_t;
+
+// Cache line size used to keep shards from sharing lines (false sharing)
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Maximum hash table load factor (numerator / 8) before the table grows
+constexpr size_t SLOT_LOAD_FACTOR_EIGHTHS = 7;
+
+// Expiry timing wheel: 4 levels of 64 one-second slots (~194 days of range)
+constexpr unsigned int WHEEL_LEVELS = 4;
+constexpr unsigned int WHEEL_SLOT_BITS = 6;
+constexpr size_t WHEEL_SLOTS = (size_t)1 << WHEEL_SLOT_BITS;
+constexpr int64_t WHEEL_SPAN = (int64_t)1 << (WHEEL_SLOT_BITS * WHEEL_LEVELS);
+
+// expire_tick of sessions without an expiration time
+constexpr int64_t TICK_NEVER = INT64_MAX;
+
+// Negative filter: blocked counting Bloom filter. A session uses
+// FILTER_HASHES counters within one cache-line block, and there are at least
+// FILTER_COUNTERS_PER_ENTRY counters per unit of shard capacity (about 1%
+// false positives when full).
+constexpr unsigned int FILTER_HASHES = 4;
+constexpr size_t FILTER_COUNTERS_PER_ENTRY = 12;
+constexpr size_t FILTER_BLOCK = CACHE_LINE_SIZE;    // One-byte counters
+constexpr unsigned int FILTER_BLOCK_BITS = 6;       // log2(FILTER_BLOCK)
+
+/**
+ * Cache shard (hash table + eviction queues, independently locked)
+ *
+ * Aligned to a cache line so that the mutex and hot counters of one shard
+ * never share a line with a neighbouring shard.
+ */
+typedef struct session_cache_shard {
+    // Thread safety
+    alignas(CACHE_LINE_SIZE) pthread_mutex_t mutex;
+
+    // Share of the total cache capacity
     size_t capacity;
-    unsigned int timeout_secs;
+    session_cache_policy_t policy;
+
+    // Hash table (Robin Hood open addressing, slot_mask + 1 slots)
+    cache_slot_t *slots;
+    size_t slot_mask;
 
-    // Hash table (array of bucket heads)
-    cache_entry_t *hash_table[SESSION_CACHE_HASH_BUCKETS];
+    // Eviction queues. LRU uses main_queue only; S3-FIFO admits new entries
+    // to small_queue (probation) and promotes reused ones to main_queue.
+    cache_queue_t main_queue;
+    cache_queue_t small_queue;
+    size_t small_target;
 
-    // LRU list (head = most recent, tail = least recent)
-    cache_entry_t *lru_head;
-    cache_entry_t *lru_tail;
+    // S3-FIFO ghost set: hashes recently evicted from small_queue
+    // (direct-mapped, so collisions just forget older ghosts)
+    uint64_t *ghost;
+    size_t ghost_mask;
+
+    // Hierarchical timing wheel (wheel_time = last processed tick)
+    int64_t wheel_time;
+    cache_entry_t *wheel[WHEEL_LEVELS][WHEEL_SLOTS];
 
     // Current state
     size_t count;
+    size_t leases;              // Outstanding leases on this shard's entries
+
+    // Releases native objects referenced by session data (optional)
+    session_cache_free_data_fn free_data;
+
+    // Negative filter (optional): counters are written under the mutex and
+    // read without it; saturated counters stick until the next rebuild
+    _Atomic uint8_t *filter;
+    size_t filter_mask;
+    bool filter_saturated;
+
+    // Entry allocator (pages are released on clear/free)
+    slab_class_t slab[SLAB_CLASS_COUNT];
+    slab_page_t *slab_pages;
+    size_t slab_bytes;          // Bytes held in slab pages
+    size_t entry_bytes;         // Bytes of slab blocks holding live entries
 
     // Statistics
     uint64_t hits;
     uint64_t misses;
     uint64_t evictions;
     uint64_t expirations;
+    uint64_t filter_false_positives;
+    _Atomic uint64_t filter_rejects;    // Counted without the mutex
+} cache_shard_t;
 
-    // Thread safety
-    pthread_mutex_t mutex;
+/**
+ * Session cache (array of shards)
+ */
+struct session_cache {
+    // Configuration
+    size_t capacity;
+    unsigned int timeout_secs;
+
+    // SipHash key (random per cache, see hash_session_id)
+    uint64_t hash_key[2];
+
+    // Wall-clock seconds minus coarse monotonic seconds at creation
+    int64_t clock_offset;
+
+    // Shards (shard_count is a power of 2, shard_mask = shard_count - 1)
+    size_t shard_count;
+    size_t shard_mask;
+    cache_shard_t *shards;
+
+    // Shared-memory backend (session_cache_new_shared), nullptr otherwise
+    shm_cache_t *shm;
+
+    // Session data release hook (session_cache_config_t.free_data)
+    session_cache_free_data_fn free_data;
+
+    // Snapshot file (session_cache_set_snapshot), nullptr if disabled
+    char *snapshot_path;
+    unsigned int snapshot_interval;
+
+    // Periodic snapshot thread (its lock and condition exist while it runs)
+    pthread_t snapshot_thread;
+    pthread_mutex_t snapshot_lock;
+    pthread_cond_t snapshot_wake;
+    bool snapshot_running;
+    bool snapshot_stopping;
 };
 
+// Snapshot / Restore section below
+static void snapshot_thread_stop(session_cache_t *cache);
+
 /* ============================================================================
- * Hash Function (FNV-1a)
+ * Hash Function (SipHash-1-3)
  * ============================================================================ */
 
+static inline uint64_t rotl64(uint64_t x, unsigned int b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+static inline void sip_round(uint64_t v[4]) {
+    v[0] += v[1]; v[1] = rotl64(v[1], 13); v[1] ^= v[0]; v[0] = rotl64(v[0], 32);
+    v[2] += v[3]; v[3] = rotl64(v[3], 16); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = rotl64(v[3], 21); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = rotl64(v[1], 17); v[1] ^= v[2]; v[2] = rotl64(v[2], 32);
+}
+
+/**
+ * SipHash-1-3 with a 128-bit key, 64-bit output
+ *
+ * Words are loaded in host byte order.
+ */
+static uint64_t siphash13(const uint64_t key[2], const uint8_t *data, size_t size) {
+    uint64_t v[4] = {
+        key[0] ^ 0x736f6d6570736575ULL,
+        key[1] ^ 0x646f72616e646f6dULL,
+        key[0] ^ 0x6c7967656e657261ULL,
+        key[1] ^ 0x7465646279746573ULL,
+    };
+
+    size_t tail = size & 7;
+    const uint8_t *end = data + (size - tail);
+
+    for (const uint8_t *p = data; p != end; p += 8) {
+        uint64_t m;
+        memcpy(&m, p, sizeof(m));
+        v[3] ^= m;
+        sip_round(v);
+        v[0] ^= m;
+    }
+
+    uint64_t b = (uint64_t)size << 56;
+    for (size_t i = 0; i < tail; i++) {
+        b |= (uint64_t)end[i] << (8 * i);
+    }
+
+    v[3] ^= b;
+    sip_round(v);
+    v[0] ^= b;
+
+    v[2] ^= 0xFF;
+    sip_round(v);
+    sip_round(v);
+    sip_round(v);
+
+    return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
 /**
- * FNV-1a hash function for session IDs
+ * Keyed hash of a session ID
  *
- * Uses first 8 bytes of session_id for fast hashing.
- * FNV-1a is chosen for:
- * - Excellent avalanche properties
- * - Fast computation
- * - No patent restrictions
+ * Session IDs are chosen by the peer, so an unkeyed hash would let a client
+ * steer every ID into the same probe sequence. The whole ID is hashed (TLS
+ * 1.2 IDs can share long prefixes) with a random per-cache key. Hashes never
+ * leave the process (or the shared segment, which stores its key).
  *
+ * The low bits select the slot inside a shard and the high bits select the
+ * shard, so both indices stay independent.
+ *
+ * @param cache Cache (provides the key)
  * @param session_id Session ID bytes
  * @param session_id_size Length of session ID
- * @return Hash value (0 to SESSION_CACHE_HASH_BUCKETS-1)
+ * @return 64-bit hash value
  */
-static inline size_t hash_session_id(const uint8_t *session_id, size_t session_id_size) {
-    // FNV-1a constants
-    constexpr uint64_t FNV_OFFSET_BASIS = 14'695'981'039'346'656'037ULL;
-    constexpr uint64_t FNV_PRIME = 1'099'511'628'211ULL;
-
-    uint64_t hash = FNV_OFFSET_BASIS;
+static inline uint64_t hash_session_id(const session_cache_t *cache,
+                                       const uint8_t *session_id,
+                                       size_t session_id_size) {
+    return siphash13(cache->hash_key, session_id, session_id_size);
+}
 
-    // Hash first 8 bytes (or less if shorter)
-    size_t hash_len = (session_id_size < 8) ? session_id_size : 8;
-    for (size_t i = 0; i < hash_len; i++) {
-        hash ^= session_id[i];
-        hash *= FNV_PRIME;
+/**
+ * Generate a random SipHash key for a new cache
+ *
+ * Falls back to a time/address mix if the kernel RNG is unavailable; the key
+ * only protects against hash flooding, it does not protect any secret.
+ */
+static void hash_key_init(session_cache_t *cache) {
+    if (getrandom(cache->hash_key, sizeof(cache->hash_key), 0) ==
+        (ssize_t)sizeof(cache->hash_key)) {
+        return;
     }
 
-    // Map to bucket index (fast modulo using power-of-2)
-    return hash & (SESSION_CACHE_HASH_BUCKETS - 1);
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    cache->hash_key[0] = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec;
+    cache->hash_key[1] = (uint64_t)(uintptr_t)cache ^ ((uint64_t)ts.tv_nsec << 21);
+}
+
+/**
+ * Select shard for a session ID hash
+ */
+static inline cache_shard_t* shard_for_hash(session_cache_t *cache, uint64_t hash) {
+    return &cache->shards[(size_t)(hash >> 32) & cache->shard_mask];
 }
 
 /**
@@ -125,336 +425,1322 @@ static inline bool session_id_equal(const uint8_t *id1, size_t len1,
 }
 
 /* ============================================================================
- * LRU List Operations
+ * Coarse Clock
  * ============================================================================ */
 
 /**
- * Remove entry from LRU list
+ * Current coarse monotonic time in seconds
+ *
+ * Expiry only needs one-second resolution, so the kernel's tick-cached clock
+ * is enough and keeps time lookups off the hot path.
  */
-static void lru_remove(session_cache_t *cache, cache_entry_t *entry) {
-    if (entry->lru_prev != nullptr) {
-        entry->lru_prev->lru_next = entry->lru_next;
-    } else {
-        // entry is head
-        cache->lru_head = entry->lru_next;
-    }
+static inline int64_t cache_clock_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (int64_t)ts.tv_sec;
+}
 
-    if (entry->lru_next != nullptr) {
-        entry->lru_next->lru_prev = entry->lru_prev;
-    } else {
-        // entry is tail
-        cache->lru_tail = entry->lru_prev;
+/**
+ * Convert a wall-clock expiration (as set by the TLS backends) to the first
+ * coarse tick at which the session counts as expired
+ *
+ * The offset is sampled once at cache creation, so later wall-clock steps do
+ * not shorten or extend cached sessions.
+ */
+static inline int64_t expire_tick_for(const session_cache_t *cache, time_t expiration) {
+    if (expiration <= 0) {
+        return TICK_NEVER;
     }
-
-    entry->lru_prev = nullptr;
-    entry->lru_next = nullptr;
+    return (int64_t)expiration - cache->clock_offset + 1;
 }
 
+/* ============================================================================
+ * Timing Wheel Operations
+ * ============================================================================ */
+
 /**
- * Add entry to front of LRU list (most recently used)
+ * Pick the wheel bucket for an expiry tick
+ *
+ * Level L holds entries due in [64^L, 64^(L+1)) ticks, indexed by the L-th
+ * 6-bit digit of the tick. Entries beyond the wheel range are parked in the
+ * top level and re-filed when that slot cascades.
  */
-static void lru_add_front(session_cache_t *cache, cache_entry_t *entry) {
-    entry->lru_next = cache->lru_head;
-    entry->lru_prev = nullptr;
+static cache_entry_t** wheel_bucket(cache_shard_t *shard, int64_t tick) {
+    int64_t delta = tick - shard->wheel_time;
+    if (delta >= WHEEL_SPAN) {
+        tick = shard->wheel_time + WHEEL_SPAN - 1;
+        delta = WHEEL_SPAN - 1;
+    }
 
-    if (cache->lru_head != nullptr) {
-        cache->lru_head->lru_prev = entry;
-    } else {
-        // First entry
-        cache->lru_tail = entry;
+    unsigned int level = 0;
+    while (level + 1 < WHEEL_LEVELS &&
+           delta >= ((int64_t)1 << (WHEEL_SLOT_BITS * (level + 1)))) {
+        level++;
     }
 
-    cache->lru_head = entry;
-    entry->last_access = time(nullptr);
+    size_t slot = (size_t)(tick >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1);
+    return &shard->wheel[level][slot];
 }
 
 /**
- * Move entry to front of LRU list (mark as recently used)
+ * Schedule entry expiry, no earlier than @p min_tick
  */
-static void lru_move_front(session_cache_t *cache, cache_entry_t *entry) {
-    if (cache->lru_head == entry) {
-        // Already at front
-        entry->last_access = time(nullptr);
+static void wheel_insert(cache_shard_t *shard, cache_entry_t *entry, int64_t min_tick) {
+    if (entry->expire_tick == TICK_NEVER) {
         return;
     }
 
-    lru_remove(cache, entry);
-    lru_add_front(cache, entry);
+    int64_t tick = entry->expire_tick > min_tick ? entry->expire_tick : min_tick;
+    cache_entry_t **bucket = wheel_bucket(shard, tick);
+
+    entry->wheel_next = *bucket;
+    entry->wheel_pprev = bucket;
+    if (*bucket != nullptr) {
+        (*bucket)->wheel_pprev = &entry->wheel_next;
+    }
+    *bucket = entry;
 }
 
 /**
- * Get least recently used entry (tail of LRU list)
+ * Unschedule entry (no-op if it has no expiry)
  */
-static cache_entry_t* lru_get_tail(session_cache_t *cache) {
-    return cache->lru_tail;
+static void wheel_remove(cache_entry_t *entry) {
+    if (entry->wheel_pprev == nullptr) {
+        return;
+    }
+
+    *entry->wheel_pprev = entry->wheel_next;
+    if (entry->wheel_next != nullptr) {
+        entry->wheel_next->wheel_pprev = entry->wheel_pprev;
+    }
+
+    entry->wheel_next = nullptr;
+    entry->wheel_pprev = nullptr;
 }
 
 /* ============================================================================
- * Hash Table Operations
+ * Eviction Queue Operations
  * ============================================================================ */
 
 /**
- * Find entry in hash table by session ID
+ * Remove entry from queue
  */
-static cache_entry_t* hash_find(session_cache_t *cache,
-                                  const uint8_t *session_id,
-                                  size_t session_id_size) {
-    size_t bucket = hash_session_id(session_id, session_id_size);
-    cache_entry_t *entry = cache->hash_table[bucket];
+static void queue_remove(cache_queue_t *queue, cache_entry_t *entry) {
+    if (entry->queue_prev != nullptr) {
+        entry->queue_prev->queue_next = entry->queue_next;
+    } else {
+        // entry is head
+        queue->head = entry->queue_next;
+    }
 
-    while (entry != nullptr) {
-        if (session_id_equal(entry->session.session_id,
-                             entry->session.session_id_size,
-                             session_id,
-                             session_id_size)) {
-            return entry;
-        }
-        entry = entry->hash_next;
+    if (entry->queue_next != nullptr) {
+        entry->queue_next->queue_prev = entry->queue_prev;
+    } else {
+        // entry is tail
+        queue->tail = entry->queue_prev;
     }
 
-    return nullptr;
+    entry->queue_prev = nullptr;
+    entry->queue_next = nullptr;
+    queue->count--;
 }
 
 /**
- * Insert entry into hash table
+ * Add entry to front of queue
  */
-static void hash_insert(session_cache_t *cache, cache_entry_t *entry) {
-    size_t bucket = hash_session_id(entry->session.session_id,
-                                      entry->session.session_id_size);
-
-    // Insert at head of bucket chain
-    entry->hash_next = cache->hash_table[bucket];
-    entry->hash_prev = nullptr;
+static void queue_push_front(cache_queue_t *queue, cache_entry_t *entry) {
+    entry->queue_next = queue->head;
+    entry->queue_prev = nullptr;
 
-    if (cache->hash_table[bucket] != nullptr) {
-        cache->hash_table[bucket]->hash_prev = entry;
+    if (queue->head != nullptr) {
+        queue->head->queue_prev = entry;
+    } else {
+        // First entry
+        queue->tail = entry;
     }
 
-    cache->hash_table[bucket] = entry;
+    queue->head = entry;
+    queue->count++;
 }
 
 /**
- * Remove entry from hash table
+ * Queue currently holding an entry
  */
-static void hash_remove(session_cache_t *cache, cache_entry_t *entry) {
-    size_t bucket = hash_session_id(entry->session.session_id,
-                                      entry->session.session_id_size);
-
-    if (entry->hash_prev != nullptr) {
-        entry->hash_prev->hash_next = entry->hash_next;
-    } else {
-        // entry is head of bucket
-        cache->hash_table[bucket] = entry->hash_next;
-    }
-
-    if (entry->hash_next != nullptr) {
-        entry->hash_next->hash_prev = entry->hash_prev;
-    }
-
-    entry->hash_prev = nullptr;
-    entry->hash_next = nullptr;
+static inline cache_queue_t* entry_queue(cache_shard_t *shard, const cache_entry_t *entry) {
+    return entry->queue == QUEUE_SMALL ? &shard->small_queue : &shard->main_queue;
 }
 
 /* ============================================================================
- * Cache Entry Operations
+ * Eviction Policy (LRU / S3-FIFO)
  * ============================================================================ */
 
+static inline bool ghost_contains(const cache_shard_t *shard, uint64_t hash) {
+    return shard->ghost != nullptr && shard->ghost[(size_t)hash & shard->ghost_mask] == hash;
+}
+
+static inline void ghost_insert(cache_shard_t *shard, uint64_t hash) {
+    shard->ghost[(size_t)hash & shard->ghost_mask] = hash;
+}
+
 /**
- * Create new cache entry
+ * Link a new entry into the eviction queues
+ *
+ * S3-FIFO puts new sessions on probation in the small queue unless they were
+ * evicted from it recently (@p ghost_hit), in which case they go to main.
  */
-static cache_entry_t* entry_new(const tls_session_cache_entry_t *session) {
-    cache_entry_t *entry = calloc(1, sizeof(cache_entry_t));
-    if (entry == nullptr) {
-        return nullptr;
-    }
+static void policy_insert(cache_shard_t *shard, cache_entry_t *entry, bool ghost_hit) {
+    entry->last_access = shard->wheel_time;
+    entry->freq = 0;
 
-    // Copy session data
-    memcpy(&entry->session, session, sizeof(tls_session_cache_entry_t));
-    entry->last_access = time(nullptr);
+    if (shard->policy == SESSION_CACHE_POLICY_S3FIFO && !ghost_hit) {
+        entry->queue = QUEUE_SMALL;
+        queue_push_front(&shard->small_queue, entry);
+        return;
+    }
 
-    return entry;
+    entry->queue = QUEUE_MAIN;
+    queue_push_front(&shard->main_queue, entry);
 }
 
 /**
- * Free cache entry
+ * Record a cache hit
+ *
+ * LRU moves the entry to the front (four pointer writes). S3-FIFO only bumps
+ * a saturating counter in the entry; queues are reordered lazily on eviction.
  */
-static void entry_free(cache_entry_t *entry) {
-    if (entry != nullptr) {
-        // Zero sensitive session data
-        memset(&entry->session, 0, sizeof(tls_session_cache_entry_t));
-        free(entry);
+static void policy_touch(cache_shard_t *shard, cache_entry_t *entry) {
+    if (shard->policy == SESSION_CACHE_POLICY_S3FIFO) {
+        if (entry->freq < S3FIFO_MAX_FREQ) {
+            entry->freq++;
+        }
+        return;
+    }
+
+    entry->last_access = shard->wheel_time;
+    if (shard->main_queue.head != entry) {
+        queue_remove(&shard->main_queue, entry);
+        queue_push_front(&shard->main_queue, entry);
     }
 }
 
 /**
- * Check if entry is expired
+ * Unlink entry from whichever queue holds it
  */
-static bool entry_is_expired(cache_entry_t *entry, time_t now) {
-    return (entry->session.expiration > 0) && (now > entry->session.expiration);
+static void policy_unlink(cache_shard_t *shard, cache_entry_t *entry) {
+    queue_remove(entry_queue(shard, entry), entry);
 }
 
 /* ============================================================================
- * Cache Management Implementation
+ * Negative Lookup Filter
  * ============================================================================ */
 
-session_cache_t* session_cache_new(size_t capacity, unsigned int timeout_secs) {
-    if (capacity == 0 || timeout_secs == 0) {
-        errno = EINVAL;
-        return nullptr;
-    }
+/**
+ * Counter @p i of a session hash
+ *
+ * The low 32 bits pick the block (bits 32 and up pick the shard); the
+ * counters within the block come from the top bits of a multiplicative mix,
+ * so a lookup touches a single cache line.
+ */
+static inline size_t filter_index(const cache_shard_t *shard, uint64_t hash, unsigned int i) {
+    size_t block = ((size_t)(uint32_t)hash * FILTER_BLOCK) & shard->filter_mask;
+    uint64_t mix = hash * 0x9E37'79B9'7F4A'7C15ULL;
+    return block + (size_t)(mix >> (64 - FILTER_BLOCK_BITS * (i + 1))) % FILTER_BLOCK;
+}
 
-    session_cache_t *cache = calloc(1, sizeof(session_cache_t));
-    if (cache == nullptr) {
-        return nullptr;
+/**
+ * Check whether a session may be cached (lock-free)
+ *
+ * @return false if the session is definitely not cached
+ */
+static inline bool filter_may_contain(const cache_shard_t *shard, uint64_t hash) {
+    for (unsigned int i = 0; i < FILTER_HASHES; i++) {
+        size_t pos = filter_index(shard, hash, i);
+        if (atomic_load_explicit(&shard->filter[pos], memory_order_relaxed) == 0) {
+            return false;
+        }
     }
+    return true;
+}
 
-    cache->capacity = capacity;
-    cache->timeout_secs = timeout_secs;
-    cache->count = 0;
-    cache->hits = 0;
-    cache->misses = 0;
-    cache->evictions = 0;
-    cache->expirations = 0;
-    cache->lru_head = nullptr;
-    cache->lru_tail = nullptr;
+/**
+ * Count a session in the filter (caller holds shard mutex)
+ */
+static void filter_add(cache_shard_t *shard, uint64_t hash) {
+    if (shard->filter == nullptr) {
+        return;
+    }
 
-    // Initialize hash table to null
-    for (size_t i = 0; i < SESSION_CACHE_HASH_BUCKETS; i++) {
-        cache->hash_table[i] = nullptr;
+    for (unsigned int i = 0; i < FILTER_HASHES; i++) {
+        _Atomic uint8_t *counter = &shard->filter[filter_index(shard, hash, i)];
+        uint8_t value = atomic_load_explicit(counter, memory_order_relaxed);
+        if (value < UINT8_MAX) {
+            atomic_store_explicit(counter, (uint8_t)(value + 1), memory_order_relaxed);
+        }
     }
+}
 
-    // Initialize mutex
-    if (pthread_mutex_init(&cache->mutex, nullptr) != 0) {
-        free(cache);
-        return nullptr;
+/**
+ * Uncount a session (caller holds shard mutex)
+ *
+ * A saturated counter may be hiding more sessions than it can count, so it
+ * is left alone (never a false negative) and the shard is flagged for a
+ * recount.
+ */
+static void filter_remove(cache_shard_t *shard, uint64_t hash) {
+    if (shard->filter == nullptr) {
+        return;
     }
 
-    return cache;
+    for (unsigned int i = 0; i < FILTER_HASHES; i++) {
+        _Atomic uint8_t *counter = &shard->filter[filter_index(shard, hash, i)];
+        uint8_t value = atomic_load_explicit(counter, memory_order_relaxed);
+        if (value == UINT8_MAX) {
+            shard->filter_saturated = true;
+        } else if (value > 0) {
+            atomic_store_explicit(counter, (uint8_t)(value - 1), memory_order_relaxed);
+        }
+    }
 }
 
-void session_cache_free(session_cache_t *cache) {
-    if (cache == nullptr) {
+/**
+ * Reset every counter to zero (caller holds shard mutex, shard is empty)
+ */
+static void filter_reset(cache_shard_t *shard) {
+    if (shard->filter == nullptr) {
         return;
     }
 
-    pthread_mutex_lock(&cache->mutex);
-
-    // Free all entries
-    cache_entry_t *entry = cache->lru_head;
-    while (entry != nullptr) {
-        cache_entry_t *next = entry->lru_next;
-        entry_free(entry);
-        entry = next;
+    for (size_t i = 0; i <= shard->filter_mask; i++) {
+        atomic_store_explicit(&shard->filter[i], 0, memory_order_relaxed);
     }
+    shard->filter_saturated = false;
+}
 
-    pthread_mutex_unlock(&cache->mutex);
-    pthread_mutex_destroy(&cache->mutex);
+/* ============================================================================
+ * Hash Table Operations (Robin Hood open addressing)
+ * ============================================================================ */
 
-    free(cache);
+// Returned by table_find() when the session is not present
+constexpr size_t SLOT_NOT_FOUND = SIZE_MAX;
+
+/**
+ * Probe distance of a slot from the home slot of its hash
+ */
+static inline size_t slot_distance(const cache_shard_t *shard, uint64_t hash, size_t pos) {
+    return (pos - ((size_t)hash & shard->slot_mask)) & shard->slot_mask;
 }
 
-void session_cache_clear(session_cache_t *cache) {
-    if (cache == nullptr) {
-        return;
-    }
+/**
+ * Find slot holding a session ID
+ *
+ * Robin Hood ordering guarantees that once we meet a slot closer to its home
+ * than we are to ours, the key cannot be further along the probe sequence.
+ *
+ * @return Slot index, or SLOT_NOT_FOUND
+ */
+static size_t table_find(const cache_shard_t *shard,
+                         uint64_t hash,
+                         const uint8_t *session_id,
+                         size_t session_id_size) {
+    size_t pos = (size_t)hash & shard->slot_mask;
 
-    pthread_mutex_lock(&cache->mutex);
+    for (size_t dist = 0; ; dist++) {
+        const cache_slot_t *slot = &shard->slots[pos];
 
-    // Free all entries
-    cache_entry_t *entry = cache->lru_head;
-    while (entry != nullptr) {
-        cache_entry_t *next = entry->lru_next;
-        entry_free(entry);
-        entry = next;
-    }
+        if (slot->entry == nullptr || slot_distance(shard, slot->hash, pos) < dist) {
+            return SLOT_NOT_FOUND;
+        }
 
-    // Reset state
-    cache->lru_head = nullptr;
-    cache->lru_tail = nullptr;
-    cache->count = 0;
+        if (slot->hash == hash &&
+            session_id_equal(entry_session_id(slot->entry),
+                             slot->entry->session_id_size,
+                             session_id,
+                             session_id_size)) {
+            return pos;
+        }
 
-    // Clear hash table
-    for (size_t i = 0; i < SESSION_CACHE_HASH_BUCKETS; i++) {
-        cache->hash_table[i] = nullptr;
+        pos = (pos + 1) & shard->slot_mask;
     }
-
-    pthread_mutex_unlock(&cache->mutex);
 }
 
-void session_cache_get_stats(session_cache_t *cache,
-                              size_t *count,
-                              size_t *capacity,
-                              uint64_t *hits,
-                              uint64_t *misses,
-                              uint64_t *evictions) {
-    if (cache == nullptr) {
-        return;
-    }
+/**
+ * Insert entry into slot array (no duplicate check, table must have room)
+ */
+static void table_place(cache_slot_t *slots, size_t slot_mask, cache_entry_t *entry) {
+    cache_slot_t carry = {.hash = entry->hash, .entry = entry};
+    size_t pos = (size_t)carry.hash & slot_mask;
+    size_t dist = 0;
 
-    pthread_mutex_lock(&cache->mutex);
+    for (;;) {
+        cache_slot_t *slot = &slots[pos];
 
-    if (count != nullptr) *count = cache->count;
-    if (capacity != nullptr) *capacity = cache->capacity;
-    if (hits != nullptr) *hits = cache->hits;
-    if (misses != nullptr) *misses = cache->misses;
-    if (evictions != nullptr) *evictions = cache->evictions;
+        if (slot->entry == nullptr) {
+            *slot = carry;
+            return;
+        }
+
+        // Steal the slot from a richer (closer to home) resident
+        size_t resident_dist = (pos - ((size_t)slot->hash & slot_mask)) & slot_mask;
+        if (resident_dist < dist) {
+            cache_slot_t tmp = *slot;
+            *slot = carry;
+            carry = tmp;
+            dist = resident_dist;
+        }
 
-    pthread_mutex_unlock(&cache->mutex);
+        pos = (pos + 1) & slot_mask;
+        dist++;
+    }
 }
 
-/* ============================================================================
- * TLS Callback Functions Implementation
- * ============================================================================ */
+/**
+ * Double the slot array and rehash all entries (caller holds shard mutex)
+ *
+ * @return 0 on success, -1 on allocation failure (table left unchanged)
+ */
+static int table_grow(cache_shard_t *shard) {
+    size_t old_size = shard->slot_mask + 1;
+    size_t new_size = old_size * 2;
 
-int session_cache_store(void *userdata, const tls_session_cache_entry_t *entry) {
-    if (userdata == nullptr || entry == nullptr) {
+    cache_slot_t *slots = calloc(new_size, sizeof(cache_slot_t));
+    if (slots == nullptr) {
         return -1;
     }
 
-    session_cache_t *cache = (session_cache_t *)userdata;
+    for (size_t i = 0; i < old_size; i++) {
+        if (shard->slots[i].entry != nullptr) {
+            table_place(slots, new_size - 1, shard->slots[i].entry);
+        }
+    }
 
-    pthread_mutex_lock(&cache->mutex);
+    free(shard->slots);
+    shard->slots = slots;
+    shard->slot_mask = new_size - 1;
+    return 0;
+}
 
-    // Check if session already exists
-    cache_entry_t *existing = hash_find(cache,
-                                         entry->session_id,
-                                         entry->session_id_size);
-
-    if (existing != nullptr) {
-        // Update existing entry
-        memcpy(&existing->session, entry, sizeof(tls_session_cache_entry_t));
-        lru_move_front(cache, existing);
-        pthread_mutex_unlock(&cache->mutex);
-        return 0;
-    }
+/**
+ * Insert entry into hash table, growing it if the load factor would be exceeded
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int table_insert(cache_shard_t *shard, cache_entry_t *entry) {
+    size_t size = shard->slot_mask + 1;
 
-    // Need to add new entry
-    // Check if cache is full
-    if (cache->count >= cache->capacity) {
-        // Evict LRU entry
-        cache_entry_t *lru = lru_get_tail(cache);
-        if (lru != nullptr) {
-            hash_remove(cache, lru);
-            lru_remove(cache, lru);
-            entry_free(lru);
-            cache->count--;
-            cache->evictions++;
+    if ((shard->count + 1) * 8 > size * SLOT_LOAD_FACTOR_EIGHTHS) {
+        if (table_grow(shard) != 0) {
+            return -1;
         }
     }
 
-    // Create new entry
-    cache_entry_t *new_entry = entry_new(entry);
-    if (new_entry == nullptr) {
-        pthread_mutex_unlock(&cache->mutex);
-        return -1;
-    }
-
-    // Insert into hash table and LRU list
-    hash_insert(cache, new_entry);
-    lru_add_front(cache, new_entry);
-    cache->count++;
-
-    pthread_mutex_unlock(&cache->mutex);
+    table_place(shard->slots, shard->slot_mask, entry);
+    return 0;
+}
+
+/**
+ * Remove slot at @p pos using backward-shift deletion (no tombstones)
+ */
+static void table_remove_at(cache_shard_t *shard, size_t pos) {
+    size_t next = (pos + 1) & shard->slot_mask;
+
+    while (shard->slots[next].entry != nullptr &&
+           slot_distance(shard, shard->slots[next].hash, next) != 0) {
+        shard->slots[pos] = shard->slots[next];
+        pos = next;
+        next = (next + 1) & shard->slot_mask;
+    }
+
+    shard->slots[pos] = (cache_slot_t){0};
+}
+
+/**
+ * Remove entry from hash table
+ */
+static void table_remove(cache_shard_t *shard, const cache_entry_t *entry) {
+    size_t pos = (size_t)entry->hash & shard->slot_mask;
+
+    while (shard->slots[pos].entry != entry) {
+        pos = (pos + 1) & shard->slot_mask;
+    }
+
+    table_remove_at(shard, pos);
+}
+
+/* ============================================================================
+ * Slab Allocator
+ * ============================================================================ */
+
+/**
+ * Smallest size class that fits @p size bytes
+ *
+ * @return Class index, or SLAB_CLASS_COUNT if too large
+ */
+static size_t slab_class_for(size_t size) {
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        if (size <= slab_class_sizes[i]) {
+            return i;
+        }
+    }
+    return SLAB_CLASS_COUNT;
+}
+
+/**
+ * Allocate a block from a size class (caller holds shard mutex)
+ *
+ * Reuses released blocks first, then carves the newest page, then adds a
+ * page. Pages hold at most shard->capacity blocks so small caches do not
+ * reserve a full SLAB_PAGE_SIZE per class.
+ */
+static void* slab_alloc(cache_shard_t *shard, size_t cls) {
+    slab_class_t *sc = &shard->slab[cls];
+    size_t block_size = slab_class_sizes[cls];
+
+    if (sc->free_list != nullptr) {
+        slab_block_t *block = sc->free_list;
+        sc->free_list = block->next;
+        shard->entry_bytes += block_size;
+        return block;
+    }
+
+    if (sc->bump_left == 0) {
+        size_t blocks = SLAB_PAGE_SIZE / block_size;
+        if (blocks > shard->capacity) {
+            blocks = shard->capacity;
+        }
+        if (blocks == 0) {
+            blocks = 1;
+        }
+
+        size_t page_size = sizeof(slab_page_t) + blocks * block_size;
+        slab_page_t *page = malloc(page_size);
+        if (page == nullptr) {
+            return nullptr;
+        }
+
+        page->next = shard->slab_pages;
+        page->size = page_size;
+        shard->slab_pages = page;
+        shard->slab_bytes += page_size;
+
+        sc->bump = page->mem;
+        sc->bump_left = blocks;
+    }
+
+    void *block = sc->bump;
+    sc->bump += block_size;
+    sc->bump_left--;
+    shard->entry_bytes += block_size;
+    return block;
+}
+
+/**
+ * Return a block to its size class (caller holds shard mutex)
+ */
+static void slab_free(cache_shard_t *shard, size_t cls, void *ptr) {
+    slab_block_t *block = ptr;
+
+    block->next = shard->slab[cls].free_list;
+    shard->slab[cls].free_list = block;
+    shard->entry_bytes -= slab_class_sizes[cls];
+}
+
+/**
+ * Release every slab page of a shard (all entries must already be dead)
+ */
+static void slab_release_all(cache_shard_t *shard) {
+    slab_page_t *page = shard->slab_pages;
+    while (page != nullptr) {
+        slab_page_t *next = page->next;
+        free(page);
+        page = next;
+    }
+
+    shard->slab_pages = nullptr;
+    shard->slab_bytes = 0;
+    shard->entry_bytes = 0;
+    memset(shard->slab, 0, sizeof(shard->slab));
+}
+
+/* ============================================================================
+ * Cache Entry Operations
+ * ============================================================================ */
+
+/**
+ * Check that a session fits the compact entry encoding
+ */
+static bool session_is_storable(const tls_session_cache_entry_t *session) {
+    return session->session_id_size <= TLS_MAX_SESSION_ID_SIZE &&
+           session->session_data_size <= TLS_MAX_SESSION_DATA_SIZE &&
+           session->remote_addr_len <= sizeof(struct sockaddr_storage);
+}
+
+/**
+ * Copy session fields into an entry whose class is large enough
+ */
+static void entry_fill(cache_entry_t *entry, const tls_session_cache_entry_t *session) {
+    entry->expiration = session->expiration;
+    entry->session_id_size = (uint16_t)session->session_id_size;
+    entry->session_data_size = (uint16_t)session->session_data_size;
+    entry->remote_addr_len = session->remote_addr_len;
+
+    uint8_t *p = entry->bytes;
+    memcpy(p, session->session_id, session->session_id_size);
+    p += session->session_id_size;
+    memcpy(p, session->session_data, session->session_data_size);
+    p += session->session_data_size;
+    memcpy(p, &session->remote_addr, session->remote_addr_len);
+}
+
+/**
+ * Expand an entry back into the public session structure
+ *
+ * Only the used prefix of session_data is written.
+ */
+static void entry_export(const cache_entry_t *entry, tls_session_cache_entry_t *session) {
+    memcpy(session->session_id, entry_session_id(entry), entry->session_id_size);
+    session->session_id_size = entry->session_id_size;
+    memcpy(session->session_data, entry_session_data(entry), entry->session_data_size);
+    session->session_data_size = entry->session_data_size;
+    session->expiration = entry->expiration;
+
+    memset(&session->remote_addr, 0, sizeof(session->remote_addr));
+    memcpy(&session->remote_addr, entry_remote_addr(entry), entry->remote_addr_len);
+    session->remote_addr_len = entry->remote_addr_len;
+}
+
+/**
+ * Create new cache entry (caller holds shard mutex)
+ */
+static cache_entry_t* entry_new(cache_shard_t *shard,
+                                const tls_session_cache_entry_t *session,
+                                uint64_t hash,
+                                int64_t expire_tick) {
+    size_t cls = slab_class_for(entry_size_for(session));
+    if (cls == SLAB_CLASS_COUNT) {
+        return nullptr;
+    }
+
+    cache_entry_t *entry = slab_alloc(shard, cls);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    memset(entry, 0, sizeof(cache_entry_t));
+    entry->hash = hash;
+    entry->slab_class = (uint8_t)cls;
+    entry->expire_tick = expire_tick;
+    entry_fill(entry, session);
+
+    return entry;
+}
+
+/**
+ * Free cache entry (caller holds shard mutex)
+ */
+static void entry_free(cache_shard_t *shard, cache_entry_t *entry) {
+    if (entry != nullptr) {
+        size_t cls = entry->slab_class;
+
+        if (shard->free_data != nullptr) {
+            shard->free_data(entry_session_data(entry), entry->session_data_size);
+        }
+
+        // Zero sensitive session data
+        memset(entry, 0, slab_class_sizes[cls]);
+        slab_free(shard, cls, entry);
+    }
+}
+
+/**
+ * Dispose of an entry that left the cache (caller holds shard mutex)
+ *
+ * Leased entries stay allocated, unlinked from every structure, until
+ * session_cache_release() returns the last lease.
+ */
+static void entry_retire(cache_shard_t *shard, cache_entry_t *entry) {
+    if (entry->leases > 0) {
+        entry->queue = QUEUE_DETACHED;
+        return;
+    }
+    entry_free(shard, entry);
+}
+
+/**
+ * Check if entry is expired at coarse tick @p now
+ */
+static bool entry_is_expired(const cache_entry_t *entry, int64_t now) {
+    return now >= entry->expire_tick;
+}
+
+/* ============================================================================
+ * Shard Operations
+ * ============================================================================ */
+
+/**
+ * Unlink entry from shard and free it (caller holds shard mutex)
+ */
+static void shard_drop_entry(cache_shard_t *shard, cache_entry_t *entry) {
+    table_remove(shard, entry);
+    filter_remove(shard, entry->hash);
+    policy_unlink(shard, entry);
+    wheel_remove(entry);
+    entry_retire(shard, entry);
+    shard->count--;
+}
+
+/**
+ * Unlink the entry stored at slot @p pos and free it (caller holds shard mutex)
+ *
+ * Same as shard_drop_entry() when the slot is already known from a lookup.
+ */
+static void shard_drop_slot(cache_shard_t *shard, size_t pos) {
+    cache_entry_t *entry = shard->slots[pos].entry;
+
+    table_remove_at(shard, pos);
+    filter_remove(shard, entry->hash);
+    policy_unlink(shard, entry);
+    wheel_remove(entry);
+    entry_retire(shard, entry);
+    shard->count--;
+}
+
+/**
+ * Free all entries of a shard (caller holds shard mutex)
+ */
+static void shard_free_entries(cache_shard_t *shard) {
+    cache_queue_t *queues[] = {&shard->main_queue, &shard->small_queue};
+
+    for (size_t i = 0; i < sizeof(queues) / sizeof(queues[0]); i++) {
+        cache_entry_t *entry = queues[i]->head;
+        while (entry != nullptr) {
+            cache_entry_t *next = entry->queue_next;
+            entry->wheel_pprev = nullptr;
+            entry_retire(shard, entry);
+            entry = next;
+        }
+        *queues[i] = (cache_queue_t){0};
+    }
+
+    // Leased entries still live in the slab pages
+    if (shard->leases == 0) {
+        slab_release_all(shard);
+    }
+    memset(shard->wheel, 0, sizeof(shard->wheel));
+
+    if (shard->ghost != nullptr) {
+        memset(shard->ghost, 0, (shard->ghost_mask + 1) * sizeof(uint64_t));
+    }
+    filter_reset(shard);
+    shard->count = 0;
+
+    memset(shard->slots, 0, (shard->slot_mask + 1) * sizeof(cache_slot_t));
+}
+
+/**
+ * Evict one entry to make room (caller holds shard mutex)
+ *
+ * LRU drops the tail of the main queue. S3-FIFO (Yang et al., SOSP'23):
+ * - while the small queue is over its target share, its tail is either
+ *   promoted to main (accessed while on probation) or evicted and
+ *   remembered in the ghost set (one-shot session)
+ * - otherwise the main tail gets a second chance per remaining access
+ *   (CLOCK-style) and is evicted once its counter reaches zero
+ */
+static void shard_evict(cache_shard_t *shard) {
+    if (shard->policy != SESSION_CACHE_POLICY_S3FIFO) {
+        if (shard->main_queue.tail != nullptr) {
+            shard_drop_entry(shard, shard->main_queue.tail);
+            shard->evictions++;
+        }
+        return;
+    }
+
+    for (;;) {
+        bool from_small = shard->small_queue.count > 0 &&
+                          (shard->small_queue.count >= shard->small_target ||
+                           shard->main_queue.count == 0);
+        cache_queue_t *queue = from_small ? &shard->small_queue : &shard->main_queue;
+        cache_entry_t *victim = queue->tail;
+
+        if (victim == nullptr) {
+            return;
+        }
+
+        if (victim->freq > 0) {
+            queue_remove(queue, victim);
+            if (from_small) {
+                victim->queue = QUEUE_MAIN;
+                victim->freq = 0;
+            } else {
+                victim->freq--;
+            }
+            queue_push_front(&shard->main_queue, victim);
+            continue;
+        }
+
+        if (from_small) {
+            ghost_insert(shard, victim->hash);
+        }
+        shard_drop_entry(shard, victim);
+        shard->evictions++;
+        return;
+    }
+}
+
+/**
+ * Advance the shard's timing wheel to @p now, expiring due entries
+ *
+ * Each elapsed tick cascades the higher-level slots whose lower digits rolled
+ * over and then frees the level-0 slot for that tick, so the work is O(1) per
+ * tick plus O(1) per expired entry. Caller holds shard mutex.
+ *
+ * @return Number of entries expired
+ */
+static size_t shard_advance(cache_shard_t *shard, int64_t now) {
+    size_t expired = 0;
+
+    if (shard->count == 0) {
+        // Nothing scheduled, just catch up
+        if (now > shard->wheel_time) {
+            shard->wheel_time = now;
+        }
+        return 0;
+    }
+
+    while (shard->wheel_time < now) {
+        int64_t tick = ++shard->wheel_time;
+
+        for (unsigned int level = 1; level < WHEEL_LEVELS; level++) {
+            int64_t level_mask = ((int64_t)1 << (WHEEL_SLOT_BITS * level)) - 1;
+            if ((tick & level_mask) != 0) {
+                break;
+            }
+
+            size_t slot = (size_t)(tick >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1);
+            cache_entry_t *entry = shard->wheel[level][slot];
+            shard->wheel[level][slot] = nullptr;
+
+            while (entry != nullptr) {
+                cache_entry_t *next = entry->wheel_next;
+                entry->wheel_pprev = nullptr;
+                wheel_insert(shard, entry, tick);
+                entry = next;
+            }
+        }
+
+        cache_entry_t **bucket = &shard->wheel[0][(size_t)tick & (WHEEL_SLOTS - 1)];
+        while (*bucket != nullptr) {
+            shard_drop_entry(shard, *bucket);
+            shard->expirations++;
+            expired++;
+        }
+    }
+
+    return expired;
+}
+
+/**
+ * Answer a lookup from the negative filter alone, without the shard mutex
+ *
+ * @return true if the session is definitely not cached (miss recorded)
+ */
+static inline bool shard_filter_rejects(cache_shard_t *shard, uint64_t hash) {
+    if (shard->filter == nullptr || filter_may_contain(shard, hash)) {
+        return false;
+    }
+
+    atomic_fetch_add_explicit(&shard->filter_rejects, 1, memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Record a lookup miss on a session that is not in the table (caller holds
+ * shard mutex); with a filter, that lookup got past it as a false positive
+ */
+static inline void shard_record_miss(cache_shard_t *shard) {
+    shard->misses++;
+    if (shard->filter != nullptr) {
+        shard->filter_false_positives++;
+    }
+}
+
+/**
+ * Recount the negative filter from the live entries (caller holds shard mutex)
+ *
+ * Only needed after counters saturated. The exact counts are built in a
+ * scratch array and then stored counter by counter; a stored value is never
+ * below the number of cached sessions using that counter, so concurrent
+ * lock-free lookups never see a false negative.
+ */
+static void shard_filter_rebuild(cache_shard_t *shard) {
+    size_t size = shard->filter_mask + 1;
+    uint8_t *counts = calloc(size, sizeof(uint8_t));
+    if (counts == nullptr) {
+        return; // Stays flagged, retried on the next sweep
+    }
+
+    bool saturated = false;
+    const cache_queue_t *queues[] = {&shard->main_queue, &shard->small_queue};
+
+    for (size_t q = 0; q < sizeof(queues) / sizeof(queues[0]); q++) {
+        for (const cache_entry_t *entry = queues[q]->head; entry != nullptr;
+             entry = entry->queue_next) {
+            for (unsigned int i = 0; i < FILTER_HASHES; i++) {
+                size_t pos = filter_index(shard, entry->hash, i);
+                if (counts[pos] == UINT8_MAX) {
+                    saturated = true;
+                } else {
+                    counts[pos]++;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        atomic_store_explicit(&shard->filter[i], counts[i], memory_order_relaxed);
+    }
+    shard->filter_saturated = saturated;
+    free(counts);
+}
+
+/**
+ * Initialize an empty, zeroed shard
+ *
+ * @return 0 on success, -1 on allocation or mutex failure
+ */
+static int shard_init(cache_shard_t *shard,
+                      size_t capacity,
+                      session_cache_policy_t policy,
+                      bool negative_filter,
+                      int64_t now) {
+    shard->capacity = capacity;
+    shard->policy = policy;
+    shard->wheel_time = now;
+
+    // Hash table starts small and grows with the number of entries
+    shard->slots = calloc(SESSION_CACHE_INITIAL_SLOTS, sizeof(cache_slot_t));
+    shard->slot_mask = SESSION_CACHE_INITIAL_SLOTS - 1;
+    if (shard->slots == nullptr) {
+        return -1;
+    }
+
+    if (policy == SESSION_CACHE_POLICY_S3FIFO) {
+        shard->small_target = capacity * S3FIFO_SMALL_PERCENT / 100;
+        if (shard->small_target == 0) {
+            shard->small_target = 1;
+        }
+
+        // Ghost set remembers about as many sessions as the main queue holds
+        size_t ghost_size = 1;
+        while (ghost_size < capacity) {
+            ghost_size *= 2;
+        }
+        shard->ghost = calloc(ghost_size, sizeof(uint64_t));
+        shard->ghost_mask = ghost_size - 1;
+        if (shard->ghost == nullptr) {
+            free(shard->slots);
+            return -1;
+        }
+    }
+
+    if (negative_filter) {
+        size_t filter_size = FILTER_BLOCK;
+        while (filter_size < capacity * FILTER_COUNTERS_PER_ENTRY) {
+            filter_size *= 2;
+        }
+        shard->filter = aligned_alloc(CACHE_LINE_SIZE, filter_size * sizeof(*shard->filter));
+        shard->filter_mask = filter_size - 1;
+        if (shard->filter == nullptr) {
+            free(shard->ghost);
+            free(shard->slots);
+            return -1;
+        }
+        filter_reset(shard);
+    }
+
+    if (pthread_mutex_init(&shard->mutex, nullptr) != 0) {
+        free((void *)shard->filter);
+        free(shard->ghost);
+        free(shard->slots);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Release shard resources (entries must already be freed)
+ */
+static void shard_destroy(cache_shard_t *shard) {
+    pthread_mutex_destroy(&shard->mutex);
+    free((void *)shard->filter);
+    free(shard->ghost);
+    free(shard->slots);
+}
+
+/**
+ * Pick the effective shard count for a configuration
+ *
+ * Rounds the request down to a power of 2 and clamps it so that every shard
+ * keeps at least SESSION_CACHE_MIN_SHARD_CAPACITY entries.
+ */
+static size_t effective_shard_count(size_t requested, size_t capacity) {
+    if (requested == 0) {
+        requested = SESSION_CACHE_DEFAULT_SHARDS;
+    }
+    if (requested > SESSION_CACHE_MAX_SHARDS) {
+        requested = SESSION_CACHE_MAX_SHARDS;
+    }
+
+    size_t count = 1;
+    while (count * 2 <= requested &&
+           capacity / (count * 2) >= SESSION_CACHE_MIN_SHARD_CAPACITY) {
+        count *= 2;
+    }
+
+    return count;
+}
+
+/* ============================================================================
+ * Cache Management Implementation
+ * ============================================================================ */
+
+session_cache_t* session_cache_new(size_t capacity, unsigned int timeout_secs) {
+    session_cache_config_t config = {
+        .capacity = capacity,
+        .timeout_secs = timeout_secs,
+    };
+
+    return session_cache_new_with_config(&config);
+}
+
+session_cache_t* session_cache_new_with_config(const session_cache_config_t *config) {
+    if (config == nullptr || config->capacity == 0 || config->timeout_secs == 0 ||
+        (config->policy != SESSION_CACHE_POLICY_LRU &&
+         config->policy != SESSION_CACHE_POLICY_S3FIFO)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    session_cache_t *cache = calloc(1, sizeof(session_cache_t));
+    if (cache == nullptr) {
+        return nullptr;
+    }
+
+    cache->capacity = config->capacity;
+    cache->timeout_secs = config->timeout_secs;
+    cache->free_data = config->free_data;
+    hash_key_init(cache);
+
+    int64_t now = cache_clock_now();
+    cache->clock_offset = (int64_t)time(nullptr) - now;
+    cache->shard_count = effective_shard_count(config->shard_count, config->capacity);
+    cache->shard_mask = cache->shard_count - 1;
+
+    // Shards are cache-line aligned (see cache_shard_t)
+    cache->shards = aligned_alloc(alignof(cache_shard_t),
+                                  cache->shard_count * sizeof(cache_shard_t));
+    if (cache->shards == nullptr) {
+        free(cache);
+        return nullptr;
+    }
+    memset(cache->shards, 0, cache->shard_count * sizeof(cache_shard_t));
+
+    // Split capacity across shards (first shards take the remainder)
+    size_t base = cache->capacity / cache->shard_count;
+    size_t extra = cache->capacity % cache->shard_count;
+
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        size_t capacity = base + (i < extra ? 1 : 0);
+
+        cache->shards[i].free_data = config->free_data;
+        if (shard_init(&cache->shards[i], capacity, config->policy,
+                       config->negative_filter, now) != 0) {
+            for (size_t j = 0; j < i; j++) {
+                shard_destroy(&cache->shards[j]);
+            }
+            free(cache->shards);
+            free(cache);
+            return nullptr;
+        }
+    }
+
+    return cache;
+}
+
+session_cache_t* session_cache_new_shared(const char *name,
+                                          const session_cache_config_t *config) {
+    if (name == nullptr ||
+        (config != nullptr && (config->capacity == 0 || config->timeout_secs == 0 ||
+                               config->policy != SESSION_CACHE_POLICY_LRU ||
+                               config->free_data != nullptr || config->negative_filter))) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    session_cache_t *cache = calloc(1, sizeof(session_cache_t));
+    if (cache == nullptr) {
+        return nullptr;
+    }
+
+    // Key for a new segment; an existing segment's key replaces it below
+    hash_key_init(cache);
+
+    session_cache_config_t geometry;
+    if (config != nullptr) {
+        geometry = *config;
+        geometry.shard_count = effective_shard_count(config->shard_count, config->capacity);
+    }
+
+    cache->shm = shm_cache_open(name, config != nullptr ? &geometry : nullptr, cache->hash_key);
+    if (cache->shm == nullptr) {
+        int saved_errno = errno;
+        free(cache);
+        errno = saved_errno;
+        return nullptr;
+    }
+
+    cache->capacity = shm_cache_capacity(cache->shm);
+    cache->timeout_secs = shm_cache_timeout(cache->shm);
+    cache->shard_count = shm_cache_shard_count(cache->shm);
+    cache->shard_mask = cache->shard_count - 1;
+    shm_cache_hash_key(cache->shm, cache->hash_key);
+
+    return cache;
+}
+
+int session_cache_unlink_shared(const char *name) {
+    if (name == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return shm_cache_unlink(name);
+}
+
+void session_cache_free(session_cache_t *cache) {
+    if (cache == nullptr) {
+        return;
+    }
+
+    // Shutdown snapshot (best effort, the cache is going away either way)
+    snapshot_thread_stop(cache);
+    if (cache->snapshot_path != nullptr) {
+        (void)session_cache_save(cache, cache->snapshot_path, nullptr);
+        free(cache->snapshot_path);
+    }
+
+    if (cache->shm != nullptr) {
+        shm_cache_close(cache->shm);
+        free(cache);
+        return;
+    }
+
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        cache_shard_t *shard = &cache->shards[i];
+
+        pthread_mutex_lock(&shard->mutex);
+        shard_free_entries(shard);
+        pthread_mutex_unlock(&shard->mutex);
+        shard_destroy(shard);
+    }
+
+    free(cache->shards);
+    free(cache);
+}
+
+void session_cache_clear(session_cache_t *cache) {
+    if (cache == nullptr) {
+        return;
+    }
+
+    if (cache->shm != nullptr) {
+        shm_cache_clear(cache->shm);
+        return;
+    }
+
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        cache_shard_t *shard = &cache->shards[i];
+
+        pthread_mutex_lock(&shard->mutex);
+        shard_free_entries(shard);
+        pthread_mutex_unlock(&shard->mutex);
+    }
+}
+
+size_t session_cache_shard_count(session_cache_t *cache) {
+    return cache != nullptr ? cache->shard_count : 0;
+}
+
+void session_cache_get_stats(session_cache_t *cache,
+                              size_t *count,
+                              size_t *capacity,
+                              uint64_t *hits,
+                              uint64_t *misses,
+                              uint64_t *evictions) {
+    session_cache_stats_t stats;
+    if (session_cache_get_stats_ex(cache, &stats) != 0) {
+        return;
+    }
+
+    if (count != nullptr) *count = stats.count;
+    if (capacity != nullptr) *capacity = stats.capacity;
+    if (hits != nullptr) *hits = stats.hits;
+    if (misses != nullptr) *misses = stats.misses;
+    if (evictions != nullptr) *evictions = stats.evictions;
+}
+
+int session_cache_get_stats_ex(session_cache_t *cache, session_cache_stats_t *stats) {
+    if (cache == nullptr || stats == nullptr) {
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    if (cache->shm != nullptr) {
+        shm_cache_get_stats(cache->shm, stats);
+        if (stats->count > 0) {
+            stats->bytes_per_session = (stats->slab_bytes + stats->table_bytes) / stats->count;
+        }
+        return 0;
+    }
+
+    stats->capacity = cache->capacity;
+    stats->table_bytes = sizeof(session_cache_t) + cache->shard_count * sizeof(cache_shard_t);
+
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        cache_shard_t *shard = &cache->shards[i];
+
+        pthread_mutex_lock(&shard->mutex);
+        stats->count += shard->count;
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->evictions += shard->evictions;
+        stats->expirations += shard->expirations;
+        stats->entry_bytes += shard->entry_bytes;
+        stats->slab_bytes += shard->slab_bytes;
+        stats->table_bytes += (shard->slot_mask + 1) * sizeof(cache_slot_t);
+        stats->filter_false_positives += shard->filter_false_positives;
+        pthread_mutex_unlock(&shard->mutex);
+
+        stats->filter_rejects += atomic_load_explicit(&shard->filter_rejects,
+                                                      memory_order_relaxed);
+    }
+
+    // Ghost sets (S3-FIFO only) and negative filters
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        if (cache->shards[i].ghost != nullptr) {
+            stats->table_bytes += (cache->shards[i].ghost_mask + 1) * sizeof(uint64_t);
+        }
+        if (cache->shards[i].filter != nullptr) {
+            stats->table_bytes += (cache->shards[i].filter_mask + 1) * sizeof(uint8_t);
+        }
+    }
+
+    // Filter rejects are misses that never reached a shard
+    stats->misses += stats->filter_rejects;
+    uint64_t filtered_absent = stats->filter_rejects + stats->filter_false_positives;
+    if (filtered_absent > 0) {
+        stats->filter_false_positive_rate =
+            (double)stats->filter_false_positives / (double)filtered_absent;
+    }
+
+    if (stats->count > 0) {
+        stats->bytes_per_session = (stats->slab_bytes + stats->table_bytes) / stats->count;
+    }
+
+    return 0;
+}
+
+/* ============================================================================
+ * TLS Callback Functions Implementation
+ * ============================================================================ */
+
+int session_cache_store(void *userdata, const tls_session_cache_entry_t *entry) {
+    if (userdata == nullptr || entry == nullptr || !session_is_storable(entry)) {
+        return -1;
+    }
+
+    session_cache_t *cache = (session_cache_t *)userdata;
+    uint64_t hash = hash_session_id(cache, entry->session_id, entry->session_id_size);
+
+    if (cache->shm != nullptr) {
+        return shm_cache_store(cache->shm, hash, entry);
+    }
+
+    cache_shard_t *shard = shard_for_hash(cache, hash);
+    int64_t now = cache_clock_now();
+    int64_t expire_tick = expire_tick_for(cache, entry->expiration);
+
+    pthread_mutex_lock(&shard->mutex);
+    shard_advance(shard, now);
+
+    // Check if session already exists
+    size_t pos = table_find(shard, hash, entry->session_id, entry->session_id_size);
+
+    // Already expired: nothing to cache (and the old copy is stale too)
+    if (expire_tick <= now) {
+        if (pos != SLOT_NOT_FOUND) {
+            shard_drop_slot(shard, pos);
+        }
+        if (shard->free_data != nullptr) {
+            shard->free_data(entry->session_data, entry->session_data_size);
+        }
+        shard->expirations++;
+        pthread_mutex_unlock(&shard->mutex);
+        return 0;
+    }
+
+    if (pos != SLOT_NOT_FOUND) {
+        cache_entry_t *existing = shard->slots[pos].entry;
+
+        // Update in place if the new session fits the existing size class
+        // (never under a lease: borrowers must keep seeing the old bytes)
+        if (existing->leases == 0 &&
+            entry_size_for(entry) <= slab_class_sizes[existing->slab_class]) {
+            if (shard->free_data != nullptr) {
+                shard->free_data(entry_session_data(existing), existing->session_data_size);
+            }
+            wheel_remove(existing);
+            existing->expire_tick = expire_tick;
+            entry_fill(existing, entry);
+            wheel_insert(shard, existing, shard->wheel_time + 1);
+            policy_touch(shard, existing);
+            pthread_mutex_unlock(&shard->mutex);
+            return 0;
+        }
+
+        // Otherwise replace it with an entry from a larger class
+        shard_drop_slot(shard, pos);
+    }
+
+    // Need to add new entry (check the ghost set before evicting refills it)
+    bool ghost_hit = ghost_contains(shard, hash);
+
+    // Check if shard is full
+    if (shard->count >= shard->capacity) {
+        shard_evict(shard);
+    }
+
+    // Create new entry
+    cache_entry_t *new_entry = entry_new(shard, entry, hash, expire_tick);
+    if (new_entry == nullptr) {
+        pthread_mutex_unlock(&shard->mutex);
+        return -1;
+    }
+
+    // Insert into hash table, eviction queue and timing wheel
+    if (table_insert(shard, new_entry) != 0) {
+        entry_free(shard, new_entry);
+        pthread_mutex_unlock(&shard->mutex);
+        return -1;
+    }
+    filter_add(shard, hash);
+    policy_insert(shard, new_entry, ghost_hit);
+    wheel_insert(shard, new_entry, shard->wheel_time + 1);
+    shard->count++;
+
+    pthread_mutex_unlock(&shard->mutex);
     return 0;
 }
 
@@ -467,43 +1753,168 @@ int session_cache_retrieve(void *userdata,
     }
 
     session_cache_t *cache = (session_cache_t *)userdata;
+    uint64_t hash = hash_session_id(cache, session_id, session_id_size);
+
+    if (cache->shm != nullptr) {
+        return shm_cache_retrieve(cache->shm, hash, session_id, session_id_size, entry);
+    }
+
+    cache_shard_t *shard = shard_for_hash(cache, hash);
+    if (shard_filter_rejects(shard, hash)) {
+        return -1;
+    }
 
-    pthread_mutex_lock(&cache->mutex);
+    int64_t now = cache_clock_now();
+
+    pthread_mutex_lock(&shard->mutex);
+    shard_advance(shard, now);
 
     // Find entry
-    cache_entry_t *found = hash_find(cache, session_id, session_id_size);
+    size_t pos = table_find(shard, hash, session_id, session_id_size);
 
-    if (found == nullptr) {
-        cache->misses++;
-        pthread_mutex_unlock(&cache->mutex);
+    if (pos == SLOT_NOT_FOUND) {
+        shard_record_miss(shard);
+        pthread_mutex_unlock(&shard->mutex);
         return -1;
     }
 
-    // Check if expired
-    time_t now = time(nullptr);
+    cache_entry_t *found = shard->slots[pos].entry;
+
+    // Check if expired (due this tick, not yet reaped by the wheel)
     if (entry_is_expired(found, now)) {
         // Remove expired entry
-        hash_remove(cache, found);
-        lru_remove(cache, found);
-        entry_free(found);
-        cache->count--;
-        cache->expirations++;
-        cache->misses++;
-        pthread_mutex_unlock(&cache->mutex);
+        shard_drop_slot(shard, pos);
+        shard->expirations++;
+        shard->misses++;
+        pthread_mutex_unlock(&shard->mutex);
         return -1;
     }
 
     // Copy session data
-    memcpy(entry, &found->session, sizeof(tls_session_cache_entry_t));
+    entry_export(found, entry);
+
+    // Record the hit for the eviction policy
+    policy_touch(shard, found);
+    shard->hits++;
+
+    pthread_mutex_unlock(&shard->mutex);
+    return 0;
+}
+
+int session_cache_borrow(void *userdata,
+                          const uint8_t *session_id,
+                          size_t session_id_size,
+                          tls_session_lease_t *lease) {
+    if (userdata == nullptr || session_id == nullptr || lease == nullptr) {
+        return -1;
+    }
 
-    // Move to front of LRU list
-    lru_move_front(cache, found);
-    cache->hits++;
+    session_cache_t *cache = (session_cache_t *)userdata;
+
+    if (cache->shm != nullptr) {
+        // Other processes may overwrite shared records at any time, so a
+        // shared lease is a private copy of just the session data
+        tls_session_cache_entry_t entry;
+        uint64_t hash = hash_session_id(cache, session_id, session_id_size);
+        if (shm_cache_retrieve(cache->shm, hash, session_id, session_id_size, &entry) != 0) {
+            return -1;
+        }
+
+        uint8_t *copy = malloc(entry.session_data_size > 0 ? entry.session_data_size : 1);
+        if (copy == nullptr) {
+            return -1;
+        }
+        memcpy(copy, entry.session_data, entry.session_data_size);
+
+        *lease = (tls_session_lease_t){
+            .session_data = copy,
+            .session_data_size = entry.session_data_size,
+            .expiration = entry.expiration,
+            .handle = copy,
+        };
+        return 0;
+    }
+
+    uint64_t hash = hash_session_id(cache, session_id, session_id_size);
+    cache_shard_t *shard = shard_for_hash(cache, hash);
+    if (shard_filter_rejects(shard, hash)) {
+        return -1;
+    }
+
+    int64_t now = cache_clock_now();
+
+    pthread_mutex_lock(&shard->mutex);
+    shard_advance(shard, now);
+
+    size_t pos = table_find(shard, hash, session_id, session_id_size);
+
+    if (pos == SLOT_NOT_FOUND) {
+        shard_record_miss(shard);
+        pthread_mutex_unlock(&shard->mutex);
+        return -1;
+    }
 
-    pthread_mutex_unlock(&cache->mutex);
+    cache_entry_t *found = shard->slots[pos].entry;
+
+    if (entry_is_expired(found, now)) {
+        shard_drop_slot(shard, pos);
+        shard->expirations++;
+        shard->misses++;
+        pthread_mutex_unlock(&shard->mutex);
+        return -1;
+    }
+
+    // Lease counter saturated: treat as a miss rather than wrap
+    if (found->leases == UINT8_MAX) {
+        shard->misses++;
+        pthread_mutex_unlock(&shard->mutex);
+        return -1;
+    }
+
+    found->leases++;
+    shard->leases++;
+    policy_touch(shard, found);
+    shard->hits++;
+
+    *lease = (tls_session_lease_t){
+        .session_data = entry_session_data(found),
+        .session_data_size = found->session_data_size,
+        .expiration = found->expiration,
+        .handle = found,
+    };
+
+    pthread_mutex_unlock(&shard->mutex);
     return 0;
 }
 
+void session_cache_release(void *userdata, tls_session_lease_t *lease) {
+    if (userdata == nullptr || lease == nullptr || lease->handle == nullptr) {
+        return;
+    }
+
+    session_cache_t *cache = (session_cache_t *)userdata;
+
+    if (cache->shm != nullptr) {
+        free(lease->handle);
+        *lease = (tls_session_lease_t){0};
+        return;
+    }
+
+    // The hash stays intact while an entry is leased, detached or not
+    cache_entry_t *entry = lease->handle;
+    cache_shard_t *shard = shard_for_hash(cache, entry->hash);
+
+    pthread_mutex_lock(&shard->mutex);
+    entry->leases--;
+    shard->leases--;
+    if (entry->leases == 0 && entry->queue == QUEUE_DETACHED) {
+        entry_free(shard, entry);
+    }
+    pthread_mutex_unlock(&shard->mutex);
+
+    *lease = (tls_session_lease_t){0};
+}
+
 int session_cache_remove(void *userdata,
                           const uint8_t *session_id,
                           size_t session_id_size) {
@@ -512,24 +1923,28 @@ int session_cache_remove(void *userdata,
     }
 
     session_cache_t *cache = (session_cache_t *)userdata;
+    uint64_t hash = hash_session_id(cache, session_id, session_id_size);
+
+    if (cache->shm != nullptr) {
+        return shm_cache_remove(cache->shm, hash, session_id, session_id_size);
+    }
+
+    cache_shard_t *shard = shard_for_hash(cache, hash);
 
-    pthread_mutex_lock(&cache->mutex);
+    pthread_mutex_lock(&shard->mutex);
 
     // Find entry
-    cache_entry_t *found = hash_find(cache, session_id, session_id_size);
+    size_t pos = table_find(shard, hash, session_id, session_id_size);
 
-    if (found == nullptr) {
-        pthread_mutex_unlock(&cache->mutex);
+    if (pos == SLOT_NOT_FOUND) {
+        pthread_mutex_unlock(&shard->mutex);
         return -1;
     }
 
-    // Remove from hash table and LRU list
-    hash_remove(cache, found);
-    lru_remove(cache, found);
-    entry_free(found);
-    cache->count--;
+    // Remove from hash table and eviction queue
+    shard_drop_slot(shard, pos);
 
-    pthread_mutex_unlock(&cache->mutex);
+    pthread_mutex_unlock(&shard->mutex);
     return 0;
 }
 
@@ -542,29 +1957,24 @@ size_t session_cache_cleanup_expired(session_cache_t *cache) {
         return 0;
     }
 
-    pthread_mutex_lock(&cache->mutex);
-
-    time_t now = time(nullptr);
+    int64_t now = cache_clock_now();
     size_t removed = 0;
 
-    // Iterate through LRU list and remove expired entries
-    cache_entry_t *entry = cache->lru_head;
-    while (entry != nullptr) {
-        cache_entry_t *next = entry->lru_next;
-
-        if (entry_is_expired(entry, now)) {
-            hash_remove(cache, entry);
-            lru_remove(cache, entry);
-            entry_free(entry);
-            cache->count--;
-            cache->expirations++;
-            removed++;
+    if (cache->shm != nullptr) {
+        removed = shm_cache_cleanup_expired(cache->shm);
+    } else {
+        for (size_t i = 0; i < cache->shard_count; i++) {
+            cache_shard_t *shard = &cache->shards[i];
+
+            pthread_mutex_lock(&shard->mutex);
+            removed += shard_advance(shard, now);
+            if (shard->filter_saturated) {
+                shard_filter_rebuild(shard);
+            }
+            pthread_mutex_unlock(&shard->mutex);
         }
-
-        entry = next;
     }
 
-    pthread_mutex_unlock(&cache->mutex);
     return removed;
 }
 
@@ -573,11 +1983,7 @@ bool session_cache_is_full(session_cache_t *cache) {
         return false;
     }
 
-    pthread_mutex_lock(&cache->mutex);
-    bool full = (cache->count >= cache->capacity);
-    pthread_mutex_unlock(&cache->mutex);
-
-    return full;
+    return session_cache_size(cache) >= cache->capacity;
 }
 
 size_t session_cache_size(session_cache_t *cache) {
@@ -585,9 +1991,555 @@ size_t session_cache_size(session_cache_t *cache) {
         return 0;
     }
 
-    pthread_mutex_lock(&cache->mutex);
-    size_t size = cache->count;
-    pthread_mutex_unlock(&cache->mutex);
+    if (cache->shm != nullptr) {
+        session_cache_stats_t stats = {0};
+        shm_cache_get_stats(cache->shm, &stats);
+        return stats.count;
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i < cache->shard_count; i++) {
+        cache_shard_t *shard = &cache->shards[i];
+
+        pthread_mutex_lock(&shard->mutex);
+        size += shard->count;
+        pthread_mutex_unlock(&shard->mutex);
+    }
 
     return size;
 }
+
+/* ============================================================================
+ * Snapshot / Restore
+ * ============================================================================ */
+
+/*
+ * File layout (host byte order; every record is 8-byte aligned, so the file
+ * is mapped and walked in place on load):
+ *
+ *   snapshot_header_t | snapshot_record_t id|data|addr pad | ...
+ *
+ * The header checksums itself and records the body size; every record
+ * checksums its own bytes. Records are written least recently used first, so
+ * replaying them in file order restores each shard's recency order.
+ */
+
+constexpr uint64_t SNAPSHOT_MAGIC = 0x5747'534E'4150'0001ULL;   // "WGSNAP" + 1
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr size_t SNAPSHOT_WRITE_BUFFER = 1 << 20;
+constexpr size_t SNAPSHOT_MAX_PAYLOAD = TLS_MAX_SESSION_ID_SIZE + TLS_MAX_SESSION_DATA_SIZE +
+                                        sizeof(struct sockaddr_storage);
+
+// Fixed checksum key: snapshots detect corruption, not tampering (mode 0600)
+static const uint64_t snapshot_checksum_key[2] = {
+    0x7773'6e61'7073'686fULL,
+    0x7420'6373'756d'7631ULL,
+};
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t record_count;
+    uint64_t body_size;         // Bytes of records after the header
+    int64_t saved_at;           // Wall-clock seconds
+    uint64_t reserved[2];
+    uint64_t checksum;          // Of the fields above
+} snapshot_header_t;
+
+typedef struct {
+    uint64_t checksum;          // Of the rest of the record (after this field)
+    uint32_t record_size;       // Header + payload + padding
+    uint16_t session_id_size;
+    uint16_t session_data_size;
+    int64_t expiration;
+    uint32_t remote_addr_len;
+    uint32_t reserved;
+} snapshot_record_t;
+
+static_assert(sizeof(snapshot_header_t) == 64, "snapshot header layout changed");
+static_assert(sizeof(snapshot_record_t) == 32, "snapshot record layout changed");
+
+typedef struct {
+    FILE *fp;
+    int64_t now;                // Wall-clock seconds (expired sessions are skipped)
+    uint64_t record_count;
+    uint64_t body_size;
+
+    // Records copied from the shard being walked, written once it is unlocked
+    uint8_t *buffer;
+    size_t buffer_used;
+    size_t buffer_size;
+} snapshot_writer_t;
+
+static inline uint64_t snapshot_checksum(const void *data, size_t size) {
+    return siphash13(snapshot_checksum_key, data, size);
+}
+
+/**
+ * Grow the writer's buffer
+ *
+ * The buffer holds session secrets, so it is copied by hand rather than with
+ * realloc(), which could leave the old contents in freed memory.
+ */
+static int snapshot_buffer_grow(snapshot_writer_t *writer, size_t size) {
+    uint8_t *buffer = malloc(size);
+    if (buffer == nullptr) {
+        return -1;
+    }
+    if (writer->buffer != nullptr) {
+        memcpy(buffer, writer->buffer, writer->buffer_used);
+        explicit_bzero(writer->buffer, writer->buffer_size);
+        free(writer->buffer);
+    }
+    writer->buffer = buffer;
+    writer->buffer_size = size;
+    return 0;
+}
+
+/**
+ * Copy one session into the writer's buffer (shm_cache_visit_fn)
+ *
+ * Runs with the shard locked, so it only copies: checksums and file I/O wait
+ * for snapshot_flush().
+ */
+static int snapshot_copy_session(void *arg,
+                                 const uint8_t *bytes,
+                                 size_t session_id_size,
+                                 size_t session_data_size,
+                                 size_t remote_addr_len,
+                                 time_t expiration) {
+    snapshot_writer_t *writer = arg;
+
+    if (expiration > 0 && writer->now > (int64_t)expiration) {
+        return 0;
+    }
+
+    size_t payload = session_id_size + session_data_size + remote_addr_len;
+    size_t record_size = (sizeof(snapshot_record_t) + payload + 7) & ~(size_t)7;
+
+    if (writer->buffer_size - writer->buffer_used < record_size) {
+        size_t size = writer->buffer_size > 0 ? writer->buffer_size * 2 : SNAPSHOT_WRITE_BUFFER;
+        if (snapshot_buffer_grow(writer, size) != 0) {
+            return -1;
+        }
+    }
+
+    uint8_t *out = writer->buffer + writer->buffer_used;
+    snapshot_record_t record = {
+        .record_size = (uint32_t)record_size,
+        .session_id_size = (uint16_t)session_id_size,
+        .session_data_size = (uint16_t)session_data_size,
+        .expiration = (int64_t)expiration,
+        .remote_addr_len = (uint32_t)remote_addr_len,
+    };
+    memcpy(out, &record, sizeof(record));
+    memcpy(out + sizeof(snapshot_record_t), bytes, payload);
+    memset(out + sizeof(snapshot_record_t) + payload, 0,
+           record_size - sizeof(snapshot_record_t) - payload);
+
+    writer->buffer_used += record_size;
+    return 0;
+}
+
+/**
+ * Checksum the copied records and write them (shard unlocked)
+ */
+static int snapshot_flush(snapshot_writer_t *writer) {
+    for (size_t offset = 0; offset < writer->buffer_used;) {
+        snapshot_record_t *record = (snapshot_record_t *)(writer->buffer + offset);
+        record->checksum = snapshot_checksum((const uint8_t *)record + sizeof(uint64_t),
+                                             record->record_size - sizeof(uint64_t));
+        offset += record->record_size;
+        writer->record_count++;
+    }
+
+    if (writer->buffer_used > 0 &&
+        fwrite(writer->buffer, 1, writer->buffer_used, writer->fp) != writer->buffer_used) {
+        return -1;
+    }
+
+    writer->body_size += writer->buffer_used;
+    writer->buffer_used = 0;
+    return 0;
+}
+
+// shm_cache_shard_done_fn: write what was copied from the shard just unlocked
+static int snapshot_shard_done(void *arg) {
+    return snapshot_flush(arg);
+}
+
+/**
+ * Copy one in-process shard, least recently used first (caller holds lock)
+ *
+ * S3-FIFO probation sessions go first so that main-queue sessions, which
+ * have already been resumed, end up most recent after a reload.
+ */
+static int shard_snapshot(cache_shard_t *shard, snapshot_writer_t *writer) {
+    const cache_queue_t *queues[] = {&shard->small_queue, &shard->main_queue};
+
+    for (size_t q = 0; q < sizeof(queues) / sizeof(queues[0]); q++) {
+        for (const cache_entry_t *entry = queues[q]->tail; entry != nullptr;
+             entry = entry->queue_prev) {
+            if (snapshot_copy_session(writer, entry_session_id(entry),
+                                      entry->session_id_size, entry->session_data_size,
+                                      entry->remote_addr_len, entry->expiration) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * fsync() the directory holding @p path so a completed rename survives a crash
+ */
+static void snapshot_sync_dir(const char *path) {
+    char *copy = strdup(path);
+    if (copy == nullptr) {
+        return;
+    }
+
+    int fd = open(dirname(copy), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        (void)fsync(fd);
+        close(fd);
+    }
+
+    free(copy);
+}
+
+int session_cache_save(session_cache_t *cache, const char *path, size_t *saved) {
+    // Data owned through free_data (native objects) cannot be persisted
+    if (cache == nullptr || path == nullptr || cache->free_data != nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Write a temporary file and rename it over the target, so a crash
+    // leaves either the previous snapshot or the new one, never a mix. The
+    // name is unique per save, so concurrent saves to the same path (an
+    // explicit one and the snapshot thread's) never write the same file.
+    size_t tmp_size = strlen(path) + sizeof(".tmp.XXXXXX");
+    char *tmp_path = malloc(tmp_size);
+    if (tmp_path == nullptr) {
+        return -1;
+    }
+    snprintf(tmp_path, tmp_size, "%s.tmp.XXXXXX", path);
+
+    // stdio buffers records too: give it a buffer that is wiped afterwards
+    char *io_buffer = malloc(SNAPSHOT_WRITE_BUFFER);
+    int fd = io_buffer != nullptr ? mkstemp(tmp_path) : -1;
+    if (fd >= 0) {
+        (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    FILE *fp = fd >= 0 ? fdopen(fd, "wb") : nullptr;
+    if (fp == nullptr) {
+        int saved_errno = errno;
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path);
+        }
+        free(io_buffer);
+        free(tmp_path);
+        errno = saved_errno;
+        return -1;
+    }
+    setvbuf(fp, io_buffer, _IOFBF, SNAPSHOT_WRITE_BUFFER);
+
+    snapshot_writer_t writer = {.fp = fp, .now = (int64_t)time(nullptr)};
+    snapshot_header_t header = {0};
+    int rc = fwrite(&header, sizeof(header), 1, fp) == 1 ? 0 : -1;
+
+    // Each shard is locked only while its records are copied
+    if (rc == 0 && cache->shm != nullptr) {
+        rc = shm_cache_for_each(cache->shm, snapshot_copy_session, snapshot_shard_done, &writer);
+    } else if (rc == 0) {
+        for (size_t i = 0; i < cache->shard_count && rc == 0; i++) {
+            cache_shard_t *shard = &cache->shards[i];
+
+            pthread_mutex_lock(&shard->mutex);
+            rc = shard_snapshot(shard, &writer);
+            pthread_mutex_unlock(&shard->mutex);
+
+            if (rc == 0) {
+                rc = snapshot_flush(&writer);
+            }
+        }
+    }
+    if (writer.buffer != nullptr) {
+        explicit_bzero(writer.buffer, writer.buffer_size);
+        free(writer.buffer);
+    }
+
+    if (rc == 0) {
+        header = (snapshot_header_t){
+            .magic = SNAPSHOT_MAGIC,
+            .version = SNAPSHOT_VERSION,
+            .header_size = sizeof(snapshot_header_t),
+            .record_count = writer.record_count,
+            .body_size = writer.body_size,
+            .saved_at = writer.now,
+        };
+        header.checksum = snapshot_checksum(&header, offsetof(snapshot_header_t, checksum));
+
+        if (fflush(fp) != 0 || fseek(fp, 0, SEEK_SET) != 0 ||
+            fwrite(&header, sizeof(header), 1, fp) != 1 || fflush(fp) != 0 ||
+            fsync(fileno(fp)) != 0) {
+            rc = -1;
+        }
+    }
+
+    int saved_errno = errno;
+    if (fclose(fp) != 0 && rc == 0) {
+        rc = -1;
+        saved_errno = errno;
+    }
+    explicit_bzero(io_buffer, SNAPSHOT_WRITE_BUFFER);
+    free(io_buffer);
+    if (rc == 0 && rename(tmp_path, path) != 0) {
+        rc = -1;
+        saved_errno = errno;
+    }
+
+    if (rc != 0) {
+        unlink(tmp_path);
+        free(tmp_path);
+        errno = saved_errno;
+        return -1;
+    }
+
+    free(tmp_path);
+    snapshot_sync_dir(path);
+
+    if (saved != nullptr) {
+        *saved = (size_t)writer.record_count;
+    }
+    return 0;
+}
+
+/**
+ * Validate and replay a mapped snapshot into the cache
+ */
+static int snapshot_replay(session_cache_t *cache,
+                           const uint8_t *map,
+                           size_t size,
+                           size_t *loaded) {
+    const snapshot_header_t *header = (const snapshot_header_t *)map;
+
+    if (size < sizeof(snapshot_header_t) || header->magic != SNAPSHOT_MAGIC ||
+        header->version != SNAPSHOT_VERSION ||
+        header->header_size != sizeof(snapshot_header_t) ||
+        header->checksum != snapshot_checksum(header, offsetof(snapshot_header_t, checksum)) ||
+        header->body_size != size - sizeof(snapshot_header_t)) {
+        errno = EBADMSG;
+        return -1;
+    }
+
+    // Reused for every record; store() only reads the used prefix of each field
+    tls_session_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+
+    int64_t now = (int64_t)time(nullptr);
+    size_t offset = sizeof(snapshot_header_t);
+
+    for (uint64_t i = 0; i < header->record_count; i++) {
+        if (size - offset < sizeof(snapshot_record_t)) {
+            errno = EBADMSG;
+            return -1;
+        }
+
+        const snapshot_record_t *record = (const snapshot_record_t *)(map + offset);
+        size_t payload = (size_t)record->session_id_size + record->session_data_size +
+                         record->remote_addr_len;
+
+        if (record->record_size % 8 != 0 || record->record_size > size - offset ||
+            record->session_id_size > TLS_MAX_SESSION_ID_SIZE ||
+            record->session_data_size > TLS_MAX_SESSION_DATA_SIZE ||
+            record->remote_addr_len > sizeof(struct sockaddr_storage) ||
+            sizeof(snapshot_record_t) + payload > record->record_size ||
+            record->checksum != snapshot_checksum((const uint8_t *)record + sizeof(uint64_t),
+                                                  record->record_size - sizeof(uint64_t))) {
+            errno = EBADMSG;
+            return -1;
+        }
+
+        offset += record->record_size;
+
+        // Sessions that expired while we were down stay gone
+        if (record->expiration > 0 && now > record->expiration) {
+            continue;
+        }
+
+        const uint8_t *p = (const uint8_t *)(record + 1);
+        memcpy(entry.session_id, p, record->session_id_size);
+        entry.session_id_size = record->session_id_size;
+        p += record->session_id_size;
+        memcpy(entry.session_data, p, record->session_data_size);
+        entry.session_data_size = record->session_data_size;
+        p += record->session_data_size;
+        memcpy(&entry.remote_addr, p, record->remote_addr_len);
+        entry.remote_addr_len = (socklen_t)record->remote_addr_len;
+        entry.expiration = (time_t)record->expiration;
+
+        if (session_cache_store(cache, &entry) == 0) {
+            (*loaded)++;
+        }
+    }
+
+    if (offset != size) {
+        errno = EBADMSG;
+        return -1;
+    }
+
+    return 0;
+}
+
+int session_cache_load(session_cache_t *cache, const char *path, size_t *loaded) {
+    if (cache == nullptr || path == nullptr || cache->free_data != nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t count = 0;
+    if (loaded != nullptr) {
+        *loaded = 0;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return -1;
+    }
+
+    if ((size_t)st.st_size < sizeof(snapshot_header_t)) {
+        close(fd);
+        errno = EBADMSG;
+        return -1;
+    }
+
+    void *map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    (void)posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    int rc = snapshot_replay(cache, map, (size_t)st.st_size, &count);
+    int saved_errno = errno;
+    munmap(map, (size_t)st.st_size);
+
+    if (loaded != nullptr) {
+        *loaded = count;
+    }
+
+    errno = saved_errno;
+    return rc;
+}
+
+/**
+ * Periodic snapshot thread
+ *
+ * Saving walks every shard and writes the whole file, so it runs here rather
+ * than on a caller's path (lookups, session_cache_cleanup_expired()).
+ */
+static void *snapshot_thread_main(void *arg) {
+    session_cache_t *cache = arg;
+
+    pthread_mutex_lock(&cache->snapshot_lock);
+    while (!cache->snapshot_stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += cache->snapshot_interval;
+
+        while (!cache->snapshot_stopping &&
+               pthread_cond_timedwait(&cache->snapshot_wake, &cache->snapshot_lock,
+                                      &deadline) != ETIMEDOUT) {
+        }
+        if (!cache->snapshot_stopping) {
+            (void)session_cache_save(cache, cache->snapshot_path, nullptr);
+        }
+    }
+    pthread_mutex_unlock(&cache->snapshot_lock);
+    return nullptr;
+}
+
+// Start the periodic snapshot thread; 0 or an errno value
+static int snapshot_thread_start(session_cache_t *cache) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&cache->snapshot_lock, nullptr);
+    pthread_cond_init(&cache->snapshot_wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    cache->snapshot_stopping = false;
+    int ret = pthread_create(&cache->snapshot_thread, nullptr, snapshot_thread_main, cache);
+    if (ret != 0) {
+        pthread_cond_destroy(&cache->snapshot_wake);
+        pthread_mutex_destroy(&cache->snapshot_lock);
+        return ret;
+    }
+
+    cache->snapshot_running = true;
+    return 0;
+}
+
+// Stop the periodic snapshot thread, waiting for a save in progress
+static void snapshot_thread_stop(session_cache_t *cache) {
+    if (!cache->snapshot_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->snapshot_lock);
+    cache->snapshot_stopping = true;
+    pthread_cond_signal(&cache->snapshot_wake);
+    pthread_mutex_unlock(&cache->snapshot_lock);
+    pthread_join(cache->snapshot_thread, nullptr);
+
+    pthread_cond_destroy(&cache->snapshot_wake);
+    pthread_mutex_destroy(&cache->snapshot_lock);
+    cache->snapshot_running = false;
+}
+
+int session_cache_set_snapshot(session_cache_t *cache,
+                               const char *path,
+                               unsigned int interval_secs) {
+    if (cache == nullptr || (path != nullptr && cache->free_data != nullptr)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    char *copy = nullptr;
+    if (path != nullptr) {
+        copy = strdup(path);
+        if (copy == nullptr) {
+            return -1;
+        }
+    }
+
+    snapshot_thread_stop(cache);
+    free(cache->snapshot_path);
+    cache->snapshot_path = copy;
+    cache->snapshot_interval = interval_secs;
+
+    if (copy != nullptr && interval_secs > 0) {
+        int ret = snapshot_thread_start(cache);
+        if (ret != 0) {
+            free(cache->snapshot_path);
+            cache->snapshot_path = nullptr;
+            errno = ret;
+            return -1;
+        }
+    }
+
+    return 0;
+}
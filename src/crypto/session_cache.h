@@ -28,15 +28,41 @@
  * Features:
  * - Fast O(1) lookup by session ID (hash table)
  * - Automatic expiration of old sessions
- * - LRU eviction when cache is full
- * - Thread-safe operations (mutex-protected)
- * - Configurable capacity and timeout
+ * - LRU or S3-FIFO eviction when cache is full
+ * - Thread-safe operations (lock-striped shards)
+ * - Configurable capacity, timeout and shard count
  * - Zero-copy where possible
  *
  * Design:
- * - Hash table: session_id (first 8 bytes) → cache entry
- * - LRU list: doubly-linked list tracking access order
- * - Cleanup: periodic expiration check (on access)
+ * - Hash: keyed SipHash-1-3 over the full session_id (random per-cache key)
+ * - Shards: session_id hash → one of N independently locked shards
+ * - Hash table: open addressing with Robin Hood probing (per shard), grows
+ *   on demand up to the shard capacity
+ * - Eviction: LRU list, or S3-FIFO small/main queues + ghost set (per shard)
+ * - Storage: variable-length entries in slab size classes (per shard), so
+ *   each session only costs the ID/data bytes it actually uses
+ * - Expiry: hierarchical timing wheel per shard (4 x 64 one-second slots),
+ *   advanced on access from a cached CLOCK_MONOTONIC_COARSE timestamp
+ *
+ * Sharding:
+ *   Each shard owns its own mutex, hash table, LRU list, capacity slice and
+ *   statistics, so concurrent handshakes only contend when their session IDs
+ *   land in the same shard. Eviction is LRU within a shard (approximate LRU
+ *   across the whole cache). Statistics are aggregated over all shards.
+ *
+ * Shared mode (session_cache_new_shared):
+ *   The cache lives in a named POSIX shared-memory segment so that forked
+ *   workers, or unrelated processes of the same user, resume each other's
+ *   sessions without IPC to a central process. Shards are guarded by robust
+ *   process-shared mutexes; a worker dying mid-operation only costs the
+ *   sessions of the shard it held. Shared caches use fixed-size records and
+ *   LRU eviction, and their size is fixed when the segment is created.
+ *
+ * Snapshots (session_cache_save / session_cache_load):
+ *   The cache can be written to a checksummed file and replayed at startup,
+ *   so a restart or deploy does not send every client back to a full
+ *   handshake at once. Sessions keep their original expiration; those that
+ *   expired while the server was down are dropped on load.
  *
  * Usage:
  *   session_cache_t *cache = session_cache_new(1000, 7200); // 1000 entries, 2h timeout
@@ -45,6 +71,9 @@
  *                                  session_cache_retrieve,
  *                                  session_cache_remove,
  *                                  cache);
+ *   tls_context_set_session_cache_lease(ctx,
+ *                                        session_cache_borrow,
+ *                                        session_cache_release);
  *   // ... use TLS context ...
  *   session_cache_free(cache);
  */
@@ -66,7 +95,15 @@ constexpr size_t SESSION_CACHE_DEFAULT_CAPACITY = 1'000;
 constexpr unsigned int SESSION_CACHE_DEFAULT_TIMEOUT_SECS = 7'200; // 2 hours
 
 // Hash table configuration
-constexpr size_t SESSION_CACHE_HASH_BUCKETS = 256; // Power of 2 for fast modulo
+constexpr size_t SESSION_CACHE_INITIAL_SLOTS = 16; // Per shard, power of 2
+
+// Shard configuration
+constexpr size_t SESSION_CACHE_DEFAULT_SHARDS = 16;       // Power of 2
+constexpr size_t SESSION_CACHE_MAX_SHARDS = 1'024;        // Power of 2
+constexpr size_t SESSION_CACHE_MIN_SHARD_CAPACITY = 64;   // Entries per shard
+
+// Shared-memory mode: bytes reserved per session for ID + data + address
+constexpr size_t SESSION_CACHE_SHARED_DEFAULT_ENTRY_SIZE = 2'048;
 
 /* ============================================================================
  * Opaque Types
@@ -77,6 +114,105 @@ constexpr size_t SESSION_CACHE_HASH_BUCKETS = 256; // Power of 2 for fast modulo
  */
 typedef struct session_cache session_cache_t;
 
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+/**
+ * Eviction policy
+ *
+ * SESSION_CACHE_POLICY_LRU moves an entry to the front on every hit.
+ *
+ * SESSION_CACHE_POLICY_S3FIFO (Yang et al., SOSP'23) admits new sessions to a
+ * small probation FIFO (10% of capacity) and only promotes those that are
+ * resumed before they reach its tail. A hit just bumps a 2-bit counter, so
+ * lookups write no list pointers, and floods of one-shot clients cycle
+ * through the probation queue without evicting regularly reconnecting users.
+ */
+typedef enum {
+    SESSION_CACHE_POLICY_LRU = 0,   // Default
+    SESSION_CACHE_POLICY_S3FIFO,
+} session_cache_policy_t;
+
+/**
+ * Hook that releases a session's data when the cache lets go of it
+ *
+ * @param session_data Stored session data
+ * @param session_data_size Length of session data
+ */
+typedef void (*session_cache_free_data_fn)(const uint8_t *session_data,
+                                           size_t session_data_size);
+
+/**
+ * Session cache configuration
+ *
+ * Zero-initialized fields select the documented defaults, so callers can use
+ * designated initializers and only set what they care about:
+ *
+ *   session_cache_config_t config = {
+ *       .capacity = 100'000,
+ *       .timeout_secs = 7'200,
+ *       .shard_count = 32,
+ *   };
+ */
+typedef struct {
+    size_t capacity;            // Maximum number of sessions (required, > 0)
+    unsigned int timeout_secs;  // Session timeout (required, > 0)
+
+    // Number of independently locked shards. Rounded down to a power of 2
+    // and clamped so that every shard holds at least
+    // SESSION_CACHE_MIN_SHARD_CAPACITY entries (small caches use one shard
+    // and keep exact LRU order). 0 selects SESSION_CACHE_DEFAULT_SHARDS.
+    size_t shard_count;
+
+    // Eviction policy (0 = SESSION_CACHE_POLICY_LRU). Shared caches only
+    // support LRU.
+    session_cache_policy_t policy;
+
+    // Shared mode only: bytes reserved per session for session ID, data and
+    // remote address. Larger sessions are not cached. 0 selects
+    // SESSION_CACHE_SHARED_DEFAULT_ENTRY_SIZE.
+    size_t shared_entry_size;
+
+    // Optional: called with the session data of every entry the cache drops
+    // (eviction, expiry, removal, replacement, clear, free), so that the
+    // cache can own native session objects stored by pointer. With a hook,
+    // a successful session_cache_store() always takes ownership of the
+    // stored data, even when the session is not kept because it has already
+    // expired. Not supported for shared caches or snapshots.
+    session_cache_free_data_fn free_data;
+
+    // Optional negative lookup filter: a per-shard counting Bloom filter kept
+    // in sync by store, remove, eviction and expiry, so that retrieve() and
+    // borrow() reject unknown session IDs without taking the shard lock.
+    // Costs 12-24 bytes per unit of capacity. Not supported for shared
+    // caches.
+    bool negative_filter;
+} session_cache_config_t;
+
+/**
+ * Detailed cache statistics (see session_cache_get_stats_ex)
+ */
+typedef struct {
+    size_t count;               // Current number of cached sessions
+    size_t capacity;            // Maximum capacity
+    uint64_t hits;              // Successful retrievals
+    uint64_t misses;            // Failed retrievals (including expired)
+    uint64_t evictions;         // Capacity evictions
+    uint64_t expirations;       // Entries dropped because they expired
+
+    // Memory accounting
+    size_t entry_bytes;         // Slab blocks holding live sessions
+    size_t slab_bytes;          // Slab pages reserved (live + free blocks)
+    size_t table_bytes;         // Hash tables and shard structures
+    size_t bytes_per_session;   // (slab_bytes + table_bytes) / count, 0 if empty
+
+    // Negative filter (session_cache_config_t.negative_filter)
+    uint64_t filter_rejects;            // Misses answered by the filter (part of misses)
+    uint64_t filter_false_positives;    // Lookups that passed the filter and missed
+    double filter_false_positive_rate;  // false_positives / (false_positives + rejects)
+} session_cache_stats_t;
+
 /* ============================================================================
  * Cache Management
  * ============================================================================ */
@@ -89,10 +225,61 @@ typedef struct session_cache session_cache_t;
  * @return Cache handle on success, nullptr on failure
  *
  * Note: capacity must be > 0, timeout_secs must be > 0
+ *       Uses the default shard count (see session_cache_config_t).
  */
 [[nodiscard]] session_cache_t* session_cache_new(size_t capacity,
                                                    unsigned int timeout_secs);
 
+/**
+ * Create new session cache from explicit configuration
+ *
+ * @param config Cache configuration
+ * @return Cache handle on success, nullptr on failure (errno = EINVAL for
+ *         invalid configuration)
+ */
+[[nodiscard]] session_cache_t* session_cache_new_with_config(
+    const session_cache_config_t *config);
+
+/**
+ * Create or attach to a session cache in named shared memory
+ *
+ * With @p config, creates the segment @p name if it does not exist yet, or
+ * attaches to it if it does (its existing geometry wins). With a nullptr
+ * @p config, only attaches. Every process that maps the segment, including
+ * children forked after this call, serves lookups and stores directly from
+ * shared memory.
+ *
+ * @param name POSIX shared-memory name ("/wolfguard-sessions")
+ * @param config Cache configuration, or nullptr to attach only
+ * @return Cache handle on success, nullptr on failure (errno = EINVAL for
+ *         invalid configuration, ENOENT if attaching to a missing segment,
+ *         EPROTO if the segment is not a compatible session cache)
+ *
+ * Note: The segment is created with mode 0600. session_cache_free() only
+ *       unmaps it; use session_cache_unlink_shared() to remove it.
+ */
+[[nodiscard]] session_cache_t* session_cache_new_shared(const char *name,
+                                                          const session_cache_config_t *config);
+
+/**
+ * Remove a shared session cache segment name
+ *
+ * @param name POSIX shared-memory name
+ * @return 0 on success, -1 on failure (errno set)
+ *
+ * Note: Processes that already mapped the cache keep using it until they
+ *       call session_cache_free().
+ */
+int session_cache_unlink_shared(const char *name);
+
+/**
+ * Get number of shards actually used by the cache
+ *
+ * @param cache Cache handle
+ * @return Shard count (power of 2), 0 if cache is nullptr
+ */
+[[nodiscard]] size_t session_cache_shard_count(session_cache_t *cache);
+
 /**
  * Free session cache
  *
@@ -115,12 +302,15 @@ void session_cache_clear(session_cache_t *cache);
 /**
  * Get cache statistics
  *
+ * Values are aggregated over all shards. Each shard is locked in turn, so the
+ * result is not an atomic snapshot of the whole cache while it is in use.
+ *
  * @param cache Cache handle
  * @param count Output: current number of cached sessions
  * @param capacity Output: maximum capacity
  * @param hits Output: number of successful retrievals
  * @param misses Output: number of failed retrievals
- * @param evictions Output: number of LRU evictions
+ * @param evictions Output: number of capacity evictions
  */
 void session_cache_get_stats(session_cache_t *cache,
                               size_t *count,
@@ -129,6 +319,19 @@ void session_cache_get_stats(session_cache_t *cache,
                               uint64_t *misses,
                               uint64_t *evictions);
 
+/**
+ * Get detailed cache statistics, including memory usage
+ *
+ * Same aggregation rules as session_cache_get_stats(). bytes_per_session is
+ * the total memory held by the cache divided by the number of live sessions,
+ * i.e. what one more resumable session costs in RAM at the current fill.
+ *
+ * @param cache Cache handle
+ * @param stats Output: statistics
+ * @return 0 on success, -1 on invalid arguments
+ */
+int session_cache_get_stats_ex(session_cache_t *cache, session_cache_stats_t *stats);
+
 /* ============================================================================
  * TLS Callback Functions
  * ============================================================================ */
@@ -142,7 +345,8 @@ void session_cache_get_stats(session_cache_t *cache,
  *
  * Note: This function is called by TLS backend when new session is established.
  *       It performs LRU eviction if cache is full.
- *       Expired sessions are automatically removed.
+ *       Expired sessions are automatically removed. A session whose
+ *       expiration is already in the past is not cached (returns 0).
  */
 int session_cache_store(void *userdata, const tls_session_cache_entry_t *entry);
 
@@ -164,6 +368,43 @@ int session_cache_retrieve(void *userdata,
                             size_t session_id_size,
                             tls_session_cache_entry_t *entry);
 
+/**
+ * Borrow a read-only view of a cached session (TLS lease callback)
+ *
+ * Like session_cache_retrieve(), but instead of copying the session into a
+ * caller-provided tls_session_cache_entry_t it pins the stored entry and
+ * points @p lease at its session data. The entry may be evicted, replaced or
+ * expire while leased; its bytes stay valid and unchanged until
+ * session_cache_release().
+ *
+ * @param userdata Cache handle (session_cache_t*)
+ * @param session_id Session ID to look up
+ * @param session_id_size Length of session ID
+ * @param lease Output: borrowed view
+ * @return 0 on success, -1 if not found or expired
+ *
+ * Note: Every successful borrow must be released, and all leases must be
+ *       released before session_cache_free(). Shared caches return a
+ *       private copy of the session data (other processes may overwrite the
+ *       shared record).
+ *
+ * Usage:
+ *   tls_context_set_session_cache_lease(ctx, session_cache_borrow,
+ *                                       session_cache_release);
+ */
+int session_cache_borrow(void *userdata,
+                          const uint8_t *session_id,
+                          size_t session_id_size,
+                          tls_session_lease_t *lease);
+
+/**
+ * Return a lease obtained from session_cache_borrow() (TLS lease callback)
+ *
+ * @param userdata Cache handle (session_cache_t*)
+ * @param lease Lease to release (reset to empty)
+ */
+void session_cache_release(void *userdata, tls_session_lease_t *lease);
+
 /**
  * Remove session from cache (TLS callback)
  *
@@ -178,6 +419,67 @@ int session_cache_remove(void *userdata,
                           const uint8_t *session_id,
                           size_t session_id_size);
 
+/* ============================================================================
+ * Snapshot / Restore
+ * ============================================================================ */
+
+/**
+ * Write all live sessions to a snapshot file
+ *
+ * The snapshot is written to a temporary file, fsync()ed and renamed over
+ * @p path, so a crash at any point leaves either the old or the new snapshot.
+ * The file holds session secrets and is created with mode 0600.
+ *
+ * @param cache Cache handle
+ * @param path Snapshot file path
+ * @param saved Output: number of sessions written (may be nullptr)
+ * @return 0 on success, -1 on failure (errno set)
+ *
+ * Note: Each shard is locked only while its sessions are copied to memory;
+ *       the file is written after the lock is released, so lookups never
+ *       wait for file I/O.
+ */
+int session_cache_save(session_cache_t *cache, const char *path, size_t *saved);
+
+/**
+ * Load sessions from a snapshot file
+ *
+ * The file is mapped and replayed through session_cache_store(), least
+ * recently used first, so recency order survives the restart. Expired
+ * sessions are skipped; loading more sessions than the capacity evicts as
+ * usual.
+ *
+ * @param cache Cache handle
+ * @param path Snapshot file path
+ * @param loaded Output: number of sessions loaded (may be nullptr)
+ * @return 0 on success, -1 on failure (errno = ENOENT if there is no
+ *         snapshot, EBADMSG if it is damaged or from another version)
+ *
+ * Note: Records are checked one by one as they are replayed. If a damaged
+ *       record is found, the sessions before it stay loaded and -1 is returned.
+ */
+int session_cache_load(session_cache_t *cache, const char *path, size_t *loaded);
+
+/**
+ * Configure automatic snapshots
+ *
+ * With a @p path, a background thread saves the cache every
+ * @p interval_secs seconds (0 = never periodically), and session_cache_free()
+ * saves it once more. A nullptr @p path disables automatic snapshots.
+ *
+ * @param cache Cache handle
+ * @param path Snapshot file path (copied), or nullptr
+ * @param interval_secs Seconds between periodic snapshots, 0 for shutdown only
+ * @return 0 on success, -1 on failure (errno set; automatic snapshots are
+ *         then disabled)
+ *
+ * Note: Not thread-safe with respect to other calls on the same cache; call
+ *       it during setup. For shared caches, enable it in one process only.
+ */
+int session_cache_set_snapshot(session_cache_t *cache,
+                               const char *path,
+                               unsigned int interval_secs);
+
 /* ============================================================================
  * Utility Functions
  * ============================================================================ */
@@ -189,7 +491,9 @@ int session_cache_remove(void *userdata,
  * @return Number of sessions removed
  *
  * Note: This function is optional - expiration happens automatically on access.
- *       Can be called periodically for proactive cleanup.
+ *       Can be called periodically for proactive cleanup. It only advances
+ *       each shard's timing wheel to the current second, so the cost is
+ *       proportional to elapsed seconds and expired sessions, not cache size.
  */
 size_t session_cache_cleanup_expired(session_cache_t *cache);
 
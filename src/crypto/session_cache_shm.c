@@ -0,0 +1,857 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // For shm_open(), robust mutexes, nanosleep()
+
+#include "session_cache_shm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+// Wall clock updated once per tick (expirations are wall-clock seconds)
+#ifndef CLOCK_REALTIME_COARSE
+#define CLOCK_REALTIME_COARSE CLOCK_REALTIME
+#endif
+
+/* ============================================================================
+ * Segment Layout
+ * ============================================================================ */
+
+constexpr uint64_t SHM_MAGIC = 0x5747'4353'484D'0001ULL;   // "WGCSHM" + 1
+constexpr uint32_t SHM_VERSION = 1;
+constexpr uint32_t SHM_NONE = UINT32_MAX;                   // Null record index
+constexpr size_t SHM_ALIGN = 64;
+
+// How long attach waits for a concurrent creator to finish initializing
+constexpr int SHM_ATTACH_RETRIES = 1'000;
+constexpr long SHM_ATTACH_RETRY_NS = 1'000'000;              // 1 ms
+
+/**
+ * Segment header (offset 0)
+ */
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    _Atomic uint32_t ready;     // Set (release) once the creator is done
+    uint64_t segment_size;
+
+    uint64_t capacity;
+    uint32_t timeout_secs;
+    uint32_t shard_count;
+    uint32_t records_per_shard;
+    uint32_t record_size;
+    uint32_t payload_size;      // Bytes for ID + data + address per record
+    uint32_t slots_per_shard;   // Power of 2
+    uint64_t hash_key[2];
+
+    uint64_t shards_offset;
+    uint64_t slots_offset;
+    uint64_t records_offset;
+} shm_header_t;
+
+/**
+ * Shard control block (protected by its robust mutex)
+ */
+typedef struct {
+    alignas(SHM_ALIGN) pthread_mutex_t mutex;
+
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t lru_head;          // Most recently used record
+    uint32_t lru_tail;          // Least recently used record
+    uint32_t free_head;         // Released records
+    uint32_t next_unused;       // Records never handed out yet
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t expirations;
+} shm_shard_t;
+
+/**
+ * Hash table slot (ref = record index + 1, 0 = empty so that fresh zero
+ * pages of the segment are a valid empty table)
+ */
+typedef struct {
+    uint64_t hash;
+    uint32_t ref;
+    uint32_t reserved;
+} shm_slot_t;
+
+/**
+ * Session record (fixed size: header + payload_size bytes)
+ */
+typedef struct {
+    uint64_t hash;
+    uint32_t lru_prev;
+    uint32_t lru_next;
+    int64_t expiration;
+    uint16_t session_id_size;
+    uint16_t session_data_size;
+    uint32_t remote_addr_len;
+
+    // session_id | session_data | remote_addr
+    alignas(8) uint8_t bytes[];
+} shm_record_t;
+
+/**
+ * Process-local mapping
+ */
+struct shm_cache {
+    uint8_t *base;
+    size_t size;
+    shm_header_t *header;
+    shm_shard_t *shards;
+};
+
+/**
+ * Shard plus its slot table and record pool (resolved per operation)
+ */
+typedef struct {
+    shm_shard_t *shard;
+    shm_slot_t *slots;
+    size_t slot_mask;
+    uint8_t *records;
+    size_t record_size;
+    uint32_t records_per_shard;
+} shard_view_t;
+
+static inline size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static shard_view_t shard_view(shm_cache_t *shm, size_t index) {
+    const shm_header_t *hdr = shm->header;
+
+    return (shard_view_t){
+        .shard = &shm->shards[index],
+        .slots = (shm_slot_t *)(shm->base + hdr->slots_offset) + index * hdr->slots_per_shard,
+        .slot_mask = hdr->slots_per_shard - 1,
+        .records = shm->base + hdr->records_offset +
+                   index * (size_t)hdr->records_per_shard * hdr->record_size,
+        .record_size = hdr->record_size,
+        .records_per_shard = hdr->records_per_shard,
+    };
+}
+
+static inline size_t shard_index_for_hash(const shm_cache_t *shm, uint64_t hash) {
+    return (size_t)(hash >> 32) & (shm->header->shard_count - 1);
+}
+
+static inline shm_record_t* record_at(const shard_view_t *view, uint32_t index) {
+    return (shm_record_t *)(view->records + (size_t)index * view->record_size);
+}
+
+static inline int64_t shm_clock_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return (int64_t)ts.tv_sec;
+}
+
+static inline bool record_is_expired(const shm_record_t *record, int64_t now) {
+    return record->expiration > 0 && now > record->expiration;
+}
+
+/* ============================================================================
+ * LRU List (record indices)
+ * ============================================================================ */
+
+static void lru_unlink(const shard_view_t *view, uint32_t index) {
+    shm_record_t *record = record_at(view, index);
+
+    if (record->lru_prev != SHM_NONE) {
+        record_at(view, record->lru_prev)->lru_next = record->lru_next;
+    } else {
+        view->shard->lru_head = record->lru_next;
+    }
+
+    if (record->lru_next != SHM_NONE) {
+        record_at(view, record->lru_next)->lru_prev = record->lru_prev;
+    } else {
+        view->shard->lru_tail = record->lru_prev;
+    }
+
+    record->lru_prev = SHM_NONE;
+    record->lru_next = SHM_NONE;
+}
+
+static void lru_push_front(const shard_view_t *view, uint32_t index) {
+    shm_record_t *record = record_at(view, index);
+
+    record->lru_prev = SHM_NONE;
+    record->lru_next = view->shard->lru_head;
+
+    if (view->shard->lru_head != SHM_NONE) {
+        record_at(view, view->shard->lru_head)->lru_prev = index;
+    } else {
+        view->shard->lru_tail = index;
+    }
+
+    view->shard->lru_head = index;
+}
+
+/* ============================================================================
+ * Hash Table (linear probing, backward-shift deletion)
+ * ============================================================================ */
+
+/**
+ * Find slot for a session ID, or the empty slot ending its probe sequence
+ *
+ * @return true if found
+ */
+static bool table_lookup(const shard_view_t *view,
+                         uint64_t hash,
+                         const uint8_t *session_id,
+                         size_t session_id_size,
+                         size_t *pos_out) {
+    size_t pos = (size_t)hash & view->slot_mask;
+
+    while (view->slots[pos].ref != 0) {
+        if (view->slots[pos].hash == hash) {
+            const shm_record_t *record = record_at(view, view->slots[pos].ref - 1);
+            if (record->session_id_size == session_id_size &&
+                memcmp(record->bytes, session_id, session_id_size) == 0) {
+                *pos_out = pos;
+                return true;
+            }
+        }
+        pos = (pos + 1) & view->slot_mask;
+    }
+
+    *pos_out = pos;
+    return false;
+}
+
+/**
+ * Delete slot @p pos, shifting later members of the cluster back (Knuth R)
+ */
+static void table_delete(const shard_view_t *view, size_t pos) {
+    size_t hole = pos;
+    size_t next = pos;
+
+    for (;;) {
+        next = (next + 1) & view->slot_mask;
+        if (view->slots[next].ref == 0) {
+            break;
+        }
+
+        // Move next into the hole unless its home lies cyclically in (hole, next]
+        size_t home = (size_t)view->slots[next].hash & view->slot_mask;
+        bool stays = (hole <= next) ? (hole < home && home <= next)
+                                    : (hole < home || home <= next);
+        if (!stays) {
+            view->slots[hole] = view->slots[next];
+            hole = next;
+        }
+    }
+
+    view->slots[hole] = (shm_slot_t){0};
+}
+
+/**
+ * Find the slot that references record @p index
+ */
+static size_t table_slot_of(const shard_view_t *view, uint32_t index) {
+    const shm_record_t *record = record_at(view, index);
+    size_t pos = (size_t)record->hash & view->slot_mask;
+
+    while (view->slots[pos].ref != index + 1) {
+        pos = (pos + 1) & view->slot_mask;
+    }
+
+    return pos;
+}
+
+/* ============================================================================
+ * Record Pool
+ * ============================================================================ */
+
+static uint32_t record_alloc(const shard_view_t *view) {
+    shm_shard_t *shard = view->shard;
+
+    if (shard->free_head != SHM_NONE) {
+        uint32_t index = shard->free_head;
+        shard->free_head = record_at(view, index)->lru_next;
+        return index;
+    }
+
+    if (shard->next_unused < view->records_per_shard) {
+        return shard->next_unused++;
+    }
+
+    return SHM_NONE;
+}
+
+/**
+ * Unlink record from table and LRU, zero it and return it to the free list
+ */
+static void record_drop(const shard_view_t *view, size_t slot_pos, uint32_t index) {
+    table_delete(view, slot_pos);
+    lru_unlink(view, index);
+
+    shm_record_t *record = record_at(view, index);
+    memset(record, 0, view->record_size);
+    record->lru_next = view->shard->free_head;
+    view->shard->free_head = index;
+    view->shard->count--;
+}
+
+static void record_fill(shm_record_t *record, uint64_t hash, const tls_session_cache_entry_t *entry) {
+    record->hash = hash;
+    record->expiration = (int64_t)entry->expiration;
+    record->session_id_size = (uint16_t)entry->session_id_size;
+    record->session_data_size = (uint16_t)entry->session_data_size;
+    record->remote_addr_len = (uint32_t)entry->remote_addr_len;
+
+    uint8_t *p = record->bytes;
+    memcpy(p, entry->session_id, entry->session_id_size);
+    p += entry->session_id_size;
+    memcpy(p, entry->session_data, entry->session_data_size);
+    p += entry->session_data_size;
+    memcpy(p, &entry->remote_addr, entry->remote_addr_len);
+}
+
+static void record_export(const shm_record_t *record, tls_session_cache_entry_t *entry) {
+    const uint8_t *p = record->bytes;
+
+    memcpy(entry->session_id, p, record->session_id_size);
+    entry->session_id_size = record->session_id_size;
+    p += record->session_id_size;
+
+    memcpy(entry->session_data, p, record->session_data_size);
+    entry->session_data_size = record->session_data_size;
+    p += record->session_data_size;
+
+    memset(&entry->remote_addr, 0, sizeof(entry->remote_addr));
+    memcpy(&entry->remote_addr, p, record->remote_addr_len);
+    entry->remote_addr_len = (socklen_t)record->remote_addr_len;
+    entry->expiration = (time_t)record->expiration;
+}
+
+/* ============================================================================
+ * Shard Locking
+ * ============================================================================ */
+
+/**
+ * Reset shard to empty (caller holds or is recovering its mutex)
+ */
+static void shard_reset(const shard_view_t *view) {
+    shm_shard_t *shard = view->shard;
+
+    // Zero every record ever handed out (session secrets)
+    memset(view->records, 0, (size_t)shard->next_unused * view->record_size);
+    memset(view->slots, 0, (view->slot_mask + 1) * sizeof(shm_slot_t));
+
+    shard->count = 0;
+    shard->lru_head = SHM_NONE;
+    shard->lru_tail = SHM_NONE;
+    shard->free_head = SHM_NONE;
+    shard->next_unused = 0;
+}
+
+/**
+ * Lock shard, recovering it if the previous owner died while holding it
+ *
+ * @return 0 on success, -1 if the mutex is unusable
+ */
+static int shard_lock(const shard_view_t *view) {
+    int rc = pthread_mutex_lock(&view->shard->mutex);
+
+    if (rc == EOWNERDEAD) {
+        // Lists may be half updated: drop the shard's sessions and continue
+        shard_reset(view);
+        pthread_mutex_consistent(&view->shard->mutex);
+        return 0;
+    }
+
+    return rc == 0 ? 0 : -1;
+}
+
+static inline void shard_unlock(const shard_view_t *view) {
+    pthread_mutex_unlock(&view->shard->mutex);
+}
+
+/* ============================================================================
+ * Segment Creation / Attach
+ * ============================================================================ */
+
+static int shard_mutex_init(pthread_mutex_t *mutex) {
+    pthread_mutexattr_t attr;
+
+    if (pthread_mutexattr_init(&attr) != 0) {
+        return -1;
+    }
+
+    int rc = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    if (rc == 0) {
+        rc = pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    }
+    if (rc == 0) {
+        rc = pthread_mutex_init(mutex, &attr);
+    }
+
+    pthread_mutexattr_destroy(&attr);
+    return rc == 0 ? 0 : -1;
+}
+
+static shm_cache_t* shm_cache_map(int fd, size_t size) {
+    shm_cache_t *shm = calloc(1, sizeof(shm_cache_t));
+    if (shm == nullptr) {
+        return nullptr;
+    }
+
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        free(shm);
+        return nullptr;
+    }
+
+    shm->base = base;
+    shm->size = size;
+    shm->header = base;
+    return shm;
+}
+
+static shm_cache_t* shm_cache_create(int fd,
+                                     const session_cache_config_t *config,
+                                     const uint64_t hash_key[2]) {
+    size_t shard_count = config->shard_count;
+    size_t records_per_shard = (config->capacity + shard_count - 1) / shard_count;
+    size_t payload = config->shared_entry_size != 0 ? config->shared_entry_size
+                                                    : SESSION_CACHE_SHARED_DEFAULT_ENTRY_SIZE;
+    size_t record_size = align_up(sizeof(shm_record_t) + payload, 8);
+
+    // Keep the table at most 7/8 full so probe sequences always terminate
+    size_t slots_per_shard = 1;
+    while (slots_per_shard * 7 < (records_per_shard + 1) * 8) {
+        slots_per_shard *= 2;
+    }
+
+    if (records_per_shard >= SHM_NONE || record_size > UINT32_MAX ||
+        payload > TLS_MAX_SESSION_ID_SIZE + TLS_MAX_SESSION_DATA_SIZE +
+                  sizeof(struct sockaddr_storage)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    size_t shards_offset = align_up(sizeof(shm_header_t), SHM_ALIGN);
+    size_t slots_offset = align_up(shards_offset + shard_count * sizeof(shm_shard_t), SHM_ALIGN);
+    size_t records_offset = align_up(slots_offset +
+                                     shard_count * slots_per_shard * sizeof(shm_slot_t),
+                                     SHM_ALIGN);
+    size_t size = records_offset + shard_count * records_per_shard * record_size;
+
+    // Fresh shm pages are zero-filled and only materialize when touched
+    if (ftruncate(fd, (off_t)size) != 0) {
+        return nullptr;
+    }
+
+    shm_cache_t *shm = shm_cache_map(fd, size);
+    if (shm == nullptr) {
+        return nullptr;
+    }
+
+    shm_header_t *hdr = shm->header;
+    hdr->magic = SHM_MAGIC;
+    hdr->version = SHM_VERSION;
+    hdr->segment_size = size;
+    hdr->capacity = config->capacity;
+    hdr->timeout_secs = config->timeout_secs;
+    hdr->shard_count = (uint32_t)shard_count;
+    hdr->records_per_shard = (uint32_t)records_per_shard;
+    hdr->record_size = (uint32_t)record_size;
+    hdr->payload_size = (uint32_t)(record_size - sizeof(shm_record_t));
+    hdr->slots_per_shard = (uint32_t)slots_per_shard;
+    hdr->hash_key[0] = hash_key[0];
+    hdr->hash_key[1] = hash_key[1];
+    hdr->shards_offset = shards_offset;
+    hdr->slots_offset = slots_offset;
+    hdr->records_offset = records_offset;
+
+    shm->shards = (shm_shard_t *)(shm->base + shards_offset);
+
+    // Split capacity across shards (first shards take the remainder)
+    size_t base = config->capacity / shard_count;
+    size_t extra = config->capacity % shard_count;
+
+    for (size_t i = 0; i < shard_count; i++) {
+        shm_shard_t *shard = &shm->shards[i];
+
+        if (shard_mutex_init(&shard->mutex) != 0) {
+            shm_cache_close(shm);
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        shard->capacity = (uint32_t)(base + (i < extra ? 1 : 0));
+        shard->lru_head = SHM_NONE;
+        shard->lru_tail = SHM_NONE;
+        shard->free_head = SHM_NONE;
+    }
+
+    atomic_store_explicit(&hdr->ready, 1, memory_order_release);
+    return shm;
+}
+
+static shm_cache_t* shm_cache_attach(int fd) {
+    struct timespec delay = {.tv_sec = 0, .tv_nsec = SHM_ATTACH_RETRY_NS};
+    struct stat st;
+
+    // Wait for the creator to size and initialize the segment
+    for (int i = 0; ; i++) {
+        if (fstat(fd, &st) != 0) {
+            return nullptr;
+        }
+        if ((size_t)st.st_size >= sizeof(shm_header_t)) {
+            break;
+        }
+        if (i == SHM_ATTACH_RETRIES) {
+            errno = ETIMEDOUT;
+            return nullptr;
+        }
+        nanosleep(&delay, nullptr);
+    }
+
+    shm_cache_t *shm = shm_cache_map(fd, (size_t)st.st_size);
+    if (shm == nullptr) {
+        return nullptr;
+    }
+
+    for (int i = 0; atomic_load_explicit(&shm->header->ready, memory_order_acquire) == 0; i++) {
+        if (i == SHM_ATTACH_RETRIES) {
+            shm_cache_close(shm);
+            errno = ETIMEDOUT;
+            return nullptr;
+        }
+        nanosleep(&delay, nullptr);
+    }
+
+    const shm_header_t *hdr = shm->header;
+    if (hdr->magic != SHM_MAGIC || hdr->version != SHM_VERSION ||
+        hdr->segment_size != shm->size || hdr->shard_count == 0 ||
+        (hdr->shard_count & (hdr->shard_count - 1)) != 0) {
+        shm_cache_close(shm);
+        errno = EPROTO;
+        return nullptr;
+    }
+
+    shm->shards = (shm_shard_t *)(shm->base + hdr->shards_offset);
+    return shm;
+}
+
+/* ============================================================================
+ * Public (module) API
+ * ============================================================================ */
+
+shm_cache_t* shm_cache_open(const char *name,
+                            const session_cache_config_t *config,
+                            const uint64_t hash_key[2]) {
+    if (name == nullptr) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    if (config != nullptr) {
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            shm_cache_t *shm = shm_cache_create(fd, config, hash_key);
+            int saved_errno = errno;
+            close(fd);
+            if (shm == nullptr) {
+                shm_unlink(name);
+                errno = saved_errno;
+            }
+            return shm;
+        }
+        if (errno != EEXIST) {
+            return nullptr;
+        }
+    }
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    shm_cache_t *shm = shm_cache_attach(fd);
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return shm;
+}
+
+void shm_cache_close(shm_cache_t *shm) {
+    if (shm == nullptr) {
+        return;
+    }
+
+    munmap(shm->base, shm->size);
+    free(shm);
+}
+
+int shm_cache_unlink(const char *name) {
+    return shm_unlink(name) == 0 ? 0 : -1;
+}
+
+size_t shm_cache_capacity(const shm_cache_t *shm) {
+    return (size_t)shm->header->capacity;
+}
+
+unsigned int shm_cache_timeout(const shm_cache_t *shm) {
+    return shm->header->timeout_secs;
+}
+
+size_t shm_cache_shard_count(const shm_cache_t *shm) {
+    return shm->header->shard_count;
+}
+
+void shm_cache_hash_key(const shm_cache_t *shm, uint64_t key[2]) {
+    key[0] = shm->header->hash_key[0];
+    key[1] = shm->header->hash_key[1];
+}
+
+int shm_cache_store(shm_cache_t *shm, uint64_t hash, const tls_session_cache_entry_t *entry) {
+    size_t payload = entry->session_id_size + entry->session_data_size + entry->remote_addr_len;
+    if (payload > shm->header->payload_size) {
+        return -1;     // Does not fit a fixed-size record
+    }
+
+    shard_view_t view = shard_view(shm, shard_index_for_hash(shm, hash));
+    int64_t now = shm_clock_now();
+
+    if (shard_lock(&view) != 0) {
+        return -1;
+    }
+
+    size_t pos;
+    bool found = table_lookup(&view, hash, entry->session_id, entry->session_id_size, &pos);
+
+    // Already expired: nothing to cache (and the old copy is stale too)
+    if (entry->expiration > 0 && now > entry->expiration) {
+        if (found) {
+            record_drop(&view, pos, view.slots[pos].ref - 1);
+        }
+        view.shard->expirations++;
+        shard_unlock(&view);
+        return 0;
+    }
+
+    if (found) {
+        uint32_t index = view.slots[pos].ref - 1;
+        record_fill(record_at(&view, index), hash, entry);
+        lru_unlink(&view, index);
+        lru_push_front(&view, index);
+        shard_unlock(&view);
+        return 0;
+    }
+
+    // Evict LRU record if the shard is full
+    if (view.shard->count >= view.shard->capacity && view.shard->lru_tail != SHM_NONE) {
+        uint32_t victim = view.shard->lru_tail;
+        record_drop(&view, table_slot_of(&view, victim), victim);
+        view.shard->evictions++;
+
+        // Deletion may have shifted our insertion point
+        table_lookup(&view, hash, entry->session_id, entry->session_id_size, &pos);
+    }
+
+    uint32_t index = record_alloc(&view);
+    if (index == SHM_NONE) {
+        shard_unlock(&view);
+        return -1;
+    }
+
+    record_fill(record_at(&view, index), hash, entry);
+    view.slots[pos] = (shm_slot_t){.hash = hash, .ref = index + 1};
+    lru_push_front(&view, index);
+    view.shard->count++;
+
+    shard_unlock(&view);
+    return 0;
+}
+
+int shm_cache_retrieve(shm_cache_t *shm,
+                       uint64_t hash,
+                       const uint8_t *session_id,
+                       size_t session_id_size,
+                       tls_session_cache_entry_t *entry) {
+    shard_view_t view = shard_view(shm, shard_index_for_hash(shm, hash));
+    int64_t now = shm_clock_now();
+
+    if (shard_lock(&view) != 0) {
+        return -1;
+    }
+
+    size_t pos;
+    if (!table_lookup(&view, hash, session_id, session_id_size, &pos)) {
+        view.shard->misses++;
+        shard_unlock(&view);
+        return -1;
+    }
+
+    uint32_t index = view.slots[pos].ref - 1;
+    shm_record_t *record = record_at(&view, index);
+
+    if (record_is_expired(record, now)) {
+        record_drop(&view, pos, index);
+        view.shard->expirations++;
+        view.shard->misses++;
+        shard_unlock(&view);
+        return -1;
+    }
+
+    record_export(record, entry);
+    lru_unlink(&view, index);
+    lru_push_front(&view, index);
+    view.shard->hits++;
+
+    shard_unlock(&view);
+    return 0;
+}
+
+int shm_cache_remove(shm_cache_t *shm,
+                     uint64_t hash,
+                     const uint8_t *session_id,
+                     size_t session_id_size) {
+    shard_view_t view = shard_view(shm, shard_index_for_hash(shm, hash));
+
+    if (shard_lock(&view) != 0) {
+        return -1;
+    }
+
+    size_t pos;
+    if (!table_lookup(&view, hash, session_id, session_id_size, &pos)) {
+        shard_unlock(&view);
+        return -1;
+    }
+
+    record_drop(&view, pos, view.slots[pos].ref - 1);
+
+    shard_unlock(&view);
+    return 0;
+}
+
+void shm_cache_clear(shm_cache_t *shm) {
+    for (size_t i = 0; i < shm->header->shard_count; i++) {
+        shard_view_t view = shard_view(shm, i);
+
+        if (shard_lock(&view) == 0) {
+            shard_reset(&view);
+            shard_unlock(&view);
+        }
+    }
+}
+
+size_t shm_cache_cleanup_expired(shm_cache_t *shm) {
+    int64_t now = shm_clock_now();
+    size_t removed = 0;
+
+    for (size_t i = 0; i < shm->header->shard_count; i++) {
+        shard_view_t view = shard_view(shm, i);
+
+        if (shard_lock(&view) != 0) {
+            continue;
+        }
+
+        uint32_t index = view.shard->lru_head;
+        while (index != SHM_NONE) {
+            uint32_t next = record_at(&view, index)->lru_next;
+
+            if (record_is_expired(record_at(&view, index), now)) {
+                record_drop(&view, table_slot_of(&view, index), index);
+                view.shard->expirations++;
+                removed++;
+            }
+
+            index = next;
+        }
+
+        shard_unlock(&view);
+    }
+
+    return removed;
+}
+
+void shm_cache_get_stats(shm_cache_t *shm, session_cache_stats_t *stats) {
+    const shm_header_t *hdr = shm->header;
+
+    stats->capacity = (size_t)hdr->capacity;
+    stats->slab_bytes = hdr->segment_size - hdr->records_offset;
+    stats->table_bytes = hdr->records_offset;
+
+    for (size_t i = 0; i < hdr->shard_count; i++) {
+        shard_view_t view = shard_view(shm, i);
+
+        if (shard_lock(&view) != 0) {
+            continue;
+        }
+
+        stats->count += view.shard->count;
+        stats->hits += view.shard->hits;
+        stats->misses += view.shard->misses;
+        stats->evictions += view.shard->evictions;
+        stats->expirations += view.shard->expirations;
+        shard_unlock(&view);
+    }
+
+    stats->entry_bytes = stats->count * hdr->record_size;
+}
+
+int shm_cache_for_each(shm_cache_t *shm,
+                       shm_cache_visit_fn visit,
+                       shm_cache_shard_done_fn shard_done,
+                       void *arg) {
+    for (size_t i = 0; i < shm->header->shard_count; i++) {
+        shard_view_t view = shard_view(shm, i);
+
+        if (shard_lock(&view) != 0) {
+            continue;
+        }
+
+        for (uint32_t index = view.shard->lru_tail; index != SHM_NONE;
+             index = record_at(&view, index)->lru_prev) {
+            const shm_record_t *record = record_at(&view, index);
+
+            if (visit(arg, record->bytes, record->session_id_size, record->session_data_size,
+                      record->remote_addr_len, (time_t)record->expiration) != 0) {
+                shard_unlock(&view);
+                return -1;
+            }
+        }
+
+        shard_unlock(&view);
+
+        if (shard_done != nullptr && shard_done(arg) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_SESSION_CACHE_SHM_H
+#define WOLFGUARD_SESSION_CACHE_SHM_H
+
+/**
+ * Shared-Memory Session Cache Backend (internal)
+ *
+ * Storage backend behind session_cache_new_shared(). Everything lives in one
+ * named POSIX shared-memory segment and is addressed by offsets/indices, so
+ * the segment may be mapped at different addresses in different processes:
+ *
+ *   header | shards[] | per-shard slot tables | per-shard record pools
+ *
+ * Each shard has a robust, process-shared mutex, a linear-probing hash table
+ * of record indices, a fixed pool of fixed-size records and an LRU list
+ * threaded through the records by index. The segment size is fixed at
+ * creation, so sessions larger than the record payload are not cached.
+ *
+ * If a process dies while holding a shard lock, the next locker gets
+ * EOWNERDEAD, wipes that shard (its lists may be half updated) and marks the
+ * mutex consistent; the other shards are unaffected.
+ *
+ * Hashing and the session_cache_t API live in session_cache.c; this module
+ * receives precomputed hashes.
+ */
+
+#include "session_cache.h"
+
+/* Shared cache mapping (process-local handle) */
+typedef struct shm_cache shm_cache_t;
+
+/**
+ * Create or attach to a named segment
+ *
+ * @param name POSIX shm name ("/..." form)
+ * @param config Geometry for a new segment (shard_count already a power of
+ *               2), nullptr to only attach
+ * @param hash_key Hash key stored in a new segment (ignored when attaching)
+ * @return Handle, or nullptr with errno set
+ */
+shm_cache_t* shm_cache_open(const char *name,
+                            const session_cache_config_t *config,
+                            const uint64_t hash_key[2]);
+
+/** Unmap segment (the segment itself persists until unlinked) */
+void shm_cache_close(shm_cache_t *shm);
+
+/** Remove the segment name (existing mappings stay valid) */
+int shm_cache_unlink(const char *name);
+
+/* Geometry of an opened segment */
+size_t shm_cache_capacity(const shm_cache_t *shm);
+unsigned int shm_cache_timeout(const shm_cache_t *shm);
+size_t shm_cache_shard_count(const shm_cache_t *shm);
+void shm_cache_hash_key(const shm_cache_t *shm, uint64_t key[2]);
+
+/* Operations (hash computed by caller with the segment's hash key) */
+int shm_cache_store(shm_cache_t *shm, uint64_t hash, const tls_session_cache_entry_t *entry);
+int shm_cache_retrieve(shm_cache_t *shm,
+                       uint64_t hash,
+                       const uint8_t *session_id,
+                       size_t session_id_size,
+                       tls_session_cache_entry_t *entry);
+int shm_cache_remove(shm_cache_t *shm,
+                     uint64_t hash,
+                     const uint8_t *session_id,
+                     size_t session_id_size);
+void shm_cache_clear(shm_cache_t *shm);
+size_t shm_cache_cleanup_expired(shm_cache_t *shm);
+void shm_cache_get_stats(shm_cache_t *shm, session_cache_stats_t *stats);
+
+/**
+ * Session visitor: @p bytes holds session_id | session_data | remote_addr
+ *
+ * @return 0 to continue, -1 to stop
+ */
+typedef int (*shm_cache_visit_fn)(void *arg,
+                                  const uint8_t *bytes,
+                                  size_t session_id_size,
+                                  size_t session_data_size,
+                                  size_t remote_addr_len,
+                                  time_t expiration);
+
+/**
+ * Shard finished: called after a shard's sessions were visited and its lock
+ * released
+ *
+ * @return 0 to continue, -1 to stop
+ */
+typedef int (*shm_cache_shard_done_fn)(void *arg);
+
+/**
+ * Visit every session, least recently used first within each shard
+ *
+ * Each shard stays locked while its sessions are visited; @p shard_done
+ * (may be nullptr) runs after each shard is unlocked, for work that should
+ * not hold the lock.
+ *
+ * @return 0 on success, -1 if a callback stopped the walk
+ */
+int shm_cache_for_each(shm_cache_t *shm,
+                       shm_cache_visit_fn visit,
+                       shm_cache_shard_done_fn shard_done,
+                       void *arg);
+
+#endif // WOLFGUARD_SESSION_CACHE_SHM_H
@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE  // For explicit_bzero()
+
+#include "ticket_keys.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+constexpr size_t TICKET_KEYS_INITIAL_CONTEXTS = 4;
+
+/* ============================================================================
+ * Internal Structures
+ * ============================================================================ */
+
+/**
+ * Parsed key ring
+ *
+ * Unused bytes stay zero, so two rings compare equal with memcmp().
+ */
+typedef struct {
+    uint8_t secrets[TLS_MAX_TICKET_KEYS][TICKET_KEYS_MAX_SECRET_SIZE];
+    size_t sizes[TLS_MAX_TICKET_KEYS];
+    size_t count;
+} key_ring_t;
+
+struct ticket_keys {
+    // Guards everything below; held across source I/O, never by handshakes
+    pthread_mutex_t lock;
+
+    char *path;
+    ticket_keys_source_t source;
+    unsigned int lifetime_secs;
+    unsigned int poll_interval_ms;
+
+    key_ring_t ring;            // Ring every attached context has
+
+    // Key file identity at the last load, to skip unchanged files on a stat()
+    struct stat file_stat;
+    bool file_stat_valid;
+
+    tls_context_t **contexts;
+    size_t context_count;
+    size_t context_capacity;
+
+    ticket_keys_stats_t stats;
+
+    // Watcher thread
+    pthread_t watcher;
+    pthread_cond_t wake;
+    bool watcher_running;
+    bool stopping;
+};
+
+/* ============================================================================
+ * Key Ring Parsing
+ * ============================================================================ */
+
+static inline int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Decode one hex secret into the next ring slot
+static int ring_add(key_ring_t *ring, const char *hex, size_t len) {
+    if (ring->count == TLS_MAX_TICKET_KEYS || len % 2 != 0 ||
+        len / 2 < TLS_TICKET_KEY_MIN_SIZE || len / 2 > TICKET_KEYS_MAX_SECRET_SIZE) {
+        return -1;
+    }
+
+    uint8_t *secret = ring->secrets[ring->count];
+    for (size_t i = 0; i < len; i += 2) {
+        int hi = hex_value(hex[i]);
+        int lo = hex_value(hex[i + 1]);
+        if (hi < 0 || lo < 0) {
+            return -1;
+        }
+        secret[i / 2] = (uint8_t)(hi << 4 | lo);
+    }
+    ring->sizes[ring->count++] = len / 2;
+    return 0;
+}
+
+/**
+ * Parse a key ring: one hex secret per line, '#' comments, blank lines
+ *
+ * @return 0 on success, -1 if the ring is malformed or empty (errno = EBADMSG)
+ */
+static int ring_parse(const char *text, size_t len, key_ring_t *ring) {
+    memset(ring, 0, sizeof(*ring));
+
+    size_t pos = 0;
+    while (pos < len) {
+        const char *line = text + pos;
+        const char *newline = memchr(line, '\n', len - pos);
+        size_t line_len = newline != nullptr ? (size_t)(newline - line) : len - pos;
+        pos += line_len + 1;
+
+        const char *comment = memchr(line, '#', line_len);
+        if (comment != nullptr) {
+            line_len = (size_t)(comment - line);
+        }
+        while (line_len > 0 && is_blank(line[0])) {
+            line++;
+            line_len--;
+        }
+        while (line_len > 0 && is_blank(line[line_len - 1])) {
+            line_len--;
+        }
+
+        if (line_len > 0 && ring_add(ring, line, line_len) != 0) {
+            explicit_bzero(ring, sizeof(*ring));
+            errno = EBADMSG;
+            return -1;
+        }
+    }
+
+    if (ring->count == 0) {
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Sources
+ * ============================================================================ */
+
+static bool same_file(const struct stat *a, const struct stat *b) {
+    return a->st_dev == b->st_dev && a->st_ino == b->st_ino && a->st_size == b->st_size &&
+           a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec &&
+           a->st_ctim.tv_sec == b->st_ctim.tv_sec && a->st_ctim.tv_nsec == b->st_ctim.tv_nsec;
+}
+
+// Read until EOF; a source larger than @p size fails with EFBIG
+static int read_all(int fd, char *buf, size_t size, size_t *len) {
+    size_t got = 0;
+    for (;;) {
+        ssize_t n = read(fd, buf + got, size - got);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                errno = ETIMEDOUT;  // SO_RCVTIMEO expired
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        got += (size_t)n;
+        if (got == size) {
+            errno = EFBIG;
+            return -1;
+        }
+    }
+    *len = got;
+    return 0;
+}
+
+static int read_file(const char *path, char *buf, size_t size, size_t *len, struct stat *st) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    int rc = fstat(fd, st) == 0 ? read_all(fd, buf, size, len) : -1;
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return rc;
+}
+
+static int read_socket(const char *path, char *buf, size_t size, size_t *len) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    memcpy(addr.sun_path, path, strlen(path) + 1);  // Length checked in ticket_keys_new()
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Bound how long a stuck key service can hold the watcher (and the lock)
+    struct timeval timeout = {
+        .tv_sec = TICKET_KEYS_SOCKET_TIMEOUT_MS / 1'000,
+        .tv_usec = (TICKET_KEYS_SOCKET_TIMEOUT_MS % 1'000) * 1'000,
+    };
+    int rc = -1;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 &&
+        connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        rc = read_all(fd, buf, size, len);
+    }
+
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return rc;
+}
+
+/* ============================================================================
+ * Reloading
+ * ============================================================================ */
+
+static int tls_error_to_errno(int ret) {
+    switch (ret) {
+        case TLS_E_MEMORY_ERROR:
+            return ENOMEM;
+        case TLS_E_INVALID_PARAMETER:
+        case TLS_E_INVALID_REQUEST:
+            return EINVAL;
+        default:
+            return EIO;
+    }
+}
+
+static int apply_ring(const ticket_keys_t *keys, const key_ring_t *ring, tls_context_t *ctx) {
+    tls_datum_t datums[TLS_MAX_TICKET_KEYS];
+    for (size_t i = 0; i < ring->count; i++) {
+        datums[i] = (tls_datum_t){
+            .data = (uint8_t *)ring->secrets[i],
+            .size = ring->sizes[i],
+        };
+    }
+
+    int ret = tls_context_set_ticket_keys(ctx, datums, ring->count, keys->lifetime_secs);
+    if (ret != TLS_E_SUCCESS) {
+        errno = tls_error_to_errno(ret);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Read the source and apply a changed ring (lock held)
+ *
+ * @return 1 if applied, 0 if unchanged, -1 on failure (errno set)
+ */
+static int poll_locked(ticket_keys_t *keys) {
+    char buf[TICKET_KEYS_MAX_RING_SIZE + 1];
+    size_t len = 0;
+    struct stat st = {0};
+    int rc;
+
+    if (keys->source == TICKET_KEYS_SOURCE_FILE) {
+        // Cheap path for the common case: the file has not been touched
+        if (keys->file_stat_valid && stat(keys->path, &st) == 0 &&
+            same_file(&st, &keys->file_stat)) {
+            return 0;
+        }
+        rc = read_file(keys->path, buf, sizeof(buf), &len, &st);
+    } else {
+        rc = read_socket(keys->path, buf, sizeof(buf), &len);
+    }
+
+    key_ring_t ring;
+    if (rc == 0) {
+        rc = ring_parse(buf, len, &ring);
+    }
+    explicit_bzero(buf, len);
+    if (rc != 0) {
+        return -1;
+    }
+
+    if (memcmp(&ring, &keys->ring, sizeof(ring)) == 0) {
+        explicit_bzero(&ring, sizeof(ring));
+        keys->file_stat = st;
+        keys->file_stat_valid = keys->source == TICKET_KEYS_SOURCE_FILE;
+        return 0;
+    }
+
+    // The new ring replaces the current one only once every context took
+    // it. If one refuses it, those that took it go back to the current ring,
+    // so all contexts - and any attached later - stay on the same ring; the
+    // file identity is not recorded, so the next poll tries again
+    for (size_t i = 0; i < keys->context_count; i++) {
+        if (apply_ring(keys, &ring, keys->contexts[i]) != 0) {
+            int saved_errno = errno;
+            for (size_t j = 0; j < i; j++) {
+                (void)apply_ring(keys, &keys->ring, keys->contexts[j]);
+            }
+            explicit_bzero(&ring, sizeof(ring));
+            errno = saved_errno;
+            return -1;
+        }
+    }
+
+    explicit_bzero(&keys->ring, sizeof(keys->ring));
+    keys->ring = ring;
+    explicit_bzero(&ring, sizeof(ring));
+
+    keys->file_stat = st;
+    keys->file_stat_valid = keys->source == TICKET_KEYS_SOURCE_FILE;
+    keys->stats.reloads++;
+    keys->stats.key_count = keys->ring.count;
+    keys->stats.loaded_at = time(nullptr);
+    return 1;
+}
+
+// poll_locked() plus failure accounting (lock held)
+static int poll_counted(ticket_keys_t *keys) {
+    int rc = poll_locked(keys);
+    if (rc < 0) {
+        keys->stats.failures++;
+        keys->stats.last_error = errno;
+    }
+    return rc;
+}
+
+static void *watcher_main(void *arg) {
+    ticket_keys_t *keys = arg;
+
+    pthread_mutex_lock(&keys->lock);
+    while (!keys->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += keys->poll_interval_ms / 1'000;
+        deadline.tv_nsec += (long)(keys->poll_interval_ms % 1'000) * 1'000'000L;
+        if (deadline.tv_nsec >= 1'000'000'000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1'000'000'000L;
+        }
+
+        while (!keys->stopping &&
+               pthread_cond_timedwait(&keys->wake, &keys->lock, &deadline) != ETIMEDOUT) {
+        }
+        if (!keys->stopping) {
+            (void)poll_counted(keys);
+        }
+    }
+    pthread_mutex_unlock(&keys->lock);
+    return nullptr;
+}
+
+int ticket_keys_reload(ticket_keys_t *keys) {
+    if (keys == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&keys->lock);
+    int rc = poll_counted(keys);
+    int saved_errno = errno;
+    pthread_mutex_unlock(&keys->lock);
+
+    errno = saved_errno;
+    return rc;
+}
+
+void ticket_keys_get_stats(ticket_keys_t *keys, ticket_keys_stats_t *stats) {
+    if (stats == nullptr) {
+        return;
+    }
+    if (keys == nullptr) {
+        *stats = (ticket_keys_stats_t){0};
+        return;
+    }
+
+    pthread_mutex_lock(&keys->lock);
+    *stats = keys->stats;
+    pthread_mutex_unlock(&keys->lock);
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+static void keys_destroy(ticket_keys_t *keys) {
+    pthread_cond_destroy(&keys->wake);
+    pthread_mutex_destroy(&keys->lock);
+    explicit_bzero(&keys->ring, sizeof(keys->ring));
+    free(keys->contexts);
+    free(keys->path);
+    free(keys);
+}
+
+ticket_keys_t* ticket_keys_new(const ticket_keys_config_t *config) {
+    if (config == nullptr || config->path == nullptr || config->path[0] == '\0' ||
+        config->lifetime_secs == 0 || config->lifetime_secs > INT_MAX ||
+        (config->source != TICKET_KEYS_SOURCE_FILE &&
+         config->source != TICKET_KEYS_SOURCE_SOCKET) ||
+        (config->source == TICKET_KEYS_SOURCE_SOCKET &&
+         strlen(config->path) >= sizeof(((struct sockaddr_un *)nullptr)->sun_path))) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    ticket_keys_t *keys = calloc(1, sizeof(ticket_keys_t));
+    if (keys == nullptr) {
+        return nullptr;
+    }
+    keys->path = strdup(config->path);
+    if (keys->path == nullptr) {
+        free(keys);
+        return nullptr;
+    }
+    keys->source = config->source;
+    keys->lifetime_secs = config->lifetime_secs;
+    keys->poll_interval_ms = config->poll_interval_ms;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&keys->lock, nullptr);
+    pthread_cond_init(&keys->wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    // No contexts yet, so this only loads the ring
+    if (poll_locked(keys) < 0) {
+        int saved_errno = errno;
+        keys_destroy(keys);
+        errno = saved_errno;
+        return nullptr;
+    }
+
+    if (keys->poll_interval_ms > 0) {
+        int ret = pthread_create(&keys->watcher, nullptr, watcher_main, keys);
+        if (ret != 0) {
+            keys_destroy(keys);
+            errno = ret;
+            return nullptr;
+        }
+        keys->watcher_running = true;
+    }
+
+    return keys;
+}
+
+void ticket_keys_free(ticket_keys_t *keys) {
+    if (keys == nullptr) {
+        return;
+    }
+
+    if (keys->watcher_running) {
+        pthread_mutex_lock(&keys->lock);
+        keys->stopping = true;
+        pthread_cond_signal(&keys->wake);
+        pthread_mutex_unlock(&keys->lock);
+        pthread_join(keys->watcher, nullptr);
+    }
+
+    keys_destroy(keys);
+}
+
+/* ============================================================================
+ * Contexts
+ * ============================================================================ */
+
+int ticket_keys_attach(ticket_keys_t *keys, tls_context_t *ctx) {
+    if (keys == nullptr || ctx == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&keys->lock);
+
+    int rc = 0;
+    for (size_t i = 0; i < keys->context_count && rc == 0; i++) {
+        if (keys->contexts[i] == ctx) {
+            errno = EALREADY;
+            rc = -1;
+        }
+    }
+
+    if (rc == 0 && keys->context_count == keys->context_capacity) {
+        size_t capacity = keys->context_capacity > 0 ? keys->context_capacity * 2
+                                                     : TICKET_KEYS_INITIAL_CONTEXTS;
+        tls_context_t **contexts = realloc(keys->contexts, capacity * sizeof(*contexts));
+        if (contexts == nullptr) {
+            rc = -1;
+        } else {
+            keys->contexts = contexts;
+            keys->context_capacity = capacity;
+        }
+    }
+
+    if (rc == 0) {
+        rc = apply_ring(keys, &keys->ring, ctx);
+    }
+    if (rc == 0) {
+        keys->contexts[keys->context_count++] = ctx;
+    }
+
+    int saved_errno = errno;
+    pthread_mutex_unlock(&keys->lock);
+    errno = saved_errno;
+    return rc;
+}
+
+int ticket_keys_detach(ticket_keys_t *keys, tls_context_t *ctx) {
+    if (keys == nullptr || ctx == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&keys->lock);
+
+    int rc = -1;
+    for (size_t i = 0; i < keys->context_count; i++) {
+        if (keys->contexts[i] == ctx) {
+            keys->contexts[i] = keys->contexts[--keys->context_count];
+            rc = 0;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&keys->lock);
+
+    if (rc != 0) {
+        errno = ENOENT;
+    }
+    return rc;
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_TICKET_KEYS_H
+#define WOLFGUARD_TICKET_KEYS_H
+
+/**
+ * Session Ticket Key Source
+ *
+ * Feeds tls_context_set_ticket_keys() from a key ring that lives outside the
+ * process, so every node behind a load balancer issues and accepts the same
+ * tickets and a client resumes on whichever node it lands on.
+ *
+ * Sources:
+ * - File: a key file distributed to every node (config management, a
+ *   mounted secret). Replace it with rename() so readers never see a
+ *   half-written ring; a ring that does not parse is ignored until the file
+ *   changes again.
+ * - Socket: a local key service on a unix stream socket. Each poll connects,
+ *   reads the ring until the service closes the connection and disconnects.
+ *
+ * Key ring format (text, the same for both sources):
+ *
+ *   # comment
+ *   <hex secret>      issues new tickets (keys[0])
+ *   <hex secret>      older, still accepted
+ *
+ * One secret of TLS_TICKET_KEY_MIN_SIZE to TICKET_KEYS_MAX_SECRET_SIZE bytes
+ * per line, newest first, at most TLS_MAX_TICKET_KEYS lines.
+ *
+ * Reloads:
+ *   A watcher thread polls the source (a stat() for files) and, when the ring
+ *   changed, hands it to every attached context in one
+ *   tls_context_set_ticket_keys() call each. File and socket I/O happen on
+ *   the watcher thread; handshakes only ever wait for the context's brief
+ *   key swap, and see either the whole old ring or the whole new one.
+ *
+ * Rolling a new secret out to a cluster:
+ *   1. Append it as the last line everywhere (accepted, not yet issued).
+ *   2. Once every node has it, move it to the first line.
+ *   3. Drop the oldest secret after one ticket lifetime.
+ *   The GnuTLS backend decrypts under one secret only and rejects rings of
+ *   more than one (the poll fails with EINVAL and the last ring stays in
+ *   place). Its rings hold just the issuing secret: replace it everywhere
+ *   at once, and tickets issued under the old one fall back to a full
+ *   handshake.
+ *
+ * Usage:
+ *   ticket_keys_config_t config = {
+ *       .path = "/run/wolfguard/ticket-keys",
+ *       .lifetime_secs = 3600,
+ *       .poll_interval_ms = 1000,
+ *   };
+ *   ticket_keys_t *keys = ticket_keys_new(&config);
+ *   ticket_keys_attach(keys, server_ctx);
+ *   // ... serve ...
+ *   ticket_keys_detach(keys, server_ctx);
+ *   ticket_keys_free(keys);
+ */
+
+#include "tls_abstract.h"
+#include <time.h>
+
+// C23 standard compliance
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+/* ============================================================================
+ * Configuration Constants
+ * ============================================================================ */
+
+constexpr size_t TICKET_KEYS_MAX_SECRET_SIZE = 64;
+constexpr size_t TICKET_KEYS_MAX_RING_SIZE = 4'096;        // Bytes of key file or reply
+constexpr unsigned int TICKET_KEYS_SOCKET_TIMEOUT_MS = 1'000;
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/**
+ * Ticket key source handle (opaque)
+ */
+typedef struct ticket_keys ticket_keys_t;
+
+/**
+ * Where the key ring comes from
+ */
+typedef enum {
+    TICKET_KEYS_SOURCE_FILE = 0,    // Default
+    TICKET_KEYS_SOURCE_SOCKET,      // Unix stream socket of a key service
+} ticket_keys_source_t;
+
+/**
+ * Key source configuration
+ */
+typedef struct {
+    const char *path;                   // Key file or socket path (copied)
+    ticket_keys_source_t source;
+    unsigned int lifetime_secs;         // Ticket lifetime for attached contexts
+    unsigned int poll_interval_ms;      // Watcher period, 0 = no watcher thread
+} ticket_keys_config_t;
+
+/**
+ * Key source statistics
+ */
+typedef struct {
+    uint64_t reloads;       // Rings handed to the attached contexts
+    uint64_t failures;      // Polls that could not read, parse or apply a ring
+    int last_error;         // errno of the last failure, 0 if none yet
+    size_t key_count;       // Keys in the current ring
+    time_t loaded_at;       // When the current ring was loaded
+} ticket_keys_stats_t;
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+/**
+ * Create a key source and load its ring
+ *
+ * @param config Source configuration
+ * @return Handle on success, nullptr on failure (errno = EINVAL for invalid
+ *         configuration, EBADMSG if the ring does not parse, or the errno of
+ *         the failed open/connect/read)
+ *
+ * Note: The initial load must succeed, so a node never starts serving with
+ *       tickets it cannot share. The watcher, if any, starts afterwards.
+ */
+[[nodiscard]] ticket_keys_t* ticket_keys_new(const ticket_keys_config_t *config);
+
+/**
+ * Stop the watcher and free the source
+ *
+ * Attached contexts keep the last ring they were given.
+ *
+ * @param keys Key source
+ */
+void ticket_keys_free(ticket_keys_t *keys);
+
+/* ============================================================================
+ * Contexts
+ * ============================================================================ */
+
+/**
+ * Give a server context the current ring and every future one
+ *
+ * @param keys Key source
+ * @param ctx Server context
+ * @return 0 on success, -1 on failure (errno = EINVAL for client contexts,
+ *         EALREADY if attached, ENOMEM)
+ */
+int ticket_keys_attach(ticket_keys_t *keys, tls_context_t *ctx);
+
+/**
+ * Stop updating a context (detach before tls_context_free())
+ *
+ * The context keeps the ring it has.
+ *
+ * @param keys Key source
+ * @param ctx Attached context
+ * @return 0 on success, -1 if @p ctx is not attached (errno = ENOENT)
+ */
+int ticket_keys_detach(ticket_keys_t *keys, tls_context_t *ctx);
+
+/* ============================================================================
+ * Reloading
+ * ============================================================================ */
+
+/**
+ * Poll the source now
+ *
+ * What the watcher thread does every poll_interval_ms, for callers without a
+ * watcher (or with a SIGHUP handler that defers to a worker).
+ *
+ * @param keys Key source
+ * @return 1 if a new ring was applied, 0 if the ring is unchanged, -1 on
+ *         failure (errno set; the current ring stays in place)
+ *
+ * Note: A ring that was read but could not be applied to every context is
+ *       retried on the next poll. Until then every context, including those
+ *       attached meanwhile, keeps the current ring.
+ */
+int ticket_keys_reload(ticket_keys_t *keys);
+
+/**
+ * Get source statistics
+ *
+ * @param keys Key source
+ * @param stats Output statistics
+ */
+void ticket_keys_get_stats(ticket_keys_t *keys, ticket_keys_stats_t *stats);
+
+#endif // WOLFGUARD_TICKET_KEYS_H
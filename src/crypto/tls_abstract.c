@@ -27,6 +27,7 @@
  * - Maintains global state tracking the active backend
  * - Provides thread-safe initialization using C23 atomics
  * - Dispatches API calls to the appropriate backend implementation
+ *   through its tls_backend_ops_t (see tls_backend.h)
  * - Ensures single initialization prevents backend mixing
  *
  * Thread Safety:
@@ -35,17 +36,8 @@
  * - Safe for concurrent session creation after init
  */
 
-#include "tls_abstract.h"
-
-// Conditionally include backend headers to avoid struct redefinition
-#ifdef USE_GNUTLS
-#include "tls_gnutls.h"
-#include <gnutls/gnutls.h>
-#endif
-
-#ifdef USE_WOLFSSL
-#include "tls_wolfssl.h"
-#endif
+#include "tls_backend.h"
+#include "allocator.h"
 
 #include <stdatomic.h>
 #include <stdbool.h>
@@ -66,6 +58,38 @@
 static atomic_bool g_initialized = false;
 static tls_backend_t g_active_backend = TLS_BACKEND_NONE;
 
+// Operations of the active backend; the first compiled one until init
+#ifdef USE_GNUTLS
+static const tls_backend_ops_t *g_ops = &tls_gnutls_ops;
+#else
+static const tls_backend_ops_t *g_ops = &tls_wolfssl_ops;
+#endif
+
+// Compiled-in backend operations by tls_backend_t
+static const tls_backend_ops_t *backend_ops(tls_backend_t backend) {
+    switch (backend) {
+        case TLS_BACKEND_GNUTLS:
+#ifdef USE_GNUTLS
+            return &tls_gnutls_ops;
+#else
+            return nullptr;
+#endif
+        case TLS_BACKEND_WOLFSSL:
+#ifdef USE_WOLFSSL
+            return &tls_wolfssl_ops;
+#else
+            return nullptr;
+#endif
+        case TLS_BACKEND_NONE:
+            break;
+    }
+    return nullptr;
+}
+
+[[nodiscard]] const tls_backend_ops_t *tls_backend_get_ops(void) {
+    return g_ops;
+}
+
 /* ============================================================================
  * Backend Initialization and Management
  * ============================================================================ */
@@ -73,16 +97,31 @@ static tls_backend_t g_active_backend = TLS_BACKEND_NONE;
 /**
  * Initialize TLS backend
  *
+ * @param backend Backend to initialize (TLS_BACKEND_GNUTLS or TLS_BACKEND_WOLFSSL)
+ * @return TLS_E_SUCCESS on success, error code on failure
+ */
+[[nodiscard]] int tls_global_init(tls_backend_t backend) {
+    return tls_global_init_with_allocator(backend, nullptr);
+}
+
+/**
+ * Initialize TLS backend with an allocator
+ *
  * This function performs runtime backend selection and initialization.
  * It can only be called once - subsequent calls with the same backend
  * succeed immediately, but calls with different backends fail.
  *
+ * The allocator is installed before the backend initializes, so the TLS
+ * library never sees memory from two different allocators.
+ *
  * @param backend Backend to initialize (TLS_BACKEND_GNUTLS or TLS_BACKEND_WOLFSSL)
+ * @param allocator Allocator vtable, or nullptr for the system heap
  * @return TLS_E_SUCCESS on success, error code on failure
  *
  * Thread Safety: Uses atomic compare-exchange for initialization guard
  */
-[[nodiscard]] int tls_global_init(tls_backend_t backend) {
+[[nodiscard]] int tls_global_init_with_allocator(tls_backend_t backend,
+                                                  const tls_allocator_t *allocator) {
     // Validate backend parameter
     if (backend != TLS_BACKEND_GNUTLS && backend != TLS_BACKEND_WOLFSSL) {
         fprintf(stderr, "tls_global_init: Invalid backend %d\n", backend);
@@ -98,54 +137,41 @@ static tls_backend_t g_active_backend = TLS_BACKEND_NONE;
                     g_active_backend, backend);
             return TLS_E_BACKEND_ERROR;
         }
+        if (allocator != nullptr && allocator != allocator_get()) {
+            fprintf(stderr, "tls_global_init: Allocator mismatch\n");
+            return TLS_E_BACKEND_ERROR;
+        }
         // Same backend already initialized - this is OK
         return TLS_E_SUCCESS;
     }
 
     // Store active backend before calling backend init
     g_active_backend = backend;
+    allocator_set(allocator);
 
     // Dispatch to backend-specific initialization
-    int ret;
-    switch (backend) {
-        case TLS_BACKEND_GNUTLS:
-#ifdef USE_GNUTLS
-            ret = tls_gnutls_init();
-#else
-            fprintf(stderr, "tls_global_init: GnuTLS backend not compiled in\n");
-            atomic_store(&g_initialized, false);
-            g_active_backend = TLS_BACKEND_NONE;
-            return TLS_E_BACKEND_ERROR;
-#endif
-            break;
-
-        case TLS_BACKEND_WOLFSSL:
-#ifdef USE_WOLFSSL
-            ret = tls_wolfssl_init();
-#else
-            fprintf(stderr, "tls_global_init: wolfSSL backend not compiled in\n");
-            atomic_store(&g_initialized, false);
-            g_active_backend = TLS_BACKEND_NONE;
-            return TLS_E_BACKEND_ERROR;
-#endif
-            break;
-
-        default:
-            // Should never reach here due to validation above
-            fprintf(stderr, "tls_global_init: Unexpected backend %d\n", backend);
-            atomic_store(&g_initialized, false);
-            g_active_backend = TLS_BACKEND_NONE;
-            return TLS_E_INVALID_PARAMETER;
+    const tls_backend_ops_t *ops = backend_ops(backend);
+    if (ops == nullptr) {
+        fprintf(stderr, "tls_global_init: %s backend not compiled in\n",
+                backend == TLS_BACKEND_GNUTLS ? "GnuTLS" : "wolfSSL");
+        atomic_store(&g_initialized, false);
+        g_active_backend = TLS_BACKEND_NONE;
+        allocator_set(nullptr);
+        return TLS_E_BACKEND_ERROR;
     }
 
+    int ret = ops->init();
+
     // Handle initialization failure
     if (ret != TLS_E_SUCCESS) {
         fprintf(stderr, "tls_global_init: Backend initialization failed (ret=%d)\n", ret);
         atomic_store(&g_initialized, false);
         g_active_backend = TLS_BACKEND_NONE;
+        allocator_set(nullptr);
         return ret;
     }
 
+    g_ops = ops;
     return TLS_E_SUCCESS;
 }
 
@@ -164,26 +190,14 @@ void tls_global_deinit(void) {
     }
 
     // Dispatch to backend-specific cleanup
-    switch (g_active_backend) {
-        case TLS_BACKEND_GNUTLS:
-#ifdef USE_GNUTLS
-            tls_gnutls_deinit();
-#endif
-            break;
-
-        case TLS_BACKEND_WOLFSSL:
-#ifdef USE_WOLFSSL
-            tls_wolfssl_deinit();
-#endif
-            break;
-
-        case TLS_BACKEND_NONE:
-            // Should not happen, but handle gracefully
-            break;
+    const tls_backend_ops_t *ops = backend_ops(g_active_backend);
+    if (ops != nullptr) {
+        ops->deinit();
     }
 
-    // Reset global state
+    // Reset global state (blocks still allocated remember their allocator)
     g_active_backend = TLS_BACKEND_NONE;
+    allocator_set(nullptr);
     atomic_store(&g_initialized, false);
 }
 
@@ -214,32 +228,33 @@ void tls_global_deinit(void) {
     }
 
     // Dispatch to backend-specific version function
-    switch (g_active_backend) {
-        case TLS_BACKEND_GNUTLS:
-#ifdef USE_GNUTLS
-            {
-                // GnuTLS doesn't have a separate get_version export, so construct it here
-                static char gnutls_version[64];
-                const char *gnutls_ver = gnutls_check_version(nullptr);
-                if (gnutls_ver) {
-                    snprintf(gnutls_version, sizeof(gnutls_version), "GnuTLS %s", gnutls_ver);
-                    return gnutls_version;
-                }
-                return "GnuTLS (unknown version)";
-            }
-#else
-            return "GnuTLS (not compiled in)";
-#endif
+    const tls_backend_ops_t *ops = backend_ops(g_active_backend);
+    if (ops == nullptr) {
+        return "Unknown backend";
+    }
+    return ops->get_version();
+}
 
-        case TLS_BACKEND_WOLFSSL:
-#ifdef USE_WOLFSSL
-            return tls_wolfssl_get_version();
-#else
-            return "wolfSSL (not compiled in)";
-#endif
+/* ============================================================================
+ * Public API Dispatch (dual-backend builds)
+ * ============================================================================ */
 
-        case TLS_BACKEND_NONE:
-        default:
-            return "Unknown backend";
+#ifdef TLS_DUAL_BACKEND
+
+/*
+ * One indirect call per API call; single-backend builds define these names
+ * in the backend itself and skip this layer.
+ */
+#define TLS_DISPATCH(ret, name, params, args) \
+    ret tls_##name params { \
+        return g_ops->op_##name args; \
     }
-}
+
+#define TLS_DISPATCH_VOID(ret, name, params, args) \
+    ret tls_##name params { \
+        g_ops->op_##name args; \
+    }
+
+TLS_BACKEND_OPS(TLS_DISPATCH, TLS_DISPATCH_VOID)
+
+#endif // TLS_DUAL_BACKEND
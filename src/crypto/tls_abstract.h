@@ -44,6 +44,7 @@
 #include <stdbool.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 // C23 standard compliance (accept C2x/C20 from GCC 14 as it provides C23 features)
 #if __STDC_VERSION__ < 202000L
@@ -67,6 +68,10 @@ constexpr size_t TLS_MAX_PSK_KEY_SIZE = 64;
 constexpr size_t TLS_MAX_PRIORITY_STRING = 512;
 constexpr size_t TLS_MAX_CIPHER_NAME = 128;
 constexpr size_t TLS_MAX_ERROR_STRING = 256;
+constexpr size_t TLS_MAX_RECORD_SIZE = 16'384;     // Plaintext bytes per record
+constexpr size_t TLS_TICKET_KEY_MIN_SIZE = 32;     // Ticket key secret (tls_context_set_ticket_keys)
+constexpr size_t TLS_MAX_TICKET_KEYS = 4;          // Keys accepted for ticket decryption
+constexpr unsigned int TLS_EARLY_DATA_WINDOW_MS = 10'000;  // 0-RTT ClientHello freshness window
 
 // TLS/DTLS versions (using C23 binary literals)
 typedef enum {
@@ -124,6 +129,14 @@ typedef struct {
     socklen_t remote_addr_len;
 } tls_session_cache_entry_t;
 
+// Borrowed, read-only view of a cached session (see tls_db_borrow_func_t)
+typedef struct {
+    const uint8_t *session_data;    // Valid until the lease is released
+    size_t session_data_size;
+    time_t expiration;
+    void *handle;                   // Owned by the cache, passed back on release
+} tls_session_lease_t;
+
 // Certificate verification result
 typedef struct {
     bool verified;
@@ -142,8 +155,54 @@ typedef struct {
     uint16_t cipher_bits;
     bool session_resumed;
     bool safe_renegotiation;
+    bool early_data_accepted;   // TLS 1.3 0-RTT data was accepted by the server
 } tls_connection_info_t;
 
+// Directions offloaded to kernel TLS (see tls_session_get_ktls)
+typedef enum {
+    TLS_KTLS_NONE = 0,
+    TLS_KTLS_TX = 0b01,
+    TLS_KTLS_RX = 0b10,
+} tls_ktls_mode_t;
+
+// Memory allocator (see tls_global_init_with_allocator)
+typedef struct {
+    void *(*alloc_func)(void *userdata, size_t size);          // 16-byte aligned, nullptr on failure
+    void (*free_func)(void *userdata, void *ptr, size_t size); // size as passed to alloc_func
+    void *userdata;
+} tls_allocator_t;
+
+// Allocator traffic of one session (see tls_session_get_memory_stats). Not
+// the session's total footprint: with GnuTLS it excludes the library's own
+// allocations.
+typedef struct {
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytes_allocated;
+    uint64_t bytes_freed;
+} tls_memory_stats_t;
+
+// Digest algorithms (values match the tls_hash_fast() algo argument)
+typedef enum {
+    TLS_DIGEST_SHA256 = 0,
+    TLS_DIGEST_SHA384 = 1,
+    TLS_DIGEST_SHA512 = 2,
+} tls_digest_t;
+
+constexpr size_t TLS_DIGEST_MAX_SIZE = 64;          // SHA-512 output
+constexpr size_t TLS_HASH_CTX_SIZE = 512;
+constexpr size_t TLS_HMAC_CTX_SIZE = 1'024;
+
+// Streaming hash state; plain storage, so it can live on the stack
+typedef struct {
+    alignas(16) uint8_t opaque[TLS_HASH_CTX_SIZE];
+} tls_hash_ctx_t;
+
+// Streaming HMAC state, including the keyed pads
+typedef struct {
+    alignas(16) uint8_t opaque[TLS_HMAC_CTX_SIZE];
+} tls_hmac_ctx_t;
+
 /* ============================================================================
  * Error Codes
  * ============================================================================ */
@@ -167,6 +226,8 @@ typedef enum {
     TLS_E_REHANDSHAKE = -15,
     TLS_E_PUSH_ERROR = -16,
     TLS_E_PULL_ERROR = -17,
+    TLS_E_WANT_READ = -18,      // Non-blocking handshake: wait until readable
+    TLS_E_WANT_WRITE = -19,     // Non-blocking handshake: wait until writable
     TLS_E_BACKEND_ERROR = -100, // Backend-specific error (check tls_get_error)
 } tls_error_t;
 
@@ -249,12 +310,23 @@ typedef int (*tls_db_retrieve_func_t)(void *userdata,
 typedef int (*tls_db_remove_func_t)(void *userdata,
                                      const uint8_t *session_id,
                                      size_t session_id_size);
+typedef int (*tls_db_borrow_func_t)(void *userdata,
+                                     const uint8_t *session_id,
+                                     size_t session_id_size,
+                                     tls_session_lease_t *lease);
+typedef void (*tls_db_release_func_t)(void *userdata,
+                                       tls_session_lease_t *lease);
 
 // OCSP status request callback
 typedef int (*tls_ocsp_status_func_t)(tls_session_t *session,
                                        tls_datum_t *response,
                                        void *userdata);
 
+// 0-RTT anti-replay callback: 0 if @p key was not seen before, nonzero if it was
+typedef int (*tls_replay_check_func_t)(void *userdata,
+                                        const uint8_t *key,
+                                        size_t key_size);
+
 /* ============================================================================
  * Library Initialization and Global State
  * ============================================================================ */
@@ -270,6 +342,38 @@ typedef int (*tls_ocsp_status_func_t)(tls_session_t *session,
  */
 [[nodiscard]] int tls_global_init(tls_backend_t backend);
 
+/**
+ * Initialize TLS library subsystem with a custom allocator
+ *
+ * Session memory is then taken from @p allocator: the abstraction layer's
+ * per-session buffers always, and with the wolfSSL backend everything the
+ * library allocates. GnuTLS has ignored replacement allocators since 3.3,
+ * so its internal memory stays on the system heap.
+ *
+ * @param backend Backend to use (TLS_BACKEND_GNUTLS or TLS_BACKEND_WOLFSSL)
+ * @param allocator Allocator vtable, e.g. tls_arena_allocator(), or nullptr
+ *                  for the system heap. Not copied: it must stay valid until
+ *                  every block allocated through it has been freed.
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ *         (TLS_E_BACKEND_ERROR if already initialized with another allocator)
+ *
+ * Note: Same rules as tls_global_init(), which is equivalent to passing
+ *       nullptr.
+ */
+[[nodiscard]] int tls_global_init_with_allocator(tls_backend_t backend,
+                                                  const tls_allocator_t *allocator);
+
+/**
+ * Get the bundled per-thread arena allocator
+ *
+ * Size-class free lists cached per thread, so workers allocate and free
+ * TLS buffers without contending on the global heap. Memory is kept for
+ * reuse rather than returned to the system.
+ *
+ * @return Allocator for tls_global_init_with_allocator() (static, never nullptr)
+ */
+[[nodiscard]] const tls_allocator_t* tls_arena_allocator(void);
+
 /**
  * Cleanup TLS library subsystem
  *
@@ -309,14 +413,26 @@ void tls_global_deinit(void);
 [[nodiscard]] tls_context_t* tls_context_new(bool is_server, bool is_dtls);
 
 /**
- * Free TLS context
+ * Free TLS context (drop a reference)
  *
- * @param ctx Context to free
+ * Every session holds a reference to its context, so a context freed while
+ * sessions still use it goes away with the last of them.
  *
- * Note: All sessions using this context must be freed first.
+ * @param ctx Context to free
  */
 void tls_context_free(tls_context_t *ctx);
 
+/**
+ * Take another reference to a context
+ *
+ * For handing a context to another thread that frees it independently, as
+ * context_gen.h does when it replaces a context with a new generation.
+ *
+ * @param ctx Context
+ * @return @p ctx (nullptr if @p ctx is nullptr)
+ */
+tls_context_t* tls_context_ref(tls_context_t *ctx);
+
 /**
  * Set certificate file for context
  *
@@ -337,6 +453,30 @@ void tls_context_free(tls_context_t *ctx);
 [[nodiscard]] int tls_context_set_key_file(tls_context_t *ctx,
                                              const char *key_file);
 
+/**
+ * Set certificate chain from memory
+ *
+ * Like tls_context_set_cert_file() for a chain already in memory, e.g. from
+ * a secret store; the data is copied. Contexts that all use the same chain
+ * share it better through tls_credentials_new().
+ *
+ * @param ctx Context
+ * @param cert PEM certificate chain, leaf first
+ * @param size Length of @p cert
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_context_set_cert_mem(tls_context_t *ctx, const void *cert, size_t size);
+
+/**
+ * Set private key from memory
+ *
+ * @param ctx Context
+ * @param key PEM private key (unencrypted)
+ * @param size Length of @p key
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_context_set_key_mem(tls_context_t *ctx, const void *key, size_t size);
+
 /**
  * Set CA certificate file for verification
  *
@@ -415,6 +555,25 @@ void tls_context_free(tls_context_t *ctx);
                                                   tls_db_remove_func_t remove_func,
                                                   void *userdata);
 
+/**
+ * Set zero-copy session lookup callbacks
+ *
+ * When set, resumption borrows the stored session bytes with @p borrow_func
+ * and hands them to the TLS library directly, then returns them with
+ * @p release_func, instead of copying a full tls_session_cache_entry_t
+ * through the retrieve callback. Uses the userdata given to
+ * tls_context_set_session_cache(). Pass nullptr for both to go back to the
+ * retrieve callback.
+ *
+ * @param ctx Context
+ * @param borrow_func Borrow callback (0 on success, -1 if not found)
+ * @param release_func Release callback, called once per successful borrow
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_context_set_session_cache_lease(tls_context_t *ctx,
+                                                        tls_db_borrow_func_t borrow_func,
+                                                        tls_db_release_func_t release_func);
+
 /**
  * Set session cache timeout
  *
@@ -425,6 +584,192 @@ void tls_context_free(tls_context_t *ctx);
 [[nodiscard]] int tls_context_set_session_timeout(tls_context_t *ctx,
                                                     unsigned int timeout_secs);
 
+/**
+ * Issue stateless session tickets (TLS 1.2 RFC 5077, TLS 1.3 tickets)
+ *
+ * Resumption then needs no server-side state: the session is encrypted
+ * into the ticket the client keeps. The key that encrypts tickets is
+ * derived from @p keys[0] and the current time and rotates on its own; the
+ * previous key stays valid for decryption, so every ticket younger than
+ * @p lifetime_secs is accepted. Servers given the same secret issue and
+ * accept each other's tickets without further coordination.
+ *
+ * @p keys[1..] are older secrets whose tickets are still accepted, and
+ * re-issued under keys[0]. wolfSSL backend only: GnuTLS decrypts under one
+ * secret, so it takes a single key, and tickets issued under the secret it
+ * replaces fall back to a full handshake. May be called while sessions are
+ * being created.
+ *
+ * @param ctx Server context
+ * @param keys Secrets of at least TLS_TICKET_KEY_MIN_SIZE random bytes,
+ *             newest first, or nullptr to stop issuing tickets
+ * @param key_count Number of keys, 1 to TLS_MAX_TICKET_KEYS (0 with nullptr)
+ * @param lifetime_secs Ticket lifetime, also advertised to clients
+ * @return TLS_E_SUCCESS on success, TLS_E_INVALID_REQUEST for client
+ *         contexts and, with GnuTLS, for more than one key, negative error
+ *         code on failure
+ */
+[[nodiscard]] int tls_context_set_ticket_keys(tls_context_t *ctx,
+                                                const tls_datum_t *keys,
+                                                size_t key_count,
+                                                unsigned int lifetime_secs);
+
+/**
+ * Enable TLS 1.3 0-RTT early data
+ *
+ * Server: resumed clients may send up to @p max_size bytes with their
+ * ClientHello, and tickets issued afterwards advertise that limit. Once the
+ * ClientHello's ticket is found fresh (its age within
+ * TLS_EARLY_DATA_WINDOW_MS of what the client reports), @p check is asked
+ * whether the ClientHello was seen before; early data is only accepted from
+ * one that was not, so a recorded ClientHello replayed inside the window
+ * gets a 1-RTT handshake. The key is the PSK binder with GnuTLS; wolfSSL
+ * has no hook for the binder, so there the key is the ClientHello's random,
+ * which the binder covers.
+ *
+ * Client: @p max_size > 0 allows tls_session_write_early_data(); the limit
+ * that applies is the one in the server's ticket. @p check must be nullptr.
+ * GnuTLS clients then offer 0-RTT on every resumption the ticket allows,
+ * also without early data, so only enable it where it is used.
+ *
+ * Early data is not forward secret and can be replayed to servers that do
+ * not share @p check state: only send idempotent requests in it.
+ *
+ * @param ctx Context
+ * @param max_size Early data bytes per connection, 0 to disable
+ * @param check Anti-replay callback (server), nullptr for clients
+ * @param userdata User data passed to @p check
+ * @return TLS_E_SUCCESS on success, TLS_E_INVALID_PARAMETER for a server
+ *         without @p check or a client with one, TLS_E_INVALID_REQUEST for
+ *         DTLS contexts, negative error code on failure
+ *
+ * Note: Call during setup, before sessions are created.
+ */
+[[nodiscard]] int tls_context_set_early_data(tls_context_t *ctx,
+                                               size_t max_size,
+                                               tls_replay_check_func_t check,
+                                               void *userdata);
+
+/**
+ * Enable kernel TLS (kTLS) offload
+ *
+ * After tls_handshake() succeeds on a TCP socket given to
+ * tls_session_set_fd(), the negotiated keys are handed to the kernel and
+ * tls_send(), tls_recv() and tls_sendfile() become plain socket I/O.
+ * Sessions the kernel cannot take over (no kTLS support, another cipher,
+ * custom I/O functions) keep encrypting in user space; see
+ * tls_session_get_ktls().
+ *
+ * Supported: TLS 1.2 and TLS 1.3 with AES-128-GCM, AES-256-GCM or
+ * ChaCha20-Poly1305 on Linux, GnuTLS backend only. The wolfSSL backend
+ * accepts the setting but never offloads (it does not export the traffic
+ * keys), so its sessions always stay in user space. Renegotiation is not
+ * available on offloaded sessions.
+ *
+ * @param ctx Context
+ * @param enable true to offload, false to keep records in user space (default)
+ * @return TLS_E_SUCCESS on success, TLS_E_INVALID_REQUEST for DTLS contexts,
+ *         negative error code on failure
+ */
+[[nodiscard]] int tls_context_set_ktls(tls_context_t *ctx, bool enable);
+
+/**
+ * Drive handshakes as an explicit non-blocking state machine
+ *
+ * For event loops running many handshakes on one thread. Sessions created
+ * afterwards never wait inside the TLS library:
+ *
+ * - tls_handshake() returns TLS_E_WANT_READ or TLS_E_WANT_WRITE instead of
+ *   TLS_E_AGAIN, naming the readiness to wait for
+ * - DTLS retransmission timers are left to the caller: wait no longer than
+ *   tls_dtls_get_timeout(), then call tls_handshake() again even if nothing
+ *   arrived, and it retransmits
+ *
+ * Data calls still return TLS_E_AGAIN; their direction is the call's own.
+ *
+ * @param ctx Context
+ * @param enable true for explicit want codes, false for TLS_E_AGAIN (default)
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_context_set_nonblocking(tls_context_t *ctx, bool enable);
+
+/**
+ * Keep freed sessions for reuse
+ *
+ * tls_session_free() then resets sessions with tls_session_reset() and
+ * keeps up to @p max_sessions of them, and tls_session_new() hands them out
+ * again before creating new ones. A short-lived connection then costs a
+ * reset instead of a full session allocation and teardown. A pooled session
+ * set up before a tls_context_set_ticket_keys() or
+ * tls_context_set_early_data() call is set up again when handed out.
+ *
+ * @param ctx Context
+ * @param max_sessions Pool size, 0 to disable (default; pooled sessions are freed)
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ *
+ * Note: Thread-safe against tls_session_new() and tls_session_free() on
+ *       other threads. Pooled sessions are freed with the context.
+ */
+[[nodiscard]] int tls_context_set_session_pool(tls_context_t *ctx, size_t max_sessions);
+
+/* ============================================================================
+ * Shared Credentials (Certificate and Key Parsed Once)
+ * ============================================================================ */
+
+/**
+ * Parse a certificate chain and its private key once
+ *
+ * Many contexts with the same certificate (worker processes, virtual hosts,
+ * context generations) attach the result with tls_context_set_credentials()
+ * instead of reading and parsing the files each. Credentials are reference
+ * counted: every context they are attached to holds a reference, and the
+ * last tls_credentials_free() frees them.
+ *
+ * With GnuTLS attaching neither copies nor parses anything. wolfSSL keeps a
+ * parsed copy per context, so there attaching skips the file I/O and PEM
+ * decoding but still loads the DER.
+ *
+ * @param cert PEM certificate chain, leaf first
+ * @param cert_size Length of @p cert
+ * @param key PEM private key (unencrypted) for the leaf certificate
+ * @param key_size Length of @p key
+ * @return Credentials on success, nullptr on failure (unparseable data, or
+ *         a key that does not belong to the certificate)
+ *
+ * Note: Requires tls_global_init(); immutable once created, so attaching
+ *       from several threads is safe.
+ */
+[[nodiscard]] tls_credentials_t* tls_credentials_new(const void *cert, size_t cert_size,
+                                                     const void *key, size_t key_size);
+
+/**
+ * Take another reference to credentials
+ *
+ * @param creds Credentials
+ * @return @p creds (nullptr if @p creds is nullptr)
+ */
+tls_credentials_t* tls_credentials_ref(tls_credentials_t *creds);
+
+/**
+ * Drop a reference to credentials
+ *
+ * @param creds Credentials
+ */
+void tls_credentials_free(tls_credentials_t *creds);
+
+/**
+ * Use shared credentials as the context's certificate and key
+ *
+ * Replaces a certificate and key set with tls_context_set_cert_file() and
+ * friends, as those replace credentials; the context holds a reference
+ * until it is freed or given other credentials.
+ *
+ * @param ctx Context
+ * @param creds Credentials from tls_credentials_new()
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_context_set_credentials(tls_context_t *ctx, tls_credentials_t *creds);
+
 /* ============================================================================
  * Session Management (Individual TLS/DTLS Connections)
  * ============================================================================ */
@@ -446,6 +791,23 @@ void tls_context_free(tls_context_t *ctx);
  */
 void tls_session_free(tls_session_t *session);
 
+/**
+ * Reset a session for a new connection on the same context
+ *
+ * Drops the connection state and everything attached to the session (I/O
+ * setup, user pointer, memory-BIO mode, statistics) while keeping its
+ * buffers. Key material and buffered plaintext are wiped: the TLS library's
+ * connection object is freed and created again. The session then behaves as
+ * if just returned by tls_session_new().
+ *
+ * @param session Session
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ *         (the session can then only be freed)
+ *
+ * Note: Nothing is sent to the peer; call tls_bye() first for a clean close.
+ */
+[[nodiscard]] int tls_session_reset(tls_session_t *session);
+
 /**
  * Set file descriptor for session
  *
@@ -471,6 +833,64 @@ void tls_session_free(tls_session_t *session);
                                                  tls_pull_timeout_func_t pull_timeout_func,
                                                  void *userdata);
 
+/**
+ * Switch a session to memory-BIO mode
+ *
+ * The session no longer touches a socket: ciphertext received from the peer
+ * is handed in with tls_session_feed(), and ciphertext for the peer is
+ * collected with tls_session_drain(), so the event loop owns all socket I/O.
+ * tls_handshake(), tls_send(), tls_recv() and the other data calls work as
+ * usual on top of the two buffers; they return TLS_E_AGAIN when they need
+ * more ciphertext, and never block on output.
+ *
+ * The buffers belong to the session and are kept across calls, so once they
+ * have grown to the connection's largest backlog no further allocation
+ * happens. Stream (TLS) sessions only; must be called before the handshake,
+ * and the session cannot go back to tls_session_set_fd() afterwards.
+ *
+ * @param session Session
+ * @return TLS_E_SUCCESS on success, TLS_E_INVALID_REQUEST for DTLS sessions,
+ *         negative error code on other failures
+ */
+[[nodiscard]] int tls_session_set_memory_bio(tls_session_t *session);
+
+/**
+ * Hand ciphertext received from the peer to a memory-BIO session
+ *
+ * The bytes are copied and consumed by the next tls_handshake() or
+ * tls_recv(). A call with @p len 0 marks the end of the stream (the peer
+ * closed the connection): once the fed bytes are used up, reads see EOF
+ * instead of TLS_E_AGAIN.
+ *
+ * @param session Session in memory-BIO mode
+ * @param data Ciphertext
+ * @param len Length of @p data
+ * @return @p len on success, negative error code on failure
+ */
+[[nodiscard]] ssize_t tls_session_feed(tls_session_t *session, const void *data, size_t len);
+
+/**
+ * Collect ciphertext a memory-BIO session has produced for the peer
+ *
+ * Call after every tls_handshake(), tls_send(), tls_uncork() or tls_bye(),
+ * and whenever tls_session_pending_output() is non-zero.
+ *
+ * @param session Session in memory-BIO mode
+ * @param out Buffer to fill
+ * @param len Size of @p out
+ * @return Bytes copied to @p out (0 if nothing is pending), negative error
+ *         code on failure
+ */
+[[nodiscard]] ssize_t tls_session_drain(tls_session_t *session, void *out, size_t len);
+
+/**
+ * Get number of ciphertext bytes waiting for tls_session_drain()
+ *
+ * @param session Session
+ * @return Bytes pending (0 if none or not in memory-BIO mode)
+ */
+[[nodiscard]] size_t tls_session_pending_output(tls_session_t *session);
+
 /**
  * Set user pointer for session
  *
@@ -497,6 +917,74 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr);
 [[nodiscard]] int tls_session_set_timeout(tls_session_t *session,
                                             unsigned int timeout_ms);
 
+/**
+ * Export the negotiated session for resumption (client)
+ *
+ * Call after the handshake; with TLS 1.3 the ticket arrives after it, so
+ * export once the first tls_recv() has returned data.
+ *
+ * @param session Client session
+ * @param data Output buffer, or nullptr to query the size
+ * @param size In: size of @p data; out: bytes written, or needed
+ * @return TLS_E_SUCCESS on success, TLS_E_INVALID_PARAMETER if @p data is
+ *         too small (*size is set to the size needed), negative error code
+ *         on failure
+ */
+[[nodiscard]] int tls_session_get_data(tls_session_t *session, void *data, size_t *size);
+
+/**
+ * Offer a session exported by tls_session_get_data() (client)
+ *
+ * Call before tls_handshake(). If the server does not accept it the
+ * handshake falls back to a full one; check session_resumed in
+ * tls_get_connection_info().
+ *
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_session_set_data(tls_session_t *session, const void *data, size_t size);
+
+/**
+ * Send 0-RTT early data with the ClientHello (client)
+ *
+ * Call after tls_session_set_data() with a ticket from a server that allows
+ * early data, before tls_handshake(). If the server rejects it (check
+ * early_data_accepted in tls_get_connection_info() after the handshake),
+ * the data was not delivered and must be sent again with tls_send().
+ *
+ * @param session Client session on a context with early data enabled
+ * @param data Data to send
+ * @param len Data length
+ * @return Bytes queued on success, TLS_E_INVALID_REQUEST if early data is
+ *         not enabled, TLS_E_AGAIN (call again with the same data), negative
+ *         error code on failure
+ *
+ * Note: wolfSSL writes the ClientHello and the data right away; GnuTLS
+ *       queues the data and sends both from tls_handshake().
+ */
+[[nodiscard]] ssize_t tls_session_write_early_data(tls_session_t *session,
+                                                     const void *data,
+                                                     size_t len);
+
+/**
+ * Read 0-RTT early data (server)
+ *
+ * Early data arrives with the ClientHello, so it can be read as soon as
+ * tls_handshake() has processed it: on a non-blocking session while the
+ * handshake still waits for the client's Finished, a round trip before the
+ * same bytes could arrive with tls_recv(). Data not read then stays
+ * readable after the handshake. Replies go out with tls_send() once the
+ * handshake is complete.
+ *
+ * @param session Server session
+ * @param buf Output buffer
+ * @param size Buffer size
+ * @return Bytes read, 0 if there is no (more) early data, negative error
+ *         code on failure
+ */
+[[nodiscard]] ssize_t tls_session_read_early_data(tls_session_t *session,
+                                                    void *buf,
+                                                    size_t size);
+
 /* ============================================================================
  * DTLS-Specific Functions
  * ============================================================================ */
@@ -530,6 +1018,21 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr);
                                           unsigned int retrans_timeout_ms,
                                           unsigned int total_timeout_ms);
 
+/**
+ * Get time left until the next DTLS handshake retransmission
+ *
+ * Use as the event loop's wait timeout after tls_handshake() returned
+ * TLS_E_WANT_READ on a session of a tls_context_set_nonblocking() context.
+ *
+ * @param session DTLS session
+ * @param timeout_ms Output: milliseconds until tls_handshake() is due again
+ *                   (0 if it is already overdue)
+ * @return TLS_E_SUCCESS on success, TLS_E_INVALID_REQUEST if no timer is
+ *         running (not DTLS, not non-blocking, or handshake done), negative
+ *         error code on other failures
+ */
+[[nodiscard]] int tls_dtls_get_timeout(tls_session_t *session, unsigned int *timeout_ms);
+
 /* ============================================================================
  * Handshake Operations
  * ============================================================================ */
@@ -542,7 +1045,9 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr);
  *         negative error code on failure
  *
  * Note: This function may return TLS_E_AGAIN for non-blocking I/O.
- *       Caller should call again when socket is ready.
+ *       Caller should call again when socket is ready. Sessions of a
+ *       tls_context_set_nonblocking() context return TLS_E_WANT_READ or
+ *       TLS_E_WANT_WRITE instead.
  */
 [[nodiscard]] int tls_handshake(tls_session_t *session);
 
@@ -586,6 +1091,69 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr);
                                  void *data,
                                  size_t len);
 
+/**
+ * Send data gathered from several buffers over TLS/DTLS
+ *
+ * Sends the concatenation of @p iov as one tls_send() of a staging buffer
+ * would, without the caller copying the fragments together: they are packed
+ * into as few records as possible. With DTLS everything goes into a single
+ * record, so the total must fit one datagram.
+ *
+ * @param session Session
+ * @param iov Buffers to send, in order
+ * @param iovcnt Number of buffers
+ * @return Number of bytes sent on success, negative error code on failure
+ *
+ * Note: May return TLS_E_AGAIN for non-blocking I/O. Like writev(), a
+ *       non-blocking send may also return less than the total; call again
+ *       with the remaining data.
+ */
+[[nodiscard]] ssize_t tls_sendv(tls_session_t *session,
+                                  const struct iovec *iov,
+                                  int iovcnt);
+
+/**
+ * Receive data over TLS/DTLS into several buffers
+ *
+ * Fills @p iov in order. Only waits (or returns TLS_E_AGAIN) for the first
+ * byte; after that it keeps filling while decrypted data is already
+ * buffered, so one call may return data from several records. With DTLS one
+ * call returns one record; bytes that do not fit are discarded, as with
+ * recvmsg().
+ *
+ * @param session Session
+ * @param iov Buffers to fill, in order
+ * @param iovcnt Number of buffers
+ * @return Number of bytes received on success, negative error code on failure
+ *
+ * Note: May return TLS_E_AGAIN for non-blocking I/O.
+ */
+[[nodiscard]] ssize_t tls_recvv(tls_session_t *session,
+                                  const struct iovec *iov,
+                                  int iovcnt);
+
+/**
+ * Send part of a file over TLS
+ *
+ * With kTLS transmit offload this is sendfile(): the data goes from the page
+ * cache to the socket without being copied to user space. Otherwise the
+ * file is read in record-sized chunks and sent with tls_send().
+ *
+ * @param session Session (TLS only)
+ * @param in_fd File to read from
+ * @param offset File offset to start at, advanced past the bytes sent;
+ *               nullptr to use (and advance) the file position
+ * @param count Number of bytes to send
+ * @return Number of bytes sent (0 at end of file), negative error code on failure
+ *
+ * Note: May return TLS_E_AGAIN for non-blocking I/O. Like sendfile(), it
+ *       may also return less than @p count.
+ */
+[[nodiscard]] ssize_t tls_sendfile(tls_session_t *session,
+                                     int in_fd,
+                                     off_t *offset,
+                                     size_t count);
+
 /**
  * Check if data is pending in TLS buffer
  *
@@ -597,6 +1165,11 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr);
 /**
  * Enable record corking (buffer multiple records)
  *
+ * Until tls_uncork(), sent data is gathered into full-size records that are
+ * written out together, so many small sends cost few records and few
+ * system calls. A corked session may still write once a large amount of
+ * data has accumulated.
+ *
  * @param session Session
  * @return TLS_E_SUCCESS on success, negative error code on failure
  */
@@ -607,6 +1180,9 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr);
  *
  * @param session Session
  * @return TLS_E_SUCCESS on success, negative error code on failure
+ *
+ * Note: May return TLS_E_AGAIN for non-blocking I/O; the session is no
+ *       longer corked, and calling tls_uncork() again writes the rest.
  */
 [[nodiscard]] int tls_uncork(tls_session_t *session);
 
@@ -662,6 +1238,38 @@ void tls_alert_send(tls_session_t *session, tls_alert_t alert);
  */
 [[nodiscard]] const tls_certificate_t* tls_get_peer_certificate(tls_session_t *session);
 
+/**
+ * Get kernel TLS offload state
+ *
+ * @param session Session
+ * @return TLS_KTLS_* flags of the directions handled by the kernel
+ *         (TLS_KTLS_NONE before the handshake or without offload)
+ */
+[[nodiscard]] unsigned int tls_session_get_ktls(tls_session_t *session);
+
+/**
+ * Get memory statistics of a session
+ *
+ * Counts the allocations and frees made through the installed allocator
+ * while the session was being created, handshaking, transferring data or
+ * closing (see tls_global_init_with_allocator for what that covers).
+ *
+ * What that includes depends on the backend:
+ * - wolfSSL: everything the library allocates for the session, so the
+ *   counters approximate its memory use.
+ * - GnuTLS: only the abstraction layer's own allocations (the session
+ *   structure and memory-BIO buffers). GnuTLS has ignored replacement
+ *   allocators since 3.3, so its record buffers, key schedule and handshake
+ *   state are not counted, and the counters are not a measure of
+ *   per-session memory.
+ *
+ * @param session Session
+ * @param stats Output structure
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_session_get_memory_stats(tls_session_t *session,
+                                                 tls_memory_stats_t *stats);
+
 /* ============================================================================
  * Error Handling
  * ============================================================================ */
@@ -725,12 +1333,150 @@ void tls_free(void *ptr);
 /**
  * Generate random bytes
  *
+ * Thread-safe, and a forked child never repeats its parent's output. Each
+ * thread keeps its generator state between calls (wolfSSL: a cached DRBG
+ * serving small requests from a batch; GnuTLS does the same internally).
+ *
  * @param data Output buffer
  * @param len Number of bytes to generate
  * @return TLS_E_SUCCESS on success, negative error code on failure
  */
 [[nodiscard]] int tls_random(void *data, size_t len);
 
+/* ============================================================================
+ * Hashing and Key Derivation
+ * ============================================================================ */
+
+/*
+ * Contexts are caller-owned storage: initializing, updating and finishing
+ * them never allocates, and a finished context is ready for the next
+ * message (hash: empty; HMAC: same key), so a long-lived context pays the
+ * setup - for HMAC, hashing the key pads - once. Contexts hold key material
+ * and backend state: release them with tls_hash_deinit()/tls_hmac_deinit(),
+ * which also wipe them. A context is not thread-safe; use one per thread.
+ */
+
+/**
+ * Output size of a digest algorithm
+ *
+ * @return Size in bytes, or 0 for an unknown algorithm
+ */
+[[nodiscard]] size_t tls_digest_size(tls_digest_t digest);
+
+/**
+ * Start a hash
+ *
+ * @param ctx Context to initialize
+ * @param digest Algorithm
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_hash_init(tls_hash_ctx_t *ctx, tls_digest_t digest);
+
+/**
+ * Add data to a hash
+ */
+[[nodiscard]] int tls_hash_update(tls_hash_ctx_t *ctx, const void *data, size_t len);
+
+/**
+ * Finish a hash and reset the context for the next message
+ *
+ * @param output tls_digest_size() bytes
+ */
+[[nodiscard]] int tls_hash_final(tls_hash_ctx_t *ctx, uint8_t *output);
+
+/**
+ * Release and wipe a hash context (nullptr is a no-op)
+ */
+void tls_hash_deinit(tls_hash_ctx_t *ctx);
+
+/**
+ * Hash many independent inputs in one call
+ *
+ * Equivalent to tls_hash_fast() on each buffer, but one context is set up
+ * and reused for the whole batch, so per-message cost is the compression
+ * function alone. Meant for many small inputs: cookies, fingerprints.
+ *
+ * @param digest Algorithm
+ * @param inputs Buffers, each hashed separately
+ * @param count Number of buffers
+ * @param outputs count * tls_digest_size() bytes; digest i at offset
+ *                i * tls_digest_size()
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_hash_batch(tls_digest_t digest,
+                                   const struct iovec *inputs,
+                                   size_t count,
+                                   uint8_t *outputs);
+
+/**
+ * Start an HMAC
+ *
+ * @param ctx Context to initialize
+ * @param digest Underlying hash
+ * @param key Key (may be longer than the block size; it is hashed then)
+ * @param key_len Key length
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_hmac_init(tls_hmac_ctx_t *ctx, tls_digest_t digest,
+                                  const void *key, size_t key_len);
+
+/**
+ * Add data to an HMAC
+ */
+[[nodiscard]] int tls_hmac_update(tls_hmac_ctx_t *ctx, const void *data, size_t len);
+
+/**
+ * Finish an HMAC and reset the context for the next message under the
+ * same key
+ *
+ * @param output tls_digest_size() bytes
+ */
+[[nodiscard]] int tls_hmac_final(tls_hmac_ctx_t *ctx, uint8_t *output);
+
+/**
+ * Release an HMAC context and wipe the key material it holds (nullptr is
+ * a no-op)
+ */
+void tls_hmac_deinit(tls_hmac_ctx_t *ctx);
+
+/**
+ * HKDF-Extract (RFC 5869)
+ *
+ * @param digest Underlying hash
+ * @param salt Salt (nullptr with salt_len 0 for none)
+ * @param ikm Input keying material
+ * @param prk Pseudorandom key output, tls_digest_size() bytes
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_hkdf_extract(tls_digest_t digest,
+                                     const void *salt, size_t salt_len,
+                                     const void *ikm, size_t ikm_len,
+                                     uint8_t *prk);
+
+/**
+ * HKDF-Expand (RFC 5869)
+ *
+ * @param digest Underlying hash
+ * @param prk Pseudorandom key, at least tls_digest_size() bytes
+ * @param info Context string (nullptr with info_len 0 for none)
+ * @param okm Output keying material
+ * @param okm_len Output length, at most 255 * tls_digest_size()
+ * @return TLS_E_SUCCESS on success, negative error code on failure
+ */
+[[nodiscard]] int tls_hkdf_expand(tls_digest_t digest,
+                                    const uint8_t *prk, size_t prk_len,
+                                    const void *info, size_t info_len,
+                                    uint8_t *okm, size_t okm_len);
+
+/**
+ * HKDF-Extract followed by HKDF-Expand; the intermediate key is wiped
+ */
+[[nodiscard]] int tls_hkdf(tls_digest_t digest,
+                             const void *salt, size_t salt_len,
+                             const void *ikm, size_t ikm_len,
+                             const void *info, size_t info_len,
+                             uint8_t *okm, size_t okm_len);
+
 /* ============================================================================
  * C23 Cleanup Attribute Support
  * ============================================================================ */
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WOLFGUARD_TLS_BACKEND_H
+#define WOLFGUARD_TLS_BACKEND_H
+
+/**
+ * Backend Operations Table (internal)
+ *
+ * Every backend exports a tls_backend_ops_t holding its implementation of
+ * the public API, and tls_global_init() selects one of them.
+ *
+ * Single-backend builds (USE_GNUTLS or USE_WOLFSSL) keep the backend's
+ * functions under their public names, so application calls stay direct;
+ * the table is only used for init, deinit and the version string.
+ *
+ * Dual-backend builds (both defined, TLS_DUAL_BACKEND) compile both backends
+ * into one library. A backend defines TLS_BACKEND_SYMBOL before including
+ * this header, which renames its definitions (tls_send becomes
+ * tls_gnutls_send), and tls_abstract.c defines the public functions as
+ * one indirect call through the selected table. Calls made before
+ * tls_global_init() go to the first compiled backend (GnuTLS).
+ *
+ * TLS_BACKEND_OPS() is the single list of dispatched functions: the table,
+ * the dispatchers and the initializers are all generated from it. A function
+ * added to tls_abstract.h but not here fails to link in dual builds (both
+ * backends define it); one listed here but missing from the renames below
+ * fails the same way.
+ */
+
+#if defined(USE_GNUTLS) && defined(USE_WOLFSSL)
+#define TLS_DUAL_BACKEND 1
+#endif
+
+/* ============================================================================
+ * Symbol Renaming (dual-backend builds, backend sources only)
+ * ============================================================================ */
+
+#if defined(TLS_DUAL_BACKEND) && defined(TLS_BACKEND_SYMBOL)
+#define tls_context_new TLS_BACKEND_SYMBOL(context_new)
+#define tls_context_free TLS_BACKEND_SYMBOL(context_free)
+#define tls_context_ref TLS_BACKEND_SYMBOL(context_ref)
+#define tls_context_set_cert_file TLS_BACKEND_SYMBOL(context_set_cert_file)
+#define tls_context_set_key_file TLS_BACKEND_SYMBOL(context_set_key_file)
+#define tls_context_set_cert_mem TLS_BACKEND_SYMBOL(context_set_cert_mem)
+#define tls_context_set_key_mem TLS_BACKEND_SYMBOL(context_set_key_mem)
+#define tls_context_set_ca_file TLS_BACKEND_SYMBOL(context_set_ca_file)
+#define tls_context_set_priority TLS_BACKEND_SYMBOL(context_set_priority)
+#define tls_context_set_dh_params_file TLS_BACKEND_SYMBOL(context_set_dh_params_file)
+#define tls_context_set_verify TLS_BACKEND_SYMBOL(context_set_verify)
+#define tls_context_set_psk_server_callback TLS_BACKEND_SYMBOL(context_set_psk_server_callback)
+#define tls_context_set_session_cache TLS_BACKEND_SYMBOL(context_set_session_cache)
+#define tls_context_set_session_cache_lease TLS_BACKEND_SYMBOL(context_set_session_cache_lease)
+#define tls_context_set_session_timeout TLS_BACKEND_SYMBOL(context_set_session_timeout)
+#define tls_context_set_ticket_keys TLS_BACKEND_SYMBOL(context_set_ticket_keys)
+#define tls_context_set_early_data TLS_BACKEND_SYMBOL(context_set_early_data)
+#define tls_context_set_ktls TLS_BACKEND_SYMBOL(context_set_ktls)
+#define tls_context_set_nonblocking TLS_BACKEND_SYMBOL(context_set_nonblocking)
+#define tls_context_set_session_pool TLS_BACKEND_SYMBOL(context_set_session_pool)
+#define tls_credentials_new TLS_BACKEND_SYMBOL(credentials_new)
+#define tls_credentials_ref TLS_BACKEND_SYMBOL(credentials_ref)
+#define tls_credentials_free TLS_BACKEND_SYMBOL(credentials_free)
+#define tls_context_set_credentials TLS_BACKEND_SYMBOL(context_set_credentials)
+#define tls_session_new TLS_BACKEND_SYMBOL(session_new)
+#define tls_session_free TLS_BACKEND_SYMBOL(session_free)
+#define tls_session_reset TLS_BACKEND_SYMBOL(session_reset)
+#define tls_session_set_fd TLS_BACKEND_SYMBOL(session_set_fd)
+#define tls_session_set_io_functions TLS_BACKEND_SYMBOL(session_set_io_functions)
+#define tls_session_set_memory_bio TLS_BACKEND_SYMBOL(session_set_memory_bio)
+#define tls_session_feed TLS_BACKEND_SYMBOL(session_feed)
+#define tls_session_drain TLS_BACKEND_SYMBOL(session_drain)
+#define tls_session_pending_output TLS_BACKEND_SYMBOL(session_pending_output)
+#define tls_session_set_ptr TLS_BACKEND_SYMBOL(session_set_ptr)
+#define tls_session_get_ptr TLS_BACKEND_SYMBOL(session_get_ptr)
+#define tls_session_set_timeout TLS_BACKEND_SYMBOL(session_set_timeout)
+#define tls_session_get_data TLS_BACKEND_SYMBOL(session_get_data)
+#define tls_session_set_data TLS_BACKEND_SYMBOL(session_set_data)
+#define tls_session_write_early_data TLS_BACKEND_SYMBOL(session_write_early_data)
+#define tls_session_read_early_data TLS_BACKEND_SYMBOL(session_read_early_data)
+#define tls_dtls_set_mtu TLS_BACKEND_SYMBOL(dtls_set_mtu)
+#define tls_dtls_get_mtu TLS_BACKEND_SYMBOL(dtls_get_mtu)
+#define tls_dtls_set_timeouts TLS_BACKEND_SYMBOL(dtls_set_timeouts)
+#define tls_dtls_get_timeout TLS_BACKEND_SYMBOL(dtls_get_timeout)
+#define tls_handshake TLS_BACKEND_SYMBOL(handshake)
+#define tls_rehandshake TLS_BACKEND_SYMBOL(rehandshake)
+#define tls_send TLS_BACKEND_SYMBOL(send)
+#define tls_recv TLS_BACKEND_SYMBOL(recv)
+#define tls_sendv TLS_BACKEND_SYMBOL(sendv)
+#define tls_recvv TLS_BACKEND_SYMBOL(recvv)
+#define tls_sendfile TLS_BACKEND_SYMBOL(sendfile)
+#define tls_pending TLS_BACKEND_SYMBOL(pending)
+#define tls_cork TLS_BACKEND_SYMBOL(cork)
+#define tls_uncork TLS_BACKEND_SYMBOL(uncork)
+#define tls_bye TLS_BACKEND_SYMBOL(bye)
+#define tls_alert_send TLS_BACKEND_SYMBOL(alert_send)
+#define tls_get_connection_info TLS_BACKEND_SYMBOL(get_connection_info)
+#define tls_get_session_desc TLS_BACKEND_SYMBOL(get_session_desc)
+#define tls_get_peer_certificate TLS_BACKEND_SYMBOL(get_peer_certificate)
+#define tls_session_get_memory_stats TLS_BACKEND_SYMBOL(session_get_memory_stats)
+#define tls_session_get_ktls TLS_BACKEND_SYMBOL(session_get_ktls)
+#define tls_strerror TLS_BACKEND_SYMBOL(strerror)
+#define tls_error_is_fatal TLS_BACKEND_SYMBOL(error_is_fatal)
+#define tls_get_last_error TLS_BACKEND_SYMBOL(get_last_error)
+#define tls_malloc TLS_BACKEND_SYMBOL(malloc)
+#define tls_free TLS_BACKEND_SYMBOL(free)
+#define tls_hash_fast TLS_BACKEND_SYMBOL(hash_fast)
+#define tls_random TLS_BACKEND_SYMBOL(random)
+#define tls_digest_size TLS_BACKEND_SYMBOL(digest_size)
+#define tls_hash_init TLS_BACKEND_SYMBOL(hash_init)
+#define tls_hash_update TLS_BACKEND_SYMBOL(hash_update)
+#define tls_hash_final TLS_BACKEND_SYMBOL(hash_final)
+#define tls_hash_deinit TLS_BACKEND_SYMBOL(hash_deinit)
+#define tls_hash_batch TLS_BACKEND_SYMBOL(hash_batch)
+#define tls_hmac_init TLS_BACKEND_SYMBOL(hmac_init)
+#define tls_hmac_update TLS_BACKEND_SYMBOL(hmac_update)
+#define tls_hmac_final TLS_BACKEND_SYMBOL(hmac_final)
+#define tls_hmac_deinit TLS_BACKEND_SYMBOL(hmac_deinit)
+#define tls_hkdf_extract TLS_BACKEND_SYMBOL(hkdf_extract)
+#define tls_hkdf_expand TLS_BACKEND_SYMBOL(hkdf_expand)
+#define tls_hkdf TLS_BACKEND_SYMBOL(hkdf)
+#endif
+
+#include "tls_abstract.h"
+
+/* ============================================================================
+ * Operations
+ * ============================================================================ */
+
+/*
+ * X(return type, name, (parameters), (arguments)) for functions returning a
+ * value, V(...) for void ones; name is the public name without "tls_"
+ */
+#define TLS_BACKEND_OPS(X, V) \
+    /* Context */ \
+    X(tls_context_t *, context_new, (bool is_server, bool is_dtls), (is_server, is_dtls)) \
+    V(void, context_free, (tls_context_t *ctx), (ctx)) \
+    X(tls_context_t *, context_ref, (tls_context_t *ctx), (ctx)) \
+    X(int, context_set_cert_file, (tls_context_t *ctx, const char *cert_file), (ctx, cert_file)) \
+    X(int, context_set_key_file, (tls_context_t *ctx, const char *key_file), (ctx, key_file)) \
+    X(int, context_set_cert_mem, (tls_context_t *ctx, const void *cert, size_t size), (ctx, cert, size)) \
+    X(int, context_set_key_mem, (tls_context_t *ctx, const void *key, size_t size), (ctx, key, size)) \
+    X(int, context_set_ca_file, (tls_context_t *ctx, const char *ca_file), (ctx, ca_file)) \
+    X(int, context_set_priority, (tls_context_t *ctx, const char *priority), (ctx, priority)) \
+    X(int, context_set_dh_params_file, (tls_context_t *ctx, const char *dh_file), (ctx, dh_file)) \
+    X(int, context_set_verify, (tls_context_t *ctx, bool verify, tls_cert_verify_func_t callback, void *userdata), (ctx, verify, callback, userdata)) \
+    X(int, context_set_psk_server_callback, (tls_context_t *ctx, tls_psk_server_func_t callback, void *userdata), (ctx, callback, userdata)) \
+    X(int, context_set_session_cache, (tls_context_t *ctx, tls_db_store_func_t store_func, tls_db_retrieve_func_t retrieve_func, tls_db_remove_func_t remove_func, void *userdata), (ctx, store_func, retrieve_func, remove_func, userdata)) \
+    X(int, context_set_session_cache_lease, (tls_context_t *ctx, tls_db_borrow_func_t borrow_func, tls_db_release_func_t release_func), (ctx, borrow_func, release_func)) \
+    X(int, context_set_session_timeout, (tls_context_t *ctx, unsigned int timeout_secs), (ctx, timeout_secs)) \
+    X(int, context_set_ticket_keys, (tls_context_t *ctx, const tls_datum_t *keys, size_t key_count, unsigned int lifetime_secs), (ctx, keys, key_count, lifetime_secs)) \
+    X(int, context_set_early_data, (tls_context_t *ctx, size_t max_size, tls_replay_check_func_t check, void *userdata), (ctx, max_size, check, userdata)) \
+    X(int, context_set_ktls, (tls_context_t *ctx, bool enable), (ctx, enable)) \
+    X(int, context_set_nonblocking, (tls_context_t *ctx, bool enable), (ctx, enable)) \
+    X(int, context_set_session_pool, (tls_context_t *ctx, size_t max_sessions), (ctx, max_sessions)) \
+    X(tls_credentials_t *, credentials_new, (const void *cert, size_t cert_size, const void *key, size_t key_size), (cert, cert_size, key, key_size)) \
+    X(tls_credentials_t *, credentials_ref, (tls_credentials_t *creds), (creds)) \
+    V(void, credentials_free, (tls_credentials_t *creds), (creds)) \
+    X(int, context_set_credentials, (tls_context_t *ctx, tls_credentials_t *creds), (ctx, creds)) \
+    /* Session */ \
+    X(tls_session_t *, session_new, (tls_context_t *ctx), (ctx)) \
+    V(void, session_free, (tls_session_t *session), (session)) \
+    X(int, session_reset, (tls_session_t *session), (session)) \
+    X(int, session_set_fd, (tls_session_t *session, int fd), (session, fd)) \
+    X(int, session_set_io_functions, (tls_session_t *session, tls_push_func_t push_func, tls_pull_func_t pull_func, tls_pull_timeout_func_t pull_timeout_func, void *userdata), (session, push_func, pull_func, pull_timeout_func, userdata)) \
+    X(int, session_set_memory_bio, (tls_session_t *session), (session)) \
+    X(ssize_t, session_feed, (tls_session_t *session, const void *data, size_t len), (session, data, len)) \
+    X(ssize_t, session_drain, (tls_session_t *session, void *out, size_t len), (session, out, len)) \
+    X(size_t, session_pending_output, (tls_session_t *session), (session)) \
+    V(void, session_set_ptr, (tls_session_t *session, void *ptr), (session, ptr)) \
+    X(void *, session_get_ptr, (tls_session_t *session), (session)) \
+    X(int, session_set_timeout, (tls_session_t *session, unsigned int timeout_ms), (session, timeout_ms)) \
+    X(int, session_get_data, (tls_session_t *session, void *data, size_t *size), (session, data, size)) \
+    X(int, session_set_data, (tls_session_t *session, const void *data, size_t size), (session, data, size)) \
+    X(ssize_t, session_write_early_data, (tls_session_t *session, const void *data, size_t len), (session, data, len)) \
+    X(ssize_t, session_read_early_data, (tls_session_t *session, void *buf, size_t size), (session, buf, size)) \
+    X(int, dtls_set_mtu, (tls_session_t *session, unsigned int mtu), (session, mtu)) \
+    X(int, dtls_get_mtu, (tls_session_t *session), (session)) \
+    X(int, dtls_set_timeouts, (tls_session_t *session, unsigned int retrans_timeout_ms, unsigned int total_timeout_ms), (session, retrans_timeout_ms, total_timeout_ms)) \
+    X(int, dtls_get_timeout, (tls_session_t *session, unsigned int *timeout_ms), (session, timeout_ms)) \
+    X(int, session_get_memory_stats, (tls_session_t *session, tls_memory_stats_t *stats), (session, stats)) \
+    X(unsigned int, session_get_ktls, (tls_session_t *session), (session)) \
+    /* I/O */ \
+    X(int, handshake, (tls_session_t *session), (session)) \
+    X(int, rehandshake, (tls_session_t *session), (session)) \
+    X(ssize_t, send, (tls_session_t *session, const void *data, size_t len), (session, data, len)) \
+    X(ssize_t, recv, (tls_session_t *session, void *data, size_t len), (session, data, len)) \
+    X(ssize_t, sendv, (tls_session_t *session, const struct iovec *iov, int iovcnt), (session, iov, iovcnt)) \
+    X(ssize_t, recvv, (tls_session_t *session, const struct iovec *iov, int iovcnt), (session, iov, iovcnt)) \
+    X(ssize_t, sendfile, (tls_session_t *session, int in_fd, off_t *offset, size_t count), (session, in_fd, offset, count)) \
+    X(size_t, pending, (tls_session_t *session), (session)) \
+    X(int, cork, (tls_session_t *session), (session)) \
+    X(int, uncork, (tls_session_t *session), (session)) \
+    X(int, bye, (tls_session_t *session), (session)) \
+    V(void, alert_send, (tls_session_t *session, tls_alert_t alert), (session, alert)) \
+    /* Session information */ \
+    X(int, get_connection_info, (tls_session_t *session, tls_connection_info_t *info), (session, info)) \
+    X(char *, get_session_desc, (tls_session_t *session), (session)) \
+    X(const tls_certificate_t *, get_peer_certificate, (tls_session_t *session), (session)) \
+    /* Errors */ \
+    X(const char *, strerror, (int error_code), (error_code)) \
+    X(bool, error_is_fatal, (int error_code), (error_code)) \
+    X(int, get_last_error, (void), ()) \
+    /* Utilities */ \
+    X(void *, malloc, (size_t size), (size)) \
+    V(void, free, (void *ptr), (ptr)) \
+    X(int, hash_fast, (int algo, const void *data, size_t data_len, uint8_t *output), (algo, data, data_len, output)) \
+    X(int, random, (void *data, size_t len), (data, len)) \
+    /* Hashing and key derivation */ \
+    X(size_t, digest_size, (tls_digest_t digest), (digest)) \
+    X(int, hash_init, (tls_hash_ctx_t *ctx, tls_digest_t digest), (ctx, digest)) \
+    X(int, hash_update, (tls_hash_ctx_t *ctx, const void *data, size_t len), (ctx, data, len)) \
+    X(int, hash_final, (tls_hash_ctx_t *ctx, uint8_t *output), (ctx, output)) \
+    V(void, hash_deinit, (tls_hash_ctx_t *ctx), (ctx)) \
+    X(int, hash_batch, (tls_digest_t digest, const struct iovec *inputs, size_t count, uint8_t *outputs), (digest, inputs, count, outputs)) \
+    X(int, hmac_init, (tls_hmac_ctx_t *ctx, tls_digest_t digest, const void *key, size_t key_len), (ctx, digest, key, key_len)) \
+    X(int, hmac_update, (tls_hmac_ctx_t *ctx, const void *data, size_t len), (ctx, data, len)) \
+    X(int, hmac_final, (tls_hmac_ctx_t *ctx, uint8_t *output), (ctx, output)) \
+    V(void, hmac_deinit, (tls_hmac_ctx_t *ctx), (ctx)) \
+    X(int, hkdf_extract, (tls_digest_t digest, const void *salt, size_t salt_len, const void *ikm, size_t ikm_len, uint8_t *prk), (digest, salt, salt_len, ikm, ikm_len, prk)) \
+    X(int, hkdf_expand, (tls_digest_t digest, const uint8_t *prk, size_t prk_len, const void *info, size_t info_len, uint8_t *okm, size_t okm_len), (digest, prk, prk_len, info, info_len, okm, okm_len)) \
+    X(int, hkdf, (tls_digest_t digest, const void *salt, size_t salt_len, const void *ikm, size_t ikm_len, const void *info, size_t info_len, uint8_t *okm, size_t okm_len), (digest, salt, salt_len, ikm, ikm_len, info, info_len, okm, okm_len))
+
+#define TLS_BACKEND_OP_MEMBER(ret, name, params, args) ret (*op_##name) params;
+
+typedef struct {
+    tls_backend_t backend;
+    int (*init)(void);
+    void (*deinit)(void);
+    const char *(*get_version)(void);
+    TLS_BACKEND_OPS(TLS_BACKEND_OP_MEMBER, TLS_BACKEND_OP_MEMBER)
+} tls_backend_ops_t;
+
+/* Table initializer for the including backend: .op_send = tls_send, ... */
+#define TLS_BACKEND_OP_INIT(ret, name, params, args) .op_##name = tls_##name,
+#define TLS_BACKEND_OPS_INITIALIZER TLS_BACKEND_OPS(TLS_BACKEND_OP_INIT, TLS_BACKEND_OP_INIT)
+
+#ifdef USE_GNUTLS
+extern const tls_backend_ops_t tls_gnutls_ops;
+#endif
+
+#ifdef USE_WOLFSSL
+extern const tls_backend_ops_t tls_wolfssl_ops;
+#endif
+
+/**
+ * Table of the active backend (the first compiled one before
+ * tls_global_init())
+ */
+[[nodiscard]] const tls_backend_ops_t *tls_backend_get_ops(void);
+
+#endif // WOLFGUARD_TLS_BACKEND_H
@@ -17,11 +17,24 @@
  * - Comprehensive error handling
  */
 
+#define _POSIX_C_SOURCE 200809L  // For pread()
+
+// Dual-backend builds rename the public entry points (see tls_backend.h)
+#define TLS_BACKEND_SYMBOL(name) tls_gnutls_##name
+#include "tls_backend.h"
+
 #include "tls_gnutls.h"
+#include "ktls.h"
+#include "allocator.h"
+#include <nettle/hkdf.h>
+#include <nettle/hmac.h>
+#include <nettle/nettle-meta.h>
+#include <nettle/sha2.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #include <time.h>
 
@@ -34,6 +47,9 @@ static int gnutls_db_store_cb(void *ptr, gnutls_datum_t key, gnutls_datum_t data
 static gnutls_datum_t gnutls_db_retrieve_cb(void *ptr, gnutls_datum_t key);
 static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key);
 
+// Session pool
+static void gnutls_session_destroy(tls_session_t *session);
+
 /* ============================================================================
  * Global State
  * ============================================================================ */
@@ -62,7 +78,9 @@ int tls_gnutls_init(void) {
         return TLS_E_BACKEND_ERROR;
     }
 
-    // Initialize GnuTLS
+    // Initialize GnuTLS. The installed allocator is not handed over:
+    // gnutls_global_set_mem_functions() has been a no-op since 3.3, so only
+    // the buffers this backend allocates itself come from it.
     int ret = gnutls_global_init();
     if (ret != GNUTLS_E_SUCCESS) {
         fprintf(stderr, "gnutls_global_init failed: %s\n", gnutls_strerror(ret));
@@ -83,6 +101,24 @@ void tls_gnutls_deinit(void) {
     }
 }
 
+const char *tls_gnutls_get_version(void) {
+    static char version[64];
+    const char *gnutls_ver = gnutls_check_version(nullptr);
+    if (gnutls_ver == nullptr) {
+        return "GnuTLS (unknown version)";
+    }
+    snprintf(version, sizeof(version), "GnuTLS %s", gnutls_ver);
+    return version;
+}
+
+const tls_backend_ops_t tls_gnutls_ops = {
+    .backend = TLS_BACKEND_GNUTLS,
+    .init = tls_gnutls_init,
+    .deinit = tls_gnutls_deinit,
+    .get_version = tls_gnutls_get_version,
+    TLS_BACKEND_OPS_INITIALIZER
+};
+
 /* ============================================================================
  * Error Handling
  * ============================================================================ */
@@ -167,6 +203,10 @@ void tls_gnutls_deinit(void) {
             return "Push error";
         case TLS_E_PULL_ERROR:
             return "Pull error";
+        case TLS_E_WANT_READ:
+            return "Waiting for data to read";
+        case TLS_E_WANT_WRITE:
+            return "Waiting for room to write";
         case TLS_E_BACKEND_ERROR:
             return "Backend-specific error";
         default:
@@ -181,6 +221,8 @@ void tls_gnutls_deinit(void) {
         case TLS_E_INTERRUPTED:
         case TLS_E_WARNING_ALERT_RECEIVED:
         case TLS_E_REHANDSHAKE:
+        case TLS_E_WANT_READ:
+        case TLS_E_WANT_WRITE:
             return false;
         default:
             return true;
@@ -210,12 +252,17 @@ void tls_gnutls_deinit(void) {
     ctx->is_server = is_server;
     ctx->is_dtls = is_dtls;
     ctx->verify_peer = true; // Default to verification enabled
+    atomic_init(&ctx->refcount, 1);
+    pthread_mutex_init(&ctx->pool_lock, nullptr);
+    pthread_mutex_init(&ctx->ticket_lock, nullptr);
 
     // Allocate certificate credentials
     int ret = gnutls_certificate_allocate_credentials(&ctx->x509_cred);
     if (ret != GNUTLS_E_SUCCESS) {
         fprintf(stderr, "gnutls_certificate_allocate_credentials failed: %s\n",
                 gnutls_strerror(ret));
+        pthread_mutex_destroy(&ctx->pool_lock);
+        pthread_mutex_destroy(&ctx->ticket_lock);
         free(ctx);
         return nullptr;
     }
@@ -228,6 +275,23 @@ void tls_context_free(tls_context_t *ctx) {
         return;
     }
 
+    if (atomic_fetch_sub(&ctx->refcount, 1) > 1) {
+        return;     // Still used by sessions or other owners
+    }
+
+    // Pooled sessions hold no reference; they go with the context
+    for (size_t i = 0; i < ctx->pool_count; i++) {
+        gnutls_session_destroy(ctx->pool[i]);
+    }
+    free(ctx->pool);
+    pthread_mutex_destroy(&ctx->pool_lock);
+    pthread_mutex_destroy(&ctx->ticket_lock);
+    gnutls_memset(ctx->ticket_key, 0, sizeof(ctx->ticket_key));
+
+    if (ctx->anti_replay != nullptr) {
+        gnutls_anti_replay_deinit(ctx->anti_replay);
+    }
+
     if (ctx->x509_cred != nullptr) {
         gnutls_certificate_free_credentials(ctx->x509_cred);
     }
@@ -240,13 +304,98 @@ void tls_context_free(tls_context_t *ctx) {
         gnutls_dh_params_deinit(ctx->dh_params);
     }
 
-    // Free stored certificate and key paths
+    // Free stored certificate and key sources
     free(ctx->cert_file_path);
     free(ctx->key_file_path);
+    free(ctx->cert_pem.data);
+    if (ctx->key_pem.data != nullptr) {
+        gnutls_memset(ctx->key_pem.data, 0, ctx->key_pem.size);
+        free(ctx->key_pem.data);
+    }
+    tls_credentials_free(ctx->credentials);
 
     free(ctx);
 }
 
+tls_context_t* tls_context_ref(tls_context_t *ctx) {
+    if (ctx != nullptr) {
+        atomic_fetch_add(&ctx->refcount, 1);
+    }
+    return ctx;
+}
+
+// Drop shared credentials in favour of the context's own pair
+static void credentials_detach(tls_context_t *ctx) {
+    if (ctx->credentials != nullptr) {
+        gnutls_certificate_set_retrieve_function2(ctx->x509_cred, nullptr);
+        tls_credentials_free(ctx->credentials);
+        ctx->credentials = nullptr;
+    }
+}
+
+/**
+ * Load the certificate and key once both are set
+ *
+ * Each comes from a path or from memory; files are read here, so GnuTLS
+ * parses the pair from memory either way.
+ */
+static int load_key_pair(tls_context_t *ctx) {
+    if ((ctx->cert_file_path == nullptr && ctx->cert_pem.data == nullptr) ||
+        (ctx->key_file_path == nullptr && ctx->key_pem.data == nullptr)) {
+        return TLS_E_SUCCESS;
+    }
+
+    gnutls_datum_t cert_file = {0};
+    gnutls_datum_t key_file = {0};
+    int ret = GNUTLS_E_SUCCESS;
+    if (ctx->cert_pem.data == nullptr) {
+        ret = gnutls_load_file(ctx->cert_file_path, &cert_file);
+    }
+    if (ret == GNUTLS_E_SUCCESS && ctx->key_pem.data == nullptr) {
+        ret = gnutls_load_file(ctx->key_file_path, &key_file);
+    }
+    if (ret == GNUTLS_E_SUCCESS) {
+        const gnutls_datum_t *cert = ctx->cert_pem.data != nullptr ? &ctx->cert_pem : &cert_file;
+        const gnutls_datum_t *key = ctx->key_pem.data != nullptr ? &ctx->key_pem : &key_file;
+        ret = gnutls_certificate_set_x509_key_mem2(ctx->x509_cred, cert, key,
+                                                   GNUTLS_X509_FMT_PEM, nullptr, 0);
+    }
+
+    gnutls_free(cert_file.data);
+    if (key_file.data != nullptr) {
+        gnutls_memset(key_file.data, 0, key_file.size);
+        gnutls_free(key_file.data);
+    }
+
+    if (ret < 0) {
+        fprintf(stderr, "Failed to load certificate and key (%s, %s): %s\n",
+                ctx->cert_file_path != nullptr ? ctx->cert_file_path : "memory",
+                ctx->key_file_path != nullptr ? ctx->key_file_path : "memory",
+                gnutls_strerror(ret));
+        return tls_gnutls_map_error(ret);
+    }
+
+    credentials_detach(ctx);
+    return TLS_E_SUCCESS;
+}
+
+// Copy PEM data for load_key_pair(), wiping what it replaces
+static int store_pem(gnutls_datum_t *pem, const void *data, size_t size) {
+    unsigned char *copy = malloc(size);
+    if (copy == nullptr) {
+        return TLS_E_MEMORY_ERROR;
+    }
+    memcpy(copy, data, size);
+
+    if (pem->data != nullptr) {
+        gnutls_memset(pem->data, 0, pem->size);
+        free(pem->data);
+    }
+    pem->data = copy;
+    pem->size = (unsigned int)size;
+    return TLS_E_SUCCESS;
+}
+
 [[nodiscard]] int tls_context_set_cert_file(tls_context_t *ctx,
                                              const char *cert_file) {
     if (ctx == nullptr || cert_file == nullptr) {
@@ -259,21 +408,11 @@ void tls_context_free(tls_context_t *ctx) {
     if (ctx->cert_file_path == nullptr) {
         return TLS_E_MEMORY_ERROR;
     }
+    free(ctx->cert_pem.data);
+    ctx->cert_pem = (gnutls_datum_t){0};
 
-    // If key file is already set, load both now
-    if (ctx->key_file_path != nullptr) {
-        int ret = gnutls_certificate_set_x509_key_file(ctx->x509_cred,
-                                                         ctx->cert_file_path,
-                                                         ctx->key_file_path,
-                                                         GNUTLS_X509_FMT_PEM);
-        if (ret != GNUTLS_E_SUCCESS) {
-            fprintf(stderr, "Failed to load certificate from %s: %s\n",
-                    ctx->cert_file_path, gnutls_strerror(ret));
-            return tls_gnutls_map_error(ret);
-        }
-    }
-
-    return TLS_E_SUCCESS;
+    // If the key is already set, load both now
+    return load_key_pair(ctx);
 }
 
 [[nodiscard]] int tls_context_set_key_file(tls_context_t *ctx,
@@ -288,21 +427,44 @@ void tls_context_free(tls_context_t *ctx) {
     if (ctx->key_file_path == nullptr) {
         return TLS_E_MEMORY_ERROR;
     }
+    if (ctx->key_pem.data != nullptr) {
+        gnutls_memset(ctx->key_pem.data, 0, ctx->key_pem.size);
+        free(ctx->key_pem.data);
+        ctx->key_pem = (gnutls_datum_t){0};
+    }
 
-    // If cert file is already set, load both now
-    if (ctx->cert_file_path != nullptr) {
-        int ret = gnutls_certificate_set_x509_key_file(ctx->x509_cred,
-                                                         ctx->cert_file_path,
-                                                         ctx->key_file_path,
-                                                         GNUTLS_X509_FMT_PEM);
-        if (ret != GNUTLS_E_SUCCESS) {
-            fprintf(stderr, "Failed to load key from %s: %s\n",
-                    ctx->key_file_path, gnutls_strerror(ret));
-            return tls_gnutls_map_error(ret);
-        }
+    // If the certificate is already set, load both now
+    return load_key_pair(ctx);
+}
+
+[[nodiscard]] int tls_context_set_cert_mem(tls_context_t *ctx, const void *cert, size_t size) {
+    if (ctx == nullptr || cert == nullptr || size == 0 || size > UINT_MAX) {
+        return TLS_E_INVALID_PARAMETER;
     }
 
-    return TLS_E_SUCCESS;
+    int ret = store_pem(&ctx->cert_pem, cert, size);
+    if (ret != TLS_E_SUCCESS) {
+        return ret;
+    }
+    free(ctx->cert_file_path);
+    ctx->cert_file_path = nullptr;
+
+    return load_key_pair(ctx);
+}
+
+[[nodiscard]] int tls_context_set_key_mem(tls_context_t *ctx, const void *key, size_t size) {
+    if (ctx == nullptr || key == nullptr || size == 0 || size > UINT_MAX) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    int ret = store_pem(&ctx->key_pem, key, size);
+    if (ret != TLS_E_SUCCESS) {
+        return ret;
+    }
+    free(ctx->key_file_path);
+    ctx->key_file_path = nullptr;
+
+    return load_key_pair(ctx);
 }
 
 [[nodiscard]] int tls_context_set_ca_file(tls_context_t *ctx,
@@ -464,6 +626,41 @@ static int gnutls_db_store_cb(void *ptr, gnutls_datum_t key, gnutls_datum_t data
     return (result == 0) ? GNUTLS_E_SUCCESS : GNUTLS_E_DB_ERROR;
 }
 
+/**
+ * Lease path of gnutls_db_retrieve_cb()
+ *
+ * Borrows the stored bytes instead of copying a whole cache entry onto the
+ * stack. The only copy left is the buffer GnuTLS takes ownership of.
+ */
+static gnutls_datum_t gnutls_db_borrow(tls_context_t *ctx, gnutls_datum_t key) {
+    gnutls_datum_t result = {.data = nullptr, .size = 0};
+    tls_session_lease_t lease = {0};
+
+    if (ctx->db_borrow(ctx->db_userdata, key.data, key.size, &lease) != 0) {
+        return result; // Not found or error
+    }
+
+    // Check expiration
+    time_t now = time(nullptr);
+    bool expired = lease.expiration > 0 && now > lease.expiration;
+
+    if (!expired) {
+        result.data = (unsigned char *)gnutls_malloc(lease.session_data_size);
+        if (result.data != nullptr) {
+            memcpy(result.data, lease.session_data, lease.session_data_size);
+            result.size = (unsigned int)lease.session_data_size;
+        }
+    }
+
+    ctx->db_release(ctx->db_userdata, &lease);
+
+    if (expired && ctx->db_remove != nullptr) {
+        ctx->db_remove(ctx->db_userdata, key.data, key.size);
+    }
+
+    return result;
+}
+
 /**
  * GnuTLS session retrieve callback adapter
  *
@@ -484,6 +681,9 @@ static gnutls_datum_t gnutls_db_retrieve_cb(void *ptr, gnutls_datum_t key) {
     }
 
     tls_context_t *ctx = (tls_context_t *)ptr;
+    if (ctx->db_borrow != nullptr && ctx->db_release != nullptr) {
+        return gnutls_db_borrow(ctx, key);
+    }
     if (ctx->db_retrieve == nullptr) {
         return result; // No callback registered
     }
@@ -566,6 +766,20 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
     return TLS_E_SUCCESS;
 }
 
+[[nodiscard]] int tls_context_set_session_cache_lease(tls_context_t *ctx,
+                                                        tls_db_borrow_func_t borrow_func,
+                                                        tls_db_release_func_t release_func) {
+    if (ctx == nullptr || (borrow_func == nullptr) != (release_func == nullptr)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    // Applied per-session in tls_session_new(), like the other callbacks
+    ctx->db_borrow = borrow_func;
+    ctx->db_release = release_func;
+
+    return TLS_E_SUCCESS;
+}
+
 [[nodiscard]] int tls_context_set_session_timeout(tls_context_t *ctx,
                                                     unsigned int timeout_secs) {
     if (ctx == nullptr) {
@@ -577,21 +791,294 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
     return TLS_E_SUCCESS;
 }
 
+[[nodiscard]] int tls_context_set_ticket_keys(tls_context_t *ctx,
+                                                const tls_datum_t *keys,
+                                                size_t key_count,
+                                                unsigned int lifetime_secs) {
+    if (ctx == nullptr || (keys == nullptr) != (key_count == 0) ||
+        key_count > TLS_MAX_TICKET_KEYS || (keys != nullptr && lifetime_secs == 0) ||
+        lifetime_secs > INT_MAX) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    for (size_t i = 0; i < key_count; i++) {
+        if (keys[i].data == nullptr || keys[i].size < TLS_TICKET_KEY_MIN_SIZE) {
+            return TLS_E_INVALID_PARAMETER;
+        }
+    }
+    // GnuTLS takes one master key per session and decrypts only under the
+    // keys it derives from it: older secrets in keys[1..] cannot be honoured,
+    // and a ring that lists them would promise resumptions that fail
+    if (!ctx->is_server || key_count > 1) {
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    static const char info[] = "wolfguard ticket key";
+    uint8_t key[TLS_GNUTLS_TICKET_KEY_SIZE] = {0};
+    if (keys != nullptr) {
+        int ret = tls_hkdf(TLS_DIGEST_SHA256, nullptr, 0, keys[0].data, keys[0].size,
+                           info, sizeof(info) - 1, key, sizeof(key));
+        if (ret != TLS_E_SUCCESS) {
+            return ret;
+        }
+    }
+
+    pthread_mutex_lock(&ctx->ticket_lock);
+    memcpy(ctx->ticket_key, key, sizeof(key));
+    ctx->tickets = keys != nullptr;
+    ctx->ticket_lifetime_secs = lifetime_secs;
+    pthread_mutex_unlock(&ctx->ticket_lock);
+    atomic_fetch_add(&ctx->config_generation, 1);
+
+    gnutls_memset(key, 0, sizeof(key));
+    return TLS_E_SUCCESS;
+}
+
+// Anti-replay database hook: GnuTLS hands over the ClientHello's binder
+static int gnutls_replay_add_cb(void *ptr, time_t exp_time, const gnutls_datum_t *key,
+                                const gnutls_datum_t *data) {
+    (void)exp_time;
+    (void)data;
+    tls_context_t *ctx = ptr;
+    return ctx->replay_check(ctx->replay_userdata, key->data, key->size) == 0
+               ? 0
+               : GNUTLS_E_DB_ENTRY_EXISTS;
+}
+
+[[nodiscard]] int tls_context_set_early_data(tls_context_t *ctx,
+                                               size_t max_size,
+                                               tls_replay_check_func_t check,
+                                               void *userdata) {
+    if (ctx == nullptr || max_size > UINT32_MAX ||
+        (ctx->is_server && max_size > 0 && check == nullptr) ||
+        (!ctx->is_server && check != nullptr)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    if (ctx->is_dtls) {
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    if (ctx->is_server && max_size > 0 && ctx->anti_replay == nullptr) {
+        int ret = gnutls_anti_replay_init(&ctx->anti_replay);
+        if (ret != GNUTLS_E_SUCCESS) {
+            return tls_gnutls_map_error(ret);
+        }
+        gnutls_anti_replay_set_window(ctx->anti_replay, TLS_EARLY_DATA_WINDOW_MS);
+        gnutls_anti_replay_set_add_function(ctx->anti_replay, gnutls_replay_add_cb);
+        gnutls_anti_replay_set_ptr(ctx->anti_replay, ctx);
+    }
+
+    ctx->early_data_max = max_size;
+    ctx->replay_check = check;
+    ctx->replay_userdata = userdata;
+    atomic_fetch_add(&ctx->config_generation, 1);
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_context_set_ktls(tls_context_t *ctx, bool enable) {
+    if (ctx == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    // Kernel TLS is TCP only
+    if (ctx->is_dtls && enable) {
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    ctx->ktls = enable;
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_context_set_nonblocking(tls_context_t *ctx, bool enable) {
+    if (ctx == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    ctx->nonblocking = enable;
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_context_set_session_pool(tls_context_t *ctx, size_t max_sessions) {
+    if (ctx == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    tls_session_t **pool = nullptr;
+    if (max_sessions > 0) {
+        pool = calloc(max_sessions, sizeof(*pool));
+        if (pool == nullptr) {
+            return TLS_E_MEMORY_ERROR;
+        }
+    }
+
+    pthread_mutex_lock(&ctx->pool_lock);
+    tls_session_t **old_pool = ctx->pool;
+    size_t old_count = ctx->pool_count;
+    size_t kept = old_count < max_sessions ? old_count : max_sessions;
+    if (kept > 0) {
+        memcpy(pool, old_pool, kept * sizeof(*pool));
+    }
+    ctx->pool = pool;
+    ctx->pool_count = kept;
+    ctx->pool_capacity = max_sessions;
+    pthread_mutex_unlock(&ctx->pool_lock);
+
+    for (size_t i = kept; i < old_count; i++) {
+        gnutls_session_destroy(old_pool[i]);
+    }
+    free(old_pool);
+    return TLS_E_SUCCESS;
+}
+
 /* ============================================================================
- * Session Management
+ * Shared Credentials
  * ============================================================================ */
 
-[[nodiscard]] tls_session_t* tls_session_new(tls_context_t *ctx) {
-    if (ctx == nullptr) {
+/*
+ * GnuTLS loads a certificate and key into one credentials structure, which
+ * also holds the context's trust list and DH parameters. Shared credentials
+ * are therefore not loaded into it: contexts hand the parsed chain and key
+ * to the handshake from this callback, without copying either.
+ */
+static int credentials_retrieve(gnutls_session_t session, const gnutls_datum_t *req_ca_rdn,
+                                int nreqs, const gnutls_pk_algorithm_t *pk_algos,
+                                int pk_algos_length, gnutls_pcert_st **pcert,
+                                unsigned int *pcert_length, gnutls_privkey_t *privkey) {
+    (void)req_ca_rdn;
+    (void)nreqs;
+    (void)pk_algos;
+    (void)pk_algos_length;
+
+    const tls_context_t *ctx = gnutls_session_get_ptr(session);
+    if (ctx == nullptr || ctx->credentials == nullptr) {
+        *pcert_length = 0;
+        return 0;
+    }
+
+    *pcert = ctx->credentials->pcerts;
+    *pcert_length = ctx->credentials->pcert_count;
+    *privkey = ctx->credentials->key;
+    return 0;
+}
+
+// GNUTLS_E_CERTIFICATE_KEY_MISMATCH unless the key belongs to the leaf
+static int credentials_check_key(const tls_credentials_t *creds) {
+    gnutls_pubkey_t pubkey;
+    int ret = gnutls_pubkey_init(&pubkey);
+    if (ret < 0) {
+        return ret;
+    }
+
+    uint8_t key_id[64];
+    uint8_t cert_id[64];
+    size_t key_id_size = sizeof(key_id);
+    size_t cert_id_size = sizeof(cert_id);
+    ret = gnutls_pubkey_import_privkey(pubkey, creds->key, 0, 0);
+    if (ret == GNUTLS_E_SUCCESS) {
+        ret = gnutls_pubkey_get_key_id(pubkey, 0, key_id, &key_id_size);
+    }
+    if (ret == GNUTLS_E_SUCCESS) {
+        ret = gnutls_pubkey_get_key_id(creds->pcerts[0].pubkey, 0, cert_id, &cert_id_size);
+    }
+    gnutls_pubkey_deinit(pubkey);
+
+    if (ret == GNUTLS_E_SUCCESS &&
+        (key_id_size != cert_id_size || memcmp(key_id, cert_id, key_id_size) != 0)) {
+        ret = GNUTLS_E_CERTIFICATE_KEY_MISMATCH;
+    }
+    return ret;
+}
+
+static void credentials_destroy(tls_credentials_t *creds) {
+    for (unsigned int i = 0; i < creds->pcert_count; i++) {
+        gnutls_pcert_deinit(&creds->pcerts[i]);
+    }
+    if (creds->key != nullptr) {
+        gnutls_privkey_deinit(creds->key);
+    }
+    free(creds);
+}
+
+[[nodiscard]] tls_credentials_t* tls_credentials_new(const void *cert, size_t cert_size,
+                                                     const void *key, size_t key_size) {
+    if (!g_initialized || cert == nullptr || key == nullptr || cert_size == 0 ||
+        key_size == 0 || cert_size > UINT_MAX || key_size > UINT_MAX) {
         return nullptr;
     }
 
-    tls_session_t *session = (tls_session_t*)calloc(1, sizeof(tls_session_t));
-    if (session == nullptr) {
+    tls_credentials_t *creds = calloc(1, sizeof(tls_credentials_t));
+    if (creds == nullptr) {
         return nullptr;
     }
+    atomic_init(&creds->refcount, 1);
 
-    session->ctx = ctx;
+    gnutls_datum_t cert_datum = {.data = (unsigned char *)cert, .size = (unsigned int)cert_size};
+    gnutls_datum_t key_datum = {.data = (unsigned char *)key, .size = (unsigned int)key_size};
+
+    creds->pcert_count = TLS_GNUTLS_MAX_CHAIN;
+    int ret = gnutls_pcert_list_import_x509_raw(creds->pcerts, &creds->pcert_count,
+                                                &cert_datum, GNUTLS_X509_FMT_PEM, 0);
+    if (ret < 0) {
+        creds->pcert_count = 0;
+    }
+    if (ret >= 0) {
+        ret = gnutls_privkey_init(&creds->key);
+    }
+    if (ret >= 0) {
+        ret = gnutls_privkey_import_x509_raw(creds->key, &key_datum, GNUTLS_X509_FMT_PEM,
+                                             nullptr, 0);
+    }
+    if (ret >= 0) {
+        ret = credentials_check_key(creds);
+    }
+
+    if (ret < 0) {
+        fprintf(stderr, "tls_credentials_new: %s\n", gnutls_strerror(ret));
+        credentials_destroy(creds);
+        return nullptr;
+    }
+    return creds;
+}
+
+tls_credentials_t* tls_credentials_ref(tls_credentials_t *creds) {
+    if (creds != nullptr) {
+        atomic_fetch_add(&creds->refcount, 1);
+    }
+    return creds;
+}
+
+void tls_credentials_free(tls_credentials_t *creds) {
+    if (creds == nullptr || atomic_fetch_sub(&creds->refcount, 1) > 1) {
+        return;
+    }
+    credentials_destroy(creds);
+}
+
+[[nodiscard]] int tls_context_set_credentials(tls_context_t *ctx, tls_credentials_t *creds) {
+    if (ctx == nullptr || creds == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    tls_credentials_ref(creds);
+    tls_credentials_free(ctx->credentials);
+    ctx->credentials = creds;
+    gnutls_certificate_set_retrieve_function2(ctx->x509_cred, credentials_retrieve);
+    return TLS_E_SUCCESS;
+}
+
+/* ============================================================================
+ * Session Management
+ * ============================================================================ */
+
+/**
+ * Create and configure the GnuTLS session of @p session from its context
+ *
+ * @return TLS_E_SUCCESS, or an error with session->session left nullptr
+ */
+static int gnutls_session_setup(tls_session_t *session) {
+    tls_context_t *ctx = session->ctx;
+
+    // Read first: a change racing with the setup leaves the session stale
+    session->config_generation = atomic_load(&ctx->config_generation);
 
     // Initialize GnuTLS session
     unsigned int flags = 0;
@@ -603,24 +1090,33 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
 
     if (ctx->is_dtls) {
         flags |= GNUTLS_DATAGRAM;
+        if (ctx->nonblocking) {
+            // Return from the handshake instead of waiting out retransmission timers
+            flags |= GNUTLS_NONBLOCK;
+        }
+    }
+
+    if (ctx->early_data_max > 0) {
+        flags |= GNUTLS_ENABLE_EARLY_DATA;
     }
 
     int ret = gnutls_init(&session->session, flags);
     if (ret != GNUTLS_E_SUCCESS) {
         fprintf(stderr, "gnutls_init failed: %s\n", gnutls_strerror(ret));
-        free(session);
-        return nullptr;
+        session->session = nullptr;
+        return tls_gnutls_map_error(ret);
     }
 
-    // Set certificate credentials
+    // Set certificate credentials (the context, for credentials_retrieve())
+    gnutls_session_set_ptr(session->session, ctx);
     ret = gnutls_credentials_set(session->session,
                                   GNUTLS_CRD_CERTIFICATE,
                                   ctx->x509_cred);
     if (ret != GNUTLS_E_SUCCESS) {
         fprintf(stderr, "gnutls_credentials_set failed: %s\n", gnutls_strerror(ret));
         gnutls_deinit(session->session);
-        free(session);
-        return nullptr;
+        session->session = nullptr;
+        return tls_gnutls_map_error(ret);
     }
 
     // Set priority
@@ -629,8 +1125,8 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
         if (ret != GNUTLS_E_SUCCESS) {
             fprintf(stderr, "gnutls_priority_set failed: %s\n", gnutls_strerror(ret));
             gnutls_deinit(session->session);
-            free(session);
-            return nullptr;
+            session->session = nullptr;
+            return tls_gnutls_map_error(ret);
         }
     } else {
         // Use default priority
@@ -640,8 +1136,8 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
             fprintf(stderr, "gnutls_priority_set_direct failed: %s\n",
                     gnutls_strerror(ret));
             gnutls_deinit(session->session);
-            free(session);
-            return nullptr;
+            session->session = nullptr;
+            return tls_gnutls_map_error(ret);
         }
     }
 
@@ -652,7 +1148,8 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
 
     // Set session cache callbacks (if configured)
     // GnuTLS requires these to be set per-session, not per-context
-    if (ctx->db_store != nullptr || ctx->db_retrieve != nullptr || ctx->db_remove != nullptr) {
+    if (ctx->db_store != nullptr || ctx->db_retrieve != nullptr || ctx->db_remove != nullptr ||
+        ctx->db_borrow != nullptr) {
         // Set user data pointer (our context, so callbacks can access it)
         gnutls_db_set_ptr(session->session, ctx);
 
@@ -660,7 +1157,7 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
         if (ctx->db_store != nullptr) {
             gnutls_db_set_store_function(session->session, gnutls_db_store_cb);
         }
-        if (ctx->db_retrieve != nullptr) {
+        if (ctx->db_retrieve != nullptr || ctx->db_borrow != nullptr) {
             gnutls_db_set_retrieve_function(session->session, gnutls_db_retrieve_cb);
         }
         if (ctx->db_remove != nullptr) {
@@ -668,30 +1165,188 @@ static int gnutls_db_remove_cb(void *ptr, gnutls_datum_t key) {
         }
     }
 
-    ctx->sessions_created++;
-    return session;
-}
+    if (ctx->is_server && ctx->early_data_max > 0) {
+        ret = gnutls_record_set_max_early_data_size(session->session, ctx->early_data_max);
+        if (ret != GNUTLS_E_SUCCESS) {
+            gnutls_deinit(session->session);
+            session->session = nullptr;
+            return tls_gnutls_map_error(ret);
+        }
+        gnutls_anti_replay_enable(session->session, ctx->anti_replay);
+    }
+
+    // Session tickets; the copy keeps tls_context_set_ticket_keys() safe to
+    // call while sessions are being set up
+    if (ctx->is_server) {
+        uint8_t key[TLS_GNUTLS_TICKET_KEY_SIZE];
+        pthread_mutex_lock(&ctx->ticket_lock);
+        bool tickets = ctx->tickets;
+        unsigned int lifetime_secs = ctx->ticket_lifetime_secs;
+        memcpy(key, ctx->ticket_key, sizeof(key));
+        pthread_mutex_unlock(&ctx->ticket_lock);
+
+        if (tickets) {
+            gnutls_datum_t datum = {.data = key, .size = sizeof(key)};
+            ret = gnutls_session_ticket_enable_server(session->session, &datum);
+            // Both the ticket lifetime and the key rotation schedule follow it
+            gnutls_db_set_cache_expiration(session->session, (int)lifetime_secs);
+        }
+        gnutls_memset(key, 0, sizeof(key));
 
-void tls_session_free(tls_session_t *session) {
-    if (session == nullptr) {
-        return;
+        if (ret != GNUTLS_E_SUCCESS) {
+            fprintf(stderr, "gnutls_session_ticket_enable_server failed: %s\n",
+                    gnutls_strerror(ret));
+            gnutls_deinit(session->session);
+            session->session = nullptr;
+            return tls_gnutls_map_error(ret);
+        }
     }
 
-    if (session->session != nullptr) {
-        // Send close_notify
+    return TLS_E_SUCCESS;
+}
+
+/**
+ * Release everything a session owns (the context is not touched)
+ */
+static void gnutls_session_destroy(tls_session_t *session) {
+    {
+        ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+        if (session->session != nullptr) {
+            gnutls_deinit(session->session);
+        }
+
+        membio_free(&session->bio_in);
+        membio_free(&session->bio_out);
+    }
+    allocator_free(session);
+}
+
+/**
+ * Reset @p session and keep it in its context's pool
+ *
+ * @return true if pooled, false if the caller has to destroy it
+ */
+static bool gnutls_session_pool_put(tls_session_t *session) {
+    tls_context_t *ctx = session->ctx;
+
+    pthread_mutex_lock(&ctx->pool_lock);
+    bool room = ctx->pool_count < ctx->pool_capacity;
+    pthread_mutex_unlock(&ctx->pool_lock);
+    if (!room || tls_session_reset(session) != TLS_E_SUCCESS) {
+        return false;
+    }
+
+    pthread_mutex_lock(&ctx->pool_lock);
+    bool pooled = ctx->pool_count < ctx->pool_capacity;
+    if (pooled) {
+        ctx->pool[ctx->pool_count++] = session;
+    }
+    pthread_mutex_unlock(&ctx->pool_lock);
+    return pooled;
+}
+
+[[nodiscard]] tls_session_t* tls_session_new(tls_context_t *ctx) {
+    if (ctx == nullptr) {
+        return nullptr;
+    }
+
+    tls_session_t *session = nullptr;
+    pthread_mutex_lock(&ctx->pool_lock);
+    if (ctx->pool_count > 0) {
+        session = ctx->pool[--ctx->pool_count];
+    }
+    pthread_mutex_unlock(&ctx->pool_lock);
+
+    // Pooled sessions were set up when they were freed: set one up again if
+    // the ticket keys or early data settings changed since
+    if (session != nullptr &&
+        session->config_generation != atomic_load(&ctx->config_generation) &&
+        tls_session_reset(session) != TLS_E_SUCCESS) {
+        gnutls_session_destroy(session);
+        session = nullptr;
+    }
+
+    if (session == nullptr) {
+        session = (tls_session_t*)allocator_calloc(1, sizeof(tls_session_t));
+        if (session == nullptr) {
+            return nullptr;
+        }
+        ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+        session->ctx = ctx;
+        session->fd = -1;
+        if (gnutls_session_setup(session) != TLS_E_SUCCESS) {
+            allocator_free(session);
+            return nullptr;
+        }
+    }
+
+    atomic_fetch_add(&ctx->refcount, 1);
+    ctx->sessions_created++;
+    return session;
+}
+
+void tls_session_free(tls_session_t *session) {
+    if (session == nullptr) {
+        return;
+    }
+
+    if (session->session != nullptr && (session->ktls & TLS_KTLS_TX) == 0) {
+        ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+        // Send close_notify (GnuTLS no longer owns the write side once the
+        // kernel does; callers close offloaded sessions with tls_bye())
         gnutls_bye(session->session, GNUTLS_SHUT_RDWR);
+    }
+
+    tls_context_t *ctx = session->ctx;
+    if (!gnutls_session_pool_put(session)) {
+        gnutls_session_destroy(session);
+    }
+
+    // Release the session's context reference (the last one frees it)
+    tls_context_free(ctx);
+}
+
+[[nodiscard]] int tls_session_reset(tls_session_t *session) {
+    if (session == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    // gnutls_deinit() wipes the keys; GnuTLS has no way to rewind a session
+    if (session->session != nullptr) {
+        ALLOCATOR_ATTRIBUTE(&session->mem_stats);
         gnutls_deinit(session->session);
     }
 
-    free(session);
+    // Start over, keeping only the context and the memory-BIO allocations
+    membio_t bio_in = session->bio_in;
+    membio_t bio_out = session->bio_out;
+    membio_clear(&bio_in);
+    membio_clear(&bio_out);
+    *session = (tls_session_t){
+        .ctx = session->ctx,
+        .fd = -1,
+        .bio_in = bio_in,
+        .bio_out = bio_out,
+    };
+
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+    return gnutls_session_setup(session);
 }
 
 [[nodiscard]] int tls_session_set_fd(tls_session_t *session, int fd) {
     if (session == nullptr || fd < 0) {
         return TLS_E_INVALID_PARAMETER;
     }
+    if (session->membio) {
+        // The memory-BIO transport functions would stay installed
+        return TLS_E_INVALID_REQUEST;
+    }
 
     gnutls_transport_set_int(session->session, fd);
+    session->fd = fd;
     return TLS_E_SUCCESS;
 }
 
@@ -762,6 +1417,8 @@ int tls_gnutls_pull_timeout_wrapper(gnutls_transport_ptr_t ptr, unsigned int ms)
     session->pull_func = pull_func;
     session->pull_timeout_func = pull_timeout_func;
     session->io_userdata = userdata;
+    session->fd = -1;       // No socket to offload to
+    session->membio = false;
 
     // Set GnuTLS callbacks
     gnutls_transport_set_ptr(session->session, session);
@@ -799,6 +1456,175 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     return TLS_E_SUCCESS;
 }
 
+[[nodiscard]] int tls_session_get_data(tls_session_t *session, void *data, size_t *size) {
+    if (session == nullptr || size == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    gnutls_datum_t packed = {0};
+    int ret = gnutls_session_get_data2(session->session, &packed);
+    if (ret != GNUTLS_E_SUCCESS) {
+        return tls_gnutls_map_error(ret);
+    }
+
+    int result = TLS_E_SUCCESS;
+    if (data != nullptr) {
+        if (*size < packed.size) {
+            result = TLS_E_INVALID_PARAMETER;
+        } else {
+            memcpy(data, packed.data, packed.size);
+        }
+    }
+    *size = packed.size;
+
+    // The packed session holds the master secret
+    gnutls_memset(packed.data, 0, packed.size);
+    gnutls_free(packed.data);
+    return result;
+}
+
+[[nodiscard]] int tls_session_set_data(tls_session_t *session, const void *data, size_t size) {
+    if (session == nullptr || data == nullptr || size == 0) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    int ret = gnutls_session_set_data(session->session, data, size);
+    return ret == GNUTLS_E_SUCCESS ? TLS_E_SUCCESS : tls_gnutls_map_error(ret);
+}
+
+[[nodiscard]] ssize_t tls_session_write_early_data(tls_session_t *session,
+                                                     const void *data,
+                                                     size_t len) {
+    if (session == nullptr || data == nullptr || len == 0) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    if (session->ctx->is_server || session->ctx->early_data_max == 0) {
+        return TLS_E_INVALID_REQUEST;
+    }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+    // Queued whole (GnuTLS returns 0), sent behind the ClientHello by tls_handshake()
+    ssize_t ret = gnutls_record_send_early_data(session->session, data, len);
+    return ret >= 0 ? (ssize_t)len : tls_gnutls_map_error((int)ret);
+}
+
+[[nodiscard]] ssize_t tls_session_read_early_data(tls_session_t *session,
+                                                    void *buf,
+                                                    size_t size) {
+    if (session == nullptr || buf == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    if (!session->ctx->is_server) {
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    ssize_t ret = gnutls_record_recv_early_data(session->session, buf, size);
+    if (ret == GNUTLS_E_REQUESTED_DATA_NOT_AVAILABLE) {
+        return 0;
+    }
+    if (ret >= 0) {
+        session->bytes_read += ret;
+        return ret;
+    }
+    return tls_gnutls_map_error((int)ret);
+}
+
+/* ============================================================================
+ * Memory BIO
+ * ============================================================================ */
+
+/* Transport functions of a memory-BIO session (the transport pointer is the session) */
+static ssize_t gnutls_membio_push(gnutls_transport_ptr_t ptr, const void *data, size_t len) {
+    tls_session_t *session = (tls_session_t*)ptr;
+    if (membio_write(&session->bio_out, data, len) != 0) {
+        gnutls_transport_set_errno(session->session, ENOMEM);
+        return -1;
+    }
+    return (ssize_t)len;
+}
+
+static ssize_t gnutls_membio_pull(gnutls_transport_ptr_t ptr, void *data, size_t len) {
+    tls_session_t *session = (tls_session_t*)ptr;
+    size_t n = membio_read(&session->bio_in, data, len);
+    if (n == 0 && !session->membio_eof) {
+        gnutls_transport_set_errno(session->session, EAGAIN);
+        return -1;
+    }
+    return (ssize_t)n;
+}
+
+static int gnutls_membio_pull_timeout(gnutls_transport_ptr_t ptr, unsigned int ms) {
+    (void)ptr;
+    (void)ms;
+    // Never wait: the pull function reports an empty buffer as EAGAIN,
+    // which GnuTLS passes up as GNUTLS_E_AGAIN
+    return 1;
+}
+
+[[nodiscard]] int tls_session_set_memory_bio(tls_session_t *session) {
+    if (session == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    if (session->ctx->is_dtls) {
+        // Datagram boundaries and retransmission timers need more than a byte queue
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    session->membio = true;
+    session->membio_eof = false;
+    session->fd = -1;       // No socket to offload to
+    membio_clear(&session->bio_in);
+    membio_clear(&session->bio_out);
+
+    gnutls_transport_set_ptr(session->session, session);
+    gnutls_transport_set_push_function(session->session, gnutls_membio_push);
+    gnutls_transport_set_pull_function(session->session, gnutls_membio_pull);
+    gnutls_transport_set_pull_timeout_function(session->session, gnutls_membio_pull_timeout);
+
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] ssize_t tls_session_feed(tls_session_t *session, const void *data, size_t len) {
+    if (session == nullptr || (data == nullptr && len > 0) || len > SIZE_MAX / 2) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+    if (!session->membio) {
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    if (len == 0) {
+        session->membio_eof = true;
+        return 0;
+    }
+    if (membio_write(&session->bio_in, data, len) != 0) {
+        return TLS_E_MEMORY_ERROR;
+    }
+    return (ssize_t)len;
+}
+
+[[nodiscard]] ssize_t tls_session_drain(tls_session_t *session, void *out, size_t len) {
+    if (session == nullptr || (out == nullptr && len > 0)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+    if (!session->membio) {
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    if (len > SIZE_MAX / 2) {  // SSIZE_MAX
+        len = SIZE_MAX / 2;
+    }
+    return (ssize_t)membio_read(&session->bio_out, out, len);
+}
+
+[[nodiscard]] size_t tls_session_pending_output(tls_session_t *session) {
+    if (session == nullptr || !session->membio) {
+        return 0;
+    }
+    return membio_pending(&session->bio_out);
+}
+
 /* ============================================================================
  * DTLS-Specific Functions
  * ============================================================================ */
@@ -833,6 +1659,155 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     return TLS_E_SUCCESS;
 }
 
+[[nodiscard]] int tls_dtls_get_timeout(tls_session_t *session, unsigned int *timeout_ms) {
+    if (session == nullptr || timeout_ms == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    if (!session->ctx->is_dtls || !session->ctx->nonblocking || session->handshake_complete) {
+        return TLS_E_INVALID_REQUEST;
+    }
+
+    *timeout_ms = gnutls_dtls_get_timeout(session->session);
+    return TLS_E_SUCCESS;
+}
+
+/* ============================================================================
+ * Kernel TLS Offload
+ * ============================================================================ */
+
+/**
+ * Export the current traffic keys of one direction
+ *
+ * @return 0 on success, -1 if the version or cipher cannot be offloaded
+ */
+static int gnutls_ktls_export(tls_session_t *session, bool read, ktls_keys_t *keys) {
+    gnutls_protocol_t version = gnutls_protocol_get_version(session->session);
+    if (version != GNUTLS_TLS1_2 && version != GNUTLS_TLS1_3) {
+        return -1;
+    }
+
+    size_t key_size;
+    switch (gnutls_cipher_get(session->session)) {
+        case GNUTLS_CIPHER_AES_128_GCM:
+            keys->cipher = KTLS_CIPHER_AES_128_GCM;
+            key_size = 16;
+            break;
+        case GNUTLS_CIPHER_AES_256_GCM:
+            keys->cipher = KTLS_CIPHER_AES_256_GCM;
+            key_size = 32;
+            break;
+        case GNUTLS_CIPHER_CHACHA20_POLY1305:
+            keys->cipher = KTLS_CIPHER_CHACHA20_POLY1305;
+            key_size = 32;
+            break;
+        default:
+            return -1;
+    }
+
+    // TLS 1.2 AES-GCM has a 4-byte implicit IV, everything else 12 bytes
+    keys->tls13 = version == GNUTLS_TLS1_3;
+    size_t iv_size = (!keys->tls13 && keys->cipher != KTLS_CIPHER_CHACHA20_POLY1305) ? 4 : 12;
+
+    gnutls_datum_t iv;
+    gnutls_datum_t key;
+    if (gnutls_record_get_state(session->session, read ? 1 : 0, nullptr, &iv, &key,
+                                keys->seq) != GNUTLS_E_SUCCESS ||
+        key.size != key_size || iv.size < iv_size) {
+        return -1;
+    }
+
+    memcpy(keys->key, key.data, key_size);
+    memcpy(keys->iv, iv.data, iv_size);
+    return 0;
+}
+
+/**
+ * Hand the record layer to the kernel after a completed handshake
+ *
+ * Best effort: any direction that cannot be offloaded stays with GnuTLS.
+ */
+static void gnutls_ktls_enable(tls_session_t *session) {
+    if (!session->ctx->ktls || session->fd < 0 || session->ktls != TLS_KTLS_NONE ||
+        gnutls_transport_is_ktls_enabled(session->session) != 0) {
+        return;     // Not requested, no socket, or GnuTLS offloaded it itself
+    }
+
+    ktls_keys_t keys = {0};
+    if (gnutls_ktls_export(session, false, &keys) != 0 || ktls_attach(session->fd) != 0) {
+        gnutls_memset(&keys, 0, sizeof(keys));
+        return;
+    }
+
+    if (ktls_set_keys(session->fd, true, &keys) == 0) {
+        session->ktls |= TLS_KTLS_TX;
+    }
+
+    // Receiving moves only if GnuTLS holds no decrypted data. A TLS 1.3
+    // client keeps it: NewSessionTicket messages arrive after the handshake
+    // and the kernel cannot process handshake records.
+    bool tls13 = keys.tls13;
+    gnutls_memset(&keys, 0, sizeof(keys));
+
+    if ((!tls13 || session->ctx->is_server) &&
+        gnutls_record_check_pending(session->session) == 0 &&
+        gnutls_ktls_export(session, true, &keys) == 0 &&
+        ktls_set_keys(session->fd, false, &keys) == 0) {
+        session->ktls |= TLS_KTLS_RX;
+    }
+    gnutls_memset(&keys, 0, sizeof(keys));
+}
+
+static ssize_t gnutls_ktls_sendv(tls_session_t *session, const struct iovec *iov, int iovcnt) {
+    ssize_t ret = ktls_sendv(session->fd, KTLS_RECORD_APPLICATION_DATA, iov, iovcnt, 0);
+    if (ret < 0) {
+        return ktls_map_errno(errno, true);
+    }
+
+    session->bytes_written += (size_t)ret;
+    return ret;
+}
+
+static ssize_t gnutls_ktls_recvv(tls_session_t *session, const struct iovec *iov, int iovcnt) {
+    ssize_t ret = ktls_recvv(session->fd, iov, iovcnt, 0);
+    if (ret < 0) {
+        return ktls_map_errno(errno, false);
+    }
+
+    session->bytes_read += (size_t)ret;
+    return ret;
+}
+
+/**
+ * Send an alert as a kernel TLS control record
+ */
+static int gnutls_ktls_alert(tls_session_t *session, uint8_t level, uint8_t description) {
+    uint8_t alert[2] = {level, description};
+    struct iovec iov = {.iov_base = alert, .iov_len = sizeof(alert)};
+
+    if (ktls_sendv(session->fd, KTLS_RECORD_ALERT, &iov, 1, 0) < 0) {
+        return ktls_map_errno(errno, true);
+    }
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] unsigned int tls_session_get_ktls(tls_session_t *session) {
+    if (session == nullptr) {
+        return TLS_KTLS_NONE;
+    }
+
+    return session->ktls;
+}
+
+[[nodiscard]] int tls_session_get_memory_stats(tls_session_t *session,
+                                                 tls_memory_stats_t *stats) {
+    if (session == nullptr || stats == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    *stats = session->mem_stats;
+    return TLS_E_SUCCESS;
+}
+
 /* ============================================================================
  * Handshake Operations
  * ============================================================================ */
@@ -841,14 +1816,25 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     if (session == nullptr) {
         return TLS_E_INVALID_PARAMETER;
     }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
 
     int ret = gnutls_handshake(session->session);
     if (ret == GNUTLS_E_SUCCESS) {
         session->handshake_complete = true;
         session->ctx->handshakes_completed++;
+        gnutls_ktls_enable(session);
         return TLS_E_SUCCESS;
     }
 
+    if (ret == GNUTLS_E_AGAIN && session->ctx->nonblocking) {
+        // Direction of the call that would have blocked. A DTLS flight is
+        // written whole before GnuTLS returns to wait for the reply (and
+        // reports the write as the last direction), so DTLS always reads.
+        if (session->ctx->is_dtls || gnutls_record_get_direction(session->session) == 0) {
+            return TLS_E_WANT_READ;
+        }
+        return TLS_E_WANT_WRITE;
+    }
     if (ret == GNUTLS_E_AGAIN || ret == GNUTLS_E_INTERRUPTED) {
         return tls_gnutls_map_error(ret);
     }
@@ -863,6 +1849,12 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     if (session == nullptr) {
         return TLS_E_INVALID_PARAMETER;
     }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+    // The kernel has the record state; GnuTLS cannot renegotiate over it
+    if (session->ktls != TLS_KTLS_NONE) {
+        return TLS_E_INVALID_REQUEST;
+    }
 
     int ret = gnutls_rehandshake(session->session);
     return tls_gnutls_map_error(ret);
@@ -878,6 +1870,12 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     if (session == nullptr || data == nullptr) {
         return TLS_E_INVALID_PARAMETER;
     }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+    if (session->ktls & TLS_KTLS_TX) {
+        struct iovec iov = {.iov_base = (void *)data, .iov_len = len};
+        return gnutls_ktls_sendv(session, &iov, 1);
+    }
 
     ssize_t ret = gnutls_record_send(session->session, data, len);
     if (ret >= 0) {
@@ -894,6 +1892,12 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     if (session == nullptr || data == nullptr) {
         return TLS_E_INVALID_PARAMETER;
     }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+    if (session->ktls & TLS_KTLS_RX) {
+        struct iovec iov = {.iov_base = data, .iov_len = len};
+        return gnutls_ktls_recvv(session, &iov, 1);
+    }
 
     ssize_t ret = gnutls_record_recv(session->session, data, len);
     if (ret >= 0) {
@@ -904,6 +1908,286 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     return tls_gnutls_map_error(ret);
 }
 
+/**
+ * Validate an iovec array and compute its total length
+ *
+ * @return 0 on success, -1 if invalid or the total does not fit ssize_t
+ */
+static int iov_total(const struct iovec *iov, int iovcnt, size_t *total) {
+    if (iovcnt < 0 || (iov == nullptr && iovcnt > 0)) {
+        return -1;
+    }
+
+    *total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > SIZE_MAX / 2 - *total ||     // SSIZE_MAX
+            (iov[i].iov_base == nullptr && iov[i].iov_len > 0)) {
+            return -1;
+        }
+        *total += iov[i].iov_len;
+    }
+    return 0;
+}
+
+[[nodiscard]] ssize_t tls_sendv(tls_session_t *session,
+                                  const struct iovec *iov,
+                                  int iovcnt) {
+    size_t total = 0;
+    if (session == nullptr || iov_total(iov, iovcnt, &total) != 0) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+    // A DTLS send is one record
+    if (session->ctx->is_dtls && total > TLS_MAX_RECORD_SIZE) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    // The kernel gathers the fragments into records itself
+    if (session->ktls & TLS_KTLS_TX) {
+        return total > 0 ? gnutls_ktls_sendv(session, iov, iovcnt) : 0;
+    }
+
+    // Every gnutls_record_send() call costs a record (or a copy into the cork
+    // buffer plus per-call overhead), so small fragments are gathered into
+    // record-sized chunks first. Fragments that fill a whole record on their
+    // own are sent in place.
+    uint8_t record[TLS_MAX_RECORD_SIZE];
+    size_t sent = 0;
+    size_t offset = 0;
+    int i = 0;
+
+    while (sent < total) {
+        const uint8_t *data;
+        size_t len;
+
+        while (offset == iov[i].iov_len) {
+            i++;
+            offset = 0;
+        }
+
+        if (iov[i].iov_len - offset >= TLS_MAX_RECORD_SIZE) {
+            data = (const uint8_t *)iov[i].iov_base + offset;
+            len = iov[i].iov_len - offset;
+        } else {
+            // Re-gathering after TLS_E_AGAIN yields the same bytes, as
+            // GnuTLS requires for the retried send
+            int fill_i = i;
+            size_t fill_offset = offset;
+            len = 0;
+            while (len < TLS_MAX_RECORD_SIZE && fill_i < iovcnt) {
+                size_t n = iov[fill_i].iov_len - fill_offset;
+                if (n > TLS_MAX_RECORD_SIZE - len) {
+                    n = TLS_MAX_RECORD_SIZE - len;
+                }
+                memcpy(record + len, (const uint8_t *)iov[fill_i].iov_base + fill_offset, n);
+                len += n;
+                fill_offset += n;
+                if (fill_offset == iov[fill_i].iov_len) {
+                    fill_i++;
+                    fill_offset = 0;
+                }
+            }
+            data = record;
+        }
+
+        ssize_t ret = gnutls_record_send(session->session, data, len);
+        if (ret < 0) {
+            // Report progress first; the error repeats on the next call
+            if (sent > 0) {
+                break;
+            }
+            return tls_gnutls_map_error((int)ret);
+        }
+
+        // Advance over what was sent
+        sent += (size_t)ret;
+        for (size_t left = (size_t)ret; left > 0; ) {
+            size_t n = iov[i].iov_len - offset;
+            if (n > left) {
+                n = left;
+            }
+            offset += n;
+            left -= n;
+            if (offset == iov[i].iov_len && left > 0) {
+                i++;
+                offset = 0;
+            }
+        }
+
+        if ((size_t)ret < len) {
+            break;  // Interrupted mid-buffer: let the caller resend the rest
+        }
+    }
+
+    session->bytes_written += sent;
+    return (ssize_t)sent;
+}
+
+/**
+ * DTLS path of tls_recvv(): one record, scattered straight from GnuTLS's
+ * decrypted packet
+ */
+static ssize_t gnutls_dtls_recvv(tls_session_t *session,
+                                 const struct iovec *iov,
+                                 int iovcnt) {
+    gnutls_packet_t packet = nullptr;
+    ssize_t ret = gnutls_record_recv_packet(session->session, &packet);
+    if (ret < 0) {
+        return tls_gnutls_map_error((int)ret);
+    }
+    if (packet == nullptr) {
+        return 0;
+    }
+
+    gnutls_datum_t data;
+    gnutls_packet_get(packet, &data, nullptr);
+
+    size_t copied = 0;
+    for (int i = 0; i < iovcnt && copied < data.size; i++) {
+        size_t n = data.size - copied;
+        if (n > iov[i].iov_len) {
+            n = iov[i].iov_len;
+        }
+        memcpy(iov[i].iov_base, data.data + copied, n);
+        copied += n;
+    }
+    gnutls_packet_deinit(packet);
+
+    session->bytes_read += copied;
+    return (ssize_t)copied;
+}
+
+[[nodiscard]] ssize_t tls_recvv(tls_session_t *session,
+                                  const struct iovec *iov,
+                                  int iovcnt) {
+    size_t total = 0;
+    if (session == nullptr || iov_total(iov, iovcnt, &total) != 0) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+    if (total == 0) {
+        return 0;
+    }
+
+    if (session->ctx->is_dtls) {
+        return gnutls_dtls_recvv(session, iov, iovcnt);
+    }
+
+    if (session->ktls & TLS_KTLS_RX) {
+        return gnutls_ktls_recvv(session, iov, iovcnt);
+    }
+
+    size_t received = 0;
+    size_t offset = 0;
+
+    for (int i = 0; i < iovcnt; ) {
+        if (offset == iov[i].iov_len) {
+            i++;
+            offset = 0;
+            continue;
+        }
+
+        // Past the first read, only drain what is already decrypted
+        if (received > 0 && gnutls_record_check_pending(session->session) == 0) {
+            break;
+        }
+
+        ssize_t ret = gnutls_record_recv(session->session,
+                                         (uint8_t *)iov[i].iov_base + offset,
+                                         iov[i].iov_len - offset);
+        if (ret <= 0) {
+            if (received > 0 || ret == 0) {
+                break;  // Report the data; EOF or the error shows up next call
+            }
+            return tls_gnutls_map_error((int)ret);
+        }
+
+        received += (size_t)ret;
+        offset += (size_t)ret;
+    }
+
+    session->bytes_read += received;
+    return (ssize_t)received;
+}
+
+/**
+ * tls_sendfile() without kTLS: read and send one record's worth at a time
+ *
+ * Chunks are read with pread() and the offset only advances past what was
+ * sent, so a call retried after TLS_E_AGAIN gives GnuTLS the same bytes.
+ */
+static ssize_t gnutls_sendfile_copy(tls_session_t *session,
+                                    int in_fd,
+                                    off_t *offset,
+                                    size_t count) {
+    off_t pos = offset != nullptr ? *offset : lseek(in_fd, 0, SEEK_CUR);
+    if (pos < 0) {
+        return TLS_E_INVALID_PARAMETER;     // Not a seekable file
+    }
+
+    uint8_t chunk[TLS_MAX_RECORD_SIZE];
+    size_t sent = 0;
+
+    while (sent < count) {
+        size_t want = count - sent < sizeof(chunk) ? count - sent : sizeof(chunk);
+        ssize_t n = pread(in_fd, chunk, want, pos);
+        if (n <= 0) {
+            if (n == 0 || sent > 0) {
+                break;      // End of file, or report progress first
+            }
+            return errno == EINTR ? TLS_E_INTERRUPTED : TLS_E_INVALID_PARAMETER;
+        }
+
+        ssize_t ret = gnutls_record_send(session->session, chunk, (size_t)n);
+        if (ret < 0) {
+            if (sent > 0) {
+                break;
+            }
+            return tls_gnutls_map_error((int)ret);
+        }
+
+        sent += (size_t)ret;
+        pos += ret;
+        if (ret < n) {
+            break;
+        }
+    }
+
+    if (offset != nullptr) {
+        *offset = pos;
+    } else if (lseek(in_fd, pos, SEEK_SET) < 0) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    session->bytes_written += sent;
+    return (ssize_t)sent;
+}
+
+[[nodiscard]] ssize_t tls_sendfile(tls_session_t *session,
+                                     int in_fd,
+                                     off_t *offset,
+                                     size_t count) {
+    if (session == nullptr || in_fd < 0 || session->ctx->is_dtls) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+    if (count > SIZE_MAX / 2) {
+        count = SIZE_MAX / 2;       // SSIZE_MAX
+    }
+
+    if (session->ktls & TLS_KTLS_TX) {
+        ssize_t ret = ktls_sendfile(session->fd, in_fd, offset, count);
+        if (ret < 0) {
+            return ktls_map_errno(errno, true);
+        }
+        session->bytes_written += (size_t)ret;
+        return ret;
+    }
+
+    return gnutls_sendfile_copy(session, in_fd, offset, count);
+}
+
 [[nodiscard]] size_t tls_pending(tls_session_t *session) {
     if (session == nullptr) {
         return 0;
@@ -917,6 +2201,11 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
         return TLS_E_INVALID_PARAMETER;
     }
 
+    // Offloaded sends go straight to the kernel, one record per send
+    if (session->ktls & TLS_KTLS_TX) {
+        return TLS_E_SUCCESS;
+    }
+
     gnutls_record_cork(session->session);
     return TLS_E_SUCCESS;
 }
@@ -925,6 +2214,11 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     if (session == nullptr) {
         return TLS_E_INVALID_PARAMETER;
     }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+    if (session->ktls & TLS_KTLS_TX) {
+        return TLS_E_SUCCESS;
+    }
 
     int ret = gnutls_record_uncork(session->session, GNUTLS_RECORD_WAIT);
     return tls_gnutls_map_error(ret);
@@ -938,6 +2232,13 @@ void tls_session_set_ptr(tls_session_t *session, void *ptr) {
     if (session == nullptr) {
         return TLS_E_INVALID_PARAMETER;
     }
+    ALLOCATOR_ATTRIBUTE(&session->mem_stats);
+
+    // The kernel owns the write state: send close_notify through it and do
+    // not wait for the peer's
+    if (session->ktls & TLS_KTLS_TX) {
+        return gnutls_ktls_alert(session, GNUTLS_AL_WARNING, GNUTLS_A_CLOSE_NOTIFY);
+    }
 
     int ret = gnutls_bye(session->session, GNUTLS_SHUT_RDWR);
     return tls_gnutls_map_error(ret);
@@ -948,6 +2249,11 @@ void tls_alert_send(tls_session_t *session, tls_alert_t alert) {
         return;
     }
 
+    if (session->ktls & TLS_KTLS_TX) {
+        (void)gnutls_ktls_alert(session, GNUTLS_AL_FATAL, (uint8_t)alert);
+        return;
+    }
+
     gnutls_alert_send(session->session, GNUTLS_AL_FATAL, (gnutls_alert_description_t)alert);
 }
 
@@ -1004,6 +2310,10 @@ void tls_alert_send(tls_session_t *session, tls_alert_t alert) {
     // Check safe renegotiation
     info->safe_renegotiation = gnutls_safe_renegotiation_status(session->session) != 0;
 
+    // Set on both ends once the server accepted 0-RTT data
+    info->early_data_accepted =
+        (gnutls_session_get_flags(session->session) & GNUTLS_SFLAGS_EARLY_DATA) != 0;
+
     return TLS_E_SUCCESS;
 }
 
@@ -1073,3 +2383,219 @@ void tls_free(void *ptr) {
     int ret = gnutls_rnd(GNUTLS_RND_RANDOM, data, len);
     return tls_gnutls_map_error(ret);
 }
+
+/* ============================================================================
+ * Hashing and Key Derivation
+ * ============================================================================ */
+
+/*
+ * gnutls_hash_init()/gnutls_hmac_init() heap-allocate their handles, so the
+ * streaming contexts use Nettle - the library GnuTLS itself hashes with -
+ * whose contexts are plain structs that fit in the caller's storage.
+ */
+
+typedef union {
+    struct sha256_ctx sha256;
+    struct sha512_ctx sha512;       // Also SHA-384
+} gnutls_sha2_ctx_t;
+
+typedef struct {
+    const struct nettle_hash *hash;
+    gnutls_sha2_ctx_t state;
+} gnutls_hash_state_t;
+
+typedef struct {
+    const struct nettle_hash *hash;
+    gnutls_sha2_ctx_t outer;        // Key ^ opad, absorbed once
+    gnutls_sha2_ctx_t inner;        // Key ^ ipad, absorbed once
+    gnutls_sha2_ctx_t state;        // Running inner hash
+} gnutls_hmac_state_t;
+
+static_assert(sizeof(gnutls_hash_state_t) <= TLS_HASH_CTX_SIZE,
+              "tls_hash_ctx_t too small for the Nettle state");
+static_assert(sizeof(gnutls_hmac_state_t) <= TLS_HMAC_CTX_SIZE,
+              "tls_hmac_ctx_t too small for the Nettle state");
+
+static const struct nettle_hash *gnutls_nettle_hash(tls_digest_t digest) {
+    switch (digest) {
+        case TLS_DIGEST_SHA256:
+            return &nettle_sha256;
+        case TLS_DIGEST_SHA384:
+            return &nettle_sha384;
+        case TLS_DIGEST_SHA512:
+            return &nettle_sha512;
+    }
+    return nullptr;
+}
+
+[[nodiscard]] size_t tls_digest_size(tls_digest_t digest) {
+    const struct nettle_hash *hash = gnutls_nettle_hash(digest);
+    return hash != nullptr ? hash->digest_size : 0;
+}
+
+[[nodiscard]] int tls_hash_init(tls_hash_ctx_t *ctx, tls_digest_t digest) {
+    const struct nettle_hash *hash = gnutls_nettle_hash(digest);
+    if (ctx == nullptr || hash == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    gnutls_hash_state_t *state = (gnutls_hash_state_t *)ctx->opaque;
+    state->hash = hash;
+    hash->init(&state->state);
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_hash_update(tls_hash_ctx_t *ctx, const void *data, size_t len) {
+    if (ctx == nullptr || (data == nullptr && len > 0)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    gnutls_hash_state_t *state = (gnutls_hash_state_t *)ctx->opaque;
+    state->hash->update(&state->state, len, data);
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_hash_final(tls_hash_ctx_t *ctx, uint8_t *output) {
+    if (ctx == nullptr || output == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    // Nettle digest functions re-initialize the context
+    gnutls_hash_state_t *state = (gnutls_hash_state_t *)ctx->opaque;
+    state->hash->digest(&state->state, state->hash->digest_size, output);
+    return TLS_E_SUCCESS;
+}
+
+void tls_hash_deinit(tls_hash_ctx_t *ctx) {
+    if (ctx != nullptr) {
+        gnutls_memset(ctx->opaque, 0, sizeof(gnutls_hash_state_t));
+    }
+}
+
+[[nodiscard]] int tls_hash_batch(tls_digest_t digest,
+                                   const struct iovec *inputs,
+                                   size_t count,
+                                   uint8_t *outputs) {
+    const struct nettle_hash *hash = gnutls_nettle_hash(digest);
+    if (hash == nullptr || (count > 0 && (inputs == nullptr || outputs == nullptr))) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    gnutls_sha2_ctx_t state;
+    hash->init(&state);
+    for (size_t i = 0; i < count; i++) {
+        hash->update(&state, inputs[i].iov_len, inputs[i].iov_base);
+        hash->digest(&state, hash->digest_size, outputs + i * hash->digest_size);
+    }
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_hmac_init(tls_hmac_ctx_t *ctx, tls_digest_t digest,
+                                  const void *key, size_t key_len) {
+    const struct nettle_hash *hash = gnutls_nettle_hash(digest);
+    if (ctx == nullptr || hash == nullptr || (key == nullptr && key_len > 0)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    gnutls_hmac_state_t *state = (gnutls_hmac_state_t *)ctx->opaque;
+    state->hash = hash;
+    hmac_set_key(&state->outer, &state->inner, &state->state, hash, key_len, key);
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_hmac_update(tls_hmac_ctx_t *ctx, const void *data, size_t len) {
+    if (ctx == nullptr || (data == nullptr && len > 0)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    gnutls_hmac_state_t *state = (gnutls_hmac_state_t *)ctx->opaque;
+    hmac_update(&state->state, state->hash, len, data);
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_hmac_final(tls_hmac_ctx_t *ctx, uint8_t *output) {
+    if (ctx == nullptr || output == nullptr) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    // hmac_digest() restores the keyed inner state
+    gnutls_hmac_state_t *state = (gnutls_hmac_state_t *)ctx->opaque;
+    hmac_digest(&state->outer, &state->inner, &state->state, state->hash,
+                state->hash->digest_size, output);
+    return TLS_E_SUCCESS;
+}
+
+void tls_hmac_deinit(tls_hmac_ctx_t *ctx) {
+    if (ctx != nullptr) {
+        gnutls_memset(ctx->opaque, 0, sizeof(gnutls_hmac_state_t));
+    }
+}
+
+// Nettle's HKDF drives the MAC through these; neither can fail once keyed
+static void gnutls_hkdf_update(void *ctx, size_t len, const uint8_t *data) {
+    gnutls_hmac_state_t *state = (gnutls_hmac_state_t *)((tls_hmac_ctx_t *)ctx)->opaque;
+    hmac_update(&state->state, state->hash, len, data);
+}
+
+static void gnutls_hkdf_digest(void *ctx, size_t len, uint8_t *output) {
+    gnutls_hmac_state_t *state = (gnutls_hmac_state_t *)((tls_hmac_ctx_t *)ctx)->opaque;
+    hmac_digest(&state->outer, &state->inner, &state->state, state->hash, len, output);
+}
+
+[[nodiscard]] int tls_hkdf_extract(tls_digest_t digest,
+                                     const void *salt, size_t salt_len,
+                                     const void *ikm, size_t ikm_len,
+                                     uint8_t *prk) {
+    if (prk == nullptr || (ikm == nullptr && ikm_len > 0)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    // An absent salt is HashLen zeros, which HMAC pads to the same key
+    tls_hmac_ctx_t mac;
+    int ret = tls_hmac_init(&mac, digest, salt, salt_len);
+    if (ret != TLS_E_SUCCESS) {
+        return ret;
+    }
+
+    size_t size = tls_digest_size(digest);
+    hkdf_extract(&mac, gnutls_hkdf_update, gnutls_hkdf_digest, size, ikm_len, ikm, prk);
+    tls_hmac_deinit(&mac);
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_hkdf_expand(tls_digest_t digest,
+                                    const uint8_t *prk, size_t prk_len,
+                                    const void *info, size_t info_len,
+                                    uint8_t *okm, size_t okm_len) {
+    size_t size = tls_digest_size(digest);
+    if (size == 0 || prk == nullptr || prk_len < size || okm == nullptr ||
+        okm_len > 255 * size || (info == nullptr && info_len > 0)) {
+        return TLS_E_INVALID_PARAMETER;
+    }
+
+    tls_hmac_ctx_t mac;
+    int ret = tls_hmac_init(&mac, digest, prk, prk_len);
+    if (ret != TLS_E_SUCCESS) {
+        return ret;
+    }
+
+    hkdf_expand(&mac, gnutls_hkdf_update, gnutls_hkdf_digest, size, info_len, info,
+                okm_len, okm);
+    tls_hmac_deinit(&mac);
+    return TLS_E_SUCCESS;
+}
+
+[[nodiscard]] int tls_hkdf(tls_digest_t digest,
+                             const void *salt, size_t salt_len,
+                             const void *ikm, size_t ikm_len,
+                             const void *info, size_t info_len,
+                             uint8_t *okm, size_t okm_len) {
+    uint8_t prk[TLS_DIGEST_MAX_SIZE];
+
+    int ret = tls_hkdf_extract(digest, salt, salt_len, ikm, ikm_len, prk);
+    if (ret == TLS_E_SUCCESS) {
+        ret = tls_hkdf_expand(digest, prk, tls_digest_size(digest), info, info_len, okm, okm_len);
+    }
+    gnutls_memset(prk, 0, sizeof(prk));
+    return ret;
+}
@@ -34,6 +34,7 @@
  * - Custom I/O callbacks
  * - Certificate verification
  * - OCSP stapling
+ * - Kernel TLS offload after the handshake (Linux)
  *
  * Requirements:
  * - GnuTLS 3.8.0 or newer (for TLS 1.3 improvements)
@@ -41,15 +42,26 @@
  */
 
 #include "tls_abstract.h"
+#include "membio.h"
 #include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
 #include <gnutls/dtls.h>
 #include <gnutls/abstract.h>
 #include <gnutls/crypto.h>
+#include <gnutls/socket.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 /* Backend initialization (called by tls_global_init) */
 [[nodiscard]] int tls_gnutls_init(void);
 void tls_gnutls_deinit(void);
+[[nodiscard]] const char *tls_gnutls_get_version(void);
+
+/* Session ticket master key, as gnutls_session_ticket_key_generate() makes it */
+constexpr size_t TLS_GNUTLS_TICKET_KEY_SIZE = 64;
+
+/* Longest certificate chain tls_credentials_new() accepts */
+constexpr unsigned int TLS_GNUTLS_MAX_CHAIN = 16;
 
 /* GnuTLS-specific opaque structures (internal) */
 struct tls_context {
@@ -61,10 +73,19 @@ struct tls_context {
     bool is_server;
     bool is_dtls;
     bool verify_peer;
+    bool ktls;                  // Offload records to kernel TLS after the handshake
+    bool nonblocking;           // tls_context_set_nonblocking(): want codes, caller-driven DTLS timers
 
-    /* Certificate and key paths (deferred loading for GnuTLS) */
+    /* Certificate and key, each from a path or PEM in memory; loaded as a
+     * pair once both are set */
     char *cert_file_path;
     char *key_file_path;
+    gnutls_datum_t cert_pem;
+    gnutls_datum_t key_pem;
+
+    /* Shared credentials (tls_context_set_credentials), handed to sessions by
+     * a certificate retrieve callback instead of loaded into x509_cred */
+    tls_credentials_t *credentials;
 
     /* Callbacks */
     tls_cert_verify_func_t verify_callback;
@@ -76,17 +97,55 @@ struct tls_context {
     tls_db_store_func_t db_store;
     tls_db_retrieve_func_t db_retrieve;
     tls_db_remove_func_t db_remove;
+    tls_db_borrow_func_t db_borrow;
+    tls_db_release_func_t db_release;
     void *db_userdata;
 
+    /* Session tickets (tls_context_set_ticket_keys), copied into each server
+     * session under ticket_lock; GnuTLS rotates the key it derives from it */
+    pthread_mutex_t ticket_lock;
+    uint8_t ticket_key[TLS_GNUTLS_TICKET_KEY_SIZE];
+    bool tickets;
+    unsigned int ticket_lifetime_secs;
+
+    /* 0-RTT early data (tls_context_set_early_data) */
+    size_t early_data_max;
+    gnutls_anti_replay_t anti_replay;   // Servers; its add function asks replay_check
+    tls_replay_check_func_t replay_check;
+    void *replay_userdata;
+
+    /* Session pool (tls_context_set_session_pool), reset sessions for reuse */
+    pthread_mutex_t pool_lock;
+    tls_session_t **pool;
+    size_t pool_count;
+    size_t pool_capacity;
+
+    /* Bumped when the ticket keys or early data settings change; a pooled
+     * session set up under an older value is set up again before reuse */
+    atomic_uint config_generation;
+
+    /* References: the creator's and one per live session (pooled sessions
+     * hold none); the last tls_context_free() frees the context */
+    atomic_int refcount;
+
     /* Statistics */
     uint64_t sessions_created;
     uint64_t handshakes_completed;
     uint64_t handshakes_failed;
 };
 
+/* Parsed certificate chain and key shared by many contexts (immutable) */
+struct tls_credentials {
+    gnutls_pcert_st pcerts[TLS_GNUTLS_MAX_CHAIN];
+    unsigned int pcert_count;
+    gnutls_privkey_t key;
+    atomic_int refcount;
+};
+
 struct tls_session {
     gnutls_session_t session;
     tls_context_t *ctx;
+    unsigned int config_generation;     // ctx->config_generation at setup
 
     /* User data pointer */
     void *user_ptr;
@@ -97,10 +156,21 @@ struct tls_session {
     tls_pull_timeout_func_t pull_timeout_func;
     void *io_userdata;
 
+    /* Kernel TLS */
+    int fd;                     // Socket from tls_session_set_fd(), -1 otherwise
+    unsigned int ktls;          // TLS_KTLS_* directions handled by the kernel
+
+    /* Memory BIO (tls_session_set_memory_bio) */
+    bool membio;
+    bool membio_eof;            // Peer closed: reads past bio_in see EOF
+    membio_t bio_in;            // Fed ciphertext, consumed by the pull callback
+    membio_t bio_out;           // Pushed ciphertext, waiting to be drained
+
     /* Statistics */
     uint64_t bytes_read;
     uint64_t bytes_written;
     bool handshake_complete;
+    tls_memory_stats_t mem_stats;   // See tls_session_get_memory_stats()
 };
 
 struct tls_certificate {
@@ -47,20 +47,50 @@
  */
 
 #include "tls_abstract.h"
+#include "session_cache.h"
+#include "membio.h"
 #include <wolfssl/options.h>
 #include <wolfssl/ssl.h>
 #include <wolfssl/error-ssl.h>
 #include <stdatomic.h>
+#include <pthread.h>
 
 // C23 standard compliance (accept C2x/C20 from GCC 14 as it provides C23 features)
 #if __STDC_VERSION__ < 202000L
 #error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
 #endif
 
+// Sealed records a corked session queues before it writes them out even
+// without tls_uncork() (one send per this many bytes of ciphertext)
+constexpr size_t TLS_WOLFSSL_CORK_FLUSH_SIZE = 65'536;
+
+// Session tickets: ChaCha20-Poly1305 key, and the key ID that opens the
+// ticket's key name (the rest of the name is the issue time)
+constexpr size_t TLS_WOLFSSL_TICKET_KEY_SIZE = 32;
+constexpr size_t TLS_WOLFSSL_TICKET_ID_SIZE = 8;
+
+// ClientHello random, the 0-RTT anti-replay key
+constexpr size_t TLS_WOLFSSL_RANDOM_SIZE = 32;
+
 /* ============================================================================
  * Opaque Structure Definitions
  * ============================================================================ */
 
+/**
+ * Session ticket secret and the keys derived from it
+ *
+ * Tickets are encrypted under a key derived from the secret and the
+ * rotation period (issue time / lifetime). The keys of the two periods
+ * that can be in use at once are cached, one slot each (period % 2).
+ */
+typedef struct {
+    uint8_t secret[TLS_WOLFSSL_TICKET_KEY_SIZE];
+    bool cached[2];
+    uint64_t period[2];
+    uint8_t key[2][TLS_WOLFSSL_TICKET_KEY_SIZE];
+    uint8_t id[2][TLS_WOLFSSL_TICKET_ID_SIZE];
+} tls_wolfssl_ticket_key_t;
+
 /**
  * TLS context structure (server/client configuration)
  *
@@ -74,6 +104,8 @@ struct tls_context {
     WOLFSSL_CTX *wolf_ctx;                // wolfSSL context
     bool is_server;                        // Server vs client
     bool is_dtls;                          // DTLS vs TLS
+    bool ktls;                             // kTLS requested (not offloaded, see tls_context_set_ktls)
+    bool nonblocking;                      // tls_context_set_nonblocking(): want codes, caller-driven DTLS timers
 
     // Certificates and keys
     char *cert_file;                       // Certificate file path
@@ -81,6 +113,7 @@ struct tls_context {
     char *ca_file;                         // CA bundle file path
     char *dh_params_file;                  // DH parameters file path
     bool has_certificate;                  // Certificate loaded flag
+    tls_credentials_t *credentials;        // Shared credentials loaded last, if any
 
     // Priority/cipher configuration
     char *priority_string;                 // GnuTLS priority string (stored for reference)
@@ -100,17 +133,64 @@ struct tls_context {
     tls_db_store_func_t db_store;
     tls_db_retrieve_func_t db_retrieve;
     tls_db_remove_func_t db_remove;
+    tls_db_borrow_func_t db_borrow;
+    tls_db_release_func_t db_release;
     void *db_userdata;
     unsigned int session_timeout_secs;
 
+    // Native session cache (tls_wolfssl_context_set_native_session_cache),
+    // owned by the context; stores WOLFSSL_SESSION pointers, not bytes
+    session_cache_t *native_cache;
+
+    // Session tickets (tls_context_set_ticket_keys), newest secret first;
+    // read by the ticket callback under ticket_lock
+    pthread_mutex_t ticket_lock;
+    tls_wolfssl_ticket_key_t ticket_keys[TLS_MAX_TICKET_KEYS];
+    size_t ticket_key_count;
+    unsigned int ticket_lifetime_secs;
+
+    // 0-RTT early data (tls_context_set_early_data); servers ask replay_check
+    // about each TLS 1.3 ticket they decrypt
+    size_t early_data_max;
+    tls_replay_check_func_t replay_check;
+    void *replay_userdata;
+
     // OCSP callback
     tls_ocsp_status_func_t ocsp_callback;
     void *ocsp_userdata;
 
+    // Session pool (tls_context_set_session_pool): reset sessions that hold
+    // no context reference
+    pthread_mutex_t pool_lock;
+    tls_session_t **pool;
+    size_t pool_count;
+    size_t pool_capacity;
+
+    // Bumped when the early data settings change; a pooled session set up
+    // under an older value is set up again before reuse
+    atomic_uint config_generation;
+
     // Reference counting for multi-threaded safety
     atomic_int refcount;
 };
 
+/**
+ * Shared credentials (tls_credentials_new)
+ *
+ * wolfSSL keeps its own copy of the certificate and key in every
+ * WOLFSSL_CTX and parses the DER it is given into it, so what contexts
+ * share is the decoded DER: attaching skips file I/O and PEM decoding, but
+ * not the DER parse, and the pair was checked once at creation.
+ */
+struct tls_credentials {
+    uint8_t *chain_der;                    // DER certificates back to back, leaf first
+    size_t chain_size;
+    uint8_t *key_der;                      // DER private key, key_cap bytes wiped on free
+    size_t key_size;
+    size_t key_cap;                        // Allocated; a failed decode may leave any of it
+    atomic_int refcount;
+};
+
 /**
  * TLS session structure (individual connection)
  *
@@ -123,6 +203,7 @@ struct tls_context {
 struct tls_session {
     WOLFSSL *wolf_ssl;                     // wolfSSL session
     tls_context_t *ctx;                    // Parent context
+    unsigned int config_generation;        // ctx->config_generation at setup
 
     // I/O functions
     tls_push_func_t push_func;
@@ -132,13 +213,46 @@ struct tls_session {
 
     // Session state
     bool handshake_complete;               // Handshake finished
-    bool corked;                           // Record corking enabled
+    bool corked;                           // Between tls_cork() and tls_uncork()
+    bool custom_io;                        // Session-level I/O callbacks installed
+
+    // Record corking: plaintext is gathered into full records, and sealed
+    // records are queued and written with one send. Allocated on first
+    // tls_cork(); from then on the session's send callback goes through
+    // the cork queue.
+    uint8_t *cork_buf;                     // TLS_MAX_RECORD_SIZE bytes of plaintext
+    size_t cork_len;                       // Plaintext not yet sealed
+    uint8_t *cork_out;                     // Sealed records not yet written
+    size_t cork_out_len;
+    size_t cork_out_off;                   // Prefix of cork_out already written
+    size_t cork_out_cap;
+    int cork_error;                        // Held back by a send that accepted bytes
+    int fd;                                // tls_session_set_fd(), -1 if none
+
+    // Memory BIO (tls_session_set_memory_bio)
+    bool membio;
+    bool membio_eof;                       // Peer closed: reads past bio_in see EOF
+    membio_t bio_in;                       // Fed ciphertext, consumed by the recv callback
+    membio_t bio_out;                      // Sent ciphertext, waiting to be drained
+
+    // Server 0-RTT: early data read by tls_handshake() (up to the client's
+    // EndOfEarlyData), handed out by tls_session_read_early_data()
+    uint8_t *early_buf;                    // early_cap bytes, kept across resets
+    size_t early_cap;
+    size_t early_len;
+    size_t early_off;                      // Prefix already read
+    bool early_done;
+    bool early_replayed;                   // The anti-replay check refused the ClientHello
 
     // User pointer
     void *user_ptr;
 
+    // Memory accounting
+    tls_memory_stats_t mem_stats;          // See tls_session_get_memory_stats()
+
     // DTLS-specific
     unsigned int dtls_mtu;
+    uint64_t dtls_deadline_ms;             // Non-blocking: CLOCK_MONOTONIC retransmission time, 0 if none
 
     // Error tracking
     int last_error;
@@ -212,6 +326,39 @@ void tls_wolfssl_deinit(void);
                                                   char *wolfssl_ciphers,
                                                   size_t ciphers_len);
 
+/**
+ * Cache native wolfSSL session objects instead of serialized sessions
+ *
+ * Creates a session cache owned by @p ctx that stores a reference to each
+ * WOLFSSL_SESSION rather than its i2d() encoding. A resume hands wolfSSL
+ * another reference to the cached object, so neither storing nor resuming
+ * serializes anything, and wolfSSL's internal session cache is switched off
+ * so that sessions are not kept twice.
+ *
+ * The cache uses @p config (timeout, capacity, shards, policy); the session
+ * lifetime follows tls_context_set_session_timeout(). It takes precedence
+ * over callbacks set with tls_context_set_session_cache() and lives until
+ * the context is freed. Cached objects are process-local: this cannot be
+ * combined with shared-memory caches or snapshots.
+ *
+ * Requires wolfSSL built with HAVE_EXT_CACHE (--enable-opensslextra).
+ *
+ * @param ctx TLS context
+ * @param config Cache configuration, nullptr for defaults
+ * @return TLS_E_SUCCESS, TLS_E_INVALID_PARAMETER if a native cache is already
+ *         set or @p config is invalid, TLS_E_MEMORY_ERROR on allocation failure
+ */
+[[nodiscard]] int tls_wolfssl_context_set_native_session_cache(tls_context_t *ctx,
+                                                               const session_cache_config_t *config);
+
+/**
+ * Get the native session cache of @p ctx (for statistics)
+ *
+ * @return Cache, or nullptr if tls_wolfssl_context_set_native_session_cache()
+ *         was not called
+ */
+[[nodiscard]] session_cache_t* tls_wolfssl_context_get_native_session_cache(tls_context_t *ctx);
+
 /**
  * Get wolfSSL version information
  *
@@ -0,0 +1,73 @@
+/*
+ * Micro-benchmark helpers - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Shared timing and reporting helpers for the tests/bench/bench_*.c
+ *          micro-benchmarks. Header-only so each benchmark stays a single
+ *          translation unit.
+ */
+
+#ifndef WOLFGUARD_BENCH_COMMON_H
+#define WOLFGUARD_BENCH_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// C23 standard check
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+constexpr uint64_t BENCH_NS_PER_SEC = 1'000'000'000;
+
+/**
+ * Monotonic timestamp in nanoseconds
+ */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * BENCH_NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Operations per second for @p ops operations taking @p elapsed_ns
+ */
+static inline double bench_ops_per_sec(uint64_t ops, uint64_t elapsed_ns) {
+    if (elapsed_ns == 0) {
+        return 0.0;
+    }
+    return (double)ops * (double)BENCH_NS_PER_SEC / (double)elapsed_ns;
+}
+
+/**
+ * Cheap per-thread PRNG (xorshift64*) so the generator never shows up in
+ * the profile or introduces shared state between benchmark threads
+ */
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Print a section banner in the same style as the PoC tools
+ */
+static inline void bench_banner(const char *title) {
+    printf("===============================================\n");
+    printf("%s\n", title);
+    printf("===============================================\n");
+}
+
+#endif // WOLFGUARD_BENCH_COMMON_H
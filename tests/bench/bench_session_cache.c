@@ -0,0 +1,192 @@
+/*
+ * Session Cache Scaling Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure session_cache_retrieve() throughput as the number of
+ *          handshake threads grows, comparing a single-lock cache (1 shard)
+ *          against the lock-striped cache. With enough shards lookups/sec
+ *          should scale close to linearly with the thread count.
+ *
+ * Usage: bench_session_cache [max_threads] [duration_ms]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/crypto/session_cache.h"
+#include "bench_common.h"
+
+/* Configuration */
+constexpr size_t BENCH_CAPACITY = 100'000;
+constexpr size_t BENCH_POPULATION = 50'000;
+constexpr unsigned int BENCH_DEFAULT_MAX_THREADS = 8;
+constexpr unsigned int BENCH_MAX_THREADS = 256;
+constexpr unsigned int BENCH_DEFAULT_DURATION_MS = 1'000;
+constexpr size_t BENCH_SESSION_DATA_SIZE = 512;
+
+typedef struct {
+    session_cache_t *cache;
+    atomic_bool *stop;
+    uint64_t seed;
+    uint64_t lookups;
+} worker_t;
+
+/* Deterministic 32-byte session ID for population index @p n */
+static void make_session_id(uint8_t *id, uint64_t n) {
+    uint64_t state = n * 0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = 0; i < 32; i += sizeof(uint64_t)) {
+        uint64_t v = bench_rand(&state);
+        memcpy(id + i, &v, sizeof(v));
+    }
+}
+
+static void populate(session_cache_t *cache) {
+    tls_session_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.session_id_size = 32;
+    entry.session_data_size = BENCH_SESSION_DATA_SIZE;
+    entry.expiration = 0; // Never expires
+
+    for (size_t n = 0; n < BENCH_POPULATION; n++) {
+        make_session_id(entry.session_id, n);
+        memset(entry.session_data, (int)(n & 0xFF), entry.session_data_size);
+        if (session_cache_store(cache, &entry) != 0) {
+            fprintf(stderr, "Failed to populate cache\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    uint8_t id[32];
+    tls_session_cache_entry_t out;
+    uint64_t state = w->seed;
+
+    while (!atomic_load_explicit(w->stop, memory_order_relaxed)) {
+        // Batch to keep the stop-flag load out of the hot path
+        for (int i = 0; i < 256; i++) {
+            make_session_id(id, bench_rand(&state) % BENCH_POPULATION);
+            (void)session_cache_retrieve(w->cache, id, sizeof(id), &out);
+        }
+        w->lookups += 256;
+    }
+
+    return nullptr;
+}
+
+static double run(session_cache_t *cache, unsigned int threads, unsigned int duration_ms) {
+    pthread_t tids[BENCH_MAX_THREADS];
+    worker_t workers[BENCH_MAX_THREADS];
+    atomic_bool stop = false;
+
+    for (unsigned int t = 0; t < threads; t++) {
+        workers[t] = (worker_t){
+            .cache = cache,
+            .stop = &stop,
+            .seed = 0x1234'5678ULL + t,
+            .lookups = 0,
+        };
+        if (pthread_create(&tids[t], nullptr, worker_main, &workers[t]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    struct timespec ts = {
+        .tv_sec = duration_ms / 1'000,
+        .tv_nsec = (long)(duration_ms % 1'000) * 1'000'000L,
+    };
+    nanosleep(&ts, nullptr);
+    atomic_store(&stop, true);
+
+    uint64_t total = 0;
+    for (unsigned int t = 0; t < threads; t++) {
+        pthread_join(tids[t], nullptr);
+        total += workers[t].lookups;
+    }
+
+    return bench_ops_per_sec(total, bench_now_ns() - start);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int max_threads = BENCH_DEFAULT_MAX_THREADS;
+    unsigned int duration_ms = BENCH_DEFAULT_DURATION_MS;
+
+    if (argc > 1) {
+        max_threads = (unsigned int)strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        duration_ms = (unsigned int)strtoul(argv[2], nullptr, 10);
+    }
+    if (max_threads == 0 || max_threads > BENCH_MAX_THREADS || duration_ms == 0) {
+        fprintf(stderr, "Usage: %s [max_threads (1-%u)] [duration_ms]\n", argv[0],
+                BENCH_MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("Session Cache Scaling Benchmark");
+    printf("Capacity: %zu, population: %zu, duration: %u ms/run\n\n",
+           BENCH_CAPACITY, BENCH_POPULATION, duration_ms);
+
+    const size_t shard_configs[] = {1, SESSION_CACHE_DEFAULT_SHARDS, 64};
+
+    printf("%-8s", "threads");
+    for (size_t c = 0; c < sizeof(shard_configs) / sizeof(shard_configs[0]); c++) {
+        char label[32];
+        snprintf(label, sizeof(label), "%zu shard(s)", shard_configs[c]);
+        printf(" %18s", label);
+    }
+    printf("\n");
+
+    session_cache_t *caches[sizeof(shard_configs) / sizeof(shard_configs[0])];
+    for (size_t c = 0; c < sizeof(shard_configs) / sizeof(shard_configs[0]); c++) {
+        session_cache_config_t config = {
+            .capacity = BENCH_CAPACITY,
+            .timeout_secs = 3'600,
+            .shard_count = shard_configs[c],
+        };
+        caches[c] = session_cache_new_with_config(&config);
+        if (caches[c] == nullptr) {
+            fprintf(stderr, "Failed to create cache\n");
+            return EXIT_FAILURE;
+        }
+        populate(caches[c]);
+    }
+
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        printf("%-8u", threads);
+        for (size_t c = 0; c < sizeof(shard_configs) / sizeof(shard_configs[0]); c++) {
+            double ops = run(caches[c], threads, duration_ms);
+            printf(" %14.2f M/s", ops / 1e6);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    for (size_t c = 0; c < sizeof(shard_configs) / sizeof(shard_configs[0]); c++) {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        session_cache_get_stats(caches[c], nullptr, nullptr, &hits, &misses, nullptr);
+        printf("\n%zu shard(s): %zu effective, hits=%llu misses=%llu",
+               shard_configs[c], session_cache_shard_count(caches[c]),
+               (unsigned long long)hits, (unsigned long long)misses);
+        session_cache_free(caches[c]);
+    }
+    printf("\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*
+ * Session Cache Lookup Latency Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure single-threaded session_cache_retrieve() latency (hits
+ *          and misses) as the number of cached sessions grows from 1k to 1M.
+ *          With the open-addressing table the per-lookup cost should stay
+ *          roughly flat; only cache/TLB misses on the larger working set
+ *          should show up. Also reports total cache memory per session, and
+ *          miss latency and false-positive rate with the negative filter
+ *          (session_cache_config_t.negative_filter) enabled.
+ *
+ * Usage: bench_session_cache_lookup [max_entries] [lookups]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/crypto/session_cache.h"
+#include "bench_common.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_MAX_ENTRIES = 1'000'000;
+constexpr size_t BENCH_DEFAULT_LOOKUPS = 2'000'000;
+constexpr size_t BENCH_SESSION_ID_SIZE = 32;
+constexpr size_t BENCH_SESSION_DATA_SIZE = 256;
+
+/* Fill @p ids with @p count random 32-byte session IDs */
+static void make_ids(uint8_t *ids, size_t count, uint64_t seed) {
+    uint64_t state = seed;
+    for (size_t i = 0; i < count * BENCH_SESSION_ID_SIZE; i += sizeof(uint64_t)) {
+        uint64_t v = bench_rand(&state);
+        memcpy(ids + i, &v, sizeof(v));
+    }
+}
+
+/* Time @p lookups random retrievals drawn from @p ids, return ns/lookup */
+static double time_lookups(session_cache_t *cache, const uint8_t *ids, size_t count,
+                           size_t lookups, uint64_t *found) {
+    tls_session_cache_entry_t out;
+    uint64_t state = 0xC0FFEE;
+    uint64_t hits = 0;
+
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < lookups; i++) {
+        const uint8_t *id = ids + (bench_rand(&state) % count) * BENCH_SESSION_ID_SIZE;
+        if (session_cache_retrieve(cache, id, BENCH_SESSION_ID_SIZE, &out) == 0) {
+            hits++;
+        }
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    *found = hits;
+    return (double)elapsed / (double)lookups;
+}
+
+/* Cache holding @p entries sessions from @p ids, return ns/insert */
+static session_cache_t *fill_cache(const uint8_t *ids, size_t entries, bool negative_filter,
+                                   double *insert_ns) {
+    // Headroom so uneven shard fill never evicts part of the working set
+    session_cache_config_t config = {
+        .capacity = entries * 2,
+        .timeout_secs = 3'600,
+        .negative_filter = negative_filter,
+    };
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    if (cache == nullptr) {
+        fprintf(stderr, "Failed to create cache\n");
+        exit(EXIT_FAILURE);
+    }
+
+    tls_session_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.session_id_size = BENCH_SESSION_ID_SIZE;
+    entry.session_data_size = BENCH_SESSION_DATA_SIZE;
+
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < entries; i++) {
+        memcpy(entry.session_id, ids + i * BENCH_SESSION_ID_SIZE, BENCH_SESSION_ID_SIZE);
+        if (session_cache_store(cache, &entry) != 0) {
+            fprintf(stderr, "Store failed at %zu entries\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    *insert_ns = (double)(bench_now_ns() - start) / (double)entries;
+
+    return cache;
+}
+
+int main(int argc, char *argv[]) {
+    size_t max_entries = BENCH_DEFAULT_MAX_ENTRIES;
+    size_t lookups = BENCH_DEFAULT_LOOKUPS;
+
+    if (argc > 1) {
+        max_entries = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        lookups = strtoull(argv[2], nullptr, 10);
+    }
+    if (max_entries < 1'000 || lookups == 0) {
+        fprintf(stderr, "Usage: %s [max_entries (>= 1000)] [lookups]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("Session Cache Lookup Latency Benchmark");
+    printf("Lookups per size: %zu (random IDs, single thread)\n\n", lookups);
+    printf("%-10s %12s %12s %12s %14s %14s %10s\n",
+           "entries", "hit ns/op", "miss ns/op", "insert ns/op", "bytes/session",
+           "filtered miss", "filter FP");
+
+    for (size_t entries = 1'000; entries <= max_entries; entries *= 10) {
+        uint8_t *ids = malloc(entries * BENCH_SESSION_ID_SIZE);
+        uint8_t *absent = malloc(entries * BENCH_SESSION_ID_SIZE);
+        if (ids == nullptr || absent == nullptr) {
+            fprintf(stderr, "Out of memory\n");
+            return EXIT_FAILURE;
+        }
+        make_ids(ids, entries, entries);
+        make_ids(absent, entries, ~entries);
+
+        double insert_ns = 0.0;
+        session_cache_t *cache = fill_cache(ids, entries, false, &insert_ns);
+
+        uint64_t hits = 0;
+        uint64_t false_hits = 0;
+        double hit_ns = time_lookups(cache, ids, entries, lookups, &hits);
+        double miss_ns = time_lookups(cache, absent, entries, lookups, &false_hits);
+
+        session_cache_stats_t stats;
+        session_cache_get_stats_ex(cache, &stats);
+        session_cache_free(cache);
+
+        // Same misses, answered by the negative filter
+        double filter_insert_ns = 0.0;
+        uint64_t filter_false_hits = 0;
+        session_cache_t *filtered = fill_cache(ids, entries, true, &filter_insert_ns);
+        double filter_miss_ns = time_lookups(filtered, absent, entries, lookups,
+                                             &filter_false_hits);
+
+        session_cache_stats_t filter_stats;
+        session_cache_get_stats_ex(filtered, &filter_stats);
+        session_cache_free(filtered);
+
+        printf("%-10zu %12.1f %12.1f %12.1f %14zu %14.1f %9.3f%%\n",
+               entries, hit_ns, miss_ns, insert_ns, stats.bytes_per_session,
+               filter_miss_ns, 100.0 * filter_stats.filter_false_positive_rate);
+        if (hits != lookups || false_hits != 0 || filter_false_hits != 0) {
+            fprintf(stderr, "Unexpected result: %llu/%zu hits, %llu false hits\n",
+                    (unsigned long long)hits, lookups,
+                    (unsigned long long)(false_hits + filter_false_hits));
+            return EXIT_FAILURE;
+        }
+
+        free(ids);
+        free(absent);
+    }
+
+    return EXIT_SUCCESS;
+}
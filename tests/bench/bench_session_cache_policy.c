@@ -0,0 +1,188 @@
+/*
+ * Session Cache Eviction Policy Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Replay a connection trace against the session cache with the LRU
+ *          and S3-FIFO eviction policies and compare resumption hit ratio and
+ *          throughput. Every trace record is one client connecting: it tries
+ *          to resume (session_cache_retrieve) and, on a miss, performs a full
+ *          handshake and stores a new session (session_cache_store).
+ *
+ *          Without a trace file a synthetic trace is generated: a population
+ *          of regularly reconnecting users with skewed popularity, mixed with
+ *          a flood of one-shot clients that never come back.
+ *
+ * Usage: bench_session_cache_policy [trace_file]
+ *
+ * Trace file format: one client key per line (decimal or 0x-prefixed hex,
+ * anything after the key is ignored).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/crypto/session_cache.h"
+#include "bench_common.h"
+
+/* Synthetic trace configuration */
+constexpr size_t BENCH_CAPACITY = 20'000;
+constexpr size_t BENCH_LOYAL_USERS = 30'000;
+constexpr size_t BENCH_TRACE_LENGTH = 2'000'000;
+constexpr unsigned int BENCH_ONE_SHOT_PERCENT = 50;
+constexpr size_t BENCH_SESSION_DATA_SIZE = 256;
+
+typedef struct {
+    uint64_t *keys;
+    size_t count;
+} trace_t;
+
+/* Synthetic trace: skewed loyal users (u^3 popularity) + one-shot flood */
+static int trace_generate(trace_t *trace) {
+    trace->count = BENCH_TRACE_LENGTH;
+    trace->keys = malloc(trace->count * sizeof(uint64_t));
+    if (trace->keys == nullptr) {
+        return -1;
+    }
+
+    uint64_t state = 0x5E55'1011;
+    uint64_t next_one_shot = BENCH_LOYAL_USERS;
+
+    for (size_t i = 0; i < trace->count; i++) {
+        if (bench_rand(&state) % 100 < BENCH_ONE_SHOT_PERCENT) {
+            trace->keys[i] = next_one_shot++;
+        } else {
+            double u = (double)(bench_rand(&state) >> 11) / (double)(1ULL << 53);
+            trace->keys[i] = (uint64_t)(u * u * u * (double)BENCH_LOYAL_USERS);
+        }
+    }
+
+    return 0;
+}
+
+static int trace_load(trace_t *trace, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (fp == nullptr) {
+        perror(path);
+        return -1;
+    }
+
+    size_t allocated = 1'024;
+    trace->count = 0;
+    trace->keys = malloc(allocated * sizeof(uint64_t));
+
+    char line[256];
+    while (trace->keys != nullptr && fgets(line, sizeof(line), fp) != nullptr) {
+        char *end = nullptr;
+        uint64_t key = strtoull(line, &end, 0);
+        if (end == line) {
+            continue;   // Blank or comment line
+        }
+
+        if (trace->count == allocated) {
+            allocated *= 2;
+            uint64_t *keys = realloc(trace->keys, allocated * sizeof(uint64_t));
+            if (keys == nullptr) {
+                free(trace->keys);
+                trace->keys = nullptr;
+                break;
+            }
+            trace->keys = keys;
+        }
+        trace->keys[trace->count++] = key;
+    }
+
+    fclose(fp);
+    return (trace->keys != nullptr && trace->count > 0) ? 0 : -1;
+}
+
+static void replay(const trace_t *trace, session_cache_policy_t policy, const char *name) {
+    session_cache_config_t config = {
+        .capacity = BENCH_CAPACITY,
+        .timeout_secs = 3'600,
+        .policy = policy,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    if (cache == nullptr) {
+        fprintf(stderr, "Failed to create cache\n");
+        exit(EXIT_FAILURE);
+    }
+
+    tls_session_cache_entry_t entry;
+    tls_session_cache_entry_t out;
+    memset(&entry, 0, sizeof(entry));
+    entry.session_id_size = 32;
+    entry.session_data_size = BENCH_SESSION_DATA_SIZE;
+
+    uint64_t resumed = 0;
+    uint64_t start = bench_now_ns();
+
+    for (size_t i = 0; i < trace->count; i++) {
+        // Session ID derived from the client key
+        uint64_t state = trace->keys[i] * 0x9E3779B97F4A7C15ULL + 1;
+        for (size_t j = 0; j < 32; j += sizeof(uint64_t)) {
+            uint64_t v = bench_rand(&state);
+            memcpy(entry.session_id + j, &v, sizeof(v));
+        }
+
+        if (session_cache_retrieve(cache, entry.session_id, 32, &out) == 0) {
+            resumed++;
+        } else if (session_cache_store(cache, &entry) != 0) {
+            fprintf(stderr, "Store failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+
+    session_cache_stats_t stats;
+    session_cache_get_stats_ex(cache, &stats);
+
+    printf("%-8s %10.2f%% %14.2f %12llu\n",
+           name,
+           100.0 * (double)resumed / (double)trace->count,
+           bench_ops_per_sec(trace->count, elapsed) / 1e6,
+           (unsigned long long)stats.evictions);
+
+    session_cache_free(cache);
+}
+
+int main(int argc, char *argv[]) {
+    trace_t trace = {0};
+
+    if (argc > 1) {
+        if (trace_load(&trace, argv[1]) != 0) {
+            fprintf(stderr, "Failed to load trace %s\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+    } else if (trace_generate(&trace) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("Session Cache Eviction Policy Benchmark");
+    if (argc > 1) {
+        printf("Trace: %s (%zu connections)\n", argv[1], trace.count);
+    } else {
+        printf("Trace: synthetic, %zu connections, %zu loyal users, %u%% one-shot\n",
+               trace.count, BENCH_LOYAL_USERS, BENCH_ONE_SHOT_PERCENT);
+    }
+    printf("Cache capacity: %zu\n\n", BENCH_CAPACITY);
+    printf("%-8s %11s %14s %12s\n", "policy", "hit ratio", "Mconn/s", "evictions");
+
+    replay(&trace, SESSION_CACHE_POLICY_LRU, "LRU");
+    replay(&trace, SESSION_CACHE_POLICY_S3FIFO, "S3-FIFO");
+
+    free(trace.keys);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*
+ * Session Cache Snapshot Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure how long a warm restart takes: fill a cache, write it with
+ *          session_cache_save(), then time session_cache_load() into a fresh
+ *          cache (the startup cost) and check that every session resumes.
+ *          A lookup thread runs during the save and reports the longest
+ *          lookup, i.e. how long a shard was held by the snapshot.
+ *
+ * Usage: bench_session_cache_snapshot [entries] [snapshot_path]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/crypto/session_cache.h"
+#include "bench_common.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_ENTRIES = 1'000'000;
+constexpr size_t BENCH_SESSION_DATA_SIZE = 192;     // Typical serialized session
+constexpr size_t BENCH_VERIFY_SAMPLE = 100'000;
+
+/* Deterministic 32-byte session ID for index @p n */
+static void make_session_id(uint8_t *id, uint64_t n) {
+    uint64_t state = n * 0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = 0; i < 32; i += sizeof(uint64_t)) {
+        uint64_t v = bench_rand(&state);
+        memcpy(id + i, &v, sizeof(v));
+    }
+}
+
+typedef struct {
+    session_cache_t *cache;
+    size_t entries;
+    atomic_bool stop;
+    uint64_t lookups;
+    uint64_t max_ns;
+} lookup_thread_t;
+
+// Look up random sessions until stopped, recording the slowest lookup
+static void *lookup_main(void *arg) {
+    lookup_thread_t *lt = arg;
+    uint64_t state = 0xFEED;
+    uint8_t session_id[32];
+    tls_session_cache_entry_t out;
+
+    while (!atomic_load_explicit(&lt->stop, memory_order_relaxed)) {
+        make_session_id(session_id, bench_rand(&state) % lt->entries);
+        uint64_t t0 = bench_now_ns();
+        (void)session_cache_retrieve(lt->cache, session_id, sizeof(session_id), &out);
+        uint64_t ns = bench_now_ns() - t0;
+        if (ns > lt->max_ns) {
+            lt->max_ns = ns;
+        }
+        lt->lookups++;
+    }
+    return nullptr;
+}
+
+static session_cache_t *new_cache(size_t entries) {
+    session_cache_config_t config = {
+        .capacity = entries * 2,    // Headroom for shard imbalance
+        .timeout_secs = 7'200,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    if (cache == nullptr) {
+        fprintf(stderr, "Failed to create cache\n");
+        exit(EXIT_FAILURE);
+    }
+    return cache;
+}
+
+int main(int argc, char *argv[]) {
+    size_t entries = BENCH_DEFAULT_ENTRIES;
+    char default_path[64];
+    const char *path = default_path;
+
+    snprintf(default_path, sizeof(default_path), "/tmp/bench-session-cache-%ld.snap",
+             (long)getpid());
+    if (argc > 1) {
+        entries = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        path = argv[2];
+    }
+    if (entries == 0) {
+        fprintf(stderr, "Usage: %s [entries] [snapshot_path]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("Session Cache Snapshot Benchmark");
+    printf("Entries: %zu, session data: %zu bytes, file: %s\n\n",
+           entries, BENCH_SESSION_DATA_SIZE, path);
+
+    session_cache_t *cache = new_cache(entries);
+
+    tls_session_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.session_id_size = 32;
+    entry.session_data_size = BENCH_SESSION_DATA_SIZE;
+    entry.expiration = time(nullptr) + 7'200;
+
+    for (size_t n = 0; n < entries; n++) {
+        make_session_id(entry.session_id, n);
+        memset(entry.session_data, (int)(n & 0xFF), entry.session_data_size);
+        if (session_cache_store(cache, &entry) != 0) {
+            fprintf(stderr, "Failed to populate cache\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    lookup_thread_t lt = {.cache = cache, .entries = entries};
+    pthread_t tid;
+    if (pthread_create(&tid, nullptr, lookup_main, &lt) != 0) {
+        fprintf(stderr, "pthread_create failed\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t saved = 0;
+    uint64_t start = bench_now_ns();
+    if (session_cache_save(cache, path, &saved) != 0) {
+        perror("session_cache_save");
+        return EXIT_FAILURE;
+    }
+    uint64_t save_ns = bench_now_ns() - start;
+    atomic_store(&lt.stop, true);
+    pthread_join(tid, nullptr);
+    session_cache_free(cache);
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    // Warm restart: a fresh cache replays the snapshot
+    cache = new_cache(entries);
+
+    size_t loaded = 0;
+    start = bench_now_ns();
+    if (session_cache_load(cache, path, &loaded) != 0) {
+        perror("session_cache_load");
+        return EXIT_FAILURE;
+    }
+    uint64_t load_ns = bench_now_ns() - start;
+
+    // Resumption after restart
+    size_t sample = entries < BENCH_VERIFY_SAMPLE ? entries : BENCH_VERIFY_SAMPLE;
+    size_t resumed = 0;
+    uint64_t state = 0xC0FFEE;
+    tls_session_cache_entry_t out;
+
+    for (size_t i = 0; i < sample; i++) {
+        make_session_id(entry.session_id, bench_rand(&state) % entries);
+        if (session_cache_retrieve(cache, entry.session_id, 32, &out) == 0) {
+            resumed++;
+        }
+    }
+
+    printf("%-10s %12s %14s %12s\n", "phase", "sessions", "time (ms)", "Msess/s");
+    printf("%-10s %12zu %14.1f %12.2f\n", "save", saved, (double)save_ns / 1e6,
+           bench_ops_per_sec(saved, save_ns) / 1e6);
+    printf("%-10s %12zu %14.1f %12.2f\n", "load", loaded, (double)load_ns / 1e6,
+           bench_ops_per_sec(loaded, load_ns) / 1e6);
+    printf("\nLookups during save: %llu, longest %.1f us\n",
+           (unsigned long long)lt.lookups, (double)lt.max_ns / 1e3);
+    printf("Snapshot size: %.1f MiB (%.0f bytes/session)\n",
+           (double)st.st_size / (1024.0 * 1024.0), (double)st.st_size / (double)saved);
+    printf("Resumption hit rate after restart: %.2f%% (%zu sampled)\n",
+           100.0 * (double)resumed / (double)sample, sample);
+
+    session_cache_free(cache);
+    if (argc <= 2) {
+        unlink(path);
+    }
+
+    return loaded == entries ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,146 @@
+/*
+ * TLS Allocator Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure allocate/free throughput of the session allocation path
+ *          (allocator_malloc/allocator_free) with the system heap and with
+ *          the per-thread arena, as the number of worker threads grows.
+ *          Each worker replays a TLS-like mix: many small handshake objects,
+ *          some key schedules and certificates, and record-sized buffers,
+ *          freed in random order. The arena should stay flat as threads
+ *          are added, where the global heap contends. This is the path all
+ *          wolfSSL session memory takes; with GnuTLS only the abstraction
+ *          layer's buffers do (GnuTLS ignores replacement allocators).
+ *
+ * Usage: bench_tls_alloc [max_threads] [duration_ms]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/crypto/allocator.h"
+#include "bench_common.h"
+
+/* Configuration */
+constexpr unsigned int BENCH_DEFAULT_MAX_THREADS = 8;
+constexpr unsigned int BENCH_MAX_THREADS = 256;
+constexpr unsigned int BENCH_DEFAULT_DURATION_MS = 1'000;
+constexpr size_t BENCH_LIVE_BLOCKS = 256;      // Blocks a worker holds at once
+
+/* Request sizes, weighted by how often a handshake asks for them */
+static const size_t bench_sizes[] = {
+    24, 32, 48, 64, 64, 96, 128, 128, 200, 256,
+    512, 800, 1'024, 1'500, 2'048, 4'096, 16'709, 18'432,
+};
+
+typedef struct {
+    atomic_bool *stop;
+    uint64_t seed;
+    uint64_t ops;
+} worker_t;
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    void *live[BENCH_LIVE_BLOCKS] = {nullptr};
+    uint64_t state = w->seed;
+
+    while (!atomic_load_explicit(w->stop, memory_order_relaxed)) {
+        // Batch to keep the stop-flag load out of the hot path
+        for (int i = 0; i < 256; i++) {
+            uint64_t r = bench_rand(&state);
+            size_t slot = r % BENCH_LIVE_BLOCKS;
+            allocator_free(live[slot]);
+            size_t size = bench_sizes[(r >> 32) % (sizeof(bench_sizes) / sizeof(bench_sizes[0]))];
+            live[slot] = allocator_malloc(size);
+            if (live[slot] == nullptr) {
+                fprintf(stderr, "Allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+            *(volatile uint8_t *)live[slot] = (uint8_t)r;  // Touch the block
+        }
+        w->ops += 256;
+    }
+
+    for (size_t i = 0; i < BENCH_LIVE_BLOCKS; i++) {
+        allocator_free(live[i]);
+    }
+    return nullptr;
+}
+
+static double run(unsigned int threads, unsigned int duration_ms) {
+    pthread_t tids[BENCH_MAX_THREADS];
+    worker_t workers[BENCH_MAX_THREADS];
+    atomic_bool stop = false;
+
+    for (unsigned int t = 0; t < threads; t++) {
+        workers[t] = (worker_t){
+            .stop = &stop,
+            .seed = 0x1234'5678ULL + t,
+            .ops = 0,
+        };
+        if (pthread_create(&tids[t], nullptr, worker_main, &workers[t]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    struct timespec ts = {
+        .tv_sec = duration_ms / 1'000,
+        .tv_nsec = (long)(duration_ms % 1'000) * 1'000'000L,
+    };
+    nanosleep(&ts, nullptr);
+    atomic_store(&stop, true);
+
+    uint64_t total = 0;
+    for (unsigned int t = 0; t < threads; t++) {
+        pthread_join(tids[t], nullptr);
+        total += workers[t].ops;
+    }
+
+    return bench_ops_per_sec(total, bench_now_ns() - start);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int max_threads = BENCH_DEFAULT_MAX_THREADS;
+    unsigned int duration_ms = BENCH_DEFAULT_DURATION_MS;
+
+    if (argc > 1) {
+        max_threads = (unsigned int)strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        duration_ms = (unsigned int)strtoul(argv[2], nullptr, 10);
+    }
+    if (max_threads == 0 || max_threads > BENCH_MAX_THREADS || duration_ms == 0) {
+        fprintf(stderr, "Usage: %s [max_threads (1-%u)] [duration_ms]\n", argv[0],
+                BENCH_MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("TLS Allocator Benchmark");
+    printf("Live blocks/thread: %zu, duration: %u ms/run\n\n", BENCH_LIVE_BLOCKS, duration_ms);
+
+    printf("%-8s %18s %18s\n", "threads", "system heap", "arena");
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        allocator_set(nullptr);
+        double system_ops = run(threads, duration_ms);
+        allocator_set(tls_arena_allocator());
+        double arena_ops = run(threads, duration_ms);
+        printf("%-8u %14.2f M/s %14.2f M/s\n", threads, system_ops / 1e6, arena_ops / 1e6);
+        fflush(stdout);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+/*
+ * Certificate Reload Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Show that rotating the server certificate and key through
+ *          context generations (context_gen_t) does not stall handshakes.
+ *          Full handshakes run back to back while the context is:
+ *
+ *            static    never replaced
+ *            inline    rebuilt on the connection path every
+ *                      BENCH_RELOAD_MS (a server that reloads between
+ *                      accepts), so the handshake after it waits
+ *            rcu       rebuilt by a reloader thread every BENCH_RELOAD_MS
+ *                      and published with context_gen_publish()
+ *
+ *          Reported per mode: handshakes/s, latency percentiles, reloads,
+ *          and for rcu the longest grace period the reloader waited. The
+ *          cost of context_gen_acquire() on its own is printed last.
+ *
+ * Usage: bench_tls_cert_reload [handshakes] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../src/crypto/context_gen.h"
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_HANDSHAKES = 5'000;
+constexpr unsigned int BENCH_RELOAD_MS = 50;
+constexpr size_t BENCH_ACQUIRES = 1'000'000;
+
+typedef enum {
+    MODE_STATIC,
+    MODE_INLINE,
+    MODE_RCU,
+} bench_mode_t;
+
+static const char *const mode_names[] = {"static", "inline", "rcu"};
+
+typedef struct {
+    context_gen_t *gen;
+    atomic_bool stop;
+    uint64_t reloads;
+} reloader_t;
+
+static tls_context_t *build_context(void *userdata) {
+    return bench_tls_server_context(userdata);
+}
+
+static void *reloader_main(void *arg) {
+    reloader_t *rl = arg;
+    struct timespec interval = {.tv_nsec = (long)BENCH_RELOAD_MS * 1'000'000L};
+
+    while (!atomic_load_explicit(&rl->stop, memory_order_relaxed)) {
+        nanosleep(&interval, nullptr);
+        if (context_gen_reload(rl->gen) == 0) {
+            rl->reloads++;
+        }
+    }
+    return nullptr;
+}
+
+// One full handshake and a byte from the server; 0 on success
+static int connect_once(tls_context_t *server_ctx, tls_context_t *client_ctx) {
+    bench_tls_pair_t pair;
+    int result = -1;
+
+    if (bench_tls_pair_open(&pair, server_ctx, client_ctx) == 0 &&
+        tls_send(pair.server, "x", 1) == 1) {
+        uint8_t byte;
+        ssize_t got;
+        do {
+            got = tls_recv(pair.client, &byte, 1);
+        } while (got == TLS_E_AGAIN || got == TLS_E_INTERRUPTED);
+        result = got == 1 ? 0 : -1;
+    }
+
+    bench_tls_pair_close(&pair);
+    return result;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    size_t handshakes = BENCH_DEFAULT_HANDSHAKES;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        handshakes = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (handshakes == 0) {
+        fprintf(stderr, "Usage: %s [handshakes] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bench_tls_init();
+    tls_context_t *client_ctx = bench_tls_client_context();
+
+    context_gen_config_t config = {.build = build_context, .userdata = (void *)cert_dir};
+    context_gen_t *gen = context_gen_new(&config);
+    uint64_t *latency = calloc(handshakes, sizeof(*latency));
+    if (gen == nullptr || latency == nullptr) {
+        fprintf(stderr, "Failed to set up the context holder\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("Certificate Reload Benchmark");
+    printf("Backend: %s, full handshakes per mode: %zu, reload every %u ms\n\n",
+           tls_get_version_string(), handshakes, BENCH_RELOAD_MS);
+    printf("%-8s %10s %9s %9s %9s %8s %9s\n", "mode", "hs/s", "p50 us", "p99 us",
+           "max us", "reloads", "grace us");
+
+    for (bench_mode_t mode = MODE_STATIC; mode <= MODE_RCU; mode++) {
+        reloader_t rl = {.gen = gen};
+        pthread_t tid;
+        if (mode == MODE_RCU && pthread_create(&tid, nullptr, reloader_main, &rl) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            return EXIT_FAILURE;
+        }
+        context_gen_stats_t before;
+        context_gen_get_stats(gen, &before);
+
+        uint64_t inline_reloads = 0;
+        uint64_t start = bench_now_ns();
+        uint64_t next_reload = start + (uint64_t)BENCH_RELOAD_MS * 1'000'000ULL;
+        for (size_t i = 0; i < handshakes; i++) {
+            uint64_t t0 = bench_now_ns();
+            if (mode == MODE_INLINE && t0 >= next_reload) {
+                // The connection waits for the rebuild
+                (void)context_gen_publish(gen, build_context((void *)cert_dir));
+                inline_reloads++;
+                next_reload = t0 + (uint64_t)BENCH_RELOAD_MS * 1'000'000ULL;
+            }
+            tls_context_t *server_ctx = context_gen_acquire(gen);
+            int ret = connect_once(server_ctx, client_ctx);
+            tls_context_free(server_ctx);
+            latency[i] = bench_now_ns() - t0;
+            if (ret != 0) {
+                fprintf(stderr, "Handshake %zu failed\n", i);
+                return EXIT_FAILURE;
+            }
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+
+        if (mode == MODE_RCU) {
+            atomic_store(&rl.stop, true);
+            pthread_join(tid, nullptr);
+        }
+        context_gen_stats_t after;
+        context_gen_get_stats(gen, &after);
+
+        qsort(latency, handshakes, sizeof(*latency), compare_u64);
+        printf("%-8s %10.0f %9.1f %9.1f %9.1f %8llu %9.1f\n", mode_names[mode],
+               bench_ops_per_sec(handshakes, elapsed),
+               (double)latency[handshakes / 2] / 1e3,
+               (double)latency[handshakes * 99 / 100] / 1e3,
+               (double)latency[handshakes - 1] / 1e3,
+               (unsigned long long)(mode == MODE_RCU ? rl.reloads : inline_reloads),
+               mode == MODE_RCU ? (double)after.max_grace_ns / 1e3 : 0.0);
+        fflush(stdout);
+
+        if (after.failures != before.failures) {
+            fprintf(stderr, "%llu reloads failed\n",
+                    (unsigned long long)(after.failures - before.failures));
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The read side on its own
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < BENCH_ACQUIRES; i++) {
+        tls_context_free(context_gen_acquire(gen));
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    printf("\ncontext_gen_acquire + release: %.1f ns\n",
+           (double)elapsed / (double)BENCH_ACQUIRES);
+
+    context_gen_free(gen);
+    free(latency);
+    tls_context_free(client_ctx);
+    tls_global_deinit();
+    return EXIT_SUCCESS;
+}
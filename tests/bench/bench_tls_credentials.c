@@ -0,0 +1,221 @@
+/*
+ * Shared Credentials Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure the startup cost of many server contexts with the same
+ *          certificate (worker processes, virtual hosts), created by:
+ *
+ *            file      tls_context_set_cert_file()/set_key_file() each
+ *            memory    tls_context_set_cert_mem()/set_key_mem() from one
+ *                      buffer read once
+ *            shared    one tls_credentials_new(), then
+ *                      tls_context_set_credentials() each
+ *
+ *          Reported per mode: total time to create and configure all
+ *          contexts, time per context, and resident memory they added
+ *          (each mode runs in its own process, so no mode reuses heap
+ *          another freed). One handshake on the last context checks it is
+ *          usable.
+ *
+ * Usage: bench_tls_credentials [contexts] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_CONTEXTS = 1'000;
+constexpr size_t BENCH_MAX_PEM = 16'384;
+
+typedef enum {
+    MODE_FILE,
+    MODE_MEMORY,
+    MODE_SHARED,
+} bench_mode_t;
+
+static const char *const mode_names[] = {"file", "memory", "shared"};
+
+static size_t read_pem(const char *path, char *buf, size_t size) {
+    FILE *fp = fopen(path, "r");
+    if (fp == nullptr) {
+        return 0;
+    }
+    size_t len = fread(buf, 1, size, fp);
+    fclose(fp);
+    return len;
+}
+
+// Resident set size in bytes (0 if unknown)
+static size_t resident_bytes(void) {
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp == nullptr) {
+        return 0;
+    }
+    if (fscanf(fp, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(fp);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+typedef struct {
+    const char *cert_path;
+    const char *key_path;
+    const char *cert;
+    size_t cert_size;
+    const char *key;
+    size_t key_size;
+} bench_source_t;
+
+// Create @p count contexts in @p mode and print their row; 0 on success
+static int run_mode(bench_mode_t mode, const bench_source_t *src, size_t count) {
+    tls_context_t *client_ctx = bench_tls_client_context();
+    tls_context_t **contexts = calloc(count, sizeof(*contexts));
+    if (contexts == nullptr) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+
+    size_t rss_before = resident_bytes();
+    uint64_t start = bench_now_ns();
+
+    tls_credentials_t *creds = nullptr;
+    if (mode == MODE_SHARED) {
+        creds = tls_credentials_new(src->cert, src->cert_size, src->key, src->key_size);
+        if (creds == nullptr) {
+            fprintf(stderr, "tls_credentials_new failed\n");
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        tls_context_t *ctx = tls_context_new(true, false);
+        int ret = TLS_E_MEMORY_ERROR;
+        if (ctx != nullptr) {
+            switch (mode) {
+            case MODE_FILE:
+                ret = tls_context_set_cert_file(ctx, src->cert_path);
+                if (ret == TLS_E_SUCCESS) {
+                    ret = tls_context_set_key_file(ctx, src->key_path);
+                }
+                break;
+            case MODE_MEMORY:
+                ret = tls_context_set_cert_mem(ctx, src->cert, src->cert_size);
+                if (ret == TLS_E_SUCCESS) {
+                    ret = tls_context_set_key_mem(ctx, src->key, src->key_size);
+                }
+                break;
+            case MODE_SHARED:
+                ret = tls_context_set_credentials(ctx, creds);
+                break;
+            }
+        }
+        if (ret != TLS_E_SUCCESS) {
+            fprintf(stderr, "Context %zu failed: %s\n", i, tls_strerror(ret));
+            return -1;
+        }
+        contexts[i] = ctx;
+    }
+    tls_credentials_free(creds);    // The contexts hold their own references
+
+    uint64_t elapsed = bench_now_ns() - start;
+    size_t rss_after = resident_bytes();
+
+    bench_tls_pair_t pair;
+    if (bench_tls_pair_open(&pair, contexts[count - 1], client_ctx) != 0) {
+        fprintf(stderr, "Handshake on a %s context failed\n", mode_names[mode]);
+        return -1;
+    }
+    bench_tls_pair_close(&pair);
+
+    printf("%-8s %10.1f %12.1f %12zu\n", mode_names[mode], (double)elapsed / 1e6,
+           (double)elapsed / 1e3 / (double)count,
+           rss_after > rss_before ? (rss_after - rss_before) / 1'024 : 0);
+    fflush(stdout);
+
+    for (size_t i = 0; i < count; i++) {
+        tls_context_free(contexts[i]);
+    }
+    free(contexts);
+    tls_context_free(client_ctx);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = BENCH_DEFAULT_CONTEXTS;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        count = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (count == 0) {
+        fprintf(stderr, "Usage: %s [contexts] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char cert_path[512];
+    char key_path[512];
+    snprintf(cert_path, sizeof(cert_path), "%s/server-cert.pem", cert_dir);
+    snprintf(key_path, sizeof(key_path), "%s/server-key.pem", cert_dir);
+
+    static char cert[BENCH_MAX_PEM];
+    static char key[BENCH_MAX_PEM];
+    bench_source_t src = {
+        .cert_path = cert_path,
+        .key_path = key_path,
+        .cert = cert,
+        .cert_size = read_pem(cert_path, cert, sizeof(cert)),
+        .key = key,
+        .key_size = read_pem(key_path, key, sizeof(key)),
+    };
+    if (src.cert_size == 0 || src.key_size == 0) {
+        fprintf(stderr, "Failed to read certificates in %s\n", cert_dir);
+        return EXIT_FAILURE;
+    }
+
+    bench_tls_init();
+    bench_banner("Shared Credentials Benchmark");
+    printf("Backend: %s, server contexts per mode: %zu\n\n", tls_get_version_string(), count);
+    printf("%-8s %10s %12s %12s\n", "mode", "total ms", "us/context", "RSS KiB");
+    fflush(stdout);
+
+    int status = EXIT_SUCCESS;
+    for (bench_mode_t mode = MODE_FILE; mode <= MODE_SHARED; mode++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (pid == 0) {
+            _exit(run_mode(mode, &src, count) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        int wstatus;
+        if (waitpid(pid, &wstatus, 0) != pid || !WIFEXITED(wstatus) ||
+            WEXITSTATUS(wstatus) != EXIT_SUCCESS) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    tls_global_deinit();
+    return status;
+}
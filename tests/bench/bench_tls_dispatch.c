@@ -0,0 +1,158 @@
+/*
+ * Backend Dispatch Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure the cost of calling the TLS API through the backend
+ *          operations table, and compare every compiled-in backend in one
+ *          process. For each backend:
+ *
+ *            api       tls_session_get_ptr() - a direct call in a
+ *                      single-backend build, dispatcher + indirect call in
+ *                      a dual-backend build (make BACKEND=dual)
+ *            ops       the same function through tls_backend_get_ops(),
+ *                      i.e. one indirect call
+ *            record    64-byte tls_send() + tls_recv() round trip over a
+ *                      socketpair, to put the call overhead in proportion
+ *
+ *          Build once with a single backend and once with BACKEND=dual and
+ *          compare the api rows: the difference is the dispatch overhead.
+ *
+ * Usage: bench_tls_dispatch [calls] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../src/crypto/tls_backend.h"
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_CALLS = 50'000'000;
+constexpr size_t BENCH_RECORD_SIZE = 64;
+
+static const tls_backend_t BENCH_BACKENDS[] = {
+#ifdef USE_GNUTLS
+    TLS_BACKEND_GNUTLS,
+#endif
+#ifdef USE_WOLFSSL
+    TLS_BACKEND_WOLFSSL,
+#endif
+};
+
+static uint64_t run_api(tls_session_t *session, size_t calls) {
+    uintptr_t sink = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < calls; i++) {
+        sink += (uintptr_t)tls_session_get_ptr(session);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    *(volatile uintptr_t *)&sink = sink;
+    return elapsed;
+}
+
+static uint64_t run_ops(tls_session_t *session, size_t calls) {
+    const tls_backend_ops_t *ops = tls_backend_get_ops();
+    uintptr_t sink = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < calls; i++) {
+        sink += (uintptr_t)ops->op_session_get_ptr(session);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    *(volatile uintptr_t *)&sink = sink;
+    return elapsed;
+}
+
+// Record round trips; returns elapsed ns, 0 on failure
+static uint64_t run_records(bench_tls_pair_t *pair, size_t count) {
+    uint8_t buf[BENCH_RECORD_SIZE] = {0};
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        if (tls_send(pair->client, buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+            return 0;
+        }
+        size_t got = 0;
+        while (got < sizeof(buf)) {
+            ssize_t n = tls_recv(pair->server, buf + got, sizeof(buf) - got);
+            if (n <= 0) {
+                return 0;
+            }
+            got += (size_t)n;
+        }
+    }
+    return bench_now_ns() - start;
+}
+
+int main(int argc, char *argv[]) {
+    size_t calls = BENCH_DEFAULT_CALLS;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        calls = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (calls == 0) {
+        fprintf(stderr, "Usage: %s [calls] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    size_t records = calls / 500 > 0 ? calls / 500 : 1;
+
+    bench_banner("Backend Dispatch Benchmark");
+#ifdef TLS_DUAL_BACKEND
+    printf("Build: dual backend (API calls dispatched)\n");
+#else
+    printf("Build: single backend (API calls direct)\n");
+#endif
+    printf("Calls per run: %zu, %zu-byte records: %zu\n\n", calls, BENCH_RECORD_SIZE, records);
+    printf("%-22s %-8s %14s %10s\n", "backend", "path", "Mcalls/s", "ns/call");
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t b = 0; b < sizeof(BENCH_BACKENDS) / sizeof(BENCH_BACKENDS[0]); b++) {
+        bench_tls_init_backend(BENCH_BACKENDS[b]);
+        tls_context_t *server_ctx = bench_tls_server_context(cert_dir);
+        tls_context_t *client_ctx = bench_tls_client_context();
+        const char *version = tls_get_version_string();
+
+        bench_tls_pair_t pair;
+        if (bench_tls_pair_open(&pair, server_ctx, client_ctx) != 0) {
+            fprintf(stderr, "Handshake failed (%s)\n", version);
+            return EXIT_FAILURE;
+        }
+        tls_session_set_ptr(pair.server, &pair);
+
+        uint64_t elapsed = run_api(pair.server, calls);
+        printf("%-22s %-8s %14.1f %10.2f\n", version, "api",
+               bench_ops_per_sec(calls, elapsed) / 1e6, (double)elapsed / (double)calls);
+        elapsed = run_ops(pair.server, calls);
+        printf("%-22s %-8s %14.1f %10.2f\n", version, "ops",
+               bench_ops_per_sec(calls, elapsed) / 1e6, (double)elapsed / (double)calls);
+        elapsed = run_records(&pair, records);
+        if (elapsed == 0) {
+            fprintf(stderr, "Record exchange failed (%s)\n", version);
+            status = EXIT_FAILURE;
+        } else {
+            printf("%-22s %-8s %14.3f %10.0f\n", version, "record",
+                   bench_ops_per_sec(records, elapsed) / 1e6, (double)elapsed / (double)records);
+        }
+        fflush(stdout);
+
+        bench_tls_pair_close(&pair);
+        tls_context_free(client_ctx);
+        tls_context_free(server_ctx);
+        tls_global_deinit();
+    }
+
+    return status;
+}
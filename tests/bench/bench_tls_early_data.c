@@ -0,0 +1,328 @@
+/*
+ * 0-RTT Early Data Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Time to first tunnel byte on a reconnect, with and without 0-RTT.
+ *          Client and server are joined by memory BIOs and driven flight by
+ *          flight, so each connection yields its CPU time and the number of
+ *          one-way trips until
+ *
+ *            request   the client's first tunnel packet is at the server
+ *            ready     the server may send (handshake complete)
+ *
+ *          The server forwards the request into the tunnel and the answer
+ *          takes the upstream time U; the first tunnel byte reaches the
+ *          client at max(ready, request + U) + one trip. With a one-way
+ *          latency L this is modeled as CPU time + trips x L:
+ *
+ *            full      full handshake, request after it
+ *            resumed   ticket resumption, request after it (1-RTT)
+ *            0-rtt     ticket resumption, request as early data, checked
+ *                      against an anti_replay_t filter (sent again after
+ *                      the handshake if the server rejects it)
+ *
+ *          The cost of the filter itself is reported last.
+ *
+ * Usage: bench_tls_early_data [connections] [one_way_ms] [upstream_ms] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/crypto/anti_replay.h"
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_CONNECTIONS = 1'000;
+constexpr double BENCH_DEFAULT_ONE_WAY_MS = 25.0;
+constexpr double BENCH_DEFAULT_UPSTREAM_MS = 50.0;
+constexpr size_t BENCH_EARLY_DATA_MAX = 16'384;
+constexpr unsigned int BENCH_LIFETIME_SECS = 3'600;
+constexpr size_t BENCH_FILTER_CHECKS = 1'000'000;
+constexpr int BENCH_MAX_ROUNDS = 16;
+
+static const char BENCH_REQUEST[] = "CONNECT 10.0.0.1:443\r\n\r\n";
+static const char BENCH_REPLY[] = "200\r\n\r\n";
+
+typedef enum { MODE_FULL, MODE_RESUMED, MODE_EARLY } bench_mode_t;
+
+static const char *const BENCH_MODE_NAMES[] = {"full", "resumed", "0-rtt"};
+
+typedef struct {
+    uint8_t data[TLS_MAX_SESSION_DATA_SIZE];
+    size_t size;
+} saved_session_t;
+
+typedef struct {
+    uint64_t cpu_ns;
+    int request_trips;          // Request at the server
+    int ready_trips;            // Server handshake complete
+    bool early_accepted;
+} connection_result_t;
+
+/* Move pending ciphertext across; one trip if anything moved */
+static int pump(tls_session_t *from, tls_session_t *to, int *trips) {
+    uint8_t buffer[16'384];
+    bool moved = false;
+    ssize_t n;
+    while ((n = tls_session_drain(from, buffer, sizeof(buffer))) > 0) {
+        if (tls_session_feed(to, buffer, (size_t)n) != n) {
+            return -1;
+        }
+        moved = true;
+    }
+    *trips += moved ? 1 : 0;
+    return n == 0 ? 0 : -1;
+}
+
+static inline bool handshaking(int ret) {
+    return ret == TLS_E_SUCCESS || ret == TLS_E_WANT_READ || ret == TLS_E_AGAIN;
+}
+
+/**
+ * One connection, flight by flight. With @p ticket the client resumes and
+ * the ticket is replaced by the one the connection yields.
+ *
+ * @return 0 on success, -1 on failure
+ */
+static int connect_once(tls_context_t *server_ctx, tls_context_t *client_ctx,
+                        bench_mode_t mode, saved_session_t *ticket,
+                        connection_result_t *result) {
+    *result = (connection_result_t){.request_trips = -1, .ready_trips = -1};
+    uint64_t start = bench_now_ns();
+
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    bool ok = server != nullptr && client != nullptr &&
+              tls_session_set_memory_bio(server) == TLS_E_SUCCESS &&
+              tls_session_set_memory_bio(client) == TLS_E_SUCCESS &&
+              (mode == MODE_FULL ||
+               tls_session_set_data(client, ticket->data, ticket->size) == TLS_E_SUCCESS);
+    bool early = mode == MODE_EARLY;
+    if (ok && early) {
+        ok = tls_session_write_early_data(client, BENCH_REQUEST, sizeof(BENCH_REQUEST) - 1) ==
+             (ssize_t)(sizeof(BENCH_REQUEST) - 1);
+    }
+
+    int trips = 0;
+    int client_ret = TLS_E_WANT_READ;
+    int server_ret = TLS_E_WANT_READ;
+    bool request_sent = early;
+    char buffer[64];
+
+    for (int round = 0; ok && round < BENCH_MAX_ROUNDS && result->request_trips < 0; round++) {
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+            // Rejected early data is the client's to send again
+            if (client_ret == TLS_E_SUCCESS && early) {
+                tls_connection_info_t info;
+                request_sent = tls_get_connection_info(client, &info) == TLS_E_SUCCESS &&
+                               info.early_data_accepted;
+            }
+        }
+        if (client_ret == TLS_E_SUCCESS && !request_sent) {
+            ok = tls_send(client, BENCH_REQUEST, sizeof(BENCH_REQUEST) - 1) ==
+                 (ssize_t)(sizeof(BENCH_REQUEST) - 1);
+            request_sent = true;
+        }
+        ok = ok && handshaking(client_ret) && pump(client, server, &trips) == 0;
+
+        if (ok && server_ret != TLS_E_SUCCESS) {
+            server_ret = tls_handshake(server);
+            if (server_ret == TLS_E_SUCCESS) {
+                result->ready_trips = trips;
+            }
+        }
+        ssize_t got = 0;
+        if (ok && early) {
+            got = tls_session_read_early_data(server, buffer, sizeof(buffer));
+        }
+        if (ok && got == 0 && server_ret == TLS_E_SUCCESS) {
+            got = tls_recv(server, buffer, sizeof(buffer));
+            got = got == TLS_E_AGAIN ? 0 : got;
+        }
+        if (got > 0) {
+            result->request_trips = trips;
+        }
+        ok = ok && handshaking(server_ret) && got >= 0 && pump(server, client, &trips) == 0;
+    }
+
+    // Finish the handshake, answer, and keep the client's newest ticket
+    for (int round = 0; ok && round < BENCH_MAX_ROUNDS && server_ret != TLS_E_SUCCESS; round++) {
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+        }
+        ok = handshaking(client_ret) && pump(client, server, &trips) == 0;
+        if (ok) {
+            server_ret = tls_handshake(server);
+            if (server_ret == TLS_E_SUCCESS) {
+                result->ready_trips = trips;
+            }
+        }
+        ok = ok && handshaking(server_ret) && pump(server, client, &trips) == 0;
+    }
+    ok = ok && result->request_trips >= 0 && server_ret == TLS_E_SUCCESS &&
+         tls_send(server, BENCH_REPLY, sizeof(BENCH_REPLY) - 1) ==
+             (ssize_t)(sizeof(BENCH_REPLY) - 1);
+    ok = ok && pump(server, client, &trips) == 0;
+    ssize_t got = TLS_E_AGAIN;
+    for (int i = 0; ok && got == TLS_E_AGAIN && i < 8; i++) {
+        got = tls_recv(client, buffer, sizeof(buffer));
+    }
+    ok = ok && got == (ssize_t)(sizeof(BENCH_REPLY) - 1);
+
+    tls_connection_info_t info;
+    ok = ok && tls_get_connection_info(server, &info) == TLS_E_SUCCESS &&
+         info.session_resumed == (mode != MODE_FULL);
+    result->early_accepted = ok && info.early_data_accepted;
+    if (ok && ticket != nullptr) {
+        ticket->size = sizeof(ticket->data);
+        ok = tls_session_get_data(client, ticket->data, &ticket->size) == TLS_E_SUCCESS;
+    }
+
+    tls_session_free(client);
+    tls_session_free(server);
+    result->cpu_ns = bench_now_ns() - start;
+    return ok ? 0 : -1;
+}
+
+/* Modeled time to first tunnel byte at the client, in ms */
+static double first_byte_ms(const connection_result_t *result, double one_way_ms,
+                            double upstream_ms) {
+    double ready = result->ready_trips * one_way_ms;
+    double answer = result->request_trips * one_way_ms + upstream_ms;
+    return (ready > answer ? ready : answer) + one_way_ms + (double)result->cpu_ns / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    size_t connections = BENCH_DEFAULT_CONNECTIONS;
+    double one_way_ms = BENCH_DEFAULT_ONE_WAY_MS;
+    double upstream_ms = BENCH_DEFAULT_UPSTREAM_MS;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        connections = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        one_way_ms = strtod(argv[2], nullptr);
+    }
+    if (argc > 3) {
+        upstream_ms = strtod(argv[3], nullptr);
+    }
+    if (argc > 4) {
+        cert_dir = argv[4];
+    }
+    if (connections == 0 || one_way_ms < 0 || upstream_ms < 0) {
+        fprintf(stderr, "Usage: %s [connections] [one_way_ms] [upstream_ms] [cert_dir]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bench_tls_init();
+    tls_context_t *server_ctx = bench_tls_server_context(cert_dir);
+    tls_context_t *client_ctx = bench_tls_client_context();
+    tls_context_t *early_ctx = bench_tls_client_context();     // Offers 0-RTT when it can
+    anti_replay_t *filter = anti_replay_new(connections, TLS_EARLY_DATA_WINDOW_MS);
+
+    uint8_t secret[32];
+    memset(secret, 0xa5, sizeof(secret));
+    tls_datum_t key = {.data = secret, .size = sizeof(secret)};
+    if (filter == nullptr ||
+        tls_context_set_nonblocking(server_ctx, true) != TLS_E_SUCCESS ||
+        tls_context_set_nonblocking(client_ctx, true) != TLS_E_SUCCESS ||
+        tls_context_set_nonblocking(early_ctx, true) != TLS_E_SUCCESS ||
+        tls_context_set_ticket_keys(server_ctx, &key, 1, BENCH_LIFETIME_SECS) != TLS_E_SUCCESS ||
+        tls_context_set_early_data(server_ctx, BENCH_EARLY_DATA_MAX, anti_replay_check,
+                                   filter) != TLS_E_SUCCESS ||
+        tls_context_set_early_data(early_ctx, BENCH_EARLY_DATA_MAX, nullptr,
+                                   nullptr) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to enable early data\n");
+        return EXIT_FAILURE;
+    }
+
+    saved_session_t ticket;
+    connection_result_t result;
+    if (connect_once(server_ctx, client_ctx, MODE_FULL, &ticket, &result) != 0) {
+        fprintf(stderr, "Initial handshake failed\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("0-RTT Early Data Benchmark");
+    printf("Backend: %s, connections per mode: %zu\n", tls_get_version_string(), connections);
+    printf("Model: one-way latency %.1f ms, upstream answer %.1f ms\n\n", one_way_ms,
+           upstream_ms);
+    printf("%-8s %9s %9s %9s %9s %12s\n", "mode", "cpu us", "request", "ready", "0-rtt",
+           "first byte");
+    printf("%-8s %9s %9s %9s %9s %12s\n", "", "", "trips", "trips", "accepted", "ms");
+
+    for (bench_mode_t mode = MODE_FULL; mode <= MODE_EARLY; mode++) {
+        uint64_t cpu_ns = 0;
+        double first_byte = 0;
+        size_t accepted = 0;
+        connection_result_t last = {0};
+
+        for (size_t i = 0; i < connections; i++) {
+            if (connect_once(server_ctx, mode == MODE_EARLY ? early_ctx : client_ctx, mode,
+                             mode == MODE_FULL ? nullptr : &ticket, &last) != 0) {
+                fprintf(stderr, "%s connection %zu failed\n", BENCH_MODE_NAMES[mode], i);
+                return EXIT_FAILURE;
+            }
+            cpu_ns += last.cpu_ns;
+            first_byte += first_byte_ms(&last, one_way_ms, upstream_ms);
+            accepted += last.early_accepted ? 1 : 0;
+        }
+
+        printf("%-8s %9.1f %9d %9d %8.1f%% %12.2f\n", BENCH_MODE_NAMES[mode],
+               (double)cpu_ns / (double)connections / 1e3, last.request_trips,
+               last.ready_trips, 100.0 * (double)accepted / (double)connections,
+               first_byte / (double)connections);
+        fflush(stdout);
+    }
+
+    // The filter on its own, at its configured load and well past it
+    anti_replay_stats_t stats;
+    anti_replay_get_stats(filter, &stats);
+    printf("\nFilter: %zu keys per window, %zu KB, %llu checked, %llu replays\n",
+           stats.capacity, stats.memory_bytes / 1'024, (unsigned long long)stats.checked,
+           (unsigned long long)stats.replays);
+
+    anti_replay_t *load = anti_replay_new(BENCH_FILTER_CHECKS, TLS_EARLY_DATA_WINDOW_MS);
+    if (load == nullptr) {
+        fprintf(stderr, "Failed to create filter\n");
+        return EXIT_FAILURE;
+    }
+    uint64_t state = 1;
+    uint64_t key_words[4];
+    size_t seen = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < BENCH_FILTER_CHECKS; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            key_words[j] = bench_rand(&state);
+        }
+        seen += (size_t)anti_replay_check(load, (const uint8_t *)key_words, sizeof(key_words));
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    anti_replay_get_stats(load, &stats);
+    printf("Check: %.1f ns per 32-byte binder, %zu fresh keys, %.3f%% false replays, %zu KB\n",
+           (double)elapsed / (double)BENCH_FILTER_CHECKS, BENCH_FILTER_CHECKS,
+           100.0 * (double)seen / (double)BENCH_FILTER_CHECKS, stats.memory_bytes / 1'024);
+
+    anti_replay_free(load);
+    tls_context_free(early_ctx);
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    anti_replay_free(filter);
+    tls_global_deinit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,331 @@
+/*
+ * Non-Blocking Handshake Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Run many concurrent server handshakes on one thread over
+ *          non-blocking socketpairs and compare two event loops:
+ *
+ *            spin   call tls_handshake() on every unfinished session until
+ *                   all are done (what a loop that only sees TLS_E_AGAIN
+ *                   has to do)
+ *            epoll  tls_context_set_nonblocking(): wait in epoll for the
+ *                   readiness named by TLS_E_WANT_READ / TLS_E_WANT_WRITE
+ *                   and only call tls_handshake() on sessions that can move
+ *
+ *          The clients run in a second thread that answers each batch of
+ *          flights after a simulated round trip, so server sessions really
+ *          wait. Reported for the server thread: handshakes per second,
+ *          tls_handshake() calls per session and CPU time per handshake.
+ *
+ * Usage: bench_tls_handshake_epoll [connections] [rtt_us] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_CONNECTIONS = 1'000;
+constexpr unsigned long BENCH_DEFAULT_RTT_US = 1'000;
+constexpr int BENCH_EPOLL_BATCH = 256;
+constexpr uint64_t BENCH_STALL_NS = 60'000'000'000;     // Give up on a run after 60 s
+
+typedef enum {
+    MODE_SPIN,
+    MODE_EPOLL,
+} loop_mode_t;
+
+static const char *const MODE_NAMES[] = {"spin", "epoll"};
+
+typedef struct {
+    tls_session_t *session;
+    int fd;
+    int result;                 // Last tls_handshake() return
+} endpoint_t;
+
+typedef struct {
+    endpoint_t *endpoints;
+    size_t count;
+    uint64_t rtt_ns;            // Pause before answering each batch (clients only)
+    uint64_t calls;             // tls_handshake() calls
+    bool stalled;
+} event_loop_t;
+
+static bool is_waiting(int result) {
+    return result == TLS_E_AGAIN || result == TLS_E_INTERRUPTED ||
+           result == TLS_E_WANT_READ || result == TLS_E_WANT_WRITE;
+}
+
+static uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1'000'000'000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Step one endpoint and re-arm it for the readiness its handshake wants
+ *
+ * @return true while the endpoint is still handshaking
+ */
+static bool step_epoll(int epfd, endpoint_t *endpoint, event_loop_t *loop) {
+    endpoint->result = tls_handshake(endpoint->session);
+    loop->calls++;
+
+    if (endpoint->result != TLS_E_WANT_READ && endpoint->result != TLS_E_WANT_WRITE) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, endpoint->fd, nullptr);
+        return false;
+    }
+
+    struct epoll_event event = {
+        .events = (endpoint->result == TLS_E_WANT_READ ? EPOLLIN : EPOLLOUT) | EPOLLONESHOT,
+        .data.ptr = endpoint,
+    };
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, endpoint->fd, &event) != 0) {
+        perror("epoll_ctl");
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+/**
+ * Handshake all endpoints of @p loop, sleeping in epoll between steps
+ */
+static void run_epoll(event_loop_t *loop) {
+    int epfd = epoll_create1(0);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        exit(EXIT_FAILURE);
+    }
+
+    // Register disarmed, then let the first call say what each end waits for
+    size_t waiting = 0;
+    for (size_t i = 0; i < loop->count; i++) {
+        struct epoll_event event = {.events = EPOLLONESHOT, .data.ptr = &loop->endpoints[i]};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, loop->endpoints[i].fd, &event) != 0) {
+            perror("epoll_ctl");
+            exit(EXIT_FAILURE);
+        }
+        waiting += step_epoll(epfd, &loop->endpoints[i], loop) ? 1 : 0;
+    }
+
+    struct epoll_event events[BENCH_EPOLL_BATCH];
+    while (waiting > 0) {
+        if (loop->rtt_ns > 0) {
+            struct timespec rtt = {
+                .tv_sec = (time_t)(loop->rtt_ns / 1'000'000'000),
+                .tv_nsec = (long)(loop->rtt_ns % 1'000'000'000),
+            };
+            nanosleep(&rtt, nullptr);
+        }
+
+        int n = epoll_wait(epfd, events, BENCH_EPOLL_BATCH, (int)(BENCH_STALL_NS / 1'000'000));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            loop->stalled = true;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!step_epoll(epfd, events[i].data.ptr, loop)) {
+                waiting--;
+            }
+        }
+    }
+
+    close(epfd);
+}
+
+/**
+ * Handshake all endpoints of @p loop by calling every unfinished one in turn
+ */
+static void run_spin(event_loop_t *loop) {
+    uint64_t start = bench_now_ns();
+    size_t waiting = loop->count;
+
+    while (waiting > 0) {
+        waiting = 0;
+        for (size_t i = 0; i < loop->count; i++) {
+            endpoint_t *endpoint = &loop->endpoints[i];
+            if (!is_waiting(endpoint->result)) {
+                continue;
+            }
+            endpoint->result = tls_handshake(endpoint->session);
+            loop->calls++;
+            if (is_waiting(endpoint->result)) {
+                waiting++;
+            }
+        }
+        if (bench_now_ns() - start > BENCH_STALL_NS) {
+            loop->stalled = true;
+            break;
+        }
+    }
+}
+
+static void *client_thread(void *arg) {
+    run_epoll(arg);
+    return nullptr;
+}
+
+typedef struct {
+    uint64_t elapsed_ns;
+    uint64_t cpu_ns;            // Server thread
+    uint64_t calls;             // Server tls_handshake() calls
+    size_t completed;           // Connections with both ends done
+} run_result_t;
+
+static run_result_t run(loop_mode_t mode, tls_context_t *server_ctx, tls_context_t *client_ctx,
+                        size_t connections, uint64_t rtt_ns) {
+    endpoint_t *servers = calloc(connections, sizeof(*servers));
+    endpoint_t *clients = calloc(connections, sizeof(*clients));
+    if (servers == nullptr || clients == nullptr) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < connections; i++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) != 0) {
+            perror("socketpair");
+            exit(EXIT_FAILURE);
+        }
+        servers[i] = (endpoint_t){tls_session_new(server_ctx), fds[0], TLS_E_AGAIN};
+        clients[i] = (endpoint_t){tls_session_new(client_ctx), fds[1], TLS_E_AGAIN};
+        if (servers[i].session == nullptr || clients[i].session == nullptr ||
+            tls_session_set_fd(servers[i].session, fds[0]) != TLS_E_SUCCESS ||
+            tls_session_set_fd(clients[i].session, fds[1]) != TLS_E_SUCCESS) {
+            fprintf(stderr, "Failed to set up connection %zu\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    event_loop_t server_loop = {.endpoints = servers, .count = connections};
+    event_loop_t client_loop = {.endpoints = clients, .count = connections, .rtt_ns = rtt_ns};
+
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, client_thread, &client_loop) != 0) {
+        fprintf(stderr, "Failed to start client thread\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t start = bench_now_ns();
+    uint64_t cpu_start = thread_cpu_ns();
+    if (mode == MODE_SPIN) {
+        run_spin(&server_loop);
+    } else {
+        run_epoll(&server_loop);
+    }
+    run_result_t result = {
+        .elapsed_ns = bench_now_ns() - start,
+        .cpu_ns = thread_cpu_ns() - cpu_start,
+        .calls = server_loop.calls,
+    };
+
+    if (server_loop.stalled) {
+        // Unblock the clients before joining them
+        for (size_t i = 0; i < connections; i++) {
+            shutdown(servers[i].fd, SHUT_RDWR);
+        }
+    }
+    pthread_join(thread, nullptr);
+
+    for (size_t i = 0; i < connections; i++) {
+        if (servers[i].result == TLS_E_SUCCESS && clients[i].result == TLS_E_SUCCESS) {
+            result.completed++;
+        }
+        shutdown(servers[i].fd, SHUT_RDWR);
+        tls_session_free(clients[i].session);
+        tls_session_free(servers[i].session);
+        close(servers[i].fd);
+        close(clients[i].fd);
+    }
+    free(clients);
+    free(servers);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    size_t connections = BENCH_DEFAULT_CONNECTIONS;
+    unsigned long rtt_us = BENCH_DEFAULT_RTT_US;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        connections = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        rtt_us = strtoul(argv[2], nullptr, 10);
+    }
+    if (argc > 3) {
+        cert_dir = argv[3];
+    }
+    if (connections == 0) {
+        fprintf(stderr, "Usage: %s [connections] [rtt_us] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Two descriptors per connection, plus some headroom
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < connections * 2 + 64) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < connections * 2 + 64) {
+            connections = (limit.rlim_cur - 64) / 2;
+        }
+    }
+
+    bench_tls_init();
+    tls_context_t *server_ctx = bench_tls_server_context(cert_dir);
+    tls_context_t *client_ctx = bench_tls_client_context();
+    if (tls_context_set_nonblocking(client_ctx, true) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to configure non-blocking handshakes\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("Non-Blocking Handshake Benchmark");
+    printf("Backend: %s, concurrent connections: %zu, client round trip: %lu us\n\n",
+           tls_get_version_string(), connections, rtt_us);
+    printf("%-8s %14s %16s %18s\n", "server", "handshakes/s", "calls/session", "server CPU us/hs");
+
+    int status = EXIT_SUCCESS;
+
+    for (loop_mode_t mode = MODE_SPIN; mode <= MODE_EPOLL; mode++) {
+        if (tls_context_set_nonblocking(server_ctx, mode == MODE_EPOLL) != TLS_E_SUCCESS) {
+            fprintf(stderr, "Failed to configure non-blocking handshakes\n");
+            return EXIT_FAILURE;
+        }
+
+        run_result_t r = run(mode, server_ctx, client_ctx, connections, (uint64_t)rtt_us * 1'000);
+        if (r.completed != connections) {
+            fprintf(stderr, "%s: only %zu of %zu handshakes completed\n",
+                    MODE_NAMES[mode], r.completed, connections);
+            status = EXIT_FAILURE;
+        }
+
+        printf("%-8s %14.0f %16.1f %18.1f\n", MODE_NAMES[mode],
+               bench_ops_per_sec(r.completed, r.elapsed_ns),
+               (double)r.calls / (double)connections,
+               r.completed > 0 ? (double)r.cpu_ns / 1e3 / (double)r.completed : 0.0);
+    }
+
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    tls_global_deinit();
+    return status;
+}
@@ -0,0 +1,163 @@
+/*
+ * TLS Hash Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure small-input hashing the way cookie and fingerprint code
+ *          does it:
+ *
+ *            fast       tls_hash_fast() per input
+ *            ctx        one tls_hash_ctx_t, update + final per input
+ *            batch      tls_hash_batch() over BENCH_BATCH inputs
+ *            hmac-init  tls_hmac_init() + update + final per input
+ *            hmac-ctx   one keyed tls_hmac_ctx_t, update + final per input
+ *
+ *          The hmac-ctx row is what a long-lived cookie key costs once the
+ *          pads are hashed a single time.
+ *
+ * Usage: bench_tls_hash [inputs]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_INPUTS = 500'000;
+constexpr size_t BENCH_BATCH = 64;
+constexpr size_t BENCH_MAX_INPUT = 256;
+static const size_t BENCH_INPUT_SIZES[] = {16, 64, 256};
+
+typedef enum {
+    MODE_FAST,
+    MODE_CTX,
+    MODE_BATCH,
+    MODE_HMAC_INIT,
+    MODE_HMAC_CTX,
+} hash_mode_t;
+
+static const char *const MODE_NAMES[] = {"fast", "ctx", "batch", "hmac-init", "hmac-ctx"};
+
+static uint8_t g_inputs[BENCH_BATCH][BENCH_MAX_INPUT];
+static uint8_t g_outputs[BENCH_BATCH][TLS_DIGEST_MAX_SIZE];
+static const uint8_t g_key[32] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+// Hash @p count inputs of @p size bytes; returns elapsed ns, 0 on failure
+static uint64_t run(hash_mode_t mode, size_t size, size_t count) {
+    struct iovec iov[BENCH_BATCH];
+    for (size_t i = 0; i < BENCH_BATCH; i++) {
+        iov[i] = (struct iovec){.iov_base = g_inputs[i], .iov_len = size};
+    }
+
+    tls_hash_ctx_t hash;
+    tls_hmac_ctx_t hmac;
+    if (tls_hash_init(&hash, TLS_DIGEST_SHA256) != TLS_E_SUCCESS ||
+        tls_hmac_init(&hmac, TLS_DIGEST_SHA256, g_key, sizeof(g_key)) != TLS_E_SUCCESS) {
+        return 0;
+    }
+
+    int ret = TLS_E_SUCCESS;
+    uint64_t start = bench_now_ns();
+
+    for (size_t done = 0; done < count && ret == TLS_E_SUCCESS; done += BENCH_BATCH) {
+        switch (mode) {
+            case MODE_FAST:
+                for (size_t i = 0; i < BENCH_BATCH && ret == TLS_E_SUCCESS; i++) {
+                    ret = tls_hash_fast(0, g_inputs[i], size, g_outputs[i]);
+                }
+                break;
+            case MODE_CTX:
+                for (size_t i = 0; i < BENCH_BATCH && ret == TLS_E_SUCCESS; i++) {
+                    ret = tls_hash_update(&hash, g_inputs[i], size);
+                    if (ret == TLS_E_SUCCESS) {
+                        ret = tls_hash_final(&hash, g_outputs[i]);
+                    }
+                }
+                break;
+            case MODE_BATCH:
+                ret = tls_hash_batch(TLS_DIGEST_SHA256, iov, BENCH_BATCH, g_outputs[0]);
+                break;
+            case MODE_HMAC_INIT:
+                for (size_t i = 0; i < BENCH_BATCH && ret == TLS_E_SUCCESS; i++) {
+                    tls_hmac_ctx_t once;
+                    ret = tls_hmac_init(&once, TLS_DIGEST_SHA256, g_key, sizeof(g_key));
+                    if (ret == TLS_E_SUCCESS) {
+                        ret = tls_hmac_update(&once, g_inputs[i], size);
+                    }
+                    if (ret == TLS_E_SUCCESS) {
+                        ret = tls_hmac_final(&once, g_outputs[i]);
+                    }
+                    tls_hmac_deinit(&once);
+                }
+                break;
+            case MODE_HMAC_CTX:
+                for (size_t i = 0; i < BENCH_BATCH && ret == TLS_E_SUCCESS; i++) {
+                    ret = tls_hmac_update(&hmac, g_inputs[i], size);
+                    if (ret == TLS_E_SUCCESS) {
+                        ret = tls_hmac_final(&hmac, g_outputs[i]);
+                    }
+                }
+                break;
+        }
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+    tls_hash_deinit(&hash);
+    tls_hmac_deinit(&hmac);
+    return ret == TLS_E_SUCCESS ? elapsed : 0;
+}
+
+int main(int argc, char *argv[]) {
+    size_t inputs = BENCH_DEFAULT_INPUTS;
+
+    if (argc > 1) {
+        inputs = strtoull(argv[1], nullptr, 10);
+    }
+    if (inputs < BENCH_BATCH) {
+        fprintf(stderr, "Usage: %s [inputs (>= %zu)]\n", argv[0], BENCH_BATCH);
+        return EXIT_FAILURE;
+    }
+    inputs -= inputs % BENCH_BATCH;
+
+    bench_tls_init();
+
+    uint64_t seed = 0x5eed;
+    for (size_t i = 0; i < BENCH_BATCH; i++) {
+        for (size_t j = 0; j < BENCH_MAX_INPUT; j++) {
+            g_inputs[i][j] = (uint8_t)bench_rand(&seed);
+        }
+    }
+
+    bench_banner("TLS Hash Benchmark");
+    printf("Backend: %s, SHA-256, inputs per run: %zu, batch: %zu\n\n",
+           tls_get_version_string(), inputs, BENCH_BATCH);
+    printf("%-8s %-10s %14s %10s\n", "bytes", "mode", "Mhash/s", "ns/hash");
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t s = 0; s < sizeof(BENCH_INPUT_SIZES) / sizeof(BENCH_INPUT_SIZES[0]); s++) {
+        for (hash_mode_t mode = MODE_FAST; mode <= MODE_HMAC_CTX; mode++) {
+            uint64_t elapsed = run(mode, BENCH_INPUT_SIZES[s], inputs);
+            if (elapsed == 0) {
+                fprintf(stderr, "%s failed\n", MODE_NAMES[mode]);
+                status = EXIT_FAILURE;
+                continue;
+            }
+            printf("%-8zu %-10s %14.2f %10.1f\n", BENCH_INPUT_SIZES[s], MODE_NAMES[mode],
+                   bench_ops_per_sec(inputs, elapsed) / 1e6, (double)elapsed / (double)inputs);
+        }
+    }
+
+    tls_global_deinit();
+    return status;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * In-process TLS connection pairs for benchmarks: a server and a client
+ * session of the configured backend joined by a socketpair.
+ */
+
+#ifndef WOLFGUARD_BENCH_TLS_PAIR_H
+#define WOLFGUARD_BENCH_TLS_PAIR_H
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../src/crypto/tls_abstract.h"
+
+/* Backend this benchmark was built against */
+#ifdef USE_WOLFSSL
+constexpr tls_backend_t BENCH_TLS_BACKEND = TLS_BACKEND_WOLFSSL;
+#else
+constexpr tls_backend_t BENCH_TLS_BACKEND = TLS_BACKEND_GNUTLS;
+#endif
+
+typedef struct {
+    tls_session_t *server;
+    tls_session_t *client;
+    int fds[2];                 // [0] server end, [1] client end
+} bench_tls_pair_t;
+
+/**
+ * Initialize @p backend (exits on failure)
+ */
+static inline void bench_tls_init_backend(tls_backend_t backend) {
+    // A peer that went away must not kill the benchmark
+    signal(SIGPIPE, SIG_IGN);
+
+    if (tls_global_init(backend) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to initialize TLS backend\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Initialize the build's backend (exits on failure)
+ */
+static inline void bench_tls_init(void) {
+    bench_tls_init_backend(BENCH_TLS_BACKEND);
+}
+
+/**
+ * Server context with the test certificate from @p cert_dir (exits on failure)
+ */
+static inline tls_context_t *bench_tls_server_context(const char *cert_dir) {
+    char cert[512];
+    char key[512];
+    snprintf(cert, sizeof(cert), "%s/server-cert.pem", cert_dir);
+    snprintf(key, sizeof(key), "%s/server-key.pem", cert_dir);
+
+    tls_context_t *ctx = tls_context_new(true, false);
+    if (ctx == nullptr ||
+        tls_context_set_cert_file(ctx, cert) != TLS_E_SUCCESS ||
+        tls_context_set_key_file(ctx, key) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to set up server context (certificates in %s?)\n", cert_dir);
+        exit(EXIT_FAILURE);
+    }
+    return ctx;
+}
+
+/**
+ * Client context that accepts the self-signed test certificate
+ */
+static inline tls_context_t *bench_tls_client_context(void) {
+    tls_context_t *ctx = tls_context_new(false, false);
+    if (ctx == nullptr || tls_context_set_verify(ctx, false, nullptr, nullptr) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to set up client context\n");
+        exit(EXIT_FAILURE);
+    }
+    return ctx;
+}
+
+static void *bench_tls_client_handshake(void *arg) {
+    tls_session_t *client = arg;
+    int ret;
+    do {
+        ret = tls_handshake(client);
+    } while (ret == TLS_E_AGAIN || ret == TLS_E_INTERRUPTED);
+    return (void *)(intptr_t)ret;
+}
+
+/**
+ * Create a connected pair and complete the handshake (blocking sockets),
+ * the client offering @p data from tls_session_get_data() (nullptr for none)
+ *
+ * @return 0 on success, -1 on failure
+ */
+static inline int bench_tls_pair_open_resume(bench_tls_pair_t *pair,
+                                             tls_context_t *server_ctx,
+                                             tls_context_t *client_ctx,
+                                             const void *data, size_t size) {
+    *pair = (bench_tls_pair_t){.fds = {-1, -1}};
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair->fds) != 0) {
+        return -1;
+    }
+
+    pair->server = tls_session_new(server_ctx);
+    pair->client = tls_session_new(client_ctx);
+    if (pair->server == nullptr || pair->client == nullptr ||
+        tls_session_set_fd(pair->server, pair->fds[0]) != TLS_E_SUCCESS ||
+        tls_session_set_fd(pair->client, pair->fds[1]) != TLS_E_SUCCESS ||
+        (data != nullptr && tls_session_set_data(pair->client, data, size) != TLS_E_SUCCESS)) {
+        return -1;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, bench_tls_client_handshake, pair->client) != 0) {
+        return -1;
+    }
+
+    int ret;
+    do {
+        ret = tls_handshake(pair->server);
+    } while (ret == TLS_E_AGAIN || ret == TLS_E_INTERRUPTED);
+
+    if (ret != TLS_E_SUCCESS) {
+        // Unblock the client before joining it
+        shutdown(pair->fds[0], SHUT_RDWR);
+    }
+
+    void *client_ret = nullptr;
+    pthread_join(thread, &client_ret);
+
+    return (ret == TLS_E_SUCCESS && (intptr_t)client_ret == TLS_E_SUCCESS) ? 0 : -1;
+}
+
+/**
+ * Create a connected pair and complete a full handshake (blocking sockets)
+ *
+ * @return 0 on success, -1 on failure
+ */
+static inline int bench_tls_pair_open(bench_tls_pair_t *pair,
+                                      tls_context_t *server_ctx,
+                                      tls_context_t *client_ctx) {
+    return bench_tls_pair_open_resume(pair, server_ctx, client_ctx, nullptr, 0);
+}
+
+/**
+ * Tear down a pair (sockets first, so that neither side waits for the
+ * other's close_notify)
+ */
+static inline void bench_tls_pair_close(bench_tls_pair_t *pair) {
+    for (int i = 0; i < 2; i++) {
+        if (pair->fds[i] >= 0) {
+            shutdown(pair->fds[i], SHUT_RDWR);
+        }
+    }
+
+    tls_session_free(pair->client);
+    tls_session_free(pair->server);
+
+    for (int i = 0; i < 2; i++) {
+        if (pair->fds[i] >= 0) {
+            close(pair->fds[i]);
+        }
+    }
+    *pair = (bench_tls_pair_t){.fds = {-1, -1}};
+}
+
+#endif // WOLFGUARD_BENCH_TLS_PAIR_H
@@ -0,0 +1,185 @@
+/*
+ * TLS Random Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure tls_random() calls per second for the request sizes of
+ *          the hot path - 16-byte cookies and nonces, 32-byte session IDs -
+ *          and one request too large to batch, as worker threads are added.
+ *          With the wolfSSL backend two baselines run alongside: "shared"
+ *          is one process-wide WC_RNG behind a mutex, and "per-call" is the
+ *          wc_InitRng() / wc_RNG_GenerateBlock() / wc_FreeRng() sequence
+ *          tls_random() used before it cached a DRBG per thread.
+ *
+ * Usage: bench_tls_random [max_threads] [duration_ms]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+#ifdef USE_WOLFSSL
+#include <wolfssl/options.h>
+#include <wolfssl/wolfcrypt/random.h>
+#endif
+
+/* Configuration */
+constexpr unsigned int BENCH_DEFAULT_MAX_THREADS = 4;
+constexpr unsigned int BENCH_MAX_THREADS = 256;
+constexpr unsigned int BENCH_DEFAULT_DURATION_MS = 500;
+static const size_t BENCH_SIZES[] = {16, 32, 256};
+
+typedef int (*random_func_t)(void *data, size_t len);
+
+typedef struct {
+    atomic_bool *stop;
+    random_func_t func;
+    size_t size;
+    uint64_t ops;
+    bool failed;
+} worker_t;
+
+#ifdef USE_WOLFSSL
+static WC_RNG g_shared_rng;
+static pthread_mutex_t g_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// One DRBG for all threads, serialized by a mutex
+static int random_shared(void *data, size_t len) {
+    pthread_mutex_lock(&g_shared_lock);
+    int ret = wc_RNG_GenerateBlock(&g_shared_rng, data, (word32)len);
+    pthread_mutex_unlock(&g_shared_lock);
+    return ret == 0 ? TLS_E_SUCCESS : TLS_E_BACKEND_ERROR;
+}
+
+// What tls_random() did on every call before the per-thread DRBG
+static int random_per_call(void *data, size_t len) {
+    WC_RNG rng;
+    if (wc_InitRng(&rng) != 0) {
+        return TLS_E_BACKEND_ERROR;
+    }
+    int ret = wc_RNG_GenerateBlock(&rng, data, (word32)len);
+    wc_FreeRng(&rng);
+    return ret == 0 ? TLS_E_SUCCESS : TLS_E_BACKEND_ERROR;
+}
+#endif
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    uint8_t buf[256];
+
+    while (!atomic_load_explicit(w->stop, memory_order_relaxed)) {
+        for (int i = 0; i < 64; i++) {
+            if (w->func(buf, w->size) != TLS_E_SUCCESS) {
+                w->failed = true;
+                return nullptr;
+            }
+        }
+        w->ops += 64;
+    }
+    return nullptr;
+}
+
+// Calls per second over all threads, or 0 on failure
+static double run(random_func_t func, size_t size, unsigned int threads,
+                  unsigned int duration_ms) {
+    pthread_t tids[BENCH_MAX_THREADS];
+    worker_t workers[BENCH_MAX_THREADS];
+    atomic_bool stop = false;
+
+    for (unsigned int t = 0; t < threads; t++) {
+        workers[t] = (worker_t){.stop = &stop, .func = func, .size = size};
+        if (pthread_create(&tids[t], nullptr, worker_main, &workers[t]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    struct timespec ts = {
+        .tv_sec = duration_ms / 1'000,
+        .tv_nsec = (long)(duration_ms % 1'000) * 1'000'000L,
+    };
+    nanosleep(&ts, nullptr);
+    atomic_store(&stop, true);
+
+    uint64_t total = 0;
+    bool failed = false;
+    for (unsigned int t = 0; t < threads; t++) {
+        pthread_join(tids[t], nullptr);
+        total += workers[t].ops;
+        failed |= workers[t].failed;
+    }
+
+    return failed ? 0.0 : bench_ops_per_sec(total, bench_now_ns() - start);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int max_threads = BENCH_DEFAULT_MAX_THREADS;
+    unsigned int duration_ms = BENCH_DEFAULT_DURATION_MS;
+
+    if (argc > 1) {
+        max_threads = (unsigned int)strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        duration_ms = (unsigned int)strtoul(argv[2], nullptr, 10);
+    }
+    if (max_threads == 0 || max_threads > BENCH_MAX_THREADS || duration_ms == 0) {
+        fprintf(stderr, "Usage: %s [max_threads (1-%u)] [duration_ms]\n", argv[0],
+                BENCH_MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    bench_tls_init();
+
+    bench_banner("TLS Random Benchmark");
+    printf("Backend: %s, duration: %u ms/run\n\n", tls_get_version_string(), duration_ms);
+    printf("%-8s %-8s %18s %18s %18s\n", "bytes", "threads", "tls_random", "shared",
+           "per-call");
+
+#ifdef USE_WOLFSSL
+    if (wc_InitRng(&g_shared_rng) != 0) {
+        fprintf(stderr, "wc_InitRng failed\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t s = 0; s < sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]); s++) {
+        for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+            double cached = run(tls_random, BENCH_SIZES[s], threads, duration_ms);
+            if (cached == 0.0) {
+                fprintf(stderr, "tls_random failed\n");
+                status = EXIT_FAILURE;
+                break;
+            }
+            printf("%-8zu %-8u %14.2f M/s", BENCH_SIZES[s], threads, cached / 1e6);
+#ifdef USE_WOLFSSL
+            double shared = run(random_shared, BENCH_SIZES[s], threads, duration_ms);
+            double per_call = run(random_per_call, BENCH_SIZES[s], threads, duration_ms);
+            printf(" %14.2f M/s %14.2f M/s\n", shared / 1e6, per_call / 1e6);
+#else
+            printf(" %18s %18s\n", "n/a", "n/a");
+#endif
+            fflush(stdout);
+        }
+    }
+
+#ifdef USE_WOLFSSL
+    wc_FreeRng(&g_shared_rng);
+#endif
+    tls_global_deinit();
+    return status;
+}
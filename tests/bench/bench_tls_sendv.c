@@ -0,0 +1,285 @@
+/*
+ * Scatter-Gather Send Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Compare small-packet throughput of tls_sendv() and record
+ *          corking with the copy-then-send approach they replace. Every
+ *          packet is an 8-byte CSTP-style header plus a payload in a
+ *          separate buffer:
+ *
+ *            copy  x1   memcpy header + payload into a staging buffer, tls_send()
+ *            sendv x1   tls_sendv() of {header, payload}
+ *            cork  x1   tls_cork(), tls_send() header, tls_send() payload, tls_uncork()
+ *            copy  x16  stage 16 packets, one tls_send()
+ *            sendv x16  one tls_sendv() of 16 packets (32 fragments)
+ *            cork  x16  32 tls_send() calls between tls_cork() and tls_uncork()
+ *
+ *          A client thread receives and checksums everything, so the numbers
+ *          cover encryption, the socket and decryption.
+ *
+ * Usage: bench_tls_sendv [packets] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_PACKETS = 200'000;
+constexpr size_t BENCH_HEADER_SIZE = 8;
+constexpr size_t BENCH_MAX_BATCH = 16;
+constexpr size_t BENCH_MAX_PAYLOAD = 1'400;        // Typical tunnel MTU
+static const size_t BENCH_PAYLOAD_SIZES[] = {32, 128, 512, BENCH_MAX_PAYLOAD};
+
+typedef enum {
+    MODE_COPY,
+    MODE_SENDV,
+    MODE_CORK,
+} send_mode_t;
+
+static const char *const MODE_NAMES[] = {"copy", "sendv", "cork"};
+
+typedef struct {
+    tls_session_t *session;
+    uint64_t expected;          // Bytes to receive
+    uint64_t checksum;          // Sum of received bytes
+    int error;
+} receiver_t;
+
+static void *receive_all(void *arg) {
+    receiver_t *rx = arg;
+    uint8_t buffer[65'536];
+    uint64_t received = 0;
+
+    while (received < rx->expected) {
+        ssize_t n = tls_recv(rx->session, buffer, sizeof(buffer));
+        if (n == TLS_E_AGAIN || n == TLS_E_INTERRUPTED) {
+            continue;
+        }
+        if (n <= 0) {
+            rx->error = (int)n;
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            rx->checksum += buffer[i];
+        }
+        received += (uint64_t)n;
+    }
+    return nullptr;
+}
+
+/**
+ * tls_send() until everything is out, like any caller of a stream API
+ */
+static bool send_all(tls_session_t *session, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = tls_send(session, data, len);
+        if (n == TLS_E_AGAIN || n == TLS_E_INTERRUPTED) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * tls_sendv() until everything is out, advancing past partial writes
+ */
+static bool sendv_all(tls_session_t *session, const struct iovec *iov, int iovcnt) {
+    struct iovec rest[BENCH_MAX_BATCH * 2];
+    memcpy(rest, iov, (size_t)iovcnt * sizeof(*iov));
+    struct iovec *cur = rest;
+
+    while (iovcnt > 0) {
+        ssize_t n = tls_sendv(session, cur, iovcnt);
+        if (n == TLS_E_AGAIN || n == TLS_E_INTERRUPTED) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        while (iovcnt > 0 && (size_t)n >= cur->iov_len) {
+            n -= (ssize_t)cur->iov_len;
+            cur++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            cur->iov_base = (uint8_t *)cur->iov_base + n;
+            cur->iov_len -= (size_t)n;
+        }
+    }
+    return true;
+}
+
+/**
+ * tls_uncork() until everything is out
+ */
+static bool uncork_all(tls_session_t *session) {
+    int ret;
+    do {
+        ret = tls_uncork(session);
+    } while (ret == TLS_E_AGAIN || ret == TLS_E_INTERRUPTED);
+    return ret == TLS_E_SUCCESS;
+}
+
+/**
+ * Send @p packets packets, @p batch per call, return elapsed ns (0 on error)
+ */
+static uint64_t run(bench_tls_pair_t *pair, size_t packets, size_t payload_size,
+                    size_t batch, send_mode_t mode) {
+    uint8_t headers[BENCH_MAX_BATCH][BENCH_HEADER_SIZE];
+    uint8_t payloads[BENCH_MAX_BATCH][BENCH_MAX_PAYLOAD];
+    uint8_t staging[BENCH_MAX_BATCH * (BENCH_HEADER_SIZE + BENCH_MAX_PAYLOAD)];
+    struct iovec iov[BENCH_MAX_BATCH * 2];
+    uint64_t checksum = 0;
+
+    for (size_t b = 0; b < batch; b++) {
+        memset(payloads[b], (int)(0x40 + b), payload_size);
+        headers[b][0] = 'S';
+        headers[b][1] = 'T';
+        headers[b][2] = 'F';
+        headers[b][3] = 1;
+        headers[b][4] = (uint8_t)(payload_size >> 8);
+        headers[b][5] = (uint8_t)payload_size;
+        headers[b][6] = 0;
+        headers[b][7] = 0;
+        iov[2 * b] = (struct iovec){.iov_base = headers[b], .iov_len = BENCH_HEADER_SIZE};
+        iov[2 * b + 1] = (struct iovec){.iov_base = payloads[b], .iov_len = payload_size};
+    }
+
+    size_t calls = packets / batch;
+    size_t call_bytes = batch * (BENCH_HEADER_SIZE + payload_size);
+
+    for (size_t b = 0; b < batch; b++) {
+        for (size_t i = 0; i < BENCH_HEADER_SIZE; i++) {
+            checksum += headers[b][i];
+        }
+        checksum += (uint64_t)payloads[b][0] * payload_size;
+    }
+
+    receiver_t rx = {.session = pair->client, .expected = calls * call_bytes};
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, receive_all, &rx) != 0) {
+        return 0;
+    }
+
+    uint64_t start = bench_now_ns();
+    bool ok = true;
+
+    for (size_t c = 0; c < calls && ok; c++) {
+        switch (mode) {
+            case MODE_COPY: {
+                // What callers do today: stage, then send
+                size_t len = 0;
+                for (size_t b = 0; b < batch; b++) {
+                    memcpy(staging + len, headers[b], BENCH_HEADER_SIZE);
+                    memcpy(staging + len + BENCH_HEADER_SIZE, payloads[b], payload_size);
+                    len += BENCH_HEADER_SIZE + payload_size;
+                }
+                ok = send_all(pair->server, staging, len);
+                break;
+            }
+            case MODE_SENDV:
+                ok = sendv_all(pair->server, iov, (int)(2 * batch));
+                break;
+            case MODE_CORK:
+                ok = tls_cork(pair->server) == TLS_E_SUCCESS;
+                for (size_t b = 0; b < batch && ok; b++) {
+                    ok = send_all(pair->server, headers[b], BENCH_HEADER_SIZE) &&
+                         send_all(pair->server, payloads[b], payload_size);
+                }
+                ok = uncork_all(pair->server) && ok;
+                break;
+        }
+    }
+
+    if (!ok) {
+        // The receiver would otherwise wait for bytes that never come
+        shutdown(pair->fds[0], SHUT_RDWR);
+    }
+    pthread_join(thread, nullptr);
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if (!ok || rx.error != 0 || rx.checksum != checksum * calls) {
+        fprintf(stderr, "Transfer failed (%s x%zu, %zu-byte payload)\n",
+                MODE_NAMES[mode], batch, payload_size);
+        return 0;
+    }
+    return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    size_t packets = BENCH_DEFAULT_PACKETS;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        packets = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (packets < BENCH_MAX_BATCH) {
+        fprintf(stderr, "Usage: %s [packets (>= %zu)] [cert_dir]\n", argv[0], BENCH_MAX_BATCH);
+        return EXIT_FAILURE;
+    }
+
+    bench_tls_init();
+    tls_context_t *server_ctx = bench_tls_server_context(cert_dir);
+    tls_context_t *client_ctx = bench_tls_client_context();
+
+    bench_banner("Scatter-Gather Send Benchmark");
+    printf("Backend: %s, packets per run: %zu (%zu-byte header + payload)\n\n",
+           tls_get_version_string(), packets, BENCH_HEADER_SIZE);
+    printf("%-8s %-10s %14s %12s\n", "payload", "mode", "Kpackets/s", "MB/s");
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t p = 0; p < sizeof(BENCH_PAYLOAD_SIZES) / sizeof(BENCH_PAYLOAD_SIZES[0]); p++) {
+        size_t payload_size = BENCH_PAYLOAD_SIZES[p];
+
+        for (size_t batch = 1; batch <= BENCH_MAX_BATCH; batch *= BENCH_MAX_BATCH) {
+            for (send_mode_t mode = MODE_COPY; mode <= MODE_CORK; mode++) {
+                bench_tls_pair_t pair;
+                if (bench_tls_pair_open(&pair, server_ctx, client_ctx) != 0) {
+                    fprintf(stderr, "Handshake failed\n");
+                    return EXIT_FAILURE;
+                }
+
+                uint64_t elapsed = run(&pair, packets, payload_size, batch, mode);
+                bench_tls_pair_close(&pair);
+                if (elapsed == 0) {
+                    status = EXIT_FAILURE;
+                    continue;
+                }
+
+                size_t sent = packets / batch * batch;
+                char label[16];
+                snprintf(label, sizeof(label), "%s x%zu", MODE_NAMES[mode], batch);
+                printf("%-8zu %-10s %14.1f %12.1f\n", payload_size, label,
+                       bench_ops_per_sec(sent, elapsed) / 1e3,
+                       bench_ops_per_sec(sent * (BENCH_HEADER_SIZE + payload_size), elapsed) / 1e6);
+            }
+        }
+    }
+
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    tls_global_deinit();
+    return status;
+}
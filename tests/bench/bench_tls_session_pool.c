@@ -0,0 +1,175 @@
+/*
+ * Session Pool Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Measure what tls_context_set_session_pool() saves per
+ *          connection. Two workloads run without and with the pool:
+ *
+ *            churn     tls_session_new() + tls_session_free(), no I/O - the
+ *                      pure allocation and setup cost a pool can remove
+ *            connect   a full connection over a socketpair: handshake, a
+ *                      small request/response and teardown
+ *
+ *          The connect numbers include the handshake, which dominates, so
+ *          the pool shows up there as a few percent rather than a multiple.
+ *
+ * Usage: bench_tls_session_pool [connections] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_CONNECTIONS = 2'000;
+constexpr size_t BENCH_CHURN_PER_CONNECTION = 50;  // Churn iterations per connection
+constexpr size_t BENCH_POOL_SIZE = 64;
+constexpr size_t BENCH_MESSAGE_SIZE = 64;
+
+// Session new/free without a connection; returns elapsed ns, 0 on failure
+static uint64_t run_churn(tls_context_t *ctx, size_t iterations) {
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < iterations; i++) {
+        tls_session_t *session = tls_session_new(ctx);
+        if (session == nullptr) {
+            return 0;
+        }
+        tls_session_free(session);
+    }
+    return bench_now_ns() - start;
+}
+
+// One request/response over an established pair
+static int exchange(bench_tls_pair_t *pair) {
+    uint8_t request[BENCH_MESSAGE_SIZE];
+    uint8_t response[BENCH_MESSAGE_SIZE];
+    memset(request, 'q', sizeof(request));
+
+    if (tls_send(pair->client, request, sizeof(request)) != (ssize_t)sizeof(request)) {
+        return -1;
+    }
+    size_t got = 0;
+    while (got < sizeof(response)) {
+        ssize_t n = tls_recv(pair->server, response + got, sizeof(response) - got);
+        if (n <= 0) {
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    if (tls_send(pair->server, response, sizeof(response)) != (ssize_t)sizeof(response)) {
+        return -1;
+    }
+    for (got = 0; got < sizeof(request);) {
+        ssize_t n = tls_recv(pair->client, request + got, sizeof(request) - got);
+        if (n <= 0) {
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+// Full connections; returns elapsed ns, 0 on failure
+static uint64_t run_connect(tls_context_t *server_ctx, tls_context_t *client_ctx,
+                            size_t connections) {
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < connections; i++) {
+        bench_tls_pair_t pair;
+        int ret = bench_tls_pair_open(&pair, server_ctx, client_ctx);
+        if (ret == 0) {
+            ret = exchange(&pair);
+        }
+        bench_tls_pair_close(&pair);
+        if (ret != 0) {
+            fprintf(stderr, "Connection %zu failed\n", i);
+            return 0;
+        }
+    }
+    return bench_now_ns() - start;
+}
+
+static int set_pool(tls_context_t *server_ctx, tls_context_t *client_ctx, size_t size) {
+    if (tls_context_set_session_pool(server_ctx, size) != TLS_E_SUCCESS ||
+        tls_context_set_session_pool(client_ctx, size) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to configure the session pool\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    size_t connections = BENCH_DEFAULT_CONNECTIONS;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        connections = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (connections == 0) {
+        fprintf(stderr, "Usage: %s [connections] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bench_tls_init();
+    tls_context_t *server_ctx = bench_tls_server_context(cert_dir);
+    tls_context_t *client_ctx = bench_tls_client_context();
+
+    bench_banner("Session Pool Benchmark");
+    printf("Backend: %s, connections per run: %zu, pool size: %zu\n\n",
+           tls_get_version_string(), connections, BENCH_POOL_SIZE);
+    printf("%-10s %-8s %14s %14s\n", "workload", "pool", "ops/s", "us/op");
+
+    size_t churn = connections * BENCH_CHURN_PER_CONNECTION;
+    int status = EXIT_SUCCESS;
+
+    for (size_t pool = 0; pool <= BENCH_POOL_SIZE; pool += BENCH_POOL_SIZE) {
+        if (set_pool(server_ctx, client_ctx, pool) != 0) {
+            status = EXIT_FAILURE;
+            break;
+        }
+        const char *label = pool == 0 ? "off" : "on";
+
+        // One untimed connection warms the pool and the allocator
+        if (run_connect(server_ctx, client_ctx, 1) == 0) {
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        uint64_t elapsed = run_churn(server_ctx, churn);
+        if (elapsed == 0) {
+            fprintf(stderr, "tls_session_new failed\n");
+            status = EXIT_FAILURE;
+            break;
+        }
+        printf("%-10s %-8s %14.0f %14.2f\n", "churn", label,
+               bench_ops_per_sec(churn, elapsed), (double)elapsed / (double)churn / 1e3);
+
+        elapsed = run_connect(server_ctx, client_ctx, connections);
+        if (elapsed == 0) {
+            status = EXIT_FAILURE;
+            break;
+        }
+        printf("%-10s %-8s %14.0f %14.2f\n", "connect", label,
+               bench_ops_per_sec(connections, elapsed), (double)elapsed / (double)connections / 1e3);
+        fflush(stdout);
+    }
+
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    tls_global_deinit();
+    return status;
+}
@@ -0,0 +1,273 @@
+/*
+ * Ticket Key Reload Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Show that reloading the ticket key ring (ticket_keys_t) does not
+ *          stall handshakes. Two server contexts stand in for two nodes
+ *          behind a load balancer and share one watched key file; clients
+ *          get a ticket from one node and resume on the other:
+ *
+ *            static    the key file never changes
+ *            reload    a writer replaces the key file every
+ *                      BENCH_REWRITE_MS and the watcher polls every
+ *                      BENCH_POLL_MS, so rings are swapped under load
+ *
+ *          With wolfSSL the rewritten rings keep the issuing key and change
+ *          an older one, so every swap is a real reload and every ticket
+ *          stays valid. GnuTLS takes a single key, so there every rewrite
+ *          replaces the issuing key and the tickets issued under the old one
+ *          stop resuming: clients fall back to a full handshake and keep the
+ *          new ticket, and the resumed column shows what the rotation cost.
+ *          Reported per mode: handshakes/s, latency percentiles, cross-node
+ *          resumption and completed reloads.
+ *
+ * Usage: bench_tls_ticket_reload [handshakes] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../../src/crypto/ticket_keys.h"
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_HANDSHAKES = 10'000;
+constexpr size_t BENCH_CLIENTS = 64;
+constexpr unsigned int BENCH_LIFETIME_SECS = 3'600;
+constexpr unsigned int BENCH_POLL_MS = 1;
+constexpr unsigned int BENCH_REWRITE_MS = 2;
+
+static const char BENCH_ISSUING_KEY[] =
+    "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\n";
+static const char *const BENCH_ROTATING_KEYS[] = {
+    "a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5\n",
+    "5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a\n",
+};
+
+typedef struct {
+    const char *path;
+    atomic_bool stop;
+    uint64_t writes;
+} rewriter_t;
+
+typedef struct {
+    uint8_t data[TLS_MAX_SESSION_DATA_SIZE];
+    size_t size;
+} saved_session_t;
+
+// Ring of @p generation: one rotating key, after the fixed issuing key
+// unless the backend only takes one key
+static int write_ring(const char *path, uint64_t generation) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (fp == nullptr) {
+        return -1;
+    }
+    if (tls_get_backend() != TLS_BACKEND_GNUTLS) {
+        fputs(BENCH_ISSUING_KEY, fp);
+    }
+    fputs(BENCH_ROTATING_KEYS[generation % 2], fp);
+    if (fclose(fp) != 0) {
+        return -1;
+    }
+    return rename(tmp, path);
+}
+
+static void *rewriter_main(void *arg) {
+    rewriter_t *rw = arg;
+    struct timespec interval = {.tv_nsec = (long)BENCH_REWRITE_MS * 1'000'000L};
+
+    while (!atomic_load_explicit(&rw->stop, memory_order_relaxed)) {
+        nanosleep(&interval, nullptr);
+        if (write_ring(rw->path, rw->writes + 1) == 0) {
+            rw->writes++;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * One connection; 1 if resumed, 0 if not, -1 on failure. With @p keep, the
+ * client's session is exported there (it may be @p offer).
+ */
+static int connect_once(tls_context_t *server_ctx, tls_context_t *client_ctx,
+                        const saved_session_t *offer, saved_session_t *keep) {
+    bench_tls_pair_t pair;
+    int result = -1;
+
+    if (bench_tls_pair_open_resume(&pair, server_ctx, client_ctx,
+                                   offer != nullptr ? offer->data : nullptr,
+                                   offer != nullptr ? offer->size : 0) == 0 &&
+        tls_send(pair.server, "x", 1) == 1) {
+        uint8_t byte;
+        ssize_t got;
+        do {
+            got = tls_recv(pair.client, &byte, 1);
+        } while (got == TLS_E_AGAIN || got == TLS_E_INTERRUPTED);
+
+        tls_connection_info_t info;
+        if (got == 1 && tls_get_connection_info(pair.server, &info) == TLS_E_SUCCESS) {
+            result = info.session_resumed ? 1 : 0;
+        }
+    }
+
+    if (result >= 0 && keep != nullptr) {
+        keep->size = sizeof(keep->data);
+        if (tls_session_get_data(pair.client, keep->data, &keep->size) != TLS_E_SUCCESS) {
+            result = -1;
+        }
+    }
+
+    bench_tls_pair_close(&pair);
+    return result;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    size_t handshakes = BENCH_DEFAULT_HANDSHAKES;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        handshakes = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (handshakes == 0) {
+        fprintf(stderr, "Usage: %s [handshakes] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The ring's shape depends on the backend
+    bench_tls_init();
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/bench-ticket-keys-%ld", (long)getpid());
+    if (write_ring(path, 0) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    tls_context_t *nodes[2] = {
+        bench_tls_server_context(cert_dir),
+        bench_tls_server_context(cert_dir),
+    };
+    tls_context_t *client_ctx = bench_tls_client_context();
+
+    ticket_keys_config_t config = {
+        .path = path,
+        .lifetime_secs = BENCH_LIFETIME_SECS,
+        .poll_interval_ms = BENCH_POLL_MS,
+    };
+    ticket_keys_t *keys = ticket_keys_new(&config);
+    if (keys == nullptr || ticket_keys_attach(keys, nodes[0]) != 0 ||
+        ticket_keys_attach(keys, nodes[1]) != 0) {
+        fprintf(stderr, "Failed to set up the key source\n");
+        return EXIT_FAILURE;
+    }
+
+    // Every client gets its ticket from node 0
+    saved_session_t *saved = calloc(BENCH_CLIENTS, sizeof(*saved));
+    uint64_t *latency = calloc(handshakes, sizeof(*latency));
+    if (saved == nullptr || latency == nullptr) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < BENCH_CLIENTS; i++) {
+        if (connect_once(nodes[0], client_ctx, nullptr, &saved[i]) < 0) {
+            fprintf(stderr, "Full handshake %zu failed\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    bench_banner("Ticket Key Reload Benchmark");
+    printf("Backend: %s, handshakes per mode: %zu, nodes: 2\n\n",
+           tls_get_version_string(), handshakes);
+    printf("%-8s %10s %9s %9s %9s %9s %8s\n", "mode", "hs/s", "p50 us", "p99 us",
+           "max us", "resumed", "reloads");
+
+    int status = EXIT_SUCCESS;
+
+    for (int reload = 0; reload <= 1; reload++) {
+        rewriter_t rw = {.path = path};
+        pthread_t tid;
+        if (reload && pthread_create(&tid, nullptr, rewriter_main, &rw) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            return EXIT_FAILURE;
+        }
+        ticket_keys_stats_t before;
+        ticket_keys_get_stats(keys, &before);
+
+        size_t resumed = 0;
+        uint64_t start = bench_now_ns();
+        for (size_t i = 0; i < handshakes; i++) {
+            uint64_t t0 = bench_now_ns();
+            // Clients keep the latest ticket, which after a full handshake
+            // is one under the current key
+            saved_session_t *ticket = &saved[i % BENCH_CLIENTS];
+            int ret = connect_once(nodes[1 - i % 2], client_ctx, ticket, ticket);
+            latency[i] = bench_now_ns() - t0;
+            if (ret < 0) {
+                fprintf(stderr, "Handshake %zu failed\n", i);
+                return EXIT_FAILURE;
+            }
+            resumed += (size_t)ret;
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+
+        if (reload) {
+            atomic_store(&rw.stop, true);
+            pthread_join(tid, nullptr);
+        }
+        ticket_keys_stats_t after;
+        ticket_keys_get_stats(keys, &after);
+
+        qsort(latency, handshakes, sizeof(*latency), compare_u64);
+        printf("%-8s %10.0f %9.1f %9.1f %9.1f %8.1f%% %8llu\n",
+               reload ? "reload" : "static",
+               bench_ops_per_sec(handshakes, elapsed),
+               (double)latency[handshakes / 2] / 1e3,
+               (double)latency[handshakes * 99 / 100] / 1e3,
+               (double)latency[handshakes - 1] / 1e3,
+               100.0 * (double)resumed / (double)handshakes,
+               (unsigned long long)(after.reloads - before.reloads));
+        fflush(stdout);
+
+        // Only GnuTLS, with its single key, may lose resumptions to a reload
+        bool all_resumed = resumed == handshakes;
+        if ((!all_resumed && (!reload || tls_get_backend() != TLS_BACKEND_GNUTLS)) ||
+            after.failures != before.failures) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    ticket_keys_detach(keys, nodes[1]);
+    ticket_keys_detach(keys, nodes[0]);
+    ticket_keys_free(keys);
+    unlink(path);
+    free(latency);
+    free(saved);
+    tls_context_free(client_ctx);
+    tls_context_free(nodes[1]);
+    tls_context_free(nodes[0]);
+    tls_global_deinit();
+    return status;
+}
@@ -0,0 +1,236 @@
+/*
+ * Session Ticket Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Compare stateless session tickets (tls_context_set_ticket_keys)
+ *          with the server-side session cache (session_cache_t) for a
+ *          population of clients. Every client does one full handshake and
+ *          keeps its session (tls_session_get_data), then comes back once
+ *          and offers it:
+ *
+ *            cache     TLS 1.2 session IDs, session_cache_t with the lease
+ *                      callbacks, one entry per client on the server
+ *            tickets   TLS 1.2 and TLS 1.3 tickets, nothing on the server
+ *
+ *          Reported per mode: full and resumed handshake rates, the share of
+ *          clients that resumed, the server memory that resumption costs
+ *          (session_cache_get_stats_ex for the cache, the key ring for
+ *          tickets) and what each client has to keep.
+ *
+ * Usage: bench_tls_tickets [clients] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../src/crypto/session_cache.h"
+#include "bench_common.h"
+#include "bench_tls_pair.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_CLIENTS = 100'000;
+constexpr unsigned int BENCH_LIFETIME_SECS = 3'600;
+constexpr size_t BENCH_SECRET_SIZE = 32;
+
+typedef enum {
+    MODE_CACHE,
+    MODE_TICKETS_TLS12,
+    MODE_TICKETS_TLS13,
+} resume_mode_t;
+
+static const char *const MODE_NAMES[] = {"cache", "tickets", "tickets"};
+static const char *const MODE_VERSIONS[] = {"TLS1.2", "TLS1.2", "TLS1.3"};
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} saved_session_t;
+
+typedef struct {
+    uint64_t full_ns;
+    uint64_t resume_ns;
+    size_t resumed;
+    size_t server_bytes;
+    size_t client_bytes;
+} mode_result_t;
+
+/**
+ * One connection: handshake, one byte from the server (which also carries
+ * TLS 1.3 tickets to the client), optional session export
+ *
+ * @return 1 if resumed, 0 if not, -1 on failure
+ */
+static int connect_once(tls_context_t *server_ctx, tls_context_t *client_ctx,
+                        const saved_session_t *offer, saved_session_t *keep) {
+    bench_tls_pair_t pair;
+    int result = -1;
+
+    if (bench_tls_pair_open_resume(&pair, server_ctx, client_ctx,
+                                   offer != nullptr ? offer->data : nullptr,
+                                   offer != nullptr ? offer->size : 0) == 0 &&
+        tls_send(pair.server, "x", 1) == 1) {
+        uint8_t byte;
+        ssize_t got;
+        do {
+            got = tls_recv(pair.client, &byte, 1);
+        } while (got == TLS_E_AGAIN || got == TLS_E_INTERRUPTED);
+
+        tls_connection_info_t info;
+        if (got == 1 && tls_get_connection_info(pair.server, &info) == TLS_E_SUCCESS) {
+            result = info.session_resumed ? 1 : 0;
+        }
+    }
+
+    if (result >= 0 && keep != nullptr) {
+        size_t size = 0;
+        if (tls_session_get_data(pair.client, nullptr, &size) != TLS_E_SUCCESS ||
+            (keep->data = malloc(size)) == nullptr ||
+            tls_session_get_data(pair.client, keep->data, &size) != TLS_E_SUCCESS) {
+            result = -1;
+        }
+        keep->size = size;
+    }
+
+    bench_tls_pair_close(&pair);
+    return result;
+}
+
+static mode_result_t run_mode(resume_mode_t mode, const char *cert_dir, size_t clients) {
+    mode_result_t result = {0};
+
+    tls_context_t *server_ctx = bench_tls_server_context(cert_dir);
+    tls_context_t *client_ctx = bench_tls_client_context();
+    if (mode != MODE_TICKETS_TLS13 &&
+        tls_context_set_priority(client_ctx, "NORMAL:-VERS-TLS1.3") != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to limit the client to TLS 1.2\n");
+        exit(EXIT_FAILURE);
+    }
+
+    session_cache_t *cache = nullptr;
+    int ret;
+    if (mode == MODE_CACHE) {
+        session_cache_config_t config = {
+            .capacity = clients * 2,    // Headroom for shard imbalance
+            .timeout_secs = BENCH_LIFETIME_SECS,
+        };
+        cache = session_cache_new_with_config(&config);
+        ret = cache == nullptr ? TLS_E_MEMORY_ERROR
+                               : tls_context_set_session_cache(server_ctx, session_cache_store,
+                                                               session_cache_retrieve,
+                                                               session_cache_remove, cache);
+        if (ret == TLS_E_SUCCESS) {
+            ret = tls_context_set_session_cache_lease(server_ctx, session_cache_borrow,
+                                                      session_cache_release);
+        }
+    } else {
+        uint8_t secret[BENCH_SECRET_SIZE];
+        tls_datum_t key = {.data = secret, .size = sizeof(secret)};
+        ret = tls_random(secret, sizeof(secret));
+        if (ret == TLS_E_SUCCESS) {
+            ret = tls_context_set_ticket_keys(server_ctx, &key, 1, BENCH_LIFETIME_SECS);
+        }
+        result.server_bytes = sizeof(secret);   // Fixed, whatever the population
+    }
+    if (ret != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to configure %s: %s\n", MODE_NAMES[mode], tls_strerror(ret));
+        exit(EXIT_FAILURE);
+    }
+
+    saved_session_t *saved = calloc(clients, sizeof(*saved));
+    if (saved == nullptr) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Every client connects once and keeps its session
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < clients; i++) {
+        if (connect_once(server_ctx, client_ctx, nullptr, &saved[i]) < 0) {
+            fprintf(stderr, "%s: full handshake %zu failed\n", MODE_NAMES[mode], i);
+            exit(EXIT_FAILURE);
+        }
+        result.client_bytes += saved[i].size;
+    }
+    result.full_ns = bench_now_ns() - start;
+
+    if (cache != nullptr) {
+        session_cache_stats_t stats;
+        if (session_cache_get_stats_ex(cache, &stats) == 0) {
+            result.server_bytes = stats.slab_bytes + stats.table_bytes;
+        }
+    }
+
+    // ... and comes back once
+    start = bench_now_ns();
+    for (size_t i = 0; i < clients; i++) {
+        int resumed = connect_once(server_ctx, client_ctx, &saved[i], nullptr);
+        if (resumed < 0) {
+            fprintf(stderr, "%s: resumed handshake %zu failed\n", MODE_NAMES[mode], i);
+            exit(EXIT_FAILURE);
+        }
+        result.resumed += (size_t)resumed;
+    }
+    result.resume_ns = bench_now_ns() - start;
+
+    for (size_t i = 0; i < clients; i++) {
+        free(saved[i].data);
+    }
+    free(saved);
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    session_cache_free(cache);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    size_t clients = BENCH_DEFAULT_CLIENTS;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        clients = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (clients == 0) {
+        fprintf(stderr, "Usage: %s [clients] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bench_tls_init();
+
+    bench_banner("Session Ticket Benchmark");
+    printf("Backend: %s, clients: %zu\n\n", tls_get_version_string(), clients);
+    printf("%-8s %-7s %10s %12s %9s %14s %12s\n", "mode", "version", "full/s", "resumed/s",
+           "resumed", "server MB", "client B/sess");
+
+    int status = EXIT_SUCCESS;
+
+    for (resume_mode_t mode = MODE_CACHE; mode <= MODE_TICKETS_TLS13; mode++) {
+        mode_result_t r = run_mode(mode, cert_dir, clients);
+        printf("%-8s %-7s %10.0f %12.0f %8.1f%% %14.3f %12.0f\n",
+               MODE_NAMES[mode], MODE_VERSIONS[mode],
+               bench_ops_per_sec(clients, r.full_ns),
+               bench_ops_per_sec(clients, r.resume_ns),
+               100.0 * (double)r.resumed / (double)clients,
+               (double)r.server_bytes / 1e6,
+               (double)r.client_bytes / (double)clients);
+        fflush(stdout);
+
+        if (r.resumed != clients) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    tls_global_deinit();
+    return status;
+}
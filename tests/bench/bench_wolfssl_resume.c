@@ -0,0 +1,304 @@
+/*
+ * wolfSSL Session Resumption Benchmark - wolfguard
+ *
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * Purpose: Compare the server-side session cache paths of the wolfSSL
+ *          backend on TLS 1.2 session-ID resumption:
+ *
+ *            none    - no session cache (full handshakes, baseline)
+ *            copy    - tls_context_set_session_cache(): i2d on store, copy +
+ *                      d2i on resume
+ *            lease   - copy path plus tls_context_set_session_cache_lease():
+ *                      d2i straight from the cache
+ *            native  - tls_wolfssl_context_set_native_session_cache():
+ *                      refcounted WOLFSSL_SESSION objects, no i2d/d2i
+ *
+ *          Client (raw wolfSSL) and server (wolfguard) run in one thread over
+ *          a non-blocking socketpair, so the reported latency covers both
+ *          sides of the handshake. Server memory per cached session is the
+ *          heap growth while populating, less the growth of the no-cache run
+ *          (the client keeps one session per connection in every mode).
+ *
+ * Usage: bench_wolfssl_resume [sessions] [cert_dir]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../src/crypto/tls_wolfssl.h"
+#include "bench_common.h"
+
+/* Configuration */
+constexpr size_t BENCH_DEFAULT_SESSIONS = 2'000;
+constexpr unsigned int BENCH_MAX_ROUNDS = 64;   // Handshake flights before giving up
+
+typedef enum {
+    MODE_NONE,
+    MODE_COPY,
+    MODE_LEASE,
+    MODE_NATIVE,
+} cache_mode_t;
+
+static const char *const MODE_NAMES[] = {"none", "copy", "lease", "native"};
+
+typedef struct {
+    uint64_t full_ns;
+    uint64_t resume_ns;
+    size_t resumed;
+    size_t heap_bytes;
+} mode_result_t;
+
+static size_t heap_in_use(void) {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+static tls_context_t *new_server_context(cache_mode_t mode,
+                                         const char *cert_dir,
+                                         size_t sessions,
+                                         session_cache_t **cache) {
+    char cert[512];
+    char key[512];
+    snprintf(cert, sizeof(cert), "%s/server-cert.pem", cert_dir);
+    snprintf(key, sizeof(key), "%s/server-key.pem", cert_dir);
+
+    tls_context_t *ctx = tls_context_new(true, false);
+    if (ctx == nullptr ||
+        tls_context_set_cert_file(ctx, cert) != TLS_E_SUCCESS ||
+        tls_context_set_key_file(ctx, key) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to set up server context (certificates in %s?)\n", cert_dir);
+        exit(EXIT_FAILURE);
+    }
+
+    session_cache_config_t config = {
+        .capacity = sessions * 2,   // Headroom for shard imbalance
+        .timeout_secs = 3'600,
+    };
+    int ret = TLS_E_SUCCESS;
+    *cache = nullptr;
+
+    switch (mode) {
+        case MODE_NONE:
+            break;
+        case MODE_COPY:
+        case MODE_LEASE:
+            *cache = session_cache_new_with_config(&config);
+            if (*cache == nullptr) {
+                ret = TLS_E_MEMORY_ERROR;
+                break;
+            }
+            ret = tls_context_set_session_cache(ctx, session_cache_store, session_cache_retrieve,
+                                                session_cache_remove, *cache);
+            if (ret == TLS_E_SUCCESS && mode == MODE_LEASE) {
+                ret = tls_context_set_session_cache_lease(ctx, session_cache_borrow,
+                                                          session_cache_release);
+            }
+            break;
+        case MODE_NATIVE:
+            ret = tls_wolfssl_context_set_native_session_cache(ctx, &config);
+            break;
+    }
+
+    if (ret != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to configure %s session cache\n", MODE_NAMES[mode]);
+        exit(EXIT_FAILURE);
+    }
+    return ctx;
+}
+
+/**
+ * One TLS connection, both ends stepped alternately in this thread
+ *
+ * @param resume Client session to offer, nullptr for a full handshake
+ * @param saved Output: client session to resume later (optional)
+ * @return 1 if the session was resumed, 0 if not, -1 on handshake failure
+ */
+static int connect_once(tls_context_t *server_ctx,
+                        WOLFSSL_CTX *client_ctx,
+                        WOLFSSL_SESSION *resume,
+                        WOLFSSL_SESSION **saved) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) != 0) {
+        return -1;
+    }
+
+    tls_session_t *server = tls_session_new(server_ctx);
+    WOLFSSL *client = wolfSSL_new(client_ctx);
+    int result = -1;
+
+    if (server == nullptr || client == nullptr ||
+        tls_session_set_fd(server, fds[0]) != TLS_E_SUCCESS ||
+        wolfSSL_set_fd(client, fds[1]) != SSL_SUCCESS ||
+        (resume != nullptr && wolfSSL_set_session(client, resume) != SSL_SUCCESS)) {
+        goto done;
+    }
+
+    bool client_done = false;
+    bool server_done = false;
+
+    for (unsigned int round = 0; round < BENCH_MAX_ROUNDS && !(client_done && server_done);
+         round++) {
+        if (!client_done) {
+            int ret = wolfSSL_connect(client);
+            if (ret == SSL_SUCCESS) {
+                client_done = true;
+            } else {
+                int err = wolfSSL_get_error(client, ret);
+                if (err != WOLFSSL_ERROR_WANT_READ && err != WOLFSSL_ERROR_WANT_WRITE) {
+                    goto done;
+                }
+            }
+        }
+        if (!server_done) {
+            int ret = tls_handshake(server);
+            if (ret == TLS_E_SUCCESS) {
+                server_done = true;
+            } else if (ret != TLS_E_AGAIN) {
+                goto done;
+            }
+        }
+    }
+
+    if (client_done && server_done) {
+        result = wolfSSL_session_reused(client) ? 1 : 0;
+        if (saved != nullptr) {
+            *saved = wolfSSL_get1_session(client);
+        }
+    }
+
+done:
+    wolfSSL_free(client);
+    tls_session_free(server);
+    close(fds[0]);
+    close(fds[1]);
+    return result;
+}
+
+static mode_result_t run_mode(cache_mode_t mode, const char *cert_dir, size_t sessions) {
+    mode_result_t result = {0};
+
+    WOLFSSL_CTX *client_ctx = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
+    if (client_ctx == nullptr) {
+        fprintf(stderr, "Failed to create client context\n");
+        exit(EXIT_FAILURE);
+    }
+    wolfSSL_CTX_set_verify(client_ctx, WOLFSSL_VERIFY_NONE, nullptr);
+#ifdef HAVE_SESSION_TICKET
+    // Resume by session ID, i.e. through the server-side cache
+    wolfSSL_CTX_NoTicketTLSv12(client_ctx);
+#endif
+
+    session_cache_t *cache = nullptr;
+    tls_context_t *server_ctx = new_server_context(mode, cert_dir, sessions, &cache);
+
+    WOLFSSL_SESSION **saved = calloc(sessions, sizeof(*saved));
+    if (saved == nullptr) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Populate: one full handshake per client
+    size_t heap_before = heap_in_use();
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < sessions; i++) {
+        if (connect_once(server_ctx, client_ctx, nullptr, &saved[i]) < 0 || saved[i] == nullptr) {
+            fprintf(stderr, "%s: full handshake %zu failed\n", MODE_NAMES[mode], i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    result.full_ns = bench_now_ns() - start;
+    size_t heap_after = heap_in_use();
+    result.heap_bytes = heap_after > heap_before ? heap_after - heap_before : 0;
+
+    // Every client comes back once
+    start = bench_now_ns();
+    for (size_t i = 0; i < sessions; i++) {
+        int ret = connect_once(server_ctx, client_ctx, saved[i], nullptr);
+        if (ret < 0) {
+            fprintf(stderr, "%s: resumed handshake %zu failed\n", MODE_NAMES[mode], i);
+            exit(EXIT_FAILURE);
+        }
+        result.resumed += (size_t)ret;
+    }
+    result.resume_ns = bench_now_ns() - start;
+
+    for (size_t i = 0; i < sessions; i++) {
+        wolfSSL_SESSION_free(saved[i]);
+    }
+    free(saved);
+    tls_context_free(server_ctx);
+    session_cache_free(cache);
+    wolfSSL_CTX_free(client_ctx);
+
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    size_t sessions = BENCH_DEFAULT_SESSIONS;
+    const char *cert_dir = "tests/certs";
+
+    if (argc > 1) {
+        sessions = strtoull(argv[1], nullptr, 10);
+    }
+    if (argc > 2) {
+        cert_dir = argv[2];
+    }
+    if (sessions == 0) {
+        fprintf(stderr, "Usage: %s [sessions] [cert_dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (tls_global_init(TLS_BACKEND_WOLFSSL) != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to initialize wolfSSL backend\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_banner("wolfSSL Session Resumption Benchmark");
+    printf("Sessions: %zu (TLS 1.2, session-ID resumption)\n\n", sessions);
+    printf("%-8s %12s %14s %10s %16s\n",
+           "cache", "full (us)", "resumed (us)", "resumed", "server B/sess");
+
+    mode_result_t results[4];
+    for (cache_mode_t mode = MODE_NONE; mode <= MODE_NATIVE; mode++) {
+        results[mode] = run_mode(mode, cert_dir, sessions);
+    }
+
+    for (cache_mode_t mode = MODE_NONE; mode <= MODE_NATIVE; mode++) {
+        const mode_result_t *r = &results[mode];
+        double per_session = 0.0;
+        if (mode != MODE_NONE && r->heap_bytes > results[MODE_NONE].heap_bytes) {
+            per_session = (double)(r->heap_bytes - results[MODE_NONE].heap_bytes) /
+                          (double)sessions;
+        }
+
+        printf("%-8s %12.1f %14.1f %9.1f%% %16.0f\n",
+               MODE_NAMES[mode],
+               (double)r->full_ns / 1e3 / (double)sessions,
+               (double)r->resume_ns / 1e3 / (double)sessions,
+               100.0 * (double)r->resumed / (double)sessions,
+               per_session);
+    }
+
+    tls_global_deinit();
+
+    // Every cached mode must actually resume
+    for (cache_mode_t mode = MODE_COPY; mode <= MODE_NATIVE; mode++) {
+        if (results[mode].resumed != sessions) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
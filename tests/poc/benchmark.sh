@@ -26,6 +26,8 @@ ITERATIONS=1000
 WARMUP_ITERATIONS=10
 BACKENDS=("gnutls" "wolfssl")
 OUTPUT_DIR="${SCRIPT_DIR}/results"
+KTLS_ARGS=()
+RESULT_SUFFIX=""
 TIMESTAMP=$(date +%Y%m%d_%H%M%S)
 
 # Colors for output
@@ -52,6 +54,7 @@ Options:
     -n, --iterations N       Number of iterations (default: $ITERATIONS)
     -p, --port PORT          Server port (default: $PORT)
     -o, --output DIR         Output directory (default: $OUTPUT_DIR)
+    -K, --ktls               Offload records to kernel TLS (server and client)
     -h, --help               Show this help
 
 EOF
@@ -77,6 +80,11 @@ while [[ $# -gt 0 ]]; do
             OUTPUT_DIR=$2
             shift 2
             ;;
+        -K|--ktls)
+            KTLS_ARGS=(--ktls)
+            RESULT_SUFFIX="_ktls"
+            shift
+            ;;
         -h|--help)
             usage
             ;;
@@ -163,6 +171,7 @@ start_server() {
         --port "$PORT" \
         --cert "$CERT_FILE" \
         --key "$KEY_FILE" \
+        "${KTLS_ARGS[@]}" \
         > "$log_file" 2>&1 &
 
     local server_pid=$!
@@ -205,7 +214,7 @@ stop_server() {
 # Run client benchmark
 run_benchmark() {
     local backend=$1
-    local output_file="${OUTPUT_DIR}/results_${backend}_${TIMESTAMP}.json"
+    local output_file="${OUTPUT_DIR}/results_${backend}${RESULT_SUFFIX}_${TIMESTAMP}.json"
     local client_bin
 
     if [[ "$backend" == "gnutls" ]]; then
@@ -223,6 +232,7 @@ run_benchmark() {
         --backend "$backend" \
         --port "$PORT" \
         --iterations "$WARMUP_ITERATIONS" \
+        "${KTLS_ARGS[@]}" \
         > /dev/null 2>&1 || true
 
     # Actual benchmark
@@ -233,6 +243,7 @@ run_benchmark() {
         --port "$PORT" \
         --iterations "$ITERATIONS" \
         --json \
+        "${KTLS_ARGS[@]}" \
         > "$output_file" 2>&1; then
         print_msg "$GREEN" "  Results saved to: $output_file"
         return 0
@@ -278,6 +289,7 @@ main() {
     print_msg "$BLUE" "Iterations: $ITERATIONS"
     print_msg "$BLUE" "Port: $PORT"
     print_msg "$BLUE" "Backends: ${BACKENDS[*]}"
+    print_msg "$BLUE" "kTLS: ${KTLS_ARGS[*]:-off}"
     echo ""
 
     # Check if binaries exist
@@ -19,8 +19,10 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <time.h>
 
@@ -51,6 +53,7 @@ typedef struct {
     double elapsed_seconds;
     double throughput_mbps;
     double latency_ms;
+    double cpu_seconds_per_gb;  // User + system CPU of this process per GB moved
 } test_result_t;
 
 /* Print usage */
@@ -62,6 +65,7 @@ static void print_usage(const char *prog) {
     fprintf(stderr, "  -p, --port PORT                 Server port (default: %d)\n", DEFAULT_PORT);
     fprintf(stderr, "  -n, --iterations N              Number of iterations per test (default: 100)\n");
     fprintf(stderr, "  -s, --size SIZE                 Test single size instead of all sizes\n");
+    fprintf(stderr, "  -K, --ktls                      Offload records to kernel TLS after the handshake\n");
     fprintf(stderr, "  -v, --verbose                   Verbose logging\n");
     fprintf(stderr, "  -h, --help                      Show this help\n");
 }
@@ -94,6 +98,10 @@ static int connect_to_server(const char *host, int port, bool verbose) {
         return -1;
     }
 
+    // Echoed records must not wait for delayed ACKs
+    int nodelay = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
     if (verbose) {
         printf("TCP connection established\n");
     }
@@ -108,6 +116,30 @@ static double get_time_seconds(void) {
     return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
 }
 
+/* Get CPU time (user + system) used by this process in seconds */
+static double get_cpu_seconds(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6 +
+           (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6;
+}
+
+/* Send the whole buffer (a single tls_send() writes at most one record with some backends) */
+static ssize_t send_all(tls_session_t *session, const uint8_t *data, size_t size) {
+    size_t total_sent = 0;
+    while (total_sent < size) {
+        ssize_t sent = tls_send(session, data + total_sent, size - total_sent);
+        if (sent == TLS_E_AGAIN || sent == TLS_E_INTERRUPTED) {
+            continue;
+        }
+        if (sent <= 0) {
+            return sent;
+        }
+        total_sent += sent;
+    }
+    return (ssize_t)total_sent;
+}
+
 /* Run test for specific size */
 static int run_test(tls_session_t *session, size_t size, uint64_t iterations,
                     test_result_t *result, bool verbose) {
@@ -131,10 +163,11 @@ static int run_test(tls_session_t *session, size_t size, uint64_t iterations,
     }
 
     double start_time = get_time_seconds();
+    double start_cpu = get_cpu_seconds();
 
     for (uint64_t i = 0; i < iterations; i++) {
         // Send data
-        ssize_t sent = tls_send(session, send_buffer, size);
+        ssize_t sent = send_all(session, send_buffer, size);
         if (sent < 0) {
             fprintf(stderr, "Send error: %s\n", tls_strerror(sent));
             free(send_buffer);
@@ -142,13 +175,6 @@ static int run_test(tls_session_t *session, size_t size, uint64_t iterations,
             return -1;
         }
 
-        if ((size_t)sent != size) {
-            fprintf(stderr, "Short send: %zd of %zu bytes\n", sent, size);
-            free(send_buffer);
-            free(recv_buffer);
-            return -1;
-        }
-
         // Receive echo
         size_t total_received = 0;
         while (total_received < size) {
@@ -181,6 +207,7 @@ static int run_test(tls_session_t *session, size_t size, uint64_t iterations,
 
     double end_time = get_time_seconds();
     double elapsed = end_time - start_time;
+    double cpu = get_cpu_seconds() - start_cpu;
 
     // Calculate statistics
     result->size = size;
@@ -194,6 +221,9 @@ static int run_test(tls_session_t *session, size_t size, uint64_t iterations,
     // Latency: elapsed / iterations * 1000 (convert to milliseconds)
     result->latency_ms = (elapsed / (double)iterations) * 1000.0;
 
+    // CPU per GB: what encryption, decryption and copies cost this process
+    result->cpu_seconds_per_gb = cpu / ((double)total_bytes / 1e9);
+
     free(send_buffer);
     free(recv_buffer);
 
@@ -206,15 +236,19 @@ static void print_result(const test_result_t *result) {
     printf("Iterations: %6lu | ", result->iterations);
     printf("Elapsed: %8.3f s | ", result->elapsed_seconds);
     printf("Throughput: %8.2f MB/s | ", result->throughput_mbps);
-    printf("Latency: %8.3f ms\n", result->latency_ms);
+    printf("Latency: %8.3f ms | ", result->latency_ms);
+    printf("CPU: %7.3f s/GB\n", result->cpu_seconds_per_gb);
 }
 
 /* Print results in JSON format */
 static void print_results_json(const test_result_t *results, size_t count,
-                                const char *backend_name, double handshake_time_ms) {
+                                const char *backend_name, double handshake_time_ms,
+                                unsigned int ktls) {
     printf("\n{\n");
     printf("  \"backend\": \"%s\",\n", backend_name);
     printf("  \"handshake_time_ms\": %.3f,\n", handshake_time_ms);
+    printf("  \"ktls_tx\": %s,\n", (ktls & TLS_KTLS_TX) ? "true" : "false");
+    printf("  \"ktls_rx\": %s,\n", (ktls & TLS_KTLS_RX) ? "true" : "false");
     printf("  \"tests\": [\n");
 
     for (size_t i = 0; i < count; i++) {
@@ -223,7 +257,8 @@ static void print_results_json(const test_result_t *results, size_t count,
         printf("      \"iterations\": %lu,\n", results[i].iterations);
         printf("      \"elapsed_seconds\": %.6f,\n", results[i].elapsed_seconds);
         printf("      \"throughput_mbps\": %.2f,\n", results[i].throughput_mbps);
-        printf("      \"latency_ms\": %.3f\n", results[i].latency_ms);
+        printf("      \"latency_ms\": %.3f,\n", results[i].latency_ms);
+        printf("      \"cpu_seconds_per_gb\": %.3f\n", results[i].cpu_seconds_per_gb);
         printf("    }%s\n", (i < count - 1) ? "," : "");
     }
 
@@ -240,6 +275,7 @@ int main(int argc, char **argv) {
     ssize_t single_size = -1;
     bool verbose = false;
     bool json_output = false;
+    bool ktls = false;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -286,6 +322,8 @@ int main(int argc, char **argv) {
                 return 1;
             }
             single_size = atoi(argv[i]);
+        } else if (strcmp(argv[i], "-K") == 0 || strcmp(argv[i], "--ktls") == 0) {
+            ktls = true;
         } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             verbose = true;
         } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--json") == 0) {
@@ -341,6 +379,15 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (ktls) {
+        ret = tls_context_set_ktls(ctx, true);
+        if (ret != TLS_E_SUCCESS) {
+            fprintf(stderr, "Failed to enable kTLS: %s\n", tls_strerror(ret));
+            tls_global_deinit();
+            return 1;
+        }
+    }
+
     // Connect to server
     int sockfd = connect_to_server(host, port, verbose);
     if (sockfd < 0) {
@@ -387,6 +434,11 @@ int main(int argc, char **argv) {
 
     double handshake_end = get_time_seconds();
     double handshake_time_ms = (handshake_end - handshake_start) * 1000.0;
+    unsigned int ktls_mode = tls_session_get_ktls(session);
+
+    if (ktls && ktls_mode == TLS_KTLS_NONE) {
+        fprintf(stderr, "Warning: kTLS unavailable (kernel or cipher), records stay in user space\n");
+    }
 
     // Get connection information
     tls_connection_info_t info;
@@ -407,7 +459,10 @@ int main(int argc, char **argv) {
         printf("\n=== TLS Performance Test ===\n");
         printf("Backend: %s\n", backend == TLS_BACKEND_GNUTLS ? "GnuTLS" : "wolfSSL");
         printf("Server: %s:%d\n", host, port);
-        printf("Handshake time: %.3f ms\n\n", handshake_time_ms);
+        printf("Handshake time: %.3f ms\n", handshake_time_ms);
+        printf("kTLS: TX %s, RX %s\n\n",
+               (ktls_mode & TLS_KTLS_TX) ? "kernel" : "user space",
+               (ktls_mode & TLS_KTLS_RX) ? "kernel" : "user space");
     }
 
     if (single_size > 0) {
@@ -436,7 +491,7 @@ int main(int argc, char **argv) {
     if (json_output && num_results > 0) {
         print_results_json(results, num_results,
                           backend == TLS_BACKEND_GNUTLS ? "gnutls" : "wolfssl",
-                          handshake_time_ms);
+                          handshake_time_ms, ktls_mode);
     }
 
     // Graceful shutdown
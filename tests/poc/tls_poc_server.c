@@ -23,6 +23,7 @@
 #include <signal.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <poll.h>
 #include <time.h>
@@ -43,6 +44,7 @@ typedef struct {
     uint64_t bytes_received;
     uint64_t bytes_sent;
     uint64_t handshakes_completed;
+    uint64_t ktls_offloaded;
     time_t start_time;
 } stats_t;
 
@@ -63,6 +65,7 @@ static void print_usage(const char *prog) {
     fprintf(stderr, "  -p, --port PORT                 Listen port (default: %d)\n", DEFAULT_PORT);
     fprintf(stderr, "  -c, --cert FILE                 Certificate file (required)\n");
     fprintf(stderr, "  -k, --key FILE                  Private key file (required)\n");
+    fprintf(stderr, "  -K, --ktls                      Offload records to kernel TLS after the handshake\n");
     fprintf(stderr, "  -v, --verbose                   Verbose logging\n");
     fprintf(stderr, "  -h, --help                      Show this help\n");
 }
@@ -77,6 +80,7 @@ static void print_stats(void) {
     printf("Total connections: %lu\n", g_stats.connections_accepted);
     printf("Active connections: %lu\n", g_stats.connections_active);
     printf("Handshakes completed: %lu\n", g_stats.handshakes_completed);
+    printf("kTLS offloaded: %lu\n", g_stats.ktls_offloaded);
     printf("Bytes received: %lu\n", g_stats.bytes_received);
     printf("Bytes sent: %lu\n", g_stats.bytes_sent);
 
@@ -165,8 +169,17 @@ static void handle_client(tls_context_t *ctx, int client_fd,
     }
 
     while ((ret = tls_handshake(session)) != TLS_E_SUCCESS) {
-        if (ret == TLS_E_AGAIN || ret == TLS_E_INTERRUPTED) {
-            // Non-blocking I/O - retry
+        if (ret == TLS_E_WANT_READ || ret == TLS_E_WANT_WRITE) {
+            // Wait for the direction the handshake asked for instead of spinning
+            struct pollfd pfd = {
+                .fd = client_fd,
+                .events = ret == TLS_E_WANT_READ ? POLLIN : POLLOUT,
+            };
+            if (poll(&pfd, 1, POLL_TIMEOUT_MS) >= 0 || errno == EINTR) {
+                continue;
+            }
+        }
+        if (ret == TLS_E_INTERRUPTED) {
             continue;
         }
         fprintf(stderr, "[%s:%d] Handshake failed: %s\n",
@@ -177,14 +190,21 @@ static void handle_client(tls_context_t *ctx, int client_fd,
 
     g_stats.handshakes_completed++;
 
+    unsigned int ktls = tls_session_get_ktls(session);
+    if (ktls != TLS_KTLS_NONE) {
+        g_stats.ktls_offloaded++;
+    }
+
     // Get connection information
     tls_connection_info_t info;
     if (tls_get_connection_info(session, &info) == TLS_E_SUCCESS) {
         if (verbose) {
-            printf("[%s:%d] Handshake complete: %s, resumed=%s\n",
+            printf("[%s:%d] Handshake complete: %s, resumed=%s, kTLS tx=%s rx=%s\n",
                    client_ip, ntohs(client_addr->sin_port),
                    info.cipher_name,
-                   info.session_resumed ? "yes" : "no");
+                   info.session_resumed ? "yes" : "no",
+                   (ktls & TLS_KTLS_TX) ? "yes" : "no",
+                   (ktls & TLS_KTLS_RX) ? "yes" : "no");
         }
     }
 
@@ -222,8 +242,19 @@ static void handle_client(tls_context_t *ctx, int client_fd,
                    client_ip, ntohs(client_addr->sin_port), received);
         }
 
-        // Echo back
-        ssize_t sent = tls_send(session, buffer, received);
+        // Echo back (all of it: a send may be partial)
+        ssize_t sent = 0;
+        while (sent < received) {
+            ssize_t n = tls_send(session, buffer + sent, received - sent);
+            if (n == TLS_E_AGAIN || n == TLS_E_INTERRUPTED) {
+                continue;
+            }
+            if (n < 0) {
+                sent = n;
+                break;
+            }
+            sent += n;
+        }
 
         if (sent < 0) {
             fprintf(stderr, "[%s:%d] Send error: %s\n",
@@ -250,6 +281,7 @@ int main(int argc, char **argv) {
     const char *cert_file = nullptr;
     const char *key_file = nullptr;
     bool verbose = false;
+    bool ktls = false;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -293,6 +325,8 @@ int main(int argc, char **argv) {
                 return 1;
             }
             key_file = argv[i];
+        } else if (strcmp(argv[i], "-K") == 0 || strcmp(argv[i], "--ktls") == 0) {
+            ktls = true;
         } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             verbose = true;
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
@@ -363,6 +397,23 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    // Handshakes report which readiness they wait for
+    ret = tls_context_set_nonblocking(ctx, true);
+    if (ret != TLS_E_SUCCESS) {
+        fprintf(stderr, "Failed to enable non-blocking handshakes: %s\n", tls_strerror(ret));
+        tls_global_deinit();
+        return 1;
+    }
+
+    if (ktls) {
+        ret = tls_context_set_ktls(ctx, true);
+        if (ret != TLS_E_SUCCESS) {
+            fprintf(stderr, "Failed to enable kTLS: %s\n", tls_strerror(ret));
+            tls_global_deinit();
+            return 1;
+        }
+    }
+
     // Create listening socket
     int listen_fd = create_listen_socket(port);
     if (listen_fd < 0) {
@@ -378,6 +429,7 @@ int main(int argc, char **argv) {
     printf("TLS PoC Echo Server ready (press Ctrl+C to stop)\n");
     printf("Backend: %s\n", backend == TLS_BACKEND_GNUTLS ? "GnuTLS" : "wolfSSL");
     printf("Port: %d\n", port);
+    printf("kTLS: %s\n", ktls ? "requested" : "off");
     printf("Verbose: %s\n\n", verbose ? "yes" : "no");
 
     g_stats.start_time = time(nullptr);
@@ -421,6 +473,10 @@ int main(int argc, char **argv) {
 
         g_stats.connections_accepted++;
 
+        // Echoed records must not wait for delayed ACKs
+        int nodelay = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
         // Handle client (simple synchronous handling for PoC)
         // Production code would use fork/thread pool
         handle_client(ctx, client_fd, &client_addr, verbose);
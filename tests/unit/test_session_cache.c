@@ -0,0 +1,1304 @@
+/*
+ * Copyright (C) 2025 wolfguard Contributors
+ *
+ * This file is part of wolfguard.
+ *
+ * wolfguard is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * wolfguard is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Unit tests for the in-memory TLS session cache
+ *
+ * The session cache is backend independent (it only uses the types from
+ * tls_abstract.h), so these tests do not initialize any TLS library.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // For nanosleep(), fork(), truncate()
+
+#include "session_cache.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// C23 standard check (accept C2x/C20 from GCC 14 as it provides C23 features)
+#if __STDC_VERSION__ < 202000L
+#error "This code requires C23 standard (ISO/IEC 9899:2024) or C2x support (GCC 14+)"
+#endif
+
+/* Test counter */
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/* Test macros */
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running test: %s...", #name); \
+        fflush(stdout); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name(void)
+
+#define RUN_TEST(name) run_test_##name()
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("\n    FAILED: %s:%d: Assertion failed: %s\n", \
+                   __FILE__, __LINE__, #condition); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while (0)
+
+#define ASSERT_EQ(a, b) \
+    do { \
+        if ((a) != (b)) { \
+            printf("\n    FAILED: %s:%d: Expected %d, got %d\n", \
+                   __FILE__, __LINE__, (int)(b), (int)(a)); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while (0)
+
+#define ASSERT_NOT_NULL(ptr) \
+    do { \
+        if ((ptr) == nullptr) { \
+            printf("\n    FAILED: %s:%d: Expected non-NULL pointer\n", \
+                   __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while (0)
+
+/* ============================================================================
+ * Test Utilities
+ * ============================================================================ */
+
+/**
+ * Helper: Build a cache entry with a deterministic 32-byte session ID
+ */
+static void make_entry(tls_session_cache_entry_t *entry, uint32_t id, time_t expiration) {
+    memset(entry, 0, sizeof(*entry));
+
+    entry->session_id_size = 32;
+    for (size_t i = 0; i < entry->session_id_size; i++) {
+        entry->session_id[i] = (uint8_t)((id >> ((i % 4) * 8)) ^ (i * 31));
+    }
+
+    entry->session_data_size = 64;
+    memset(entry->session_data, (int)(id & 0xFF), entry->session_data_size);
+    entry->expiration = expiration;
+}
+
+/**
+ * Helper: Look up the session built by make_entry(id)
+ */
+static bool cache_has(session_cache_t *cache, uint32_t id) {
+    tls_session_cache_entry_t key;
+    tls_session_cache_entry_t out;
+    make_entry(&key, id, 0);
+
+    return session_cache_retrieve(cache, key.session_id, key.session_id_size, &out) == 0;
+}
+
+/* ============================================================================
+ * Test Cases
+ * ============================================================================ */
+
+TEST(create_rejects_invalid_config) {
+    ASSERT(session_cache_new(0, 60) == nullptr);
+    ASSERT(session_cache_new(10, 0) == nullptr);
+    ASSERT(session_cache_new_with_config(nullptr) == nullptr);
+}
+
+TEST(store_retrieve_remove) {
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 1, time(nullptr) + 60);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(session_cache_size(cache), 1);
+
+    tls_session_cache_entry_t out;
+    ASSERT_EQ(session_cache_retrieve(cache, entry.session_id, entry.session_id_size, &out), 0);
+    ASSERT_EQ(out.session_data_size, entry.session_data_size);
+    ASSERT(memcmp(out.session_data, entry.session_data, entry.session_data_size) == 0);
+
+    ASSERT_EQ(session_cache_remove(cache, entry.session_id, entry.session_id_size), 0);
+    ASSERT_EQ(session_cache_remove(cache, entry.session_id, entry.session_id_size), -1);
+    ASSERT(!cache_has(cache, 1));
+
+    session_cache_free(cache);
+}
+
+TEST(lru_eviction_single_shard) {
+    session_cache_t *cache = session_cache_new(3, 60);
+    ASSERT_NOT_NULL(cache);
+    ASSERT_EQ(session_cache_shard_count(cache), 1);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 1; id <= 3; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    // Touch 1 so that 2 becomes least recently used
+    ASSERT(cache_has(cache, 1));
+
+    make_entry(&entry, 4, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+
+    ASSERT(cache_has(cache, 1));
+    ASSERT(!cache_has(cache, 2));
+    ASSERT(cache_has(cache, 3));
+    ASSERT(cache_has(cache, 4));
+
+    uint64_t evictions = 0;
+    session_cache_get_stats(cache, nullptr, nullptr, nullptr, nullptr, &evictions);
+    ASSERT_EQ(evictions, 1);
+
+    session_cache_free(cache);
+}
+
+TEST(expired_entries_are_not_returned) {
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 7, time(nullptr) - 1);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    make_entry(&entry, 8, time(nullptr) + 60);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+
+    // Already-expired session is never cached
+    ASSERT_EQ(session_cache_size(cache), 1);
+    ASSERT(!cache_has(cache, 7));
+    ASSERT(cache_has(cache, 8));
+
+    session_cache_stats_t stats;
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    ASSERT_EQ(stats.expirations, 1);
+
+    session_cache_free(cache);
+}
+
+TEST(timing_wheel_expires_entries) {
+    session_cache_config_t config = {
+        .capacity = 2'048,
+        .timeout_secs = 60,
+        .shard_count = 4,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    time_t now = time(nullptr);
+    for (uint32_t id = 0; id < 1'000; id++) {
+        // Half expire after one second, half after 100 (level-1 wheel slot)
+        make_entry(&entry, id, now + ((id % 2 == 0) ? 1 : 100));
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT_EQ(session_cache_cleanup_expired(cache), 0);
+
+    // Clock granularity is one second on each side of the conversion
+    struct timespec delay = {.tv_sec = 3, .tv_nsec = 0};
+    nanosleep(&delay, nullptr);
+
+    ASSERT_EQ(session_cache_cleanup_expired(cache), 500);
+    ASSERT_EQ(session_cache_size(cache), 500);
+    ASSERT(!cache_has(cache, 0));
+    ASSERT(cache_has(cache, 1));
+
+    session_cache_free(cache);
+}
+
+TEST(sharded_config_clamps_shard_count) {
+    session_cache_config_t config = {
+        .capacity = 64 * 8,
+        .timeout_secs = 60,
+        .shard_count = 1'000, // Not a power of 2, more than capacity allows
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+    ASSERT_EQ(session_cache_shard_count(cache), 8);
+    session_cache_free(cache);
+}
+
+TEST(sharded_stats_are_aggregated) {
+    session_cache_config_t config = {
+        .capacity = 4'096,
+        .timeout_secs = 60,
+        .shard_count = 16,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+    ASSERT_EQ(session_cache_shard_count(cache), 16);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 1'000; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    for (uint32_t id = 0; id < 1'000; id++) {
+        ASSERT(cache_has(cache, id));
+    }
+    ASSERT(!cache_has(cache, 5'000));
+
+    size_t count = 0;
+    size_t capacity = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    session_cache_get_stats(cache, &count, &capacity, &hits, &misses, &evictions);
+    ASSERT_EQ(count, 1'000);
+    ASSERT_EQ(capacity, 4'096);
+    ASSERT_EQ(hits, 1'000);
+    ASSERT_EQ(misses, 1);
+    ASSERT_EQ(evictions, 0);
+
+    session_cache_clear(cache);
+    ASSERT_EQ(session_cache_size(cache), 0);
+
+    session_cache_free(cache);
+}
+
+TEST(sharded_capacity_is_respected) {
+    session_cache_config_t config = {
+        .capacity = 1'024,
+        .timeout_secs = 60,
+        .shard_count = 8,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 10'000; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    ASSERT(session_cache_size(cache) <= 1'024);
+    ASSERT(session_cache_is_full(cache));
+
+    session_cache_free(cache);
+}
+
+TEST(table_grows_with_entries) {
+    session_cache_config_t config = {
+        .capacity = 20'000,
+        .timeout_secs = 60,
+        .shard_count = 1,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 20'000; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    ASSERT_EQ(session_cache_size(cache), 20'000);
+    for (uint32_t id = 0; id < 20'000; id++) {
+        ASSERT(cache_has(cache, id));
+    }
+
+    uint64_t evictions = 0;
+    session_cache_get_stats(cache, nullptr, nullptr, nullptr, nullptr, &evictions);
+    ASSERT_EQ(evictions, 0);
+
+    session_cache_free(cache);
+}
+
+TEST(ids_with_common_prefix) {
+    session_cache_t *cache = session_cache_new(1'000, 60);
+    ASSERT_NOT_NULL(cache);
+
+    // Only the last byte differs: all IDs must still be distinct keys
+    tls_session_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.session_id_size = 32;
+    memset(entry.session_id, 0xAB, entry.session_id_size);
+    entry.session_data_size = 1;
+
+    for (int i = 0; i < 256; i++) {
+        entry.session_id[31] = (uint8_t)i;
+        entry.session_data[0] = (uint8_t)i;
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT_EQ(session_cache_size(cache), 256);
+
+    tls_session_cache_entry_t out;
+    for (int i = 0; i < 256; i++) {
+        entry.session_id[31] = (uint8_t)i;
+        ASSERT_EQ(session_cache_retrieve(cache, entry.session_id, 32, &out), 0);
+        ASSERT_EQ(out.session_data[0], i);
+    }
+
+    session_cache_free(cache);
+}
+
+TEST(remove_keeps_probe_chains_intact) {
+    session_cache_config_t config = {
+        .capacity = 4'096,
+        .timeout_secs = 60,
+        .shard_count = 1,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 3'000; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    // Remove every third entry, then check that the rest is still reachable
+    for (uint32_t id = 0; id < 3'000; id += 3) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_remove(cache, entry.session_id, entry.session_id_size), 0);
+    }
+
+    for (uint32_t id = 0; id < 3'000; id++) {
+        ASSERT(cache_has(cache, id) == (id % 3 != 0));
+    }
+    ASSERT_EQ(session_cache_size(cache), 2'000);
+
+    session_cache_free(cache);
+}
+
+TEST(memory_tracks_used_bytes) {
+    session_cache_t *cache = session_cache_new(1'000, 60);
+    ASSERT_NOT_NULL(cache);
+
+    // 32-byte ID + 64-byte data: far below a full tls_session_cache_entry_t
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 500; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    session_cache_stats_t stats;
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    ASSERT_EQ(stats.count, 500);
+    ASSERT(stats.entry_bytes > 0);
+    ASSERT(stats.entry_bytes <= stats.slab_bytes);
+    ASSERT(stats.entry_bytes / stats.count < 256);
+    ASSERT(stats.bytes_per_session < sizeof(tls_session_cache_entry_t) / 4);
+
+    session_cache_clear(cache);
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    ASSERT_EQ(stats.entry_bytes, 0);
+    ASSERT_EQ(stats.slab_bytes, 0);
+    ASSERT_EQ(stats.bytes_per_session, 0);
+
+    session_cache_free(cache);
+}
+
+TEST(update_moves_between_size_classes) {
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    tls_session_cache_entry_t out;
+    make_entry(&entry, 3, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+
+    // Grow the session data well past the original size class
+    entry.session_data_size = 3'000;
+    memset(entry.session_data, 0x5A, entry.session_data_size);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(session_cache_size(cache), 1);
+    ASSERT_EQ(session_cache_retrieve(cache, entry.session_id, entry.session_id_size, &out), 0);
+    ASSERT_EQ(out.session_data_size, 3'000);
+    ASSERT(memcmp(out.session_data, entry.session_data, 3'000) == 0);
+
+    // Shrink again (updated in place)
+    entry.session_data_size = 10;
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(session_cache_retrieve(cache, entry.session_id, entry.session_id_size, &out), 0);
+    ASSERT_EQ(out.session_data_size, 10);
+
+    session_cache_free(cache);
+}
+
+TEST(remote_addr_round_trip) {
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 9, 0);
+    memset(&entry.remote_addr, 0x11, 16);
+    entry.remote_addr_len = 16;
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+
+    tls_session_cache_entry_t out;
+    memset(&out, 0xFF, sizeof(out));
+    ASSERT_EQ(session_cache_retrieve(cache, entry.session_id, entry.session_id_size, &out), 0);
+    ASSERT_EQ(out.remote_addr_len, 16);
+    ASSERT(memcmp(&out.remote_addr, &entry.remote_addr, sizeof(out.remote_addr)) == 0);
+
+    session_cache_free(cache);
+}
+
+TEST(oversized_session_is_rejected) {
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 1, 0);
+    entry.session_data_size = TLS_MAX_SESSION_DATA_SIZE + 1;
+    ASSERT_EQ(session_cache_store(cache, &entry), -1);
+    ASSERT_EQ(session_cache_size(cache), 0);
+
+    session_cache_free(cache);
+}
+
+TEST(invalid_policy_is_rejected) {
+    session_cache_config_t config = {
+        .capacity = 100,
+        .timeout_secs = 60,
+        .policy = (session_cache_policy_t)42,
+    };
+
+    ASSERT(session_cache_new_with_config(&config) == nullptr);
+}
+
+TEST(s3fifo_keeps_resumed_sessions_under_flood) {
+    session_cache_config_t config = {
+        .capacity = 100,
+        .timeout_secs = 60,
+        .shard_count = 1,
+        .policy = SESSION_CACHE_POLICY_S3FIFO,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    // 50 regular users store a session and resume it once
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 50; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+        ASSERT(cache_has(cache, id));
+    }
+
+    // A flood of one-shot clients, ten times the capacity
+    for (uint32_t id = 1'000; id < 2'000; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    for (uint32_t id = 0; id < 50; id++) {
+        ASSERT(cache_has(cache, id));
+    }
+    ASSERT(session_cache_size(cache) <= 100);
+
+    session_cache_free(cache);
+}
+
+TEST(lru_loses_resumed_sessions_under_flood) {
+    session_cache_config_t config = {
+        .capacity = 100,
+        .timeout_secs = 60,
+        .shard_count = 1,
+        .policy = SESSION_CACHE_POLICY_LRU,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 50; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+        ASSERT(cache_has(cache, id));
+    }
+    for (uint32_t id = 1'000; id < 2'000; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    // Baseline for the test above: plain LRU flushes everyone
+    for (uint32_t id = 0; id < 50; id++) {
+        ASSERT(!cache_has(cache, id));
+    }
+
+    session_cache_free(cache);
+}
+
+TEST(s3fifo_ghost_readmits_to_main) {
+    session_cache_config_t config = {
+        .capacity = 100,
+        .timeout_secs = 60,
+        .shard_count = 1,
+        .policy = SESSION_CACHE_POLICY_S3FIFO,
+    };
+
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    // Session 7 is evicted from probation without being resumed...
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 7, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    for (uint32_t id = 1'000; id < 1'100; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT(!cache_has(cache, 7));
+
+    // ...so storing it again admits it straight into the main queue, where
+    // another flood cannot push it out
+    make_entry(&entry, 7, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    for (uint32_t id = 2'000; id < 3'000; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT(cache_has(cache, 7));
+
+    session_cache_free(cache);
+}
+
+TEST(borrow_returns_stored_bytes) {
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 1, time(nullptr) + 60);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+
+    tls_session_lease_t lease = {0};
+    ASSERT_EQ(session_cache_borrow(cache, entry.session_id, entry.session_id_size, &lease), 0);
+    ASSERT_NOT_NULL(lease.handle);
+    ASSERT_EQ(lease.session_data_size, entry.session_data_size);
+    ASSERT(memcmp(lease.session_data, entry.session_data, entry.session_data_size) == 0);
+    ASSERT(lease.expiration == entry.expiration);
+    session_cache_release(cache, &lease);
+    ASSERT(lease.handle == nullptr);
+
+    // Misses are counted like retrieve()
+    make_entry(&entry, 2, 0);
+    ASSERT_EQ(session_cache_borrow(cache, entry.session_id, entry.session_id_size, &lease), -1);
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    session_cache_get_stats(cache, nullptr, nullptr, &hits, &misses, nullptr);
+    ASSERT_EQ(hits, 1);
+    ASSERT_EQ(misses, 1);
+
+    session_cache_free(cache);
+}
+
+TEST(lease_outlives_eviction_update_and_clear) {
+    session_cache_config_t config = {
+        .capacity = 2,
+        .timeout_secs = 60,
+        .shard_count = 1,
+    };
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    tls_session_lease_t evicted = {0};
+    tls_session_lease_t updated = {0};
+    tls_session_lease_t cleared = {0};
+
+    // Lease session 1, then push it out of the cache
+    make_entry(&entry, 1, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(session_cache_borrow(cache, entry.session_id, entry.session_id_size, &evicted), 0);
+    for (uint32_t id = 2; id <= 3; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT(!cache_has(cache, 1));
+    ASSERT_EQ(evicted.session_data[0], 1);
+
+    // Lease session 2, then replace its data: the lease keeps the old bytes
+    make_entry(&entry, 2, 0);
+    ASSERT_EQ(session_cache_borrow(cache, entry.session_id, entry.session_id_size, &updated), 0);
+    memset(entry.session_data, 0xAB, entry.session_data_size);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(updated.session_data[0], 2);
+
+    tls_session_cache_entry_t out;
+    ASSERT_EQ(session_cache_retrieve(cache, entry.session_id, entry.session_id_size, &out), 0);
+    ASSERT_EQ(out.session_data[0], 0xAB);
+
+    // Lease session 3 across a clear
+    make_entry(&entry, 3, 0);
+    ASSERT_EQ(session_cache_borrow(cache, entry.session_id, entry.session_id_size, &cleared), 0);
+    session_cache_clear(cache);
+    ASSERT_EQ(session_cache_size(cache), 0);
+    ASSERT_EQ(cleared.session_data[0], 3);
+
+    session_cache_release(cache, &evicted);
+    session_cache_release(cache, &updated);
+    session_cache_release(cache, &cleared);
+
+    // The cache keeps working once the parked entries are freed
+    make_entry(&entry, 4, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT(cache_has(cache, 4));
+
+    session_cache_free(cache);
+}
+
+TEST(negative_filter_rejects_unknown_ids) {
+    session_cache_config_t config = {
+        .capacity = 100,
+        .timeout_secs = 60,
+        .negative_filter = true,
+    };
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 1; id <= 100; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    // No false negatives
+    for (uint32_t id = 1; id <= 100; id++) {
+        ASSERT(cache_has(cache, id));
+    }
+
+    // Unknown IDs: almost all answered by the filter
+    for (uint32_t id = 1'000; id < 2'000; id++) {
+        ASSERT(!cache_has(cache, id));
+    }
+
+    session_cache_stats_t stats;
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    ASSERT_EQ(stats.hits, 100);
+    ASSERT_EQ(stats.misses, 1'000);
+    ASSERT_EQ(stats.filter_rejects + stats.filter_false_positives, 1'000);
+    ASSERT(stats.filter_false_positive_rate < 0.05);
+
+    // Removed sessions leave the filter: while others remain, a lookup is
+    // either rejected or a false positive, and almost all are rejected
+    uint64_t rejects = stats.filter_rejects;
+    uint64_t false_positives = stats.filter_false_positives;
+    for (uint32_t id = 1; id <= 50; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_remove(cache, entry.session_id, entry.session_id_size), 0);
+        ASSERT(!cache_has(cache, id));
+    }
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    ASSERT_EQ(stats.filter_rejects - rejects + stats.filter_false_positives - false_positives,
+              50);
+    ASSERT(stats.filter_rejects - rejects >= 40);
+
+    // Once every session is gone, all lookups are rejected without reaching
+    // the table
+    session_cache_clear(cache);
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    rejects = stats.filter_rejects;
+    for (uint32_t id = 1; id <= 100; id++) {
+        ASSERT(!cache_has(cache, id));
+    }
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    ASSERT_EQ(stats.filter_rejects, rejects + 100);
+
+    session_cache_free(cache);
+}
+
+TEST(negative_filter_follows_eviction_and_expiry) {
+    session_cache_config_t config = {
+        .capacity = 2,
+        .timeout_secs = 60,
+        .shard_count = 1,
+        .negative_filter = true,
+    };
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 1, time(nullptr) + 1);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    make_entry(&entry, 2, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    make_entry(&entry, 3, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);   // Evicts 1
+    ASSERT(!cache_has(cache, 1));
+
+    // Clear drops 2 and 3; 4 leaves through the timing wheel
+    session_cache_clear(cache);
+    make_entry(&entry, 4, time(nullptr) + 1);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    sleep(2);
+    ASSERT_EQ(session_cache_cleanup_expired(cache), 1);
+
+    session_cache_stats_t stats;
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    uint64_t rejects = stats.filter_rejects;
+
+    // The shard is empty again, so every counter must be back to zero
+    for (uint32_t id = 1; id <= 4; id++) {
+        ASSERT(!cache_has(cache, id));
+    }
+    ASSERT_EQ(session_cache_get_stats_ex(cache, &stats), 0);
+    ASSERT_EQ(stats.filter_rejects, rejects + 4);
+
+    session_cache_free(cache);
+}
+
+/* Sessions released through the free_data hook, by make_entry() id */
+static unsigned int freed_count[8];
+
+/**
+ * Helper: free_data hook counting releases per session
+ */
+static void count_free(const uint8_t *session_data, size_t session_data_size) {
+    if (session_data_size > 0 && session_data[0] < 8) {
+        freed_count[session_data[0]]++;
+    }
+}
+
+TEST(free_data_called_once_per_dropped_session) {
+    memset(freed_count, 0, sizeof(freed_count));
+
+    session_cache_config_t config = {
+        .capacity = 2,
+        .timeout_secs = 60,
+        .shard_count = 1,
+        .free_data = count_free,
+    };
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    // Eviction
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 1; id <= 3; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT_EQ(freed_count[1], 1);
+
+    // Replacement releases the old data, not the new one
+    make_entry(&entry, 2, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(freed_count[2], 1);
+
+    // An already expired session is released right away
+    make_entry(&entry, 4, time(nullptr) - 1);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(freed_count[4], 1);
+
+    // Removal
+    make_entry(&entry, 3, 0);
+    ASSERT_EQ(session_cache_remove(cache, entry.session_id, entry.session_id_size), 0);
+    ASSERT_EQ(freed_count[3], 1);
+
+    // A leased session is released when the lease ends, not on clear()
+    make_entry(&entry, 2, 0);
+    tls_session_lease_t lease = {0};
+    ASSERT_EQ(session_cache_borrow(cache, entry.session_id, entry.session_id_size, &lease), 0);
+    session_cache_clear(cache);
+    ASSERT_EQ(freed_count[2], 1);
+    session_cache_release(cache, &lease);
+    ASSERT_EQ(freed_count[2], 2);
+
+    // Snapshots cannot hold native objects
+    ASSERT_EQ(session_cache_save(cache, "/tmp/unused.snap", nullptr), -1);
+    ASSERT_EQ(errno, EINVAL);
+
+    // free()
+    make_entry(&entry, 5, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    session_cache_free(cache);
+    ASSERT_EQ(freed_count[5], 1);
+    ASSERT_EQ(freed_count[1] + freed_count[2] + freed_count[3] + freed_count[4], 5);
+}
+
+/**
+ * Helper: Per-process shared-memory name so parallel test runs do not collide
+ */
+static void shared_name(char *name, size_t size, const char *tag) {
+    snprintf(name, size, "/wolfguard-test-%s-%ld", tag, (long)getpid());
+}
+
+TEST(shared_rejects_invalid_config) {
+    char name[64];
+    shared_name(name, sizeof(name), "invalid");
+
+    session_cache_config_t config = {
+        .capacity = 100,
+        .timeout_secs = 60,
+        .policy = SESSION_CACHE_POLICY_S3FIFO,
+    };
+    ASSERT(session_cache_new_shared(name, &config) == nullptr);
+    ASSERT_EQ(errno, EINVAL);
+    ASSERT(session_cache_new_shared(nullptr, &config) == nullptr);
+
+    // Shared records cannot own process-local objects
+    config.policy = SESSION_CACHE_POLICY_LRU;
+    config.free_data = count_free;
+    ASSERT(session_cache_new_shared(name, &config) == nullptr);
+    ASSERT_EQ(errno, EINVAL);
+    config.free_data = nullptr;
+    config.negative_filter = true;
+    ASSERT(session_cache_new_shared(name, &config) == nullptr);
+    ASSERT_EQ(errno, EINVAL);
+
+    // Attach-only to a segment that does not exist
+    ASSERT(session_cache_new_shared(name, nullptr) == nullptr);
+    ASSERT_EQ(errno, ENOENT);
+}
+
+TEST(shared_lru_eviction_and_expiry) {
+    char name[64];
+    shared_name(name, sizeof(name), "lru");
+
+    session_cache_config_t config = {
+        .capacity = 4,
+        .timeout_secs = 60,
+        .shared_entry_size = 128,
+    };
+    session_cache_t *cache = session_cache_new_shared(name, &config);
+    ASSERT_NOT_NULL(cache);
+    session_cache_unlink_shared(name);
+    ASSERT_EQ(session_cache_shard_count(cache), 1);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 1; id <= 4; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    // Touch 1 so that 2 is the least recently used, then overflow
+    ASSERT(cache_has(cache, 1));
+    make_entry(&entry, 5, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT(!cache_has(cache, 2));
+    ASSERT(cache_has(cache, 1));
+    ASSERT(cache_has(cache, 5));
+    ASSERT_EQ(session_cache_size(cache), 4);
+
+    // Larger than the fixed record payload
+    make_entry(&entry, 6, 0);
+    entry.session_data_size = 512;
+    ASSERT_EQ(session_cache_store(cache, &entry), -1);
+
+    // Already expired sessions are not cached
+    make_entry(&entry, 7, time(nullptr) - 10);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT(!cache_has(cache, 7));
+
+    ASSERT_EQ(session_cache_remove(cache, entry.session_id, entry.session_id_size), -1);
+    make_entry(&entry, 5, 0);
+    ASSERT_EQ(session_cache_remove(cache, entry.session_id, entry.session_id_size), 0);
+    ASSERT(!cache_has(cache, 5));
+
+    // Shared leases are private copies
+    make_entry(&entry, 1, 0);
+    tls_session_lease_t lease = {0};
+    ASSERT_EQ(session_cache_borrow(cache, entry.session_id, entry.session_id_size, &lease), 0);
+    ASSERT_EQ(lease.session_data_size, entry.session_data_size);
+    ASSERT(memcmp(lease.session_data, entry.session_data, entry.session_data_size) == 0);
+    session_cache_release(cache, &lease);
+
+    session_cache_clear(cache);
+    ASSERT_EQ(session_cache_size(cache), 0);
+    ASSERT(!cache_has(cache, 1));
+
+    session_cache_free(cache);
+}
+
+TEST(shared_cache_across_processes) {
+    char name[64];
+    shared_name(name, sizeof(name), "fork");
+
+    session_cache_config_t config = {
+        .capacity = 1'000,
+        .timeout_secs = 60,
+    };
+    session_cache_t *cache = session_cache_new_shared(name, &config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 100; id++) {
+        make_entry(&entry, id, time(nullptr) + 60);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    pid_t pid = fork();
+    ASSERT(pid >= 0);
+
+    if (pid == 0) {
+        // Worker: attach by name, resume the parent's sessions, add its own
+        session_cache_t *worker = session_cache_new_shared(name, nullptr);
+        int status = worker != nullptr ? 0 : 1;
+
+        for (uint32_t id = 0; status == 0 && id < 100; id++) {
+            if (!cache_has(worker, id)) {
+                status = 2;
+            }
+        }
+        for (uint32_t id = 100; status == 0 && id < 200; id++) {
+            tls_session_cache_entry_t own;
+            make_entry(&own, id, time(nullptr) + 60);
+            if (session_cache_store(worker, &own) != 0) {
+                status = 3;
+            }
+        }
+
+        session_cache_free(worker);
+        _exit(status);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    session_cache_unlink_shared(name);
+    ASSERT(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    // Sessions stored by the worker are visible here
+    for (uint32_t id = 100; id < 200; id++) {
+        ASSERT(cache_has(cache, id));
+    }
+
+    uint64_t hits = 0;
+    session_cache_get_stats(cache, nullptr, nullptr, &hits, nullptr, nullptr);
+    ASSERT_EQ(hits, 200);
+    ASSERT_EQ(session_cache_size(cache), 200);
+
+    session_cache_free(cache);
+}
+
+/**
+ * Helper: Per-process snapshot path
+ */
+static void snapshot_path(char *path, size_t size, const char *tag) {
+    snprintf(path, size, "/tmp/wolfguard-test-%s-%ld.snap", tag, (long)getpid());
+}
+
+TEST(snapshot_round_trip_keeps_lru_order) {
+    char path[128];
+    snapshot_path(path, sizeof(path), "roundtrip");
+
+    session_cache_config_t config = {
+        .capacity = 4,
+        .timeout_secs = 60,
+        .shard_count = 1,
+    };
+    session_cache_t *cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 1; id <= 4; id++) {
+        make_entry(&entry, id, id % 2 == 0 ? time(nullptr) + 60 : 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT(cache_has(cache, 1));    // 2 is now least recently used
+
+    size_t saved = 0;
+    ASSERT_EQ(session_cache_save(cache, path, &saved), 0);
+    ASSERT_EQ(saved, 4);
+    session_cache_free(cache);
+
+    cache = session_cache_new_with_config(&config);
+    ASSERT_NOT_NULL(cache);
+
+    size_t loaded = 0;
+    ASSERT_EQ(session_cache_load(cache, path, &loaded), 0);
+    ASSERT_EQ(loaded, 4);
+
+    // Contents survive, including the session data
+    tls_session_cache_entry_t out;
+    make_entry(&entry, 3, 0);
+    ASSERT_EQ(session_cache_retrieve(cache, entry.session_id, entry.session_id_size, &out), 0);
+    ASSERT_EQ(out.session_data_size, entry.session_data_size);
+    ASSERT(memcmp(out.session_data, entry.session_data, entry.session_data_size) == 0);
+
+    // Recency order survives too: 2 is still the first to go
+    make_entry(&entry, 5, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT(!cache_has(cache, 2));
+    ASSERT(cache_has(cache, 1));
+
+    session_cache_free(cache);
+    unlink(path);
+}
+
+TEST(snapshot_load_skips_expired_sessions) {
+    char path[128];
+    snapshot_path(path, sizeof(path), "expired");
+
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 1, time(nullptr) + 1);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    make_entry(&entry, 2, time(nullptr) + 60);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    ASSERT_EQ(session_cache_save(cache, path, nullptr), 0);
+    session_cache_free(cache);
+
+    // Session 1 expires while the "server" is down
+    struct timespec ts = {.tv_sec = 2, .tv_nsec = 100'000'000};
+    nanosleep(&ts, nullptr);
+
+    cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+
+    size_t loaded = 0;
+    ASSERT_EQ(session_cache_load(cache, path, &loaded), 0);
+    ASSERT_EQ(loaded, 1);
+    ASSERT(!cache_has(cache, 1));
+    ASSERT(cache_has(cache, 2));
+
+    session_cache_free(cache);
+    unlink(path);
+}
+
+TEST(snapshot_rejects_damaged_files) {
+    char path[128];
+    snapshot_path(path, sizeof(path), "damaged");
+
+    session_cache_t *cache = session_cache_new(64, 60);
+    ASSERT_NOT_NULL(cache);
+
+    ASSERT_EQ(session_cache_load(cache, path, nullptr), -1);
+    ASSERT_EQ(errno, ENOENT);
+
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 0; id < 8; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+    ASSERT_EQ(session_cache_save(cache, path, nullptr), 0);
+
+    struct stat st;
+    ASSERT_EQ(stat(path, &st), 0);
+    ASSERT_EQ(st.st_mode & 0777, 0600);
+
+    // Flip one byte in the last record
+    FILE *fp = fopen(path, "r+b");
+    ASSERT_NOT_NULL(fp);
+    ASSERT_EQ(fseek(fp, st.st_size - 16, SEEK_SET), 0);
+    int c = fgetc(fp);
+    ASSERT_EQ(fseek(fp, st.st_size - 16, SEEK_SET), 0);
+    fputc(c ^ 0x01, fp);
+    fclose(fp);
+
+    session_cache_t *restored = session_cache_new(64, 60);
+    ASSERT_NOT_NULL(restored);
+
+    size_t loaded = 0;
+    ASSERT_EQ(session_cache_load(restored, path, &loaded), -1);
+    ASSERT_EQ(errno, EBADMSG);
+    ASSERT_EQ(loaded, 7);
+
+    // Truncated file
+    ASSERT_EQ(truncate(path, st.st_size - 8), 0);
+    ASSERT_EQ(session_cache_load(restored, path, nullptr), -1);
+    ASSERT_EQ(errno, EBADMSG);
+
+    session_cache_free(restored);
+    session_cache_free(cache);
+    unlink(path);
+}
+
+TEST(snapshot_written_on_free) {
+    char path[128];
+    snapshot_path(path, sizeof(path), "shutdown");
+    unlink(path);
+
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+    ASSERT_EQ(session_cache_set_snapshot(cache, path, 0), 0);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 42, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+
+    // No periodic snapshot configured
+    (void)session_cache_cleanup_expired(cache);
+    ASSERT(access(path, F_OK) != 0);
+
+    session_cache_free(cache);
+    ASSERT_EQ(access(path, F_OK), 0);
+
+    cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+    ASSERT_EQ(session_cache_load(cache, path, nullptr), 0);
+    ASSERT(cache_has(cache, 42));
+
+    session_cache_free(cache);
+    unlink(path);
+}
+
+TEST(snapshot_written_periodically) {
+    char path[128];
+    snapshot_path(path, sizeof(path), "periodic");
+    unlink(path);
+
+    session_cache_t *cache = session_cache_new(16, 60);
+    ASSERT_NOT_NULL(cache);
+    ASSERT_EQ(session_cache_set_snapshot(cache, path, 1), 0);
+
+    tls_session_cache_entry_t entry;
+    make_entry(&entry, 7, 0);
+    ASSERT_EQ(session_cache_store(cache, &entry), 0);
+
+    // Saved by the snapshot thread, without any cleanup call
+    struct timespec delay = {.tv_nsec = 100'000'000};
+    for (int i = 0; i < 30 && access(path, F_OK) != 0; i++) {
+        nanosleep(&delay, nullptr);
+    }
+    ASSERT_EQ(access(path, F_OK), 0);
+
+    // Disabling stops the thread and the shutdown snapshot
+    ASSERT_EQ(session_cache_set_snapshot(cache, nullptr, 0), 0);
+    unlink(path);
+    session_cache_free(cache);
+    ASSERT(access(path, F_OK) != 0);
+}
+
+typedef struct {
+    session_cache_t *cache;
+    const char *path;
+    int failures;
+} snapshot_saver_t;
+
+static void *snapshot_saver_main(void *arg) {
+    snapshot_saver_t *saver = arg;
+    for (int i = 0; i < 50; i++) {
+        if (session_cache_save(saver->cache, saver->path, nullptr) != 0) {
+            saver->failures++;
+        }
+    }
+    return nullptr;
+}
+
+TEST(snapshot_concurrent_saves) {
+    char path[128];
+    snapshot_path(path, sizeof(path), "concurrent");
+
+    session_cache_t *cache = session_cache_new(8'192, 60);
+    ASSERT_NOT_NULL(cache);
+    tls_session_cache_entry_t entry;
+    for (uint32_t id = 1; id <= 4'096; id++) {
+        make_entry(&entry, id, 0);
+        ASSERT_EQ(session_cache_store(cache, &entry), 0);
+    }
+
+    // An explicit save racing the snapshot thread: each writes its own
+    // temporary file, so every save succeeds and the survivor is whole
+    snapshot_saver_t savers[2] = {{cache, path, 0}, {cache, path, 0}};
+    pthread_t threads[2];
+    for (size_t i = 0; i < 2; i++) {
+        ASSERT_EQ(pthread_create(&threads[i], nullptr, snapshot_saver_main, &savers[i]), 0);
+    }
+    for (size_t i = 0; i < 2; i++) {
+        pthread_join(threads[i], nullptr);
+    }
+    ASSERT_EQ(savers[0].failures + savers[1].failures, 0);
+    session_cache_free(cache);
+
+    cache = session_cache_new(8'192, 60);
+    ASSERT_NOT_NULL(cache);
+    size_t loaded = 0;
+    ASSERT_EQ(session_cache_load(cache, path, &loaded), 0);
+    ASSERT_EQ(loaded, 4'096);
+
+    session_cache_free(cache);
+    unlink(path);
+}
+
+/* ============================================================================
+ * Main Test Runner
+ * ============================================================================ */
+
+int main(void) {
+    printf("===============================================\n");
+    printf("Session Cache Unit Tests\n");
+    printf("===============================================\n\n");
+
+    RUN_TEST(create_rejects_invalid_config);
+    RUN_TEST(store_retrieve_remove);
+    RUN_TEST(lru_eviction_single_shard);
+    RUN_TEST(expired_entries_are_not_returned);
+    RUN_TEST(timing_wheel_expires_entries);
+    RUN_TEST(sharded_config_clamps_shard_count);
+    RUN_TEST(sharded_stats_are_aggregated);
+    RUN_TEST(sharded_capacity_is_respected);
+    RUN_TEST(table_grows_with_entries);
+    RUN_TEST(ids_with_common_prefix);
+    RUN_TEST(remove_keeps_probe_chains_intact);
+    RUN_TEST(memory_tracks_used_bytes);
+    RUN_TEST(update_moves_between_size_classes);
+    RUN_TEST(remote_addr_round_trip);
+    RUN_TEST(oversized_session_is_rejected);
+    RUN_TEST(invalid_policy_is_rejected);
+    RUN_TEST(s3fifo_keeps_resumed_sessions_under_flood);
+    RUN_TEST(lru_loses_resumed_sessions_under_flood);
+    RUN_TEST(s3fifo_ghost_readmits_to_main);
+    RUN_TEST(borrow_returns_stored_bytes);
+    RUN_TEST(lease_outlives_eviction_update_and_clear);
+    RUN_TEST(free_data_called_once_per_dropped_session);
+    RUN_TEST(negative_filter_rejects_unknown_ids);
+    RUN_TEST(negative_filter_follows_eviction_and_expiry);
+    RUN_TEST(shared_rejects_invalid_config);
+    RUN_TEST(shared_lru_eviction_and_expiry);
+    RUN_TEST(shared_cache_across_processes);
+    RUN_TEST(snapshot_round_trip_keeps_lru_order);
+    RUN_TEST(snapshot_load_skips_expired_sessions);
+    RUN_TEST(snapshot_rejects_damaged_files);
+    RUN_TEST(snapshot_written_on_free);
+    RUN_TEST(snapshot_written_periodically);
+    RUN_TEST(snapshot_concurrent_saves);
+
+    // Print summary
+    printf("\n===============================================\n");
+    printf("Test Summary:\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("===============================================\n");
+
+    if (tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    }
+
+    printf("\nAll tests PASSED!\n");
+    return 0;
+}
@@ -25,10 +25,18 @@
 
 #include "tls_abstract.h"
 #include "tls_wolfssl.h"
+#include "allocator.h"
+#include "ticket_keys.h"
+#include "anti_replay.h"
+#include "context_gen.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // C23 standard check (accept C2x/C20 from GCC 14 as it provides C23 features)
 #if __STDC_VERSION__ < 202000L
@@ -110,34 +118,61 @@ static int tests_failed = 0;
         } \
     } while (0)
 
+/*
+ * Backend setup. A dual-backend build (USE_GNUTLS as well) dispatches the
+ * tls_* calls to the backend tls_global_init() selected, so select wolfSSL
+ * through it; a wolfSSL-only build drives the backend directly.
+ */
+static int wolfssl_init_with_allocator(const tls_allocator_t *allocator) {
+#ifdef USE_GNUTLS
+    return tls_global_init_with_allocator(TLS_BACKEND_WOLFSSL, allocator);
+#else
+    // What tls_global_init_with_allocator() does before the backend init
+    allocator_set(allocator);
+    return tls_wolfssl_init();
+#endif
+}
+
+static int wolfssl_init(void) {
+    return wolfssl_init_with_allocator(nullptr);
+}
+
+static void wolfssl_deinit(void) {
+#ifdef USE_GNUTLS
+    tls_global_deinit();
+#else
+    tls_wolfssl_deinit();
+#endif
+}
+
 /* ============================================================================
  * Test Cases
  * ============================================================================ */
 
 TEST(library_initialization) {
-    int ret = tls_wolfssl_init();
+    int ret = wolfssl_init();
     ASSERT_EQ(ret, TLS_E_SUCCESS);
 
     const char *version = tls_wolfssl_get_version();
     ASSERT_NOT_NULL(version);
     printf(" [v%s]", version);
 
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(library_double_init) {
-    int ret1 = tls_wolfssl_init();
+    int ret1 = wolfssl_init();
     ASSERT_EQ(ret1, TLS_E_SUCCESS);
 
-    int ret2 = tls_wolfssl_init();
+    int ret2 = wolfssl_init();
     ASSERT_EQ(ret2, TLS_E_SUCCESS);
 
-    tls_wolfssl_deinit();
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(context_creation_server) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, false);
     ASSERT_NOT_NULL(ctx);
@@ -145,11 +180,11 @@ TEST(context_creation_server) {
     ASSERT(ctx->is_dtls == false);
 
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(context_creation_client) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(false, false);
     ASSERT_NOT_NULL(ctx);
@@ -157,11 +192,11 @@ TEST(context_creation_client) {
     ASSERT(ctx->is_dtls == false);
 
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(context_creation_dtls_server) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, true);
     ASSERT_NOT_NULL(ctx);
@@ -169,11 +204,11 @@ TEST(context_creation_dtls_server) {
     ASSERT(ctx->is_dtls == true);
 
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(context_creation_dtls_client) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(false, true);
     ASSERT_NOT_NULL(ctx);
@@ -181,11 +216,11 @@ TEST(context_creation_dtls_client) {
     ASSERT(ctx->is_dtls == true);
 
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(session_creation) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, false);
     ASSERT_NOT_NULL(ctx);
@@ -197,11 +232,11 @@ TEST(session_creation) {
 
     tls_session_free(session);
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(session_set_get_ptr) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, false);
     tls_session_t *session = tls_session_new(ctx);
@@ -214,7 +249,7 @@ TEST(session_set_get_ptr) {
 
     tls_session_free(session);
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(priority_translation_normal) {
@@ -239,7 +274,7 @@ TEST(priority_translation_performance) {
 }
 
 TEST(context_set_priority) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, false);
     ASSERT_NOT_NULL(ctx);
@@ -251,11 +286,11 @@ TEST(context_set_priority) {
     ASSERT_STR_EQ(ctx->priority_string, "NORMAL");
 
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(context_set_verify) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, false);
     ASSERT_NOT_NULL(ctx);
@@ -269,11 +304,11 @@ TEST(context_set_verify) {
     ASSERT(ctx->verify_peer == false);
 
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(context_set_session_timeout) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, false);
     ASSERT_NOT_NULL(ctx);
@@ -283,11 +318,11 @@ TEST(context_set_session_timeout) {
     ASSERT_EQ(ctx->session_timeout_secs, 3600);
 
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
 }
 
 TEST(dtls_set_get_mtu) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     tls_context_t *ctx = tls_context_new(true, true);
     tls_session_t *session = tls_session_new(ctx);
@@ -300,7 +335,935 @@ TEST(dtls_set_get_mtu) {
 
     tls_session_free(session);
     tls_context_free(ctx);
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
+}
+
+/* Transport that counts writes (and can fail them), for the corking test */
+typedef struct {
+    int fd;
+    int writes;
+    bool fail;
+} counting_io_t;
+
+static ssize_t counting_push(void *userdata, const void *data, size_t len) {
+    counting_io_t *io = userdata;
+    io->writes++;
+    if (io->fail) {
+        errno = EPIPE;
+        return -1;
+    }
+    return send(io->fd, data, len, MSG_NOSIGNAL);
+}
+
+static ssize_t counting_pull(void *userdata, void *data, size_t len) {
+    counting_io_t *io = userdata;
+    return recv(io->fd, data, len, 0);
+}
+
+TEST(cork_coalesces_records) {
+    (void)wolfssl_init();
+
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    ASSERT_NOT_NULL(server);
+    ASSERT_NOT_NULL(client);
+
+    counting_io_t io = {.fd = fds[0]};
+    int ret = tls_session_set_io_functions(server, counting_push, counting_pull, nullptr, &io);
+    ASSERT_EQ(ret, TLS_E_SUCCESS);
+    ASSERT_EQ(tls_session_set_fd(client, fds[1]), TLS_E_SUCCESS);
+
+    // Both ends stepped alternately in this thread
+    int server_ret = TLS_E_AGAIN;
+    int client_ret = TLS_E_AGAIN;
+    for (int round = 0; round < 64; round++) {
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+        }
+        if (server_ret != TLS_E_SUCCESS) {
+            server_ret = tls_handshake(server);
+        }
+        if (client_ret == TLS_E_SUCCESS && server_ret == TLS_E_SUCCESS) {
+            break;
+        }
+    }
+    ASSERT_EQ(client_ret, TLS_E_SUCCESS);
+    ASSERT_EQ(server_ret, TLS_E_SUCCESS);
+
+    // 64 small sends uncorked: one write each
+    uint8_t message[32];
+    uint8_t received[64 * 32];
+    int writes_before = io.writes;
+    for (int i = 0; i < 64; i++) {
+        memset(message, 'a' + (i % 26), sizeof(message));
+        ASSERT_EQ(tls_send(server, message, sizeof(message)), (ssize_t)sizeof(message));
+    }
+    ASSERT_EQ(io.writes, writes_before + 64);
+
+    size_t got = 0;
+    for (int round = 0; round < 256 && got < sizeof(received); round++) {
+        ssize_t n = tls_recv(client, received + got, sizeof(received) - got);
+        if (n > 0) {
+            got += (size_t)n;
+        } else if (n != TLS_E_AGAIN) {
+            break;
+        }
+    }
+    ASSERT_EQ(got, sizeof(received));
+
+    // The same 64 sends corked: nothing written until the uncork, which
+    // writes a single record
+    ASSERT_EQ(tls_cork(server), TLS_E_SUCCESS);
+    writes_before = io.writes;
+    for (int i = 0; i < 64; i++) {
+        memset(message, 'a' + (i % 26), sizeof(message));
+        ASSERT_EQ(tls_send(server, message, sizeof(message)), (ssize_t)sizeof(message));
+    }
+    ASSERT_EQ(io.writes, writes_before);
+
+    ASSERT_EQ(tls_uncork(server), TLS_E_SUCCESS);
+    ASSERT_EQ(io.writes, writes_before + 1);
+
+    got = 0;
+    for (int round = 0; round < 64 && got < sizeof(received); round++) {
+        ssize_t n = tls_recv(client, received + got, sizeof(received) - got);
+        if (n > 0) {
+            got += (size_t)n;
+        } else if (n != TLS_E_AGAIN) {
+            break;
+        }
+    }
+    ASSERT_EQ(got, sizeof(received));
+    ASSERT(received[0] == 'a');
+    ASSERT(received[sizeof(received) - 1] == 'a' + (63 % 26));
+
+    // Uncorked sends are written immediately again
+    ASSERT_EQ(tls_send(server, message, sizeof(message)), (ssize_t)sizeof(message));
+    ASSERT_EQ(io.writes, writes_before + 2);
+
+    // A transport failure after some bytes were taken: the send reports
+    // those bytes, so they are not sent again, and the next call the error
+    static uint8_t bulk[TLS_WOLFSSL_CORK_FLUSH_SIZE + 4 * TLS_MAX_RECORD_SIZE];
+    memset(bulk, 'z', sizeof(bulk));
+    io.fail = true;
+    ASSERT_EQ(tls_cork(server), TLS_E_SUCCESS);
+    ssize_t sent = tls_send(server, bulk, sizeof(bulk));
+    ASSERT(sent > 0);
+    ASSERT((size_t)sent < sizeof(bulk));
+    ASSERT(tls_send(server, bulk, sizeof(bulk)) < 0);
+
+    tls_session_free(client);
+    tls_session_free(server);
+    close(fds[0]);
+    close(fds[1]);
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    wolfssl_deinit();
+}
+
+TEST(ktls_falls_back_to_user_space) {
+    (void)wolfssl_init();
+
+    ASSERT_EQ(tls_context_set_ktls(nullptr, true), TLS_E_INVALID_PARAMETER);
+
+    tls_context_t *dtls_ctx = tls_context_new(true, true);
+    ASSERT_EQ(tls_context_set_ktls(dtls_ctx, true), TLS_E_INVALID_REQUEST);
+    tls_context_free(dtls_ctx);
+
+    tls_context_t *ctx = tls_context_new(true, false);
+    ASSERT_EQ(tls_context_set_ktls(ctx, true), TLS_E_SUCCESS);
+
+    tls_session_t *session = tls_session_new(ctx);
+    ASSERT_NOT_NULL(session);
+    ASSERT_EQ(tls_session_get_ktls(session), TLS_KTLS_NONE);
+    ASSERT_EQ(tls_sendfile(session, -1, nullptr, 1), TLS_E_INVALID_PARAMETER);
+
+    tls_session_free(session);
+    tls_context_free(ctx);
+    wolfssl_deinit();
+}
+
+/* Move everything one memory-BIO session has produced to the other */
+static bool pump_memory_bio(tls_session_t *from, tls_session_t *to) {
+    uint8_t buffer[4'096];
+    ssize_t n;
+    while ((n = tls_session_drain(from, buffer, sizeof(buffer))) > 0) {
+        if (tls_session_feed(to, buffer, (size_t)n) != n) {
+            return false;
+        }
+    }
+    return n == 0;
+}
+
+TEST(memory_bio_round_trip) {
+    (void)wolfssl_init();
+
+    ASSERT_EQ(tls_session_set_memory_bio(nullptr), TLS_E_INVALID_PARAMETER);
+
+    tls_context_t *dtls_ctx = tls_context_new(true, true);
+    tls_session_t *dtls = tls_session_new(dtls_ctx);
+    ASSERT_NOT_NULL(dtls);
+    ASSERT_EQ(tls_session_set_memory_bio(dtls), TLS_E_INVALID_REQUEST);
+    tls_session_free(dtls);
+    tls_context_free(dtls_ctx);
+
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    ASSERT_NOT_NULL(server);
+    ASSERT_NOT_NULL(client);
+
+    uint8_t buffer[64];
+    ASSERT_EQ(tls_session_feed(server, buffer, 1), TLS_E_INVALID_REQUEST);
+    ASSERT_EQ(tls_session_set_memory_bio(server), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_session_set_memory_bio(client), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_session_set_fd(server, 0), TLS_E_INVALID_REQUEST);
+
+    // Nothing fed yet: the server has to wait, without blocking
+    ASSERT_EQ(tls_handshake(server), TLS_E_AGAIN);
+    ASSERT_EQ(tls_session_pending_output(server), 0);
+
+    int server_ret = TLS_E_AGAIN;
+    int client_ret = TLS_E_AGAIN;
+    for (int round = 0; round < 16; round++) {
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+        }
+        ASSERT(pump_memory_bio(client, server));
+        if (server_ret != TLS_E_SUCCESS) {
+            server_ret = tls_handshake(server);
+        }
+        ASSERT(pump_memory_bio(server, client));
+        if (client_ret == TLS_E_SUCCESS && server_ret == TLS_E_SUCCESS) {
+            break;
+        }
+    }
+    ASSERT_EQ(client_ret, TLS_E_SUCCESS);
+    ASSERT_EQ(server_ret, TLS_E_SUCCESS);
+
+    // Plaintext in, ciphertext out, fed back in two pieces
+    static const char message[] = "memory bio";
+    ASSERT_EQ(tls_send(client, message, sizeof(message)), (ssize_t)sizeof(message));
+    ASSERT(tls_session_pending_output(client) > sizeof(message));
+
+    uint8_t record[256];
+    ssize_t len = tls_session_drain(client, record, sizeof(record));
+    ASSERT(len > 1);
+    ASSERT_EQ(tls_session_pending_output(client), 0);
+    ASSERT_EQ(tls_session_feed(server, record, 1), 1);
+    ASSERT_EQ(tls_recv(server, buffer, sizeof(buffer)), TLS_E_AGAIN);
+    ASSERT_EQ(tls_session_feed(server, record + 1, (size_t)len - 1), len - 1);
+    ASSERT_EQ(tls_recv(server, buffer, sizeof(buffer)), (ssize_t)sizeof(message));
+    ASSERT(memcmp(buffer, message, sizeof(message)) == 0);
+
+    // End of stream without close_notify
+    ASSERT_EQ(tls_session_feed(server, nullptr, 0), 0);
+    ssize_t n = tls_recv(server, buffer, sizeof(buffer));
+    ASSERT(n <= 0 && n != TLS_E_AGAIN);
+
+    tls_session_free(client);
+    tls_session_free(server);
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    wolfssl_deinit();
+}
+
+TEST(nonblocking_handshake_wants) {
+    (void)wolfssl_init();
+
+    unsigned int timeout_ms = 0;
+    ASSERT_EQ(tls_context_set_nonblocking(nullptr, true), TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_dtls_get_timeout(nullptr, &timeout_ms), TLS_E_INVALID_PARAMETER);
+    ASSERT(!tls_error_is_fatal(TLS_E_WANT_READ));
+    ASSERT(!tls_error_is_fatal(TLS_E_WANT_WRITE));
+
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_context_set_nonblocking(server_ctx, true), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_context_set_nonblocking(client_ctx, true), TLS_E_SUCCESS);
+
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    ASSERT_NOT_NULL(server);
+    ASSERT_NOT_NULL(client);
+    ASSERT_EQ(tls_session_set_fd(server, fds[0]), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_session_set_fd(client, fds[1]), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_dtls_get_timeout(server, &timeout_ms), TLS_E_INVALID_REQUEST);
+
+    // Nothing sent yet: the server waits for readability, not TLS_E_AGAIN
+    ASSERT_EQ(tls_handshake(server), TLS_E_WANT_READ);
+
+    int server_ret = TLS_E_WANT_READ;
+    int client_ret = TLS_E_WANT_READ;
+    for (int round = 0; round < 16; round++) {
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+            ASSERT(client_ret == TLS_E_SUCCESS || client_ret == TLS_E_WANT_READ ||
+                   client_ret == TLS_E_WANT_WRITE);
+        }
+        if (server_ret != TLS_E_SUCCESS) {
+            server_ret = tls_handshake(server);
+            ASSERT(server_ret == TLS_E_SUCCESS || server_ret == TLS_E_WANT_READ ||
+                   server_ret == TLS_E_WANT_WRITE);
+        }
+        if (client_ret == TLS_E_SUCCESS && server_ret == TLS_E_SUCCESS) {
+            break;
+        }
+    }
+    ASSERT_EQ(client_ret, TLS_E_SUCCESS);
+    ASSERT_EQ(server_ret, TLS_E_SUCCESS);
+
+    tls_session_free(client);
+    tls_session_free(server);
+    close(fds[0]);
+    close(fds[1]);
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    wolfssl_deinit();
+}
+
+TEST(session_memory_stats) {
+    (void)wolfssl_init_with_allocator(tls_arena_allocator());
+
+    tls_memory_stats_t stats;
+    ASSERT_EQ(tls_session_get_memory_stats(nullptr, &stats), TLS_E_INVALID_PARAMETER);
+
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    ASSERT_NOT_NULL(server);
+    ASSERT_NOT_NULL(client);
+    ASSERT_EQ(tls_session_set_memory_bio(server), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_session_set_memory_bio(client), TLS_E_SUCCESS);
+
+    // wolfSSL_new() alone allocates through the hooks
+    ASSERT_EQ(tls_session_get_memory_stats(client, &stats), TLS_E_SUCCESS);
+    ASSERT(stats.allocations > 0);
+    uint64_t created = stats.allocations;
+
+    int server_ret = TLS_E_AGAIN;
+    int client_ret = TLS_E_AGAIN;
+    for (int round = 0; round < 16; round++) {
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+        }
+        ASSERT(pump_memory_bio(client, server));
+        if (server_ret != TLS_E_SUCCESS) {
+            server_ret = tls_handshake(server);
+        }
+        ASSERT(pump_memory_bio(server, client));
+        if (client_ret == TLS_E_SUCCESS && server_ret == TLS_E_SUCCESS) {
+            break;
+        }
+    }
+    ASSERT_EQ(client_ret, TLS_E_SUCCESS);
+    ASSERT_EQ(server_ret, TLS_E_SUCCESS);
+
+    ASSERT_EQ(tls_session_get_memory_stats(client, &stats), TLS_E_SUCCESS);
+    ASSERT(stats.allocations > created);
+    ASSERT(stats.frees > 0);
+    ASSERT(stats.bytes_allocated >= stats.bytes_freed);
+
+    tls_session_free(client);
+    tls_session_free(server);
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    wolfssl_deinit();
+    allocator_set(nullptr);
+}
+
+/* Memory-BIO handshake between two fresh sessions */
+static bool handshake_memory_bio(tls_session_t *server, tls_session_t *client) {
+    if (tls_session_set_memory_bio(server) != TLS_E_SUCCESS ||
+        tls_session_set_memory_bio(client) != TLS_E_SUCCESS) {
+        return false;
+    }
+
+    int server_ret = TLS_E_AGAIN;
+    int client_ret = TLS_E_AGAIN;
+    for (int round = 0; round < 16; round++) {
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+        }
+        if (!pump_memory_bio(client, server)) {
+            return false;
+        }
+        if (server_ret != TLS_E_SUCCESS) {
+            server_ret = tls_handshake(server);
+        }
+        if (!pump_memory_bio(server, client)) {
+            return false;
+        }
+        if (client_ret == TLS_E_SUCCESS && server_ret == TLS_E_SUCCESS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef OPENSSL_EXTRA
+/* Whether the session's WOLFSSL object holds a client random */
+static bool has_client_random(const tls_session_t *session) {
+    uint8_t random[TLS_WOLFSSL_RANDOM_SIZE] = {0};
+    size_t len = wolfSSL_get_client_random(session->wolf_ssl, random, sizeof(random));
+    for (size_t i = 0; i < len; i++) {
+        if (random[i] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+TEST(session_pool_reuse) {
+    (void)wolfssl_init();
+
+    ASSERT_EQ(tls_session_reset(nullptr), TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_context_set_session_pool(nullptr, 4), TLS_E_INVALID_PARAMETER);
+
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    // A reset session handshakes again, with nothing left of the previous
+    // connection's key material
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    ASSERT_NOT_NULL(server);
+    ASSERT_NOT_NULL(client);
+    ASSERT(handshake_memory_bio(server, client));
+    tls_session_set_ptr(client, client);
+#ifdef OPENSSL_EXTRA
+    ASSERT(has_client_random(client));
+#endif
+    ASSERT_EQ(tls_session_reset(client), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_session_reset(server), TLS_E_SUCCESS);
+#ifdef OPENSSL_EXTRA
+    ASSERT(!has_client_random(client));
+    ASSERT(!has_client_random(server));
+#endif
+    ASSERT(tls_session_get_ptr(client) == nullptr);
+    ASSERT_EQ(tls_session_pending_output(client), 0);
+    ASSERT(handshake_memory_bio(server, client));
+    tls_session_free(client);
+    tls_session_free(server);
+
+    // Freed sessions come back from the pool, reset
+    ASSERT_EQ(tls_context_set_session_pool(server_ctx, 2), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_context_set_session_pool(client_ctx, 2), TLS_E_SUCCESS);
+    server = tls_session_new(server_ctx);
+    client = tls_session_new(client_ctx);
+    ASSERT(handshake_memory_bio(server, client));
+    tls_session_t *pooled = client;
+    tls_session_free(client);
+    tls_session_free(server);
+
+    client = tls_session_new(client_ctx);
+    server = tls_session_new(server_ctx);
+    ASSERT(client == pooled);
+    ASSERT(handshake_memory_bio(server, client));
+
+    // Pooled sessions hold no context reference: freeing the contexts
+    // first leaves the live sessions to release them
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    tls_session_free(client);
+    tls_session_free(server);
+    wolfssl_deinit();
+}
+
+/* Handshake offering @p data (nullptr for none); 1 if the server resumed,
+ * 0 if not, -1 on failure. With @p saved, the client's session is exported. */
+static int ticket_connect(tls_context_t *server_ctx, tls_context_t *client_ctx,
+                          const uint8_t *data, size_t size,
+                          uint8_t *saved, size_t *saved_size) {
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    bool ok = server != nullptr && client != nullptr &&
+              (data == nullptr || tls_session_set_data(client, data, size) == TLS_E_SUCCESS) &&
+              handshake_memory_bio(server, client);
+
+    // TLS 1.3 tickets follow the handshake; read past them
+    uint8_t byte = 0;
+    ok = ok && tls_send(server, "x", 1) == 1 && pump_memory_bio(server, client);
+    ssize_t got = TLS_E_AGAIN;
+    for (int i = 0; ok && got == TLS_E_AGAIN && i < 8; i++) {
+        got = tls_recv(client, &byte, 1);
+    }
+    ok = ok && got == 1;
+
+    tls_connection_info_t info;
+    ok = ok && tls_get_connection_info(server, &info) == TLS_E_SUCCESS;
+    if (ok && saved != nullptr) {
+        ok = tls_session_get_data(client, saved, saved_size) == TLS_E_SUCCESS;
+    }
+
+    tls_session_free(client);
+    tls_session_free(server);
+    return ok ? (info.session_resumed ? 1 : 0) : -1;
+}
+
+TEST(session_tickets) {
+    (void)wolfssl_init();
+
+    uint8_t secret_a[32];
+    uint8_t secret_b[32];
+    memset(secret_a, 0xa5, sizeof(secret_a));
+    memset(secret_b, 0x5a, sizeof(secret_b));
+    tls_datum_t key_a = {.data = secret_a, .size = sizeof(secret_a)};
+    tls_datum_t key_b = {.data = secret_b, .size = sizeof(secret_b)};
+    tls_datum_t ring[2] = {key_b, key_a};   // Rotated: b issues, a still accepted
+
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *peer_ctx = tls_context_new(true, false);
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(peer_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    ASSERT_EQ(tls_context_set_ticket_keys(nullptr, &key_a, 1, 60), TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_context_set_ticket_keys(server_ctx, &key_a, 1, 0), TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_context_set_ticket_keys(server_ctx, nullptr, 1, 60), TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_context_set_ticket_keys(client_ctx, &key_a, 1, 60), TLS_E_INVALID_REQUEST);
+    ASSERT_EQ(tls_context_set_ticket_keys(server_ctx, &key_a, 1, 60), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_context_set_ticket_keys(peer_ctx, &key_a, 1, 60), TLS_E_SUCCESS);
+
+    uint8_t saved[TLS_MAX_SESSION_DATA_SIZE];
+    size_t saved_size = sizeof(saved);
+    ASSERT_EQ(ticket_connect(server_ctx, client_ctx, nullptr, 0, saved, &saved_size), 0);
+    size_t needed = 1;
+    ASSERT_EQ(tls_session_get_data(nullptr, nullptr, &needed), TLS_E_INVALID_PARAMETER);
+
+    // Any server holding the secret resumes, also once it is only an older key
+    ASSERT_EQ(ticket_connect(server_ctx, client_ctx, saved, saved_size, nullptr, nullptr), 1);
+    ASSERT_EQ(ticket_connect(peer_ctx, client_ctx, saved, saved_size, nullptr, nullptr), 1);
+    ASSERT_EQ(tls_context_set_ticket_keys(peer_ctx, &key_b, 1, 60), TLS_E_SUCCESS);
+    ASSERT_EQ(ticket_connect(peer_ctx, client_ctx, saved, saved_size, nullptr, nullptr), 0);
+    ASSERT_EQ(tls_context_set_ticket_keys(peer_ctx, ring, 2, 60), TLS_E_SUCCESS);
+    ASSERT_EQ(ticket_connect(peer_ctx, client_ctx, saved, saved_size, nullptr, nullptr), 1);
+
+    // Without keys the server stops issuing and accepting tickets
+    ASSERT_EQ(tls_context_set_ticket_keys(server_ctx, nullptr, 0, 0), TLS_E_SUCCESS);
+    ASSERT_EQ(ticket_connect(server_ctx, client_ctx, saved, saved_size, nullptr, nullptr), 0);
+
+    tls_context_free(client_ctx);
+    tls_context_free(peer_ctx);
+    tls_context_free(server_ctx);
+    wolfssl_deinit();
+}
+
+/* TLS 1.2 handshake without tickets, so resumption goes through the
+ * server's session ID cache; results as ticket_connect() */
+static int session_id_connect(tls_context_t *server_ctx, tls_context_t *client_ctx,
+                              const uint8_t *data, size_t size,
+                              uint8_t *saved, size_t *saved_size) {
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    bool ok = server != nullptr && client != nullptr &&
+              wolfSSL_SetVersion(client->wolf_ssl, WOLFSSL_TLSV1_2) == SSL_SUCCESS;
+#ifdef HAVE_SESSION_TICKET
+    ok = ok && wolfSSL_NoTicketTLSv12(client->wolf_ssl) == SSL_SUCCESS;
+#endif
+    ok = ok && (data == nullptr || tls_session_set_data(client, data, size) == TLS_E_SUCCESS) &&
+         handshake_memory_bio(server, client);
+
+    tls_connection_info_t info;
+    ok = ok && tls_get_connection_info(server, &info) == TLS_E_SUCCESS;
+    if (ok && saved != nullptr) {
+        ok = tls_session_get_data(client, saved, saved_size) == TLS_E_SUCCESS;
+    }
+
+    tls_session_free(client);
+    tls_session_free(server);
+    return ok ? (info.session_resumed ? 1 : 0) : -1;
+}
+
+TEST(native_session_cache) {
+    (void)wolfssl_init();
+
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    session_cache_config_t config = {.capacity = 64, .timeout_secs = 60};
+    ASSERT_NULL(tls_wolfssl_context_get_native_session_cache(server_ctx));
+    ASSERT_EQ(tls_wolfssl_context_set_native_session_cache(nullptr, &config),
+              TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_wolfssl_context_set_native_session_cache(server_ctx, &config), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_wolfssl_context_set_native_session_cache(server_ctx, &config),
+              TLS_E_INVALID_PARAMETER);
+    session_cache_t *cache = tls_wolfssl_context_get_native_session_cache(server_ctx);
+    ASSERT_NOT_NULL(cache);
+
+    // The full handshake stores one session object
+    uint8_t saved[TLS_MAX_SESSION_DATA_SIZE];
+    size_t saved_size = sizeof(saved);
+    ASSERT_EQ(session_id_connect(server_ctx, client_ctx, nullptr, 0, saved, &saved_size), 0);
+    size_t count = 0;
+    uint64_t hits = 0;
+    session_cache_get_stats(cache, &count, nullptr, &hits, nullptr, nullptr);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(hits, 0);
+
+    // Each resume is served from the cache, which keeps its reference
+    ASSERT_EQ(session_id_connect(server_ctx, client_ctx, saved, saved_size, nullptr, nullptr), 1);
+    ASSERT_EQ(session_id_connect(server_ctx, client_ctx, saved, saved_size, nullptr, nullptr), 1);
+    session_cache_get_stats(cache, &count, nullptr, &hits, nullptr, nullptr);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(hits, 2);
+
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    wolfssl_deinit();
+}
+
+// Replace a key file the way deployments should: write, then rename()
+static bool write_key_file(const char *path, const char *text) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (fp == nullptr) {
+        return false;
+    }
+    bool ok = fputs(text, fp) >= 0;
+    ok = fclose(fp) == 0 && ok;
+    return ok && rename(tmp, path) == 0;
+}
+
+TEST(ticket_key_source) {
+    (void)wolfssl_init();
+
+    static const char ring_a[] =
+        "a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5\n";
+    static const char ring_ba[] =
+        "# rotated\n"
+        "5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a\n"
+        "a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5\n";
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/wolfguard-ticket-keys-%ld", (long)getpid());
+    ASSERT(write_key_file(path, ring_a));
+
+    ticket_keys_config_t config = {.path = path, .lifetime_secs = 60};
+    ticket_keys_t *keys = ticket_keys_new(&config);
+    ASSERT_NOT_NULL(keys);
+
+    tls_context_t *node_a = tls_context_new(true, false);   // Test certificate
+    tls_context_t *node_b = tls_context_new(true, false);
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(node_a);
+    ASSERT_NOT_NULL(node_b);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    ASSERT_EQ(ticket_keys_attach(keys, client_ctx), -1);
+    ASSERT_EQ(ticket_keys_attach(keys, node_a), 0);
+    ASSERT_EQ(ticket_keys_attach(keys, node_b), 0);
+
+    // A ticket from one node resumes on the other, also after the rotation
+    uint8_t saved[TLS_MAX_SESSION_DATA_SIZE];
+    size_t saved_size = sizeof(saved);
+    ASSERT_EQ(ticket_connect(node_a, client_ctx, nullptr, 0, saved, &saved_size), 0);
+    ASSERT_EQ(ticket_connect(node_b, client_ctx, saved, saved_size, nullptr, nullptr), 1);
+    ASSERT_EQ(ticket_keys_reload(keys), 0);
+
+    ASSERT(write_key_file(path, ring_ba));
+    ASSERT_EQ(ticket_keys_reload(keys), 1);
+    ASSERT_EQ(ticket_connect(node_b, client_ctx, saved, saved_size, nullptr, nullptr), 1);
+
+    // A broken ring leaves the last good one in place
+    ASSERT(write_key_file(path, "5a5a\n"));
+    ASSERT_EQ(ticket_keys_reload(keys), -1);
+    ASSERT_EQ(errno, EBADMSG);
+    ticket_keys_stats_t stats;
+    ticket_keys_get_stats(keys, &stats);
+    ASSERT_EQ(stats.reloads, 2);
+    ASSERT_EQ(stats.failures, 1);
+    ASSERT_EQ(stats.key_count, 2);
+
+    ASSERT_EQ(ticket_keys_detach(keys, node_a), 0);
+    ASSERT_EQ(ticket_keys_detach(keys, node_b), 0);
+    ticket_keys_free(keys);
+    unlink(path);
+
+    tls_context_free(client_ctx);
+    tls_context_free(node_b);
+    tls_context_free(node_a);
+    wolfssl_deinit();
+}
+
+/* Resume from @p data with @p early as 0-RTT data; 1 if the server accepted
+ * it (and read it into @p received), 0 if not, -1 on failure. The client's
+ * first flight is kept in @p hello; with @p replay the recording is fed to
+ * the server instead, and only the server's first step runs. */
+static int early_connect(tls_context_t *server_ctx, tls_context_t *client_ctx,
+                         const uint8_t *data, size_t size, const char *early,
+                         uint8_t *hello, size_t *hello_size, bool replay,
+                         char *received, size_t received_size) {
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    bool ok = server != nullptr && client != nullptr &&
+              tls_session_set_memory_bio(server) == TLS_E_SUCCESS &&
+              tls_session_set_memory_bio(client) == TLS_E_SUCCESS &&
+              tls_session_set_data(client, data, size) == TLS_E_SUCCESS &&
+              tls_session_write_early_data(client, early, strlen(early)) >= 0;
+
+    // wolfSSL writes the ClientHello and the data right away
+    if (ok && !replay) {
+        ssize_t n = tls_session_drain(client, hello, *hello_size);
+        ok = n > 0 && tls_session_pending_output(client) == 0;
+        *hello_size = ok ? (size_t)n : 0;
+    }
+    ok = ok && tls_session_feed(server, hello, *hello_size) == (ssize_t)*hello_size;
+
+    // Readable once the server has answered the ClientHello
+    int server_ret = ok ? tls_handshake(server) : TLS_E_HANDSHAKE_FAILED;
+    ssize_t got = ok ? tls_session_read_early_data(server, received, received_size - 1) : -1;
+    ok = ok && server_ret == TLS_E_WANT_READ && got >= 0;
+    if (ok) {
+        received[got] = '\0';
+    }
+    if (replay) {
+        // The recorded client cannot finish, the server is done with it
+        tls_connection_info_t info;
+        ok = ok && tls_get_connection_info(server, &info) == TLS_E_SUCCESS;
+        bool accepted = ok && info.early_data_accepted;
+        tls_session_free(client);
+        tls_session_free(server);
+        return ok ? (accepted ? 1 : 0) : -1;
+    }
+
+    int client_ret = TLS_E_WANT_READ;
+    for (int round = 0; ok && round < 8; round++) {
+        ok = pump_memory_bio(server, client);
+        if (client_ret != TLS_E_SUCCESS) {
+            client_ret = tls_handshake(client);
+        }
+        ok = ok && pump_memory_bio(client, server);
+        if (server_ret != TLS_E_SUCCESS) {
+            server_ret = tls_handshake(server);
+        }
+        if (client_ret == TLS_E_SUCCESS && server_ret == TLS_E_SUCCESS) {
+            break;
+        }
+    }
+    ok = ok && client_ret == TLS_E_SUCCESS && server_ret == TLS_E_SUCCESS;
+
+    tls_connection_info_t server_info;
+    tls_connection_info_t client_info;
+    ok = ok && tls_get_connection_info(server, &server_info) == TLS_E_SUCCESS &&
+         tls_get_connection_info(client, &client_info) == TLS_E_SUCCESS &&
+         server_info.session_resumed &&
+         server_info.early_data_accepted == client_info.early_data_accepted;
+
+    tls_session_free(client);
+    tls_session_free(server);
+    return ok ? (server_info.early_data_accepted ? 1 : 0) : -1;
+}
+
+TEST(early_data) {
+    (void)wolfssl_init();
+
+    anti_replay_t *filter = anti_replay_new(1'024, TLS_EARLY_DATA_WINDOW_MS);
+    ASSERT_NOT_NULL(filter);
+    tls_context_t *server_ctx = tls_context_new(true, false);   // Test certificate
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    ASSERT_EQ(tls_context_set_early_data(nullptr, 1'024, nullptr, nullptr),
+              TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_context_set_early_data(server_ctx, 1'024, nullptr, nullptr),
+              TLS_E_INVALID_PARAMETER);
+    ASSERT_EQ(tls_context_set_early_data(client_ctx, 1'024, anti_replay_check, filter),
+              TLS_E_INVALID_PARAMETER);
+
+#ifdef WOLFSSL_EARLY_DATA
+    uint8_t secret[32];
+    memset(secret, 0xa5, sizeof(secret));
+    tls_datum_t key = {.data = secret, .size = sizeof(secret)};
+    ASSERT_EQ(tls_context_set_ticket_keys(server_ctx, &key, 1, 60), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_context_set_early_data(server_ctx, 1'024, anti_replay_check, filter),
+              TLS_E_SUCCESS);
+    ASSERT_EQ(tls_context_set_early_data(client_ctx, 1'024, nullptr, nullptr), TLS_E_SUCCESS);
+
+    uint8_t saved[TLS_MAX_SESSION_DATA_SIZE];
+    size_t saved_size = sizeof(saved);
+    ASSERT_EQ(ticket_connect(server_ctx, client_ctx, nullptr, 0, saved, &saved_size), 0);
+
+    uint8_t hello[4'096];
+    size_t hello_size = sizeof(hello);
+    char received[64];
+    ASSERT_EQ(early_connect(server_ctx, client_ctx, saved, saved_size, "GET /", hello,
+                            &hello_size, false, received, sizeof(received)), 1);
+    ASSERT(strcmp(received, "GET /") == 0);
+
+    // A recorded ClientHello gets no early data in: the server answers it
+    // with a 1-RTT flight instead of failing the handshake
+    ASSERT_EQ(early_connect(server_ctx, client_ctx, saved, saved_size, "GET /", hello,
+                            &hello_size, true, received, sizeof(received)), 0);
+    ASSERT_EQ(received[0], '\0');
+    anti_replay_stats_t stats;
+    anti_replay_get_stats(filter, &stats);
+    ASSERT_EQ(stats.replays, 1);
+
+    // A new ClientHello with the same ticket is no replay
+    hello_size = sizeof(hello);
+    ASSERT_EQ(early_connect(server_ctx, client_ctx, saved, saved_size, "GET /", hello,
+                            &hello_size, false, received, sizeof(received)), 1);
+    anti_replay_get_stats(filter, &stats);
+    ASSERT_EQ(stats.replays, 1);
+#else
+    ASSERT_EQ(tls_context_set_early_data(client_ctx, 1'024, nullptr, nullptr),
+              TLS_E_INVALID_REQUEST);
+#endif
+
+    tls_context_free(client_ctx);
+    tls_context_free(server_ctx);
+    anti_replay_free(filter);
+    wolfssl_deinit();
+}
+
+static tls_context_t *gen_build(void *userdata) {
+    int *built = userdata;
+    (*built)++;
+    return tls_context_new(true, false);    // Test certificate
+}
+
+TEST(context_generations) {
+    (void)wolfssl_init();
+
+    int built = 0;
+    context_gen_config_t config = {.build = gen_build, .userdata = &built};
+    context_gen_t *gen = context_gen_new(&config);
+    ASSERT_NOT_NULL(gen);
+
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    // A session on the first generation completes after a reload
+    tls_context_t *first = context_gen_acquire(gen);
+    tls_session_t *server = context_gen_session_new(gen);
+    tls_session_t *client = tls_session_new(client_ctx);
+    ASSERT_NOT_NULL(server);
+    ASSERT_NOT_NULL(client);
+    ASSERT_EQ(context_gen_reload(gen), 0);
+    tls_context_t *second = context_gen_acquire(gen);
+    ASSERT(second != first);
+    tls_context_free(second);
+    tls_context_free(first);
+    ASSERT(handshake_memory_bio(server, client));
+    tls_session_free(server);
+    tls_session_free(client);
+
+    // ... and after the holder is gone
+    server = context_gen_session_new(gen);
+    context_gen_stats_t stats;
+    context_gen_get_stats(gen, &stats);
+    ASSERT_EQ(stats.generation, 2);
+    ASSERT_EQ(built, 2);
+    context_gen_free(gen);
+    client = tls_session_new(client_ctx);
+    ASSERT(handshake_memory_bio(server, client));
+    tls_session_free(server);
+    tls_session_free(client);
+
+    tls_context_free(client_ctx);
+    wolfssl_deinit();
+}
+
+static size_t read_pem(const char *path, char *buf, size_t size) {
+    FILE *fp = fopen(path, "r");
+    if (fp == nullptr) {
+        return 0;
+    }
+    size_t len = fread(buf, 1, size - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+    return len;
+}
+
+TEST(credentials) {
+    (void)wolfssl_init();
+
+    char cert[8'192];
+    char key[8'192];
+    size_t cert_size = read_pem("tests/certs/server-cert.pem", cert, sizeof(cert));
+    size_t key_size = read_pem("tests/certs/server-key.pem", key, sizeof(key));
+    ASSERT(cert_size > 0 && key_size > 0);
+
+    ASSERT(tls_credentials_new(cert, cert_size, "garbage", 7) == nullptr);
+    ASSERT_EQ(tls_context_set_cert_mem(nullptr, cert, cert_size), TLS_E_INVALID_PARAMETER);
+
+    tls_context_t *client_ctx = tls_context_new(false, false);
+    ASSERT_NOT_NULL(client_ctx);
+    ASSERT_EQ(tls_context_set_verify(client_ctx, false, nullptr, nullptr), TLS_E_SUCCESS);
+
+    // Certificate and key from memory
+    tls_context_t *server_ctx = tls_context_new(true, false);
+    ASSERT_NOT_NULL(server_ctx);
+    ASSERT_EQ(tls_context_set_cert_mem(server_ctx, cert, cert_size), TLS_E_SUCCESS);
+    ASSERT_EQ(tls_context_set_key_mem(server_ctx, key, key_size), TLS_E_SUCCESS);
+    tls_session_t *server = tls_session_new(server_ctx);
+    tls_session_t *client = tls_session_new(client_ctx);
+    ASSERT(handshake_memory_bio(server, client));
+    tls_session_free(server);
+    tls_session_free(client);
+    tls_context_free(server_ctx);
+
+    // Parsed once, shared by contexts that outlive the creator's reference
+    tls_credentials_t *creds = tls_credentials_new(cert, cert_size, key, key_size);
+    ASSERT_NOT_NULL(creds);
+    tls_context_t *contexts[2];
+    for (size_t i = 0; i < 2; i++) {
+        contexts[i] = tls_context_new(true, false);
+        ASSERT_NOT_NULL(contexts[i]);
+        ASSERT_EQ(tls_context_set_credentials(contexts[i], creds), TLS_E_SUCCESS);
+    }
+    tls_credentials_free(creds);
+    for (size_t i = 0; i < 2; i++) {
+        server = tls_session_new(contexts[i]);
+        client = tls_session_new(client_ctx);
+        ASSERT(handshake_memory_bio(server, client));
+        tls_session_free(server);
+        tls_session_free(client);
+        tls_context_free(contexts[i]);
+    }
+
+    tls_context_free(client_ctx);
+    wolfssl_deinit();
 }
 
 TEST(error_mapping) {
@@ -344,7 +1307,7 @@ TEST(error_is_fatal) {
 }
 
 TEST(hash_fast_sha256) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     const char *data = "Hello, World!";
     uint8_t hash[32];
@@ -362,11 +1325,77 @@ TEST(hash_fast_sha256) {
     }
     ASSERT(non_zero);
 
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
+}
+
+TEST(hash_hmac_hkdf_contexts) {
+    (void)wolfssl_init();
+
+    // RFC 4231 test case 2 and RFC 5869 test case 1 (first 16 bytes)
+    static const uint8_t hmac_expected[32] = {
+        0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26,
+        0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+        0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43,
+    };
+    static const uint8_t hkdf_expected[16] = {
+        0x3c, 0xb2, 0x5f, 0x25, 0xfa, 0xac, 0xd5, 0x7a, 0x90, 0x43, 0x4f, 0x64,
+        0xd0, 0x36, 0x2f, 0x2a,
+    };
+
+    const char *message = "The quick brown fox jumps over the lazy dog";
+    uint8_t oneshot[TLS_DIGEST_MAX_SIZE];
+    uint8_t streamed[TLS_DIGEST_MAX_SIZE];
+    ASSERT_EQ(tls_hash_fast(TLS_DIGEST_SHA384, message, strlen(message), oneshot), TLS_E_SUCCESS);
+
+    tls_hash_ctx_t hash;
+    ASSERT_EQ(tls_hash_init(&hash, TLS_DIGEST_SHA384), TLS_E_SUCCESS);
+    for (int round = 0; round < 2; round++) {
+        ASSERT_EQ(tls_hash_update(&hash, message, 7), TLS_E_SUCCESS);
+        ASSERT_EQ(tls_hash_update(&hash, message + 7, strlen(message) - 7), TLS_E_SUCCESS);
+        ASSERT_EQ(tls_hash_final(&hash, streamed), TLS_E_SUCCESS);
+        ASSERT(memcmp(oneshot, streamed, 48) == 0);
+    }
+    tls_hash_deinit(&hash);
+
+    struct iovec inputs[2] = {
+        {.iov_base = (void *)message, .iov_len = strlen(message)},
+        {.iov_base = (void *)message, .iov_len = 0},
+    };
+    uint8_t batch[2 * 48];
+    ASSERT_EQ(tls_hash_batch(TLS_DIGEST_SHA384, inputs, 2, batch), TLS_E_SUCCESS);
+    ASSERT(memcmp(batch, oneshot, 48) == 0);
+
+    tls_hmac_ctx_t hmac;
+    uint8_t mac[32];
+    const char *data = "what do ya want for nothing?";
+    ASSERT_EQ(tls_hmac_init(&hmac, TLS_DIGEST_SHA256, "Jefe", 4), TLS_E_SUCCESS);
+    for (int round = 0; round < 2; round++) {
+        ASSERT_EQ(tls_hmac_update(&hmac, data, strlen(data)), TLS_E_SUCCESS);
+        ASSERT_EQ(tls_hmac_final(&hmac, mac), TLS_E_SUCCESS);
+        ASSERT(memcmp(mac, hmac_expected, sizeof(mac)) == 0);
+    }
+    tls_hmac_deinit(&hmac);
+
+    uint8_t ikm[22];
+    uint8_t salt[13];
+    uint8_t info[10];
+    memset(ikm, 0x0b, sizeof(ikm));
+    for (size_t i = 0; i < sizeof(salt); i++) {
+        salt[i] = (uint8_t)i;
+    }
+    for (size_t i = 0; i < sizeof(info); i++) {
+        info[i] = (uint8_t)(0xf0 + i);
+    }
+    uint8_t okm[42];
+    ASSERT_EQ(tls_hkdf(TLS_DIGEST_SHA256, salt, sizeof(salt), ikm, sizeof(ikm),
+                       info, sizeof(info), okm, sizeof(okm)), TLS_E_SUCCESS);
+    ASSERT(memcmp(okm, hkdf_expected, sizeof(hkdf_expected)) == 0);
+
+    wolfssl_deinit();
 }
 
 TEST(random_generation) {
-    (void)tls_wolfssl_init();
+    (void)wolfssl_init();
 
     uint8_t buf1[32];
     uint8_t buf2[32];
@@ -380,7 +1409,47 @@ TEST(random_generation) {
     // Check that two random buffers are different
     ASSERT(memcmp(buf1, buf2, sizeof(buf1)) != 0);
 
-    tls_wolfssl_deinit();
+    wolfssl_deinit();
+}
+
+TEST(random_fork_reseed) {
+    (void)wolfssl_init();
+
+    // Prime this thread's DRBG and batch, which the child inherits
+    uint8_t primer[16];
+    ASSERT_EQ(tls_random(primer, sizeof(primer)), TLS_E_SUCCESS);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    pid_t pid = fork();
+    ASSERT(pid >= 0);
+    if (pid == 0) {
+        uint8_t child[32] = {0};
+        int ok = tls_random(child, sizeof(child)) == TLS_E_SUCCESS;
+        ok = ok && write(fds[1], child, sizeof(child)) == (ssize_t)sizeof(child);
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+
+    uint8_t parent[32];
+    uint8_t child[32];
+    ASSERT_EQ(tls_random(parent, sizeof(parent)), TLS_E_SUCCESS);
+    ASSERT_EQ(read(fds[0], child, sizeof(child)), (ssize_t)sizeof(child));
+    close(fds[0]);
+
+    int wstatus = 0;
+    ASSERT_EQ(waitpid(pid, &wstatus, 0), pid);
+    ASSERT(WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0);
+
+    // The child must not replay the parent's buffered bytes
+    ASSERT(memcmp(parent, child, sizeof(parent)) != 0);
+
+    // Larger than one batch: served directly
+    uint8_t large[4096];
+    ASSERT_EQ(tls_random(large, sizeof(large)), TLS_E_SUCCESS);
+
+    wolfssl_deinit();
 }
 
 TEST(memory_allocation) {
@@ -434,11 +1503,25 @@ int main(void) {
     RUN_TEST(context_set_verify);
     RUN_TEST(context_set_session_timeout);
     RUN_TEST(dtls_set_get_mtu);
+    RUN_TEST(cork_coalesces_records);
+    RUN_TEST(ktls_falls_back_to_user_space);
+    RUN_TEST(memory_bio_round_trip);
+    RUN_TEST(nonblocking_handshake_wants);
+    RUN_TEST(session_memory_stats);
+    RUN_TEST(session_pool_reuse);
+    RUN_TEST(session_tickets);
+    RUN_TEST(native_session_cache);
+    RUN_TEST(ticket_key_source);
+    RUN_TEST(early_data);
+    RUN_TEST(context_generations);
+    RUN_TEST(credentials);
     RUN_TEST(error_mapping);
     RUN_TEST(error_strings);
     RUN_TEST(error_is_fatal);
     RUN_TEST(hash_fast_sha256);
+    RUN_TEST(hash_hmac_hkdf_contexts);
     RUN_TEST(random_generation);
+    RUN_TEST(random_fork_reseed);
     RUN_TEST(memory_allocation);
     RUN_TEST(null_parameter_checks);
 